@@ -0,0 +1,51 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use rsban_core::{BlockHash, PrivateKey, PublicKey, Signature, SignatureBatch};
+
+const BATCH_SIZES: [usize; 3] = [256, 1024, 4096];
+
+/// A vote flood: few representatives sign many hashes, so the public keys repeat
+const REPRESENTATIVES: u64 = 32;
+
+/// Signatures per second verified one by one and as a batch,
+/// for votes (repeating keys) and blocks (a new key for every signature)
+fn signature_verification(c: &mut Criterion) {
+    for (name, key_count) in [("votes", REPRESENTATIVES), ("blocks", u64::MAX)] {
+        let mut group = c.benchmark_group(format!("verify_{}", name));
+        for size in BATCH_SIZES {
+            let signatures = create_signatures(size, key_count);
+            group.throughput(Throughput::Elements(size as u64));
+            group.bench_with_input(BenchmarkId::new("single", size), &signatures, |b, s| {
+                b.iter(|| {
+                    s.iter()
+                        .filter(|(key, hash, signature)| {
+                            key.verify(hash.as_bytes(), signature).is_ok()
+                        })
+                        .count()
+                })
+            });
+            group.bench_with_input(BenchmarkId::new("batch", size), &signatures, |b, s| {
+                b.iter(|| {
+                    let mut batch = SignatureBatch::with_capacity(s.len());
+                    for (key, hash, signature) in s {
+                        batch.add(*key, *hash, signature.clone());
+                    }
+                    batch.verify()
+                })
+            });
+        }
+        group.finish();
+    }
+}
+
+fn create_signatures(count: usize, key_count: u64) -> Vec<(PublicKey, BlockHash, Signature)> {
+    (0..count as u64)
+        .map(|i| {
+            let key = PrivateKey::from(i % key_count + 1);
+            let hash = BlockHash::from(i + 1);
+            (key.public_key(), hash, key.sign(hash.as_bytes()))
+        })
+        .collect()
+}
+
+criterion_group!(benches, signature_verification);
+criterion_main!(benches);
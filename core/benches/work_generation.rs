@@ -0,0 +1,43 @@
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+use rsban_core::{
+    work::{difficulty_lanes, difficulty_lanes_simd, WORK_LANES},
+    Difficulty, DifficultyV1, Root,
+};
+
+/// Hashes per second of the work difficulty, one nonce at a time and
+/// `WORK_LANES` nonces at once with the portable and the vectorized lanes
+fn work_hashes(c: &mut Criterion) {
+    let root = Root::from(42);
+    let mut group = c.benchmark_group("work_hashes");
+    group.throughput(Throughput::Elements(WORK_LANES as u64));
+
+    let difficulty = DifficultyV1::default();
+    let mut nonce = 0u64;
+    group.bench_function("single", |b| {
+        b.iter(|| {
+            for _ in 0..WORK_LANES {
+                nonce = nonce.wrapping_add(1);
+                black_box(difficulty.get_difficulty(&root, nonce));
+            }
+        })
+    });
+
+    let mut nonces: [u64; WORK_LANES] = std::array::from_fn(|i| i as u64);
+    group.bench_function("lanes_portable", |b| {
+        b.iter(|| {
+            nonces = nonces.map(|n| n.wrapping_add(WORK_LANES as u64));
+            black_box(difficulty_lanes(&root, &nonces))
+        })
+    });
+
+    group.bench_function("lanes_simd", |b| {
+        b.iter(|| {
+            nonces = nonces.map(|n| n.wrapping_add(WORK_LANES as u64));
+            black_box(difficulty_lanes_simd(&root, &nonces))
+        })
+    });
+    group.finish();
+}
+
+criterion_group!(benches, work_hashes);
+criterion_main!(benches);
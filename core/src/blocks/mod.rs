@@ -16,6 +16,9 @@ pub use receive_block::{
     valid_receive_block_predecessor, JsonReceiveBlock, ReceiveBlock, ReceiveBlockArgs,
 };
 
+mod saved_block_view;
+pub use saved_block_view::SavedBlockView;
+
 mod send_block;
 use send_block::JsonSendBlock;
 pub use send_block::{valid_send_block_predecessor, SendBlock, SendBlockArgs};
@@ -0,0 +1,267 @@
+use super::{Block, BlockDetails, BlockSideband, BlockType, SavedBlock};
+use crate::{
+    utils::{BufferReader, Deserialize},
+    Account, Amount, BlockHash, DependentBlocks, Epoch, Epochs, Link,
+};
+use num::FromPrimitive;
+
+/// A block with sideband as it is stored in the ledger, borrowed from the database.
+/// The fields are only decoded when they are accessed, so reading a few fields of
+/// a block doesn't allocate anything.
+#[derive(Clone, Copy)]
+pub struct SavedBlockView<'a> {
+    bytes: &'a [u8],
+    block_type: BlockType,
+}
+
+impl<'a> SavedBlockView<'a> {
+    /// Returns None if the bytes don't contain a block with sideband
+    pub fn new(bytes: &'a [u8]) -> Option<Self> {
+        let block_type = BlockType::from_u8(*bytes.first()?)?;
+        let body_size = body_size(block_type)?;
+        if bytes.len() != 1 + body_size + BlockSideband::serialized_size(block_type) {
+            return None;
+        }
+        Some(Self { bytes, block_type })
+    }
+
+    pub fn block_type(&self) -> BlockType {
+        self.block_type
+    }
+
+    /// The serialized block without sideband, as it is sent over the network
+    pub fn block_bytes(&self) -> &'a [u8] {
+        &self.bytes[..self.sideband_offset()]
+    }
+
+    pub fn previous(&self) -> BlockHash {
+        match self.block_type {
+            BlockType::LegacyOpen => BlockHash::zero(),
+            BlockType::State => self.hash_at(33),
+            _ => self.hash_at(1),
+        }
+    }
+
+    pub fn account(&self) -> Account {
+        match self.block_type {
+            BlockType::State => self.hash_at(1).into(),
+            BlockType::LegacyOpen => self.hash_at(65).into(),
+            _ => self.hash_at(self.sideband_offset() + 32).into(),
+        }
+    }
+
+    pub fn balance(&self) -> Amount {
+        match self.block_type {
+            BlockType::State => self.amount_at(97),
+            BlockType::LegacySend => self.amount_at(65),
+            _ => self.amount_at(self.sideband_balance_offset()),
+        }
+    }
+
+    pub fn link_field(&self) -> Option<Link> {
+        match self.block_type {
+            BlockType::State => Some(self.hash_at(113).into()),
+            _ => None,
+        }
+    }
+
+    pub fn source(&self) -> Option<BlockHash> {
+        match self.block_type {
+            BlockType::LegacyOpen => Some(self.hash_at(1)),
+            BlockType::LegacyReceive => Some(self.hash_at(33)),
+            BlockType::State if self.details().is_receive => Some(self.hash_at(113)),
+            _ => None,
+        }
+    }
+
+    pub fn successor(&self) -> Option<BlockHash> {
+        let successor = self.hash_at(self.sideband_offset());
+        if successor.is_zero() {
+            None
+        } else {
+            Some(successor)
+        }
+    }
+
+    pub fn height(&self) -> u64 {
+        match self.block_type {
+            BlockType::LegacyOpen => 1,
+            BlockType::State => self.u64_at(self.sideband_offset() + 32),
+            _ => self.u64_at(self.sideband_offset() + 64),
+        }
+    }
+
+    pub fn timestamp(&self) -> u64 {
+        self.u64_at(self.sideband_timestamp_offset())
+    }
+
+    pub fn details(&self) -> BlockDetails {
+        match self.block_type {
+            BlockType::State => {
+                BlockDetails::unpack(self.bytes[self.sideband_timestamp_offset() + 8])
+                    .unwrap_or_else(|_| BlockDetails::new(Epoch::Epoch0, false, false, false))
+            }
+            BlockType::LegacySend => BlockDetails::new(Epoch::Epoch0, true, false, false),
+            BlockType::LegacyOpen | BlockType::LegacyReceive => {
+                BlockDetails::new(Epoch::Epoch0, false, true, false)
+            }
+            _ => BlockDetails::new(Epoch::Epoch0, false, false, false),
+        }
+    }
+
+    pub fn is_send(&self) -> bool {
+        self.details().is_send
+    }
+
+    /// Same as `SavedBlock::dependent_blocks`
+    pub fn dependent_blocks(&self, epochs: &Epochs, genesis_account: &Account) -> DependentBlocks {
+        match self.block_type {
+            BlockType::LegacySend | BlockType::LegacyChange => {
+                DependentBlocks::new(self.previous(), BlockHash::zero())
+            }
+            BlockType::LegacyReceive => {
+                DependentBlocks::new(self.previous(), self.source().unwrap_or_default())
+            }
+            BlockType::LegacyOpen => {
+                if self.account() == *genesis_account {
+                    DependentBlocks::none()
+                } else {
+                    DependentBlocks::new(self.source().unwrap_or_default(), BlockHash::zero())
+                }
+            }
+            _ => {
+                let link = self.link_field().unwrap_or_default();
+                let linked_block = if !self.is_send() && !epochs.is_epoch_link(&link) {
+                    link.into()
+                } else {
+                    BlockHash::zero()
+                };
+                DependentBlocks::new(self.previous(), linked_block)
+            }
+        }
+    }
+
+    /// Decodes the block without its sideband
+    pub fn to_block(&self) -> Block {
+        let mut stream = BufferReader::new(self.block_bytes());
+        Block::deserialize(&mut stream).expect("block view contains an invalid block")
+    }
+
+    /// Decodes the whole block including sideband
+    pub fn to_saved_block(&self) -> SavedBlock {
+        let mut stream = BufferReader::new(self.bytes);
+        SavedBlock::deserialize(&mut stream).expect("block view contains an invalid block")
+    }
+
+    fn sideband_offset(&self) -> usize {
+        self.bytes.len() - BlockSideband::serialized_size(self.block_type)
+    }
+
+    fn sideband_balance_offset(&self) -> usize {
+        match self.block_type {
+            BlockType::LegacyOpen => self.sideband_offset() + 32,
+            _ => self.sideband_offset() + 72,
+        }
+    }
+
+    fn sideband_timestamp_offset(&self) -> usize {
+        match self.block_type {
+            BlockType::LegacyOpen => self.sideband_offset() + 48,
+            BlockType::LegacySend => self.sideband_offset() + 72,
+            BlockType::State => self.sideband_offset() + 40,
+            _ => self.sideband_offset() + 88,
+        }
+    }
+
+    fn hash_at(&self, offset: usize) -> BlockHash {
+        BlockHash::from_bytes(self.bytes[offset..offset + 32].try_into().unwrap())
+    }
+
+    fn amount_at(&self, offset: usize) -> Amount {
+        Amount::from_be_bytes(self.bytes[offset..offset + 16].try_into().unwrap())
+    }
+
+    fn u64_at(&self, offset: usize) -> u64 {
+        u64::from_be_bytes(self.bytes[offset..offset + 8].try_into().unwrap())
+    }
+}
+
+fn body_size(block_type: BlockType) -> Option<usize> {
+    let size = match block_type {
+        BlockType::LegacySend => super::SendBlock::serialized_size(),
+        BlockType::LegacyReceive => super::ReceiveBlock::serialized_size(),
+        BlockType::LegacyOpen => super::OpenBlock::serialized_size(),
+        BlockType::LegacyChange => super::ChangeBlock::serialized_size(),
+        BlockType::State => super::StateBlock::serialized_size(),
+        BlockType::Invalid | BlockType::NotABlock => return None,
+    };
+    Some(size)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{BlockBase, TestBlockBuilder, DEV_GENESIS_KEY};
+
+    #[test]
+    fn invalid_bytes() {
+        assert!(SavedBlockView::new(&[]).is_none());
+        assert!(SavedBlockView::new(&[BlockType::NotABlock as u8]).is_none());
+        assert!(SavedBlockView::new(&[BlockType::State as u8, 1, 2, 3]).is_none());
+    }
+
+    #[test]
+    fn state_block() {
+        assert_view_matches(SavedBlock::new_test_instance());
+    }
+
+    #[test]
+    fn legacy_blocks() {
+        assert_view_matches(TestBlockBuilder::legacy_send().build_saved());
+        assert_view_matches(TestBlockBuilder::legacy_receive().build_saved());
+        assert_view_matches(TestBlockBuilder::legacy_change().build_saved());
+        assert_view_matches(TestBlockBuilder::legacy_open().build_saved());
+    }
+
+    #[test]
+    fn genesis_has_no_dependents() {
+        let saved = TestBlockBuilder::legacy_open()
+            .sign(&DEV_GENESIS_KEY)
+            .build_saved();
+        let bytes = saved.serialize_with_sideband();
+        let view = SavedBlockView::new(&bytes).unwrap();
+        let dependents = view.dependent_blocks(&Epochs::new(), &DEV_GENESIS_KEY.account());
+        assert_eq!(dependents.iter().count(), 0);
+    }
+
+    fn assert_view_matches(saved: SavedBlock) {
+        // A round trip through the storage format fills in the implicit sideband fields
+        let bytes = saved.serialize_with_sideband();
+        let saved = SavedBlock::deserialize(&mut BufferReader::new(&bytes)).unwrap();
+
+        let view = SavedBlockView::new(&bytes).unwrap();
+        assert_eq!(view.block_type(), saved.block_type());
+        assert_eq!(view.previous(), saved.previous());
+        assert_eq!(view.account(), saved.account());
+        assert_eq!(view.balance(), saved.balance());
+        assert_eq!(view.link_field(), saved.link_field());
+        assert_eq!(view.source(), saved.source());
+        assert_eq!(view.successor(), saved.successor());
+        assert_eq!(view.height(), saved.height());
+        assert_eq!(view.timestamp(), saved.timestamp());
+        assert_eq!(view.details(), *saved.details());
+        assert_eq!(view.is_send(), saved.is_send());
+        let epochs = Epochs::new();
+        assert_eq!(
+            view.dependent_blocks(&epochs, &Account::zero())
+                .iter()
+                .collect::<Vec<_>>(),
+            saved
+                .dependent_blocks(&epochs, &Account::zero())
+                .iter()
+                .collect::<Vec<_>>()
+        );
+        assert_eq!(view.to_block(), *saved);
+        assert_eq!(view.to_saved_block(), saved);
+    }
+}
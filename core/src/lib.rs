@@ -37,6 +37,9 @@ pub use raw_key::RawKey;
 mod signature;
 pub use signature::Signature;
 
+mod signature_batch;
+pub use signature_batch::SignatureBatch;
+
 mod u256_struct;
 
 pub mod utils;
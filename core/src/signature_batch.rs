@@ -0,0 +1,440 @@
+use crate::{BlockHash, PublicKey, Signature};
+use blake2::{Blake2b512, Digest};
+use curve25519_dalek::{
+    constants::ED25519_BASEPOINT_POINT,
+    edwards::{CompressedEdwardsY, EdwardsPoint},
+    traits::{Identity, IsIdentity, VartimeMultiscalarMul},
+    Scalar,
+};
+use rand::{thread_rng, Rng, RngCore};
+use std::{
+    collections::HashMap,
+    iter::once,
+    sync::{LazyLock, Mutex},
+};
+
+/// Decompressed public keys which passed the torsion check, or None if the key can't be
+/// batch verified. Representative keys repeat in every vote, so each key is only checked once.
+/// The cache is sharded by the first key byte, so that checker threads rarely wait for each other
+static PUBLIC_KEYS: LazyLock<[Mutex<HashMap<PublicKey, Option<EdwardsPoint>>>; KEY_SHARDS]> =
+    LazyLock::new(|| std::array::from_fn(|_| Mutex::new(HashMap::new())));
+
+const KEY_SHARDS: usize = 16;
+
+/// A shard is emptied when it is full. Keys which are still in use are checked again
+const MAX_CACHED_KEYS_PER_SHARD: usize = 16 * 1024 / KEY_SHARDS;
+
+fn key_shard(key: &PublicKey) -> usize {
+    key.as_bytes()[0] as usize % KEY_SHARDS
+}
+
+/// Number of random subsets which are checked by `all_torsion_free`
+const TORSION_SUBSETS: usize = 128;
+
+/// Verifies the signatures of many hashes (blocks or votes) at once.
+/// If the batch doesn't verify, every signature is checked on its own to find the bad ones.
+/// See the signature_verification bench for the cost compared to single verifications
+#[derive(Default)]
+pub struct SignatureBatch {
+    entries: Vec<BatchEntry>,
+}
+
+impl SignatureBatch {
+    /// Below this size the torsion check of R costs more than the batch saves
+    pub const MIN_BATCH_SIZE: usize = 256;
+
+    pub fn new() -> Self {
+        Default::default()
+    }
+
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            entries: Vec::with_capacity(capacity),
+        }
+    }
+
+    pub fn add(&mut self, public_key: PublicKey, hash: BlockHash, signature: Signature) {
+        self.entries.push(BatchEntry {
+            public_key,
+            hash,
+            signature,
+        });
+    }
+
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    /// Returns for each signature whether it is valid, in the order they were added
+    pub fn verify(&self) -> Vec<bool> {
+        if self.entries.len() < Self::MIN_BATCH_SIZE {
+            return self.verify_each();
+        }
+
+        // Entries which can't be batched are verified on their own
+        let keys = self.public_keys();
+        let mut parsed: Vec<_> = self
+            .entries
+            .iter()
+            .zip(&keys)
+            .map(|(entry, key)| entry.parse(key.as_ref()?))
+            .collect();
+        Self::remove_torsioned_r(&mut parsed);
+
+        let batchable = parsed.iter().flatten().count();
+        if batchable >= Self::MIN_BATCH_SIZE && Self::verify_all(parsed.iter().flatten()) {
+            self.entries
+                .iter()
+                .zip(&parsed)
+                .map(|(entry, parsed)| parsed.is_some() || entry.verify())
+                .collect()
+        } else {
+            self.verify_each()
+        }
+    }
+
+    fn verify_each(&self) -> Vec<bool> {
+        self.entries.iter().map(|e| e.verify()).collect()
+    }
+
+    /// Looks up the public keys in the cache. The keys which aren't cached yet
+    /// are checked together and added to the cache. Each shard is locked once per batch
+    fn public_keys(&self) -> Vec<Option<EdwardsPoint>> {
+        let mut by_shard: [Vec<usize>; KEY_SHARDS] = Default::default();
+        for (i, entry) in self.entries.iter().enumerate() {
+            by_shard[key_shard(&entry.public_key)].push(i);
+        }
+
+        let mut keys = vec![None; self.entries.len()];
+        let mut missing = Vec::new();
+        for (shard, indices) in by_shard.iter().enumerate() {
+            if indices.is_empty() {
+                continue;
+            }
+            let cache = PUBLIC_KEYS[shard].lock().unwrap();
+            for &i in indices {
+                match cache.get(&self.entries[i].public_key) {
+                    Some(key) => keys[i] = *key,
+                    None => missing.push(i),
+                }
+            }
+        }
+        if missing.is_empty() {
+            return keys;
+        }
+
+        let mut new_keys = HashMap::new();
+        for i in missing {
+            let entry = &self.entries[i];
+            keys[i] = *new_keys
+                .entry(entry.public_key)
+                .or_insert_with(|| entry.decompress_key());
+        }
+
+        let points: Vec<_> = new_keys.values().flatten().cloned().collect();
+        if !all_torsion_free(&points) {
+            for key in new_keys.values_mut() {
+                if key.is_some_and(|k| !k.is_torsion_free()) {
+                    *key = None;
+                }
+            }
+            for (entry, key) in self.entries.iter().zip(keys.iter_mut()) {
+                if let Some(checked) = new_keys.get(&entry.public_key) {
+                    *key = *checked;
+                }
+            }
+        }
+
+        let mut new_by_shard: [Vec<(PublicKey, Option<EdwardsPoint>)>; KEY_SHARDS] =
+            Default::default();
+        for (public_key, key) in new_keys {
+            new_by_shard[key_shard(&public_key)].push((public_key, key));
+        }
+        for (shard, new_keys) in new_by_shard.into_iter().enumerate() {
+            if new_keys.is_empty() {
+                continue;
+            }
+            let mut cache = PUBLIC_KEYS[shard].lock().unwrap();
+            if cache.len() + new_keys.len() > MAX_CACHED_KEYS_PER_SHARD {
+                cache.clear();
+            }
+            cache.extend(new_keys);
+        }
+        keys
+    }
+
+    /// The batch equation has no cofactor, so a small order component in R
+    /// would be cancelled whenever its coefficient z is a multiple of its order.
+    /// The single verification rejects such signatures deterministically
+    fn remove_torsioned_r(parsed: &mut [Option<ParsedEntry>]) {
+        let points: Vec<_> = parsed.iter().flatten().map(|p| p.r).collect();
+        if all_torsion_free(&points) {
+            return;
+        }
+        for entry in parsed.iter_mut() {
+            if entry.as_ref().is_some_and(|p| !p.r.is_torsion_free()) {
+                *entry = None;
+            }
+        }
+    }
+
+    /// Checks s*B == R + k*A for all entries at once by checking the random linear combination
+    /// sum(z*R) + sum(z*k*A) - sum(z*s)*B == 0 with random 128 bit coefficients z.
+    /// This only matches the single verification because R and A are torsion free
+    fn verify_all<'a>(entries: impl Iterator<Item = &'a ParsedEntry>) -> bool {
+        let mut rng = thread_rng();
+        let mut basepoint_scalar = Scalar::ZERO;
+        let mut scalars = Vec::new();
+        let mut points = Vec::new();
+
+        for parsed in entries {
+            let z = Scalar::from(rng.gen::<u128>());
+            basepoint_scalar -= z * parsed.s;
+            scalars.push(z);
+            points.push(parsed.r);
+            scalars.push(z * parsed.k);
+            points.push(parsed.a);
+        }
+
+        EdwardsPoint::vartime_multiscalar_mul(
+            scalars.iter().chain(once(&basepoint_scalar)),
+            points.iter().chain(once(&ED25519_BASEPOINT_POINT)),
+        )
+        .is_identity()
+    }
+}
+
+/// Checks that none of the points has a small order component, with one scalar
+/// multiplication per random subset instead of one per point.
+/// The sum of a subset only is torsion free if the torsion components of its points cancel out.
+/// A point with a torsion component does so in at most half of all subsets, so it goes
+/// unnoticed with a probability of at most 2^-TORSION_SUBSETS
+fn all_torsion_free(points: &[EdwardsPoint]) -> bool {
+    if points.len() <= TORSION_SUBSETS {
+        return points.iter().all(|p| p.is_torsion_free());
+    }
+    let mut rng = thread_rng();
+    (0..TORSION_SUBSETS).all(|_| {
+        let mut sum = EdwardsPoint::identity();
+        let mut bits = 0;
+        for (i, point) in points.iter().enumerate() {
+            if i % 64 == 0 {
+                bits = rng.next_u64();
+            }
+            if bits & 1 == 1 {
+                sum += point;
+            }
+            bits >>= 1;
+        }
+        sum.is_torsion_free()
+    })
+}
+
+struct BatchEntry {
+    public_key: PublicKey,
+    hash: BlockHash,
+    signature: Signature,
+}
+
+impl BatchEntry {
+    fn verify(&self) -> bool {
+        self.public_key
+            .verify(self.hash.as_bytes(), &self.signature)
+            .is_ok()
+    }
+
+    fn decompress_key(&self) -> Option<EdwardsPoint> {
+        CompressedEdwardsY(*self.public_key.as_bytes()).decompress()
+    }
+
+    /// Applies the same acceptance rules as the single signature verification,
+    /// except for the torsion check of R, which is done for the whole batch.
+    /// `a` is the decompressed and torsion free public key.
+    /// Returns None if the entry can't be batch verified
+    fn parse(&self, a: &EdwardsPoint) -> Option<ParsedEntry> {
+        let r_bytes = &self.signature.as_bytes()[..32];
+        let r = CompressedEdwardsY(r_bytes.try_into().unwrap()).decompress()?;
+        // The single verification compares the encoded R, so it must be canonical
+        if r.compress().as_bytes() != r_bytes {
+            return None;
+        }
+
+        let s_bytes: [u8; 32] = self.signature.as_bytes()[32..].try_into().unwrap();
+        // Legacy compatible scalar check: the highest 3 bits must not be set
+        if s_bytes[31] & 224 != 0 {
+            return None;
+        }
+        let s = Scalar::from_bytes_mod_order(s_bytes);
+
+        let mut hasher = Blake2b512::new();
+        hasher.update(r_bytes);
+        hasher.update(self.public_key.as_bytes());
+        hasher.update(self.hash.as_bytes());
+        let mut wide = [0; 64];
+        wide.copy_from_slice(&hasher.finalize());
+        let k = Scalar::from_bytes_mod_order_wide(&wide);
+
+        Some(ParsedEntry { a: *a, r, s, k })
+    }
+}
+
+struct ParsedEntry {
+    a: EdwardsPoint,
+    r: EdwardsPoint,
+    s: Scalar,
+    k: Scalar,
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::PrivateKey;
+
+    const BATCH_SIZE: u64 = SignatureBatch::MIN_BATCH_SIZE as u64 + 10;
+
+    #[test]
+    fn empty_batch() {
+        assert_eq!(SignatureBatch::new().verify(), Vec::<bool>::new());
+    }
+
+    #[test]
+    fn valid_batch() {
+        let batch = create_batch(BATCH_SIZE);
+        assert_eq!(batch.verify(), vec![true; BATCH_SIZE as usize]);
+    }
+
+    #[test]
+    fn small_batch() {
+        let batch = create_batch(2);
+        assert_eq!(batch.verify(), vec![true; 2]);
+    }
+
+    #[test]
+    fn find_bad_signatures() {
+        let mut batch = create_batch(BATCH_SIZE);
+        batch.entries[3].signature = Signature::from_bytes([1; 64]);
+        let key = PrivateKey::new();
+        batch.entries[7].signature = key.sign(batch.entries[7].hash.as_bytes());
+
+        let mut expected = vec![true; BATCH_SIZE as usize];
+        expected[3] = false;
+        expected[7] = false;
+        assert_eq!(batch.verify(), expected);
+    }
+
+    #[test]
+    fn batch_result_matches_single_verification() {
+        let batch = create_batch(8);
+        let mut parsed = Vec::new();
+        for (entry, key) in batch.entries.iter().zip(batch.public_keys()) {
+            parsed.push(entry.parse(&key.unwrap()).unwrap());
+            assert!(entry.verify());
+        }
+        assert!(SignatureBatch::verify_all(parsed.iter()));
+    }
+
+    #[test]
+    fn reject_signature_with_torsioned_r() {
+        let mut batch = create_batch(BATCH_SIZE - 1);
+        let (public_key, hash, signature) = torsioned_signature();
+        batch.add(public_key, hash, signature);
+        let last = BATCH_SIZE as usize - 1;
+        assert!(!batch.entries[last].verify());
+        let key = batch.entries[last].decompress_key().unwrap();
+        let parsed = batch.entries[last].parse(&key).unwrap();
+        assert!(!parsed.r.is_torsion_free());
+
+        // Without the torsion check the batch would accept it whenever z is even
+        let mut expected = vec![true; BATCH_SIZE as usize];
+        expected[last] = false;
+        for _ in 0..32 {
+            assert_eq!(batch.verify(), expected);
+        }
+    }
+
+    #[test]
+    fn torsioned_public_key_is_not_batched() {
+        let public_key = PublicKey::from_bytes(
+            (Scalar::from(5u64) * ED25519_BASEPOINT_POINT + order_two_point())
+                .compress()
+                .to_bytes(),
+        );
+        let mut batch = create_batch(BATCH_SIZE - 1);
+        batch.add(
+            public_key,
+            BlockHash::from(1),
+            Signature::from_bytes([1; 64]),
+        );
+
+        let mut expected = vec![true; BATCH_SIZE as usize];
+        expected[BATCH_SIZE as usize - 1] = false;
+        assert_eq!(batch.verify(), expected);
+        assert_eq!(
+            PUBLIC_KEYS[key_shard(&public_key)]
+                .lock()
+                .unwrap()
+                .get(&public_key),
+            Some(&None)
+        );
+    }
+
+    #[test]
+    fn find_torsioned_point_in_subsets() {
+        let mut points: Vec<_> = (1..=200u64)
+            .map(|i| Scalar::from(i) * ED25519_BASEPOINT_POINT)
+            .collect();
+        assert!(all_torsion_free(&points));
+
+        points[150] += order_two_point();
+        assert!(!all_torsion_free(&points));
+    }
+
+    fn order_two_point() -> EdwardsPoint {
+        let mut order_two = [0xff; 32];
+        order_two[0] = 0xec;
+        order_two[31] = 0x7f;
+        let t = CompressedEdwardsY(order_two).decompress().unwrap();
+        assert!(!t.is_identity() && t.is_small_order());
+        t
+    }
+
+    /// A signature with R = r*B + T, where T has order 2 and s = r + k*a.
+    /// Then s*B - k*A = R - T, so it is only valid if the cofactor is ignored
+    fn torsioned_signature() -> (PublicKey, BlockHash, Signature) {
+        let a = Scalar::from(123456789u64);
+        let public_key = PublicKey::from_bytes((a * ED25519_BASEPOINT_POINT).compress().to_bytes());
+        let hash = BlockHash::from(42);
+
+        let t = order_two_point();
+        let r = Scalar::from(987654321u64);
+        let r_point = (r * ED25519_BASEPOINT_POINT + t).compress();
+
+        let mut hasher = Blake2b512::new();
+        hasher.update(r_point.as_bytes());
+        hasher.update(public_key.as_bytes());
+        hasher.update(hash.as_bytes());
+        let mut wide = [0; 64];
+        wide.copy_from_slice(&hasher.finalize());
+        let k = Scalar::from_bytes_mod_order_wide(&wide);
+        let s = r + k * a;
+
+        let mut signature = [0; 64];
+        signature[..32].copy_from_slice(r_point.as_bytes());
+        signature[32..].copy_from_slice(s.as_bytes());
+        (public_key, hash, Signature::from_bytes(signature))
+    }
+
+    fn create_batch(count: u64) -> SignatureBatch {
+        let mut batch = SignatureBatch::new();
+        for i in 0..count {
+            let key = PrivateKey::from(i + 1);
+            let hash = BlockHash::from(i + 100);
+            batch.add(key.public_key(), hash, key.sign(hash.as_bytes()));
+        }
+        batch
+    }
+}
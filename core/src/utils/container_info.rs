@@ -66,6 +66,25 @@ impl ContainerInfo {
         }
         serde_json::Value::Object(data)
     }
+
+    /// Calls `f` for every leaf of the tree together with the names of its parent nodes
+    pub fn visit_leaves(&self, f: &mut dyn FnMut(&[&str], &Leaf)) {
+        let mut path = Vec::new();
+        self.visit_leaves_impl(&mut path, f);
+    }
+
+    fn visit_leaves_impl<'a>(&'a self, path: &mut Vec<&'a str>, f: &mut dyn FnMut(&[&str], &Leaf)) {
+        for entry in &self.0 {
+            match entry {
+                ContainerInfoEntry::Leaf(leaf) => f(path, leaf),
+                ContainerInfoEntry::Node(node) => {
+                    path.push(&node.name);
+                    node.children.visit_leaves_impl(path, f);
+                    path.pop();
+                }
+            }
+        }
+    }
 }
 
 pub struct ContainerInfosBuilder(Vec<ContainerInfoEntry>);
@@ -103,3 +122,36 @@ impl<const N: usize> From<[(&'static str, usize, usize); N]> for ContainerInfo {
         builder.finish()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn visit_leaves() {
+        let info = ContainerInfo::builder()
+            .leaf("a", 1, 8)
+            .node(
+                "b",
+                ContainerInfo::builder()
+                    .node("c", [("d", 2, 4)].into())
+                    .leaf("e", 3, 1)
+                    .finish(),
+            )
+            .finish();
+
+        let mut leaves = Vec::new();
+        info.visit_leaves(&mut |path, leaf| {
+            leaves.push((path.join("/"), leaf.name.clone(), leaf.info.count))
+        });
+
+        assert_eq!(
+            leaves,
+            vec![
+                (String::new(), "a".to_owned(), 1),
+                ("b/c".to_owned(), "d".to_owned(), 2),
+                ("b".to_owned(), "e".to_owned(), 3),
+            ]
+        );
+    }
+}
@@ -1,5 +1,6 @@
 mod cpu_work_generator;
 mod opencl_work_generator;
+mod simd_work_generator;
 mod stub_work_pool;
 mod work_pool;
 mod work_queue;
@@ -8,6 +9,8 @@ mod work_thresholds;
 mod xorshift;
 
 pub(crate) use cpu_work_generator::CpuWorkGenerator;
+pub use simd_work_generator::{difficulty_lanes, difficulty_lanes_simd, WORK_LANES};
+pub(crate) use simd_work_generator::{SimdLevel, SimdWorkGenerator};
 pub use stub_work_pool::StubWorkPool;
 pub(crate) use work_pool::WorkGenerator;
 pub use work_pool::{WorkPool, WorkPoolImpl, STUB_WORK_POOL};
@@ -0,0 +1,354 @@
+use super::{
+    cpu_work_generator::{Sleeper, ThreadSleeper},
+    WorkGenerator, WorkTicket, XorShift1024Star,
+};
+use crate::Root;
+use std::time::Duration;
+
+/// Number of nonces which are hashed per iteration
+pub const WORK_LANES: usize = 8;
+
+/// Computes the work difficulty of `WORK_LANES` nonces for the same root at once
+type LanesHashFn = fn(&Root, &[u64; WORK_LANES]) -> [u64; WORK_LANES];
+
+/// The vector instruction set which is used for hashing multiple nonces at once.
+/// Only the instruction sets of the target architecture exist
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+pub(crate) enum SimdLevel {
+    #[cfg(target_arch = "x86_64")]
+    Avx512,
+    #[cfg(target_arch = "x86_64")]
+    Avx2,
+    #[cfg(target_arch = "aarch64")]
+    Neon,
+}
+
+impl SimdLevel {
+    /// Returns the best instruction set of the CPU we are running on,
+    /// or None if it has none we can use
+    pub fn detect() -> Option<Self> {
+        #[cfg(target_arch = "x86_64")]
+        {
+            if is_x86_feature_detected!("avx512f") {
+                return Some(Self::Avx512);
+            }
+            if is_x86_feature_detected!("avx2") {
+                return Some(Self::Avx2);
+            }
+        }
+        #[cfg(target_arch = "aarch64")]
+        {
+            if std::arch::is_aarch64_feature_detected!("neon") {
+                return Some(Self::Neon);
+            }
+        }
+        None
+    }
+
+    /// All instruction sets of the target architecture, the best one first
+    #[cfg(test)]
+    const ALL: &'static [Self] = &[
+        #[cfg(target_arch = "x86_64")]
+        Self::Avx512,
+        #[cfg(target_arch = "x86_64")]
+        Self::Avx2,
+        #[cfg(target_arch = "aarch64")]
+        Self::Neon,
+    ];
+
+    /// Returns true if the CPU we are running on has this instruction set
+    pub fn is_supported(&self) -> bool {
+        match *self {
+            #[cfg(target_arch = "x86_64")]
+            Self::Avx512 => is_x86_feature_detected!("avx512f"),
+            #[cfg(target_arch = "x86_64")]
+            Self::Avx2 => is_x86_feature_detected!("avx2"),
+            #[cfg(target_arch = "aarch64")]
+            Self::Neon => std::arch::is_aarch64_feature_detected!("neon"),
+        }
+    }
+
+    /// Falls back to the portable lanes if the CPU doesn't have this instruction set,
+    /// because calling the vectorized functions without it is undefined behaviour
+    fn hash_fn(&self) -> LanesHashFn {
+        if !self.is_supported() {
+            return difficulty_lanes;
+        }
+        match *self {
+            #[cfg(target_arch = "x86_64")]
+            Self::Avx512 => |root, nonces| unsafe { x86::difficulty_avx512(root, nonces) },
+            #[cfg(target_arch = "x86_64")]
+            Self::Avx2 => |root, nonces| unsafe { x86::difficulty_avx2(root, nonces) },
+            #[cfg(target_arch = "aarch64")]
+            Self::Neon => |root, nonces| unsafe { arm::difficulty_neon(root, nonces) },
+        }
+    }
+}
+
+/// Same result as `DifficultyV1::get_difficulty` for every nonce, but the nonces
+/// are hashed side by side, so that the compiler can keep one nonce per vector lane.
+pub fn difficulty_lanes(root: &Root, nonces: &[u64; WORK_LANES]) -> [u64; WORK_LANES] {
+    blake2b_work_lanes(root, nonces)
+}
+
+/// Computes the difficulty of many nonces at once with the best instruction set of the CPU
+pub fn difficulty_lanes_simd(root: &Root, nonces: &[u64; WORK_LANES]) -> [u64; WORK_LANES] {
+    match SimdLevel::detect() {
+        Some(level) => level.hash_fn()(root, nonces),
+        None => difficulty_lanes(root, nonces),
+    }
+}
+
+#[cfg(target_arch = "x86_64")]
+mod x86 {
+    use super::*;
+
+    #[target_feature(enable = "avx512f")]
+    pub(super) unsafe fn difficulty_avx512(
+        root: &Root,
+        nonces: &[u64; WORK_LANES],
+    ) -> [u64; WORK_LANES] {
+        blake2b_work_lanes(root, nonces)
+    }
+
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn difficulty_avx2(
+        root: &Root,
+        nonces: &[u64; WORK_LANES],
+    ) -> [u64; WORK_LANES] {
+        blake2b_work_lanes(root, nonces)
+    }
+}
+
+#[cfg(target_arch = "aarch64")]
+mod arm {
+    use super::*;
+
+    #[target_feature(enable = "neon")]
+    pub(super) unsafe fn difficulty_neon(
+        root: &Root,
+        nonces: &[u64; WORK_LANES],
+    ) -> [u64; WORK_LANES] {
+        blake2b_work_lanes(root, nonces)
+    }
+}
+
+const IV: [u64; 8] = [
+    0x6a09e667f3bcc908,
+    0xbb67ae8584caa73b,
+    0x3c6ef372fe94f82b,
+    0xa54ff53a5f1d36f1,
+    0x510e527fade682d1,
+    0x9b05688c2b3e6c1f,
+    0x1f83d9abfb41bd6b,
+    0x5be0cd19137e2179,
+];
+
+const SIGMA: [[usize; 16]; 12] = [
+    [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15],
+    [14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3],
+    [11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4],
+    [7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8],
+    [9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13],
+    [2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9],
+    [12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11],
+    [13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10],
+    [6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5],
+    [10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0],
+    [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15],
+    [14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3],
+];
+
+/// The work input (nonce + root) is 40 bytes, so it always fits into a single final block
+const WORK_INPUT_LEN: u64 = 40;
+
+/// Parameter block for an unkeyed Blake2b with an 8 byte digest
+const H0: u64 = IV[0] ^ 0x0101_0000 ^ 8;
+
+type Lanes = [u64; WORK_LANES];
+
+/// Blake2b-64 of (nonce || root) in structure-of-arrays layout: every state word holds
+/// one value per nonce, and every operation is a loop over the lanes.
+#[inline(always)]
+fn blake2b_work_lanes(root: &Root, nonces: &Lanes) -> Lanes {
+    let root_bytes = root.as_bytes();
+    let mut m = [[0u64; WORK_LANES]; 16];
+    m[0] = *nonces;
+    for i in 0..4 {
+        let word = u64::from_le_bytes(root_bytes[i * 8..(i + 1) * 8].try_into().unwrap());
+        m[i + 1] = [word; WORK_LANES];
+    }
+
+    let mut v = [[0u64; WORK_LANES]; 16];
+    v[0] = [H0; WORK_LANES];
+    for i in 1..8 {
+        v[i] = [IV[i]; WORK_LANES];
+    }
+    for i in 0..8 {
+        v[i + 8] = [IV[i]; WORK_LANES];
+    }
+    v[12] = [IV[4] ^ WORK_INPUT_LEN; WORK_LANES];
+    v[14] = [!IV[6]; WORK_LANES];
+
+    for s in &SIGMA {
+        g(&mut v, 0, 4, 8, 12, &m[s[0]], &m[s[1]]);
+        g(&mut v, 1, 5, 9, 13, &m[s[2]], &m[s[3]]);
+        g(&mut v, 2, 6, 10, 14, &m[s[4]], &m[s[5]]);
+        g(&mut v, 3, 7, 11, 15, &m[s[6]], &m[s[7]]);
+        g(&mut v, 0, 5, 10, 15, &m[s[8]], &m[s[9]]);
+        g(&mut v, 1, 6, 11, 12, &m[s[10]], &m[s[11]]);
+        g(&mut v, 2, 7, 8, 13, &m[s[12]], &m[s[13]]);
+        g(&mut v, 3, 4, 9, 14, &m[s[14]], &m[s[15]]);
+    }
+
+    let mut result = [0; WORK_LANES];
+    for lane in 0..WORK_LANES {
+        result[lane] = H0 ^ v[0][lane] ^ v[8][lane];
+    }
+    result
+}
+
+#[inline(always)]
+fn g(v: &mut [Lanes; 16], a: usize, b: usize, c: usize, d: usize, x: &Lanes, y: &Lanes) {
+    let (mut va, mut vb, mut vc, mut vd) = (v[a], v[b], v[c], v[d]);
+    for i in 0..WORK_LANES {
+        va[i] = va[i].wrapping_add(vb[i]).wrapping_add(x[i]);
+        vd[i] = (vd[i] ^ va[i]).rotate_right(32);
+        vc[i] = vc[i].wrapping_add(vd[i]);
+        vb[i] = (vb[i] ^ vc[i]).rotate_right(24);
+        va[i] = va[i].wrapping_add(vb[i]).wrapping_add(y[i]);
+        vd[i] = (vd[i] ^ va[i]).rotate_right(16);
+        vc[i] = vc[i].wrapping_add(vd[i]);
+        vb[i] = (vb[i] ^ vc[i]).rotate_right(63);
+    }
+    v[a] = va;
+    v[b] = vb;
+    v[c] = vc;
+    v[d] = vd;
+}
+
+/// PoW generation on the CPU which tries `WORK_LANES` nonces per iteration
+/// using the vector instructions of the CPU
+pub(crate) struct SimdWorkGenerator<Sleep = ThreadSleeper>
+where
+    Sleep: Sleeper,
+{
+    rng: XorShift1024Star,
+    hash: LanesHashFn,
+    sleeper: Sleep,
+    rate_limiter: Duration,
+    /// Number of iterations (of `WORK_LANES` nonces each) per batch
+    pub iteration_size: usize,
+}
+
+impl SimdWorkGenerator {
+    pub fn new(level: SimdLevel, rate_limiter: Duration) -> Self {
+        Self {
+            rng: XorShift1024Star::new(),
+            hash: level.hash_fn(),
+            sleeper: ThreadSleeper::new(),
+            rate_limiter,
+            iteration_size: 256 / WORK_LANES,
+        }
+    }
+}
+
+impl<Sleep: Sleeper> SimdWorkGenerator<Sleep> {
+    fn try_create_batch(&mut self, item: &Root, min_difficulty: u64) -> Option<u64> {
+        for _ in 0..self.iteration_size {
+            let base = self.rng.next();
+            let nonces: Lanes = std::array::from_fn(|i| base.wrapping_add(i as u64));
+            let difficulties = (self.hash)(item, &nonces);
+            if let Some(lane) = difficulties.iter().position(|d| *d >= min_difficulty) {
+                return Some(nonces[lane]);
+            }
+        }
+        None
+    }
+}
+
+impl<Sleep: Sleeper> WorkGenerator for SimdWorkGenerator<Sleep> {
+    fn create(
+        &mut self,
+        item: &Root,
+        min_difficulty: u64,
+        work_ticket: &WorkTicket,
+    ) -> Option<u64> {
+        while !work_ticket.expired() {
+            let result = self.try_create_batch(item, min_difficulty);
+            if result.is_some() {
+                return result;
+            }
+
+            if !self.rate_limiter.is_zero() {
+                self.sleeper.sleep(self.rate_limiter);
+            }
+        }
+        None
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{work::WorkThresholds, Difficulty, DifficultyV1};
+
+    #[test]
+    fn lanes_match_single_difficulty() {
+        let mut rng = XorShift1024Star::new();
+        for i in 0..16u64 {
+            let root = Root::from(i);
+            let nonces: Lanes = std::array::from_fn(|_| rng.next());
+            let expected = nonces.map(|n| DifficultyV1::default().get_difficulty(&root, n));
+            assert_eq!(difficulty_lanes(&root, &nonces), expected);
+            assert_eq!(difficulty_lanes_simd(&root, &nonces), expected);
+        }
+    }
+
+    #[test]
+    fn all_levels_match() {
+        let root = Root::from(42);
+        let nonces: Lanes = std::array::from_fn(|i| i as u64 * 1000);
+        for level in SimdLevel::ALL {
+            assert_eq!(
+                level.hash_fn()(&root, &nonces),
+                difficulty_lanes(&root, &nonces),
+                "{:?}",
+                level
+            );
+        }
+    }
+
+    #[test]
+    fn detected_level_is_supported() {
+        if let Some(level) = SimdLevel::detect() {
+            assert!(level.is_supported());
+        }
+    }
+
+    #[test]
+    fn create_work() {
+        let Some(level) = SimdLevel::detect() else {
+            return;
+        };
+        let thresholds = WorkThresholds::publish_dev();
+        let root = Root::from(7);
+        let mut generator = SimdWorkGenerator::new(level, Duration::ZERO);
+
+        let work = generator
+            .create(&root, thresholds.base, &WorkTicket::never_expires())
+            .unwrap();
+
+        assert!(DifficultyV1::default().get_difficulty(&root, work) >= thresholds.base);
+    }
+
+    #[test]
+    fn expired_work_ticket() {
+        let Some(level) = SimdLevel::detect() else {
+            return;
+        };
+        let mut generator = SimdWorkGenerator::new(level, Duration::ZERO);
+        let result = generator.create(&Root::from(1), u64::MAX, &WorkTicket::already_expired());
+        assert_eq!(result, None);
+    }
+}
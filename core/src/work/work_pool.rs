@@ -1,6 +1,6 @@
 use super::{
-    CpuWorkGenerator, StubWorkPool, WorkItem, WorkQueueCoordinator, WorkThread, WorkThresholds,
-    WorkTicket, WORK_THRESHOLDS_STUB,
+    CpuWorkGenerator, SimdLevel, SimdWorkGenerator, StubWorkPool, WorkItem, WorkQueueCoordinator,
+    WorkThread, WorkThresholds, WorkTicket, WORK_THRESHOLDS_STUB,
 };
 use crate::{utils::ContainerInfo, Root};
 use std::{
@@ -30,6 +30,7 @@ pub struct WorkPoolImpl {
     work_queue: Arc<WorkQueueCoordinator>,
     work_thresholds: WorkThresholds,
     pow_rate_limiter: Duration,
+    simd_level: Option<SimdLevel>,
 }
 
 impl WorkPoolImpl {
@@ -37,12 +38,24 @@ impl WorkPoolImpl {
         work_thresholds: WorkThresholds,
         thread_count: usize,
         pow_rate_limiter: Duration,
+    ) -> Self {
+        Self::with_simd(work_thresholds, thread_count, pow_rate_limiter, true)
+    }
+
+    /// With `simd` disabled the pool hashes one nonce at a time,
+    /// even if the CPU has vector instructions
+    pub fn with_simd(
+        work_thresholds: WorkThresholds,
+        thread_count: usize,
+        pow_rate_limiter: Duration,
+        simd: bool,
     ) -> Self {
         let mut pool = Self {
             threads: Vec::new(),
             work_queue: Arc::new(WorkQueueCoordinator::new()),
             work_thresholds,
             pow_rate_limiter,
+            simd_level: if simd { SimdLevel::detect() } else { None },
         };
 
         pool.spawn_threads(thread_count);
@@ -59,6 +72,7 @@ impl WorkPoolImpl {
             work_queue: Arc::new(WorkQueueCoordinator::new()),
             work_thresholds: WORK_THRESHOLDS_STUB.clone(),
             pow_rate_limiter: Duration::ZERO,
+            simd_level: None,
         };
 
         pool.threads
@@ -72,6 +86,7 @@ impl WorkPoolImpl {
             work_queue: Arc::new(WorkQueueCoordinator::new()),
             work_thresholds: WORK_THRESHOLDS_STUB.clone(),
             pow_rate_limiter: Duration::ZERO,
+            simd_level: None,
         }
     }
 
@@ -82,7 +97,13 @@ impl WorkPoolImpl {
     }
 
     fn spawn_cpu_worker_thread(&self) -> JoinHandle<()> {
-        self.spawn_worker_thread(CpuWorkGenerator::new(self.pow_rate_limiter))
+        // Hash multiple nonces at once if the CPU has vector instructions
+        match self.simd_level {
+            Some(level) => {
+                self.spawn_worker_thread(SimdWorkGenerator::new(level, self.pow_rate_limiter))
+            }
+            None => self.spawn_worker_thread(CpuWorkGenerator::new(self.pow_rate_limiter)),
+        }
     }
 
     fn spawn_stub_worker_thread(&self, configured_work: u64) -> JoinHandle<()> {
@@ -288,6 +309,21 @@ mod tests {
         assert!(pool.threshold_base() < difficulty(&block));
     }
 
+    #[test]
+    fn work_without_simd() {
+        let pool = WorkPoolImpl::with_simd(
+            WorkThresholds::publish_dev().clone(),
+            1,
+            Duration::ZERO,
+            false,
+        );
+        assert_eq!(pool.simd_level, None);
+        let mut block = TestBlockBuilder::state().build();
+        let root = block.root();
+        block.set_work(pool.generate_dev2(root).unwrap());
+        assert!(pool.threshold_base() < difficulty(&block));
+    }
+
     #[test]
     fn work_validate() {
         let pool = &WORK_POOL;
@@ -75,6 +75,7 @@ impl DaemonBuilder {
                 node.clone(),
                 listener,
                 rpc_config.enable_control,
+                rpc_config.enable_metrics,
                 tx_stop,
                 wait_for_shutdown,
             )
@@ -1,7 +1,18 @@
 use crate::{LedgerConstants, LedgerObserver, LedgerSetAny, LedgerSetConfirmed};
 use rsban_core::{BlockHash, ConfirmationHeightInfo, SavedBlock};
 use rsban_store_lmdb::{LmdbStore, LmdbWriteTransaction, Transaction};
-use std::{collections::VecDeque, sync::atomic::Ordering};
+use std::{
+    collections::{HashSet, VecDeque},
+    sync::atomic::Ordering,
+};
+
+/// The blocks which have to be cemented to confirm the target block,
+/// ordered so that every block comes after its dependencies
+#[derive(Clone, Debug)]
+pub struct ConfirmationPlan {
+    pub target: BlockHash,
+    pub blocks: Vec<SavedBlock>,
+}
 
 /// Cements Blocks in the ledger
 pub(crate) struct BlockCementer<'a> {
@@ -60,20 +71,7 @@ impl<'a> BlockCementer<'a> {
                 stack.pop_back();
                 if !self.confirmed.block_exists_or_pruned(txn, &hash) {
                     // We must only confirm blocks that have their dependencies confirmed
-
-                    let conf_height = ConfirmationHeightInfo::new(block.height(), block.hash());
-
-                    // Update store
-                    self.store
-                        .confirmation_height
-                        .put(txn, &block.account(), &conf_height);
-                    self.store
-                        .cache
-                        .cemented_count
-                        .fetch_add(1, Ordering::SeqCst);
-
-                    self.observer.blocks_cemented(1);
-
+                    self.cement(txn, &block);
                     result.push(block);
                 }
             } else {
@@ -96,4 +94,98 @@ impl<'a> BlockCementer<'a> {
         }
         result
     }
+
+    /// Finds the blocks which `confirm` would cement, without writing anything.
+    /// Blocks in `planned` are treated as confirmed, and the found blocks are added to it.
+    /// Planning doesn't notify the observer, a plan might never be applied.
+    pub(crate) fn plan(
+        &self,
+        txn: &dyn Transaction,
+        target_hash: BlockHash,
+        max_blocks: usize,
+        planned: &mut HashSet<BlockHash>,
+    ) -> ConfirmationPlan {
+        let mut result = Vec::new();
+        let is_done = |hash: &BlockHash, planned: &HashSet<BlockHash>| {
+            planned.contains(hash) || self.confirmed.block_exists_or_pruned(txn, hash)
+        };
+
+        let mut stack = VecDeque::new();
+        stack.push_back(target_hash);
+        while let Some(&hash) = stack.back() {
+            let Some(block) = self.any.get_block(txn, &hash) else {
+                break; // Block was rolled back
+            };
+
+            let dependents =
+                block.dependent_blocks(&self.constants.epochs, &self.constants.genesis_account);
+            for dependent in dependents.iter() {
+                if !dependent.is_zero() && !is_done(dependent, planned) {
+                    stack.push_back(*dependent);
+                    if stack.len() > max_blocks {
+                        stack.pop_front();
+                    }
+                }
+            }
+
+            if stack.back() == Some(&hash) {
+                stack.pop_back();
+                if !is_done(&hash, planned) {
+                    planned.insert(hash);
+                    result.push(block);
+                }
+            }
+
+            if result.len() >= max_blocks {
+                break;
+            }
+        }
+        ConfirmationPlan {
+            target: target_hash,
+            blocks: result,
+        }
+    }
+
+    /// Cements the blocks which were found by `plan`, unless they already are cemented.
+    /// Returns the cemented blocks and whether the whole plan could be applied.
+    /// A plan becomes invalid if one of its blocks was rolled back in the meantime.
+    pub(crate) fn apply(
+        &self,
+        txn: &mut LmdbWriteTransaction,
+        plan: ConfirmationPlan,
+    ) -> (Vec<SavedBlock>, bool) {
+        let mut result = Vec::with_capacity(plan.blocks.len());
+        for block in plan.blocks {
+            if self.confirmed.block_exists_or_pruned(txn, &block.hash()) {
+                continue;
+            }
+            if !self.any.block_exists(txn, &block.hash()) {
+                return (result, false);
+            }
+            // The dependencies were either confirmed when the plan was made, or they
+            // were planned before this block and got cemented already
+            if block.hash() != plan.target {
+                self.observer.dependent_unconfirmed();
+            }
+            self.cement(txn, &block);
+            result.push(block);
+        }
+        (result, true)
+    }
+
+    fn cement(&self, txn: &mut LmdbWriteTransaction, block: &SavedBlock) {
+        let conf_height = ConfirmationHeightInfo::new(block.height(), block.hash());
+
+        // Update store
+        self.store
+            .confirmation_height
+            .put(txn, &block.account(), &conf_height);
+        self.store
+            .cache
+            .cemented_count
+            .fetch_add(1, Ordering::SeqCst);
+        self.store.persist_counts(txn);
+
+        self.observer.blocks_cemented(1);
+    }
 }
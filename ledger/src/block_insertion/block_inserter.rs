@@ -55,6 +55,7 @@ impl<'a> BlockInserter<'a> {
             .cache
             .block_count
             .fetch_add(1, Ordering::SeqCst);
+        self.ledger.store.persist_counts(self.txn);
 
         saved_block
     }
@@ -182,6 +183,56 @@ mod tests {
         );
     }
 
+    #[test]
+    fn move_account_in_delegator_index() {
+        let old_representative = PublicKey::from(1111);
+        let new_representative = PublicKey::from(2222);
+        let open = TestBlockBuilder::legacy_open()
+            .representative(old_representative)
+            .build();
+        let sideband = BlockSideband {
+            successor: BlockHash::zero(),
+            ..BlockSideband::new_test_instance()
+        };
+        let open = SavedBlock::new(open, sideband.clone());
+        let state = TestBlockBuilder::state()
+            .previous(open.hash())
+            .representative(new_representative)
+            .balance(sideband.balance)
+            .build();
+        let (mut state, mut instructions) = state_block_instructions_for(&open, state);
+        instructions.old_account_info.representative = old_representative;
+        let ledger = Ledger::new_null_builder().block(&open).finish();
+        let puts = ledger.store.delegator.track_puts();
+        let deletions = ledger.store.delegator.track_deletions();
+
+        insert(&ledger, &mut state, &instructions);
+
+        assert_eq!(
+            deletions.output(),
+            vec![(old_representative, instructions.account)]
+        );
+        assert_eq!(
+            puts.output(),
+            vec![(new_representative, instructions.account)]
+        );
+    }
+
+    #[test]
+    fn keep_delegator_index_if_representative_is_unchanged() {
+        let (mut block, mut instructions) = legacy_open_block_instructions();
+        instructions.old_account_info = AccountInfo {
+            head: BlockHash::from(42),
+            ..instructions.set_account_info.clone()
+        };
+        let ledger = Ledger::new_null();
+        let puts = ledger.store.delegator.track_puts();
+
+        insert(&ledger, &mut block, &instructions);
+
+        assert_eq!(puts.output(), Vec::new());
+    }
+
     fn insert(
         ledger: &Ledger,
         block: &mut Block,
@@ -0,0 +1,127 @@
+use rsban_core::{work::WorkThresholds, Block, BlockHash, Epochs, PublicKey, SignatureBatch};
+
+/// Result of the stateless checks of a block.
+/// These checks don't need access to the ledger, so they can be done in parallel
+/// before the write transaction is opened. The validator only trusts them if the
+/// signer matches the one it expects; otherwise it falls back to a full check.
+#[derive(Clone, Default, PartialEq, Eq, Debug)]
+pub struct BlockPrecheck {
+    pub hash: BlockHash,
+    /// The key which produced a valid signature for this block
+    pub valid_signer: Option<PublicKey>,
+    pub difficulty: u64,
+}
+
+impl BlockPrecheck {
+    pub fn new(block: &Block, epochs: &Epochs, work: &WorkThresholds) -> Self {
+        Self::new_batch(&[block], epochs, work).pop().unwrap()
+    }
+
+    /// Prechecks many blocks at once. The signatures get verified as a batch
+    pub fn new_batch(blocks: &[&Block], epochs: &Epochs, work: &WorkThresholds) -> Vec<Self> {
+        let candidates: Vec<_> = blocks
+            .iter()
+            .map(|block| Self::signer_candidate(block, epochs))
+            .collect();
+
+        let mut batch = SignatureBatch::with_capacity(blocks.len());
+        for (block, candidate) in blocks.iter().zip(&candidates) {
+            if let Some(candidate) = candidate {
+                batch.add(*candidate, block.hash(), block.signature().clone());
+            }
+        }
+        let mut signatures_valid = batch.verify().into_iter();
+
+        blocks
+            .iter()
+            .zip(candidates)
+            .map(|(block, candidate)| {
+                let valid_signer = match candidate {
+                    Some(candidate) if signatures_valid.next().unwrap() => Some(candidate),
+                    _ => None,
+                };
+                Self {
+                    hash: block.hash(),
+                    valid_signer,
+                    difficulty: work.difficulty_block(block),
+                }
+            })
+            .collect()
+    }
+
+    /// Legacy blocks without an account field can only be checked
+    /// once the previous block was loaded from the ledger
+    fn signer_candidate(block: &Block, epochs: &Epochs) -> Option<PublicKey> {
+        let link = block.link_field().unwrap_or_default();
+        if epochs.is_epoch_link(&link) {
+            epochs.epoch_signer(&link).map(|signer| signer.into())
+        } else {
+            block.account_field().map(|account| account.into())
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ledger_constants::LEDGER_CONSTANTS_STUB;
+    use rsban_core::{work::WORK_THRESHOLDS_STUB, PrivateKey, Signature, TestBlockBuilder};
+
+    #[test]
+    fn valid_state_block() {
+        let key = PrivateKey::new();
+        let block = TestBlockBuilder::state().key(&key).build();
+        let precheck =
+            BlockPrecheck::new(&block, &LEDGER_CONSTANTS_STUB.epochs, &WORK_THRESHOLDS_STUB);
+        assert_eq!(precheck.hash, block.hash());
+        assert_eq!(precheck.valid_signer, Some(key.public_key()));
+        assert_eq!(
+            precheck.difficulty,
+            WORK_THRESHOLDS_STUB.difficulty_block(&block)
+        );
+    }
+
+    #[test]
+    fn bad_signature() {
+        let block = TestBlockBuilder::state()
+            .signature(Signature::from_bytes([1; 64]))
+            .build();
+        let precheck =
+            BlockPrecheck::new(&block, &LEDGER_CONSTANTS_STUB.epochs, &WORK_THRESHOLDS_STUB);
+        assert_eq!(precheck.valid_signer, None);
+    }
+
+    #[test]
+    fn legacy_block_without_account_field() {
+        let block = TestBlockBuilder::legacy_send().build();
+        let precheck =
+            BlockPrecheck::new(&block, &LEDGER_CONSTANTS_STUB.epochs, &WORK_THRESHOLDS_STUB);
+        assert_eq!(precheck.valid_signer, None);
+    }
+
+    #[test]
+    fn batch() {
+        let blocks: Vec<_> = (0..5u128)
+            .map(|i| TestBlockBuilder::state().balance(i).build())
+            .chain(std::iter::once(TestBlockBuilder::legacy_send().build()))
+            .chain(std::iter::once(
+                TestBlockBuilder::state()
+                    .signature(Signature::from_bytes([1; 64]))
+                    .build(),
+            ))
+            .collect();
+        let block_refs: Vec<_> = blocks.iter().collect();
+
+        let prechecks = BlockPrecheck::new_batch(
+            &block_refs,
+            &LEDGER_CONSTANTS_STUB.epochs,
+            &WORK_THRESHOLDS_STUB,
+        );
+
+        let signed: Vec<_> = prechecks.iter().map(|p| p.valid_signer.is_some()).collect();
+        assert_eq!(signed, vec![true, true, true, true, true, false, false]);
+        for (block, precheck) in blocks.iter().zip(&prechecks) {
+            assert_eq!(precheck.hash, block.hash());
+        }
+    }
+}
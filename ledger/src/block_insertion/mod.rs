@@ -1,7 +1,9 @@
 mod block_inserter;
+mod block_precheck;
 mod validation;
 mod validator_factory;
 
 pub(crate) use block_inserter::{BlockInsertInstructions, BlockInserter};
+pub use block_precheck::BlockPrecheck;
 pub(crate) use validation::BlockValidator;
 pub(crate) use validator_factory::BlockValidatorFactory;
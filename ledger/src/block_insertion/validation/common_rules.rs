@@ -12,6 +12,10 @@ impl<'a> BlockValidator<'a> {
     }
 
     pub(crate) fn ensure_valid_signature(&self) -> Result<(), BlockStatus> {
+        if self.signature_prechecked() {
+            return Ok(());
+        }
+
         let result = if self.is_epoch_block() {
             self.epochs.validate_epoch_signature(self.block)
         } else {
@@ -21,6 +25,23 @@ impl<'a> BlockValidator<'a> {
         result.map_err(|_| BlockStatus::BadSignature)
     }
 
+    /// The precheck can only be trusted if it verified the signature with the expected key
+    fn signature_prechecked(&self) -> bool {
+        let Some(valid_signer) = self.precheck.and_then(|p| p.valid_signer) else {
+            return false;
+        };
+
+        let expected_signer: Option<PublicKey> = if self.is_epoch_block() {
+            self.epochs
+                .epoch_signer(&self.block.link_field().unwrap_or_default())
+                .map(|signer| signer.into())
+        } else {
+            Some(self.account.into())
+        };
+
+        expected_signer == Some(valid_signer)
+    }
+
     pub(crate) fn ensure_account_exists_for_none_open_block(&self) -> Result<(), BlockStatus> {
         if !self.block.is_open() && self.is_new_account() {
             Err(BlockStatus::GapPrevious)
@@ -57,7 +78,12 @@ impl<'a> BlockValidator<'a> {
     }
 
     pub(crate) fn ensure_sufficient_work(&self) -> Result<(), BlockStatus> {
-        if !self.work.is_valid_pow(self.block, &self.block_details()) {
+        let difficulty = match self.precheck {
+            Some(precheck) => precheck.difficulty,
+            None => self.work.difficulty_block(self.block),
+        };
+
+        if difficulty < self.work.threshold(&self.block_details()) {
             Err(BlockStatus::InsufficientWork)
         } else {
             Ok(())
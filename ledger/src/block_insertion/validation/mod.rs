@@ -7,7 +7,7 @@ mod send_block_rules;
 #[cfg(test)]
 mod tests;
 
-use super::BlockInsertInstructions;
+use super::{BlockInsertInstructions, BlockPrecheck};
 use crate::BlockStatus;
 use rsban_core::{
     work::WorkThresholds, Account, AccountInfo, Block, Epochs, PendingInfo, SavedBlock,
@@ -26,6 +26,7 @@ pub(crate) struct BlockValidator<'a> {
     pub any_pending_exists: bool,
     pub source_block_exists: bool,
     pub seconds_since_epoch: u64,
+    pub precheck: Option<&'a BlockPrecheck>,
 }
 
 impl<'a> BlockValidator<'a> {
@@ -4,13 +4,16 @@ mod validate_legacy_change;
 mod validate_legacy_open;
 mod validate_legacy_receive;
 mod validate_legacy_send;
+mod validate_precheck;
 mod validate_state_change;
 mod validate_state_open;
 mod validate_state_receive;
 mod validate_state_send;
 
 use crate::{
-    block_insertion::BlockInsertInstructions, ledger_constants::LEDGER_CONSTANTS_STUB, BlockStatus,
+    block_insertion::{BlockInsertInstructions, BlockPrecheck},
+    ledger_constants::LEDGER_CONSTANTS_STUB,
+    BlockStatus,
 };
 use rsban_core::{
     work::WORK_THRESHOLDS_STUB, Account, Amount, Block, Epoch, PendingInfo, SavedAccountChain,
@@ -26,6 +29,7 @@ pub(crate) struct BlockValidationTest {
     block_already_exists: bool,
     source_block_missing: bool,
     previous_block_missing: bool,
+    precheck: Option<BlockPrecheck>,
 }
 impl BlockValidationTest {
     pub fn for_epoch0_account() -> Self {
@@ -60,6 +64,7 @@ impl BlockValidationTest {
             block_already_exists: false,
             source_block_missing: false,
             previous_block_missing: false,
+            precheck: None,
         }
     }
 
@@ -76,6 +81,11 @@ impl BlockValidationTest {
         self
     }
 
+    pub fn with_precheck(mut self, create_precheck: impl FnOnce(&Block) -> BlockPrecheck) -> Self {
+        self.precheck = Some(create_precheck(self.block()));
+        self
+    }
+
     pub fn previous_block_is_missing(mut self) -> Self {
         self.previous_block_missing = true;
         self
@@ -129,6 +139,7 @@ impl BlockValidationTest {
         }
         validator.block_exists = self.block_already_exists;
         validator.source_block_exists = !self.source_block_missing;
+        validator.precheck = self.precheck.as_ref();
         validator.validate()
     }
 }
@@ -146,5 +157,6 @@ fn new_test_validator<'a>(block: &'a Block, account: Account) -> BlockValidator
         any_pending_exists: false,
         source_block_exists: false,
         seconds_since_epoch: 123456,
+        precheck: None,
     }
 }
@@ -0,0 +1,46 @@
+use rsban_core::{work::WORK_THRESHOLDS_STUB, PublicKey, Signature};
+
+use crate::{
+    block_insertion::{validation::tests::BlockValidationTest, BlockPrecheck},
+    ledger_constants::LEDGER_CONSTANTS_STUB,
+    BlockStatus,
+};
+
+#[test]
+fn valid_precheck() {
+    BlockValidationTest::for_epoch0_account()
+        .block_to_validate(|chain| chain.new_send_block().amount_sent(1).build())
+        .with_precheck(|block| {
+            BlockPrecheck::new(block, &LEDGER_CONSTANTS_STUB.epochs, &WORK_THRESHOLDS_STUB)
+        })
+        .assert_is_valid();
+}
+
+#[test]
+fn precheck_with_unexpected_signer_falls_back_to_full_check() {
+    BlockValidationTest::for_epoch0_account()
+        .block_to_validate(|chain| {
+            chain
+                .new_send_block()
+                .amount_sent(1)
+                .signature(Signature::from_bytes([1; 64]))
+                .build()
+        })
+        .with_precheck(|block| BlockPrecheck {
+            hash: block.hash(),
+            valid_signer: Some(PublicKey::from(42)),
+            difficulty: WORK_THRESHOLDS_STUB.difficulty_block(block),
+        })
+        .assert_validation_fails_with(BlockStatus::BadSignature);
+}
+
+#[test]
+fn uses_prechecked_difficulty() {
+    BlockValidationTest::for_epoch0_account()
+        .block_to_validate(|chain| chain.new_send_block().amount_sent(1).build())
+        .with_precheck(|block| BlockPrecheck {
+            difficulty: 0,
+            ..BlockPrecheck::new(block, &LEDGER_CONSTANTS_STUB.epochs, &WORK_THRESHOLDS_STUB)
+        })
+        .assert_validation_fails_with(BlockStatus::InsufficientWork);
+}
@@ -3,17 +3,29 @@ use rsban_store_lmdb::Transaction;
 
 use crate::Ledger;
 
-use super::BlockValidator;
+use super::{BlockPrecheck, BlockValidator};
 
 pub(crate) struct BlockValidatorFactory<'a> {
     ledger: &'a Ledger,
     txn: &'a dyn Transaction,
     block: &'a Block,
+    precheck: Option<&'a BlockPrecheck>,
 }
 
 impl<'a> BlockValidatorFactory<'a> {
     pub(crate) fn new(ledger: &'a Ledger, txn: &'a dyn Transaction, block: &'a Block) -> Self {
-        Self { ledger, txn, block }
+        Self {
+            ledger,
+            txn,
+            block,
+            precheck: None,
+        }
+    }
+
+    pub(crate) fn precheck(mut self, precheck: &'a BlockPrecheck) -> Self {
+        debug_assert_eq!(precheck.hash, self.block.hash());
+        self.precheck = Some(precheck);
+        self
     }
 
     pub(crate) fn create_validator(&self) -> BlockValidator<'a> {
@@ -50,6 +62,7 @@ impl<'a> BlockValidatorFactory<'a> {
             source_block_exists,
             previous_block,
             seconds_since_epoch: seconds_since_epoch(),
+            precheck: self.precheck,
         }
     }
 
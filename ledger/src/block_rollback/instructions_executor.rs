@@ -34,6 +34,7 @@ impl<'a> RollbackInstructionsExecutor<'a> {
             .cache
             .block_count
             .fetch_sub(1, Ordering::SeqCst);
+        self.ledger.store.persist_counts(self.txn);
 
         self.ledger
             .observer
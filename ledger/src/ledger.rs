@@ -1,7 +1,8 @@
 use super::DependentBlocksFinder;
 use crate::{
-    block_cementer::BlockCementer,
-    block_insertion::{BlockInserter, BlockValidatorFactory},
+    block_cementer::{BlockCementer, ConfirmationPlan},
+    block_insertion::{BlockInserter, BlockPrecheck, BlockValidatorFactory},
+    ledger_counts::scan_counts,
     ledger_set_confirmed::LedgerSetConfirmed,
     BlockRollbackPerformer, GenerateCacheFlags, LedgerConstants, LedgerSetAny, RepWeightCache,
     RepWeightsUpdater, RepresentativeBlockFinder, WriteGuard, WriteQueue,
@@ -11,23 +12,25 @@ use rsban_core::{
     utils::{seconds_since_epoch, ContainerInfo},
     Account, AccountInfo, Amount, Block, BlockHash, BlockSubType, ConfirmationHeightInfo,
     DependentBlocks, Epoch, Link, PendingInfo, PendingKey, PublicKey, Root, SavedBlock,
+    SavedBlockView,
 };
 use rsban_store_lmdb::{
-    ConfiguredAccountDatabaseBuilder, ConfiguredBlockDatabaseBuilder,
+    CommitDurability, ConfiguredAccountDatabaseBuilder, ConfiguredBlockDatabaseBuilder,
     ConfiguredConfirmationHeightDatabaseBuilder, ConfiguredPeersDatabaseBuilder,
-    ConfiguredPendingDatabaseBuilder, ConfiguredPrunedDatabaseBuilder, LedgerCache,
-    LmdbAccountStore, LmdbBlockStore, LmdbConfirmationHeightStore, LmdbEnv, LmdbFinalVoteStore,
-    LmdbOnlineWeightStore, LmdbPeerStore, LmdbPendingStore, LmdbPrunedStore, LmdbReadTransaction,
-    LmdbRepWeightStore, LmdbStore, LmdbVersionStore, LmdbWriteTransaction, Transaction,
+    ConfiguredPendingDatabaseBuilder, ConfiguredPrunedDatabaseBuilder, LedgerCache, LedgerCounts,
+    LmdbAccountStore, LmdbBlockStore, LmdbConfirmationHeightStore, LmdbDelegatorStore, LmdbEnv,
+    LmdbFinalVoteStore, LmdbOnlineWeightStore, LmdbPeerStore, LmdbPendingStore, LmdbPrunedStore,
+    LmdbReadTransaction, LmdbRepWeightStore, LmdbStore, LmdbVersionStore, LmdbWriteTransaction,
+    Transaction,
 };
 use std::{
-    collections::HashMap,
+    collections::{HashMap, HashSet},
     net::SocketAddrV6,
     sync::{
         atomic::{AtomicBool, Ordering},
-        Arc,
+        Arc, Weak,
     },
-    time::{Duration, SystemTime},
+    time::{Duration, Instant, SystemTime},
 };
 
 #[derive(PartialEq, Eq, Debug, Clone, Copy, FromPrimitive)]
@@ -105,6 +108,8 @@ pub struct Ledger {
     pub observer: Arc<dyn LedgerObserver>,
     pruning: AtomicBool,
     pub write_queue: Arc<WriteQueue>,
+    /// The cache counters were loaded from the persisted counts instead of a table scan
+    counts_loaded: bool,
 }
 
 pub struct NullLedgerBuilder {
@@ -188,6 +193,7 @@ impl NullLedgerBuilder {
             block: Arc::new(LmdbBlockStore::new(env.clone()).unwrap()),
             confirmation_height: Arc::new(LmdbConfirmationHeightStore::new(env.clone()).unwrap()),
             final_vote: Arc::new(LmdbFinalVoteStore::new(env.clone()).unwrap()),
+            delegator: Arc::new(LmdbDelegatorStore::new(env.clone()).unwrap()),
             online_weight: Arc::new(LmdbOnlineWeightStore::new(env.clone()).unwrap()),
             peer: Arc::new(LmdbPeerStore::new(env.clone()).unwrap()),
             pending: Arc::new(LmdbPendingStore::new(env.clone()).unwrap()),
@@ -237,6 +243,7 @@ impl Ledger {
             observer: Arc::new(NullLedgerObserver::new()),
             pruning: AtomicBool::new(false),
             write_queue: Arc::new(WriteQueue::new()),
+            counts_loaded: false,
         };
 
         ledger.initialize(&GenerateCacheFlags::new())?;
@@ -248,6 +255,27 @@ impl Ledger {
         self.observer = observer;
     }
 
+    /// Writers flush their commits to disk together. See `WriteQueue::with_group_commit`.
+    /// Every write transaction of the store joins the group commit, not only the ones
+    /// committed with `Ledger::commit`
+    pub fn enable_group_commit(&mut self) {
+        let env = Arc::downgrade(&self.store.env);
+        self.write_queue =
+            Arc::new(WriteQueue::with_group_commit(Box::new(
+                move || match Weak::upgrade(&env) {
+                    Some(env) => env.sync(),
+                    None => Ok(()),
+                },
+            )));
+        let write_queue = Arc::clone(&self.write_queue);
+        self.store
+            .env
+            .set_durability(CommitDurability::Hook(Arc::new(move || {
+                let ticket = write_queue.committed();
+                write_queue.wait_durable(ticket);
+            })));
+    }
+
     pub fn read_txn(&self) -> LmdbReadTransaction {
         self.store.tx_begin_read()
     }
@@ -261,7 +289,33 @@ impl Ledger {
             self.add_genesis_block(&mut self.rw_txn());
         }
 
+        let persisted = self.store.version.get_counts(&self.read_txn());
+        match persisted {
+            Some(counts) => {
+                // The counts are validated later by `validate_counts`
+                self.store.cache.set_counts(&counts);
+                self.load_rep_weights();
+                self.counts_loaded = true;
+            }
+            None => {
+                self.generate_cache(generate_cache);
+                if generate_cache.block_count
+                    && generate_cache.account_count
+                    && generate_cache.cemented_count
+                {
+                    self.store.persist_counts(&mut self.rw_txn());
+                }
+            }
+        }
+
+        Ok(())
+    }
+
+    /// Calculates the cache counters and rep weights by scanning the tables
+    fn generate_cache(&self, generate_cache: &GenerateCacheFlags) {
         if generate_cache.reps || generate_cache.account_count || generate_cache.block_count {
+            // The weights of all chunks are published together
+            let _rep_weights_batch = self.rep_weights_updater.begin_batch();
             self.store.account.for_each_par(&|_txn, mut i, n| {
                 let mut block_count = 0;
                 let mut account_count = 0;
@@ -309,8 +363,32 @@ impl Ledger {
             .cache
             .pruned_count
             .fetch_add(self.store.pruned.count(&transaction), Ordering::SeqCst);
+    }
 
-        Ok(())
+    fn load_rep_weights(&self) {
+        let txn = self.read_txn();
+        let weights: HashMap<PublicKey, Amount> = self.store.rep_weight.iter(&txn).collect();
+        self.rep_weights_updater.copy_from(&weights);
+    }
+
+    /// Compares the persisted counts with a scan of the tables and corrects the
+    /// cache counters if they differ. The corrected counts are persisted with the
+    /// next write. This takes as long as a startup without persisted counts, so it
+    /// should run in the background. Returns false if the counts had to be corrected.
+    pub fn validate_counts(&self) -> bool {
+        if !self.counts_loaded {
+            return true;
+        }
+        let txn = self.read_txn();
+        let Some(persisted) = self.store.version.get_counts(&txn) else {
+            return true;
+        };
+        let actual = scan_counts(&self.store, &txn);
+        if actual == persisted {
+            return true;
+        }
+        self.store.cache.correct_counts(&persisted, &actual);
+        false
     }
 
     fn add_genesis_block(&self, txn: &mut LmdbWriteTransaction) {
@@ -337,9 +415,32 @@ impl Ledger {
                 epoch: Epoch::Epoch0,
             },
         );
+        self.store
+            .delegator
+            .put(txn, &genesis_account.into(), &genesis_account);
         self.store
             .rep_weight
             .put(txn, genesis_account.into(), Amount::MAX);
+        self.store.version.put_counts(
+            txn,
+            &LedgerCounts {
+                block_count: 1,
+                cemented_count: 1,
+                account_count: 1,
+                pruned_count: 0,
+            },
+        );
+    }
+
+    /// Commits the transaction and releases the write guard.
+    /// Returns once the commit is durable. The transaction can be renewed afterwards
+    pub fn commit(&self, write_guard: WriteGuard, tx: &mut LmdbWriteTransaction) {
+        let start = Instant::now();
+        tx.commit_deferred();
+        let ticket = self.write_queue.committed();
+        drop(write_guard);
+        self.write_queue.wait_durable(ticket);
+        self.write_queue.add_commit_latency(start.elapsed());
     }
 
     pub fn refresh_if_needed(
@@ -349,8 +450,7 @@ impl Ledger {
     ) -> (WriteGuard, LmdbWriteTransaction) {
         if tx.elapsed() > Duration::from_millis(500) {
             let writer = write_guard.writer;
-            tx.commit();
-            drop(write_guard);
+            self.commit(write_guard, &mut tx);
 
             let write_guard = self.write_queue.wait(writer);
             tx.renew();
@@ -533,6 +633,29 @@ impl Ledger {
                 .account_count
                 .fetch_sub(1, Ordering::SeqCst);
         }
+        self.update_delegator_index(txn, account, old_info, new_info);
+    }
+
+    /// Moves the account to its new representative in the delegator index.
+    /// An account without head block is not in the index.
+    fn update_delegator_index(
+        &self,
+        txn: &mut LmdbWriteTransaction,
+        account: &Account,
+        old_info: &AccountInfo,
+        new_info: &AccountInfo,
+    ) {
+        let old_rep = (!old_info.head.is_zero()).then_some(old_info.representative);
+        let new_rep = (!new_info.head.is_zero()).then_some(new_info.representative);
+        if old_rep == new_rep {
+            return;
+        }
+        if let Some(rep) = old_rep {
+            self.store.delegator.del(txn, &rep, account);
+        }
+        if let Some(rep) = new_rep {
+            self.store.delegator.put(txn, &rep, account);
+        }
     }
 
     pub fn pruning_action(
@@ -553,6 +676,7 @@ impl Ledger {
                 hash = block.previous();
                 pruned_count += 1;
                 self.store.cache.pruned_count.fetch_add(1, Ordering::SeqCst);
+                self.store.persist_counts(txn);
                 if pruned_count % batch_size == 0 {
                     txn.commit();
                     txn.renew();
@@ -577,6 +701,17 @@ impl Ledger {
         DependentBlocksFinder::new(self, txn).find_dependent_blocks(block)
     }
 
+    /// Same as `dependent_blocks`, but for a block that wasn't decoded
+    pub fn dependent_blocks_view(&self, block: &SavedBlockView) -> DependentBlocks {
+        block.dependent_blocks(&self.constants.epochs, &self.constants.genesis_account)
+    }
+
+    pub fn dependents_confirmed_view(&self, txn: &dyn Transaction, block: &SavedBlockView) -> bool {
+        self.dependent_blocks_view(block)
+            .iter()
+            .all(|hash| self.confirmed().block_exists_or_pruned(txn, hash))
+    }
+
     pub fn dependents_confirmed_for_unsaved_block(
         &self,
         txn: &dyn Transaction,
@@ -602,6 +737,8 @@ impl Ledger {
         txn: &mut LmdbWriteTransaction,
         block: &BlockHash,
     ) -> anyhow::Result<Vec<SavedBlock>> {
+        // A rollback may undo many blocks, publish their weight changes once
+        let _rep_weights_batch = self.rep_weights_updater.begin_batch();
         BlockRollbackPerformer::new(self, txn).roll_back(block)
     }
 
@@ -617,8 +754,31 @@ impl Ledger {
         txn: &mut LmdbWriteTransaction,
         block: &Block,
     ) -> Result<SavedBlock, BlockStatus> {
-        let validator = BlockValidatorFactory::new(self, txn, block).create_validator();
-        let instructions = validator.validate()?;
+        self.validate_and_insert(txn, block, None)
+    }
+
+    /// Same as `process`, but reuses the results of the stateless checks
+    /// that were already done outside of the write transaction
+    pub fn process_prechecked(
+        &self,
+        txn: &mut LmdbWriteTransaction,
+        block: &Block,
+        precheck: &BlockPrecheck,
+    ) -> Result<SavedBlock, BlockStatus> {
+        self.validate_and_insert(txn, block, Some(precheck))
+    }
+
+    fn validate_and_insert(
+        &self,
+        txn: &mut LmdbWriteTransaction,
+        block: &Block,
+        precheck: Option<&BlockPrecheck>,
+    ) -> Result<SavedBlock, BlockStatus> {
+        let mut factory = BlockValidatorFactory::new(self, txn, block);
+        if let Some(precheck) = precheck {
+            factory = factory.precheck(precheck);
+        }
+        let instructions = factory.create_validator().validate()?;
         let inserted = BlockInserter::new(self, txn, block, &instructions).insert();
         Ok(inserted)
     }
@@ -662,6 +822,34 @@ impl Ledger {
         )
     }
 
+    /// Read-only part of `confirm_max`: finds the blocks that have to be cemented to confirm
+    /// the target block, so this can run in parallel to the writer.
+    /// Blocks in `planned` are treated as if they were cemented already
+    pub fn plan_confirmation(
+        &self,
+        txn: &dyn Transaction,
+        target_hash: BlockHash,
+        max_blocks: usize,
+        planned: &mut HashSet<BlockHash>,
+    ) -> ConfirmationPlan {
+        BlockCementer::new(&self.store, self.observer.as_ref(), &self.constants).plan(
+            txn,
+            target_hash,
+            max_blocks,
+            planned,
+        )
+    }
+
+    /// Cements the blocks of a plan from `plan_confirmation`.
+    /// Returns the newly cemented blocks and false if the plan became invalid
+    pub fn apply_confirmation(
+        &self,
+        txn: &mut LmdbWriteTransaction,
+        plan: ConfirmationPlan,
+    ) -> (Vec<SavedBlock>, bool) {
+        BlockCementer::new(&self.store, self.observer.as_ref(), &self.constants).apply(txn, plan)
+    }
+
     pub fn cemented_count(&self) -> u64 {
         self.store.cache.cemented_count.load(Ordering::SeqCst)
     }
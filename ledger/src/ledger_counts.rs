@@ -0,0 +1,75 @@
+use rsban_store_lmdb::{LedgerCounts, LmdbStore, Transaction};
+
+/// Calculates the ledger counters by scanning the account, confirmation height
+/// and pruned tables
+pub(crate) fn scan_counts(store: &LmdbStore, txn: &dyn Transaction) -> LedgerCounts {
+    let mut counts = LedgerCounts::default();
+    for (_, info) in store.account.iter(txn) {
+        counts.block_count += info.block_count;
+        counts.account_count += 1;
+    }
+
+    let mut it = store.confirmation_height.begin(txn);
+    while let Some((_, info)) = it.current() {
+        counts.cemented_count += info.height;
+        it.next();
+    }
+
+    counts.pruned_count = store.pruned.count(txn);
+    counts
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{ledger_constants::LEDGER_CONSTANTS_STUB, Ledger, LedgerContext, RepWeightCache};
+    use rsban_core::Amount;
+    use std::sync::Arc;
+
+    #[test]
+    fn scan_empty_ledger() {
+        let ctx = LedgerContext::empty();
+        let txn = ctx.ledger.read_txn();
+        assert_eq!(
+            scan_counts(&ctx.ledger.store, &txn),
+            LedgerCounts {
+                block_count: 1,
+                cemented_count: 1,
+                account_count: 1,
+                pruned_count: 0
+            }
+        );
+        assert!(ctx.ledger.validate_counts());
+    }
+
+    #[test]
+    fn correct_inconsistent_persisted_counts() {
+        let ctx = LedgerContext::empty();
+        let wrong = LedgerCounts {
+            block_count: 5,
+            cemented_count: 3,
+            account_count: 2,
+            pruned_count: 1,
+        };
+        ctx.ledger
+            .store
+            .version
+            .put_counts(&mut ctx.ledger.rw_txn(), &wrong);
+        ctx.ledger.store.cache.reset();
+
+        let ledger = Ledger::new(
+            ctx.ledger.store.clone(),
+            LEDGER_CONSTANTS_STUB.clone(),
+            Amount::zero(),
+            Arc::new(RepWeightCache::new()),
+        )
+        .unwrap();
+        assert_eq!(ledger.block_count(), 5);
+
+        assert_eq!(ledger.validate_counts(), false);
+        assert_eq!(ledger.block_count(), 1);
+        assert_eq!(ledger.cemented_count(), 1);
+        assert_eq!(ledger.account_count(), 1);
+        assert_eq!(ledger.pruned_count(), 0);
+    }
+}
@@ -1,6 +1,7 @@
 use rsban_core::{
     utils::{BufferReader, Deserialize},
     Account, AccountInfo, Amount, BlockHash, PendingInfo, PendingKey, QualifiedRoot, SavedBlock,
+    SavedBlockView,
 };
 use rsban_store_lmdb::{LmdbIterator, LmdbPendingStore, LmdbStore, Transaction};
 use std::ops::{Deref, RangeBounds};
@@ -18,6 +19,15 @@ impl<'a> LedgerSetAny<'a> {
         self.store.block.get(tx, hash)
     }
 
+    /// Borrows the block from the database without decoding it
+    pub fn get_block_view<'txn>(
+        &self,
+        tx: &'txn dyn Transaction,
+        hash: &BlockHash,
+    ) -> Option<SavedBlockView<'txn>> {
+        self.store.block.get_view(tx, hash)
+    }
+
     pub fn get_account(&self, tx: &dyn Transaction, account: &Account) -> Option<AccountInfo> {
         self.store.account.get(tx, account)
     }
@@ -28,20 +38,20 @@ impl<'a> LedgerSetAny<'a> {
 
     pub fn account_balance(&self, tx: &dyn Transaction, account: &Account) -> Option<Amount> {
         let head = self.account_head(tx, account)?;
-        self.get_block(tx, &head).map(|b| b.balance())
+        self.get_block_view(tx, &head).map(|b| b.balance())
     }
 
     pub fn account_height(&self, tx: &dyn Transaction, account: &Account) -> u64 {
         let Some(head) = self.account_head(tx, account) else {
             return 0;
         };
-        self.get_block(tx, &head)
+        self.get_block_view(tx, &head)
             .map(|b| b.height())
             .expect("Head block not in ledger!")
     }
 
     pub fn block_account(&self, tx: &dyn Transaction, hash: &BlockHash) -> Option<Account> {
-        self.get_block(tx, hash).map(|b| b.account())
+        self.get_block_view(tx, hash).map(|b| b.account())
     }
 
     pub fn block_amount(&self, tx: &dyn Transaction, hash: &BlockHash) -> Option<Amount> {
@@ -68,7 +78,7 @@ impl<'a> LedgerSetAny<'a> {
             return None;
         }
 
-        self.get_block(tx, hash).map(|b| b.balance())
+        self.get_block_view(tx, hash).map(|b| b.balance())
     }
 
     pub fn block_exists(&self, tx: &dyn Transaction, hash: &BlockHash) -> bool {
@@ -84,7 +94,7 @@ impl<'a> LedgerSetAny<'a> {
     }
 
     pub fn block_height(&self, tx: &dyn Transaction, hash: &BlockHash) -> u64 {
-        self.get_block(tx, hash)
+        self.get_block_view(tx, hash)
             .map(|b| b.height())
             .unwrap_or_default()
     }
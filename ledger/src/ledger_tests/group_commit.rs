@@ -0,0 +1,111 @@
+use crate::{ledger_constants::LEDGER_CONSTANTS_STUB, Ledger, RepWeightCache, Writer};
+use rsban_core::{
+    utils::{TEST_ENDPOINT_1, TEST_ENDPOINT_2},
+    Amount,
+};
+use rsban_store_lmdb::{EnvOptions, LmdbConfig, LmdbStore, SyncStrategy, TestDbFile};
+use std::{sync::Arc, time::SystemTime};
+
+#[test]
+fn commit_of_other_writers_is_durable() {
+    let (ledger, _db_file) = group_commit_ledger();
+
+    let mut txn = ledger.rw_txn();
+    ledger
+        .store
+        .peer
+        .put(&mut txn, TEST_ENDPOINT_1, SystemTime::now());
+    txn.commit();
+
+    assert_eq!(ledger.write_queue.sync_count(), 1);
+}
+
+#[test]
+fn dropped_write_txn_is_durable() {
+    let (ledger, _db_file) = group_commit_ledger();
+
+    {
+        let mut txn = ledger.rw_txn();
+        ledger
+            .store
+            .peer
+            .put(&mut txn, TEST_ENDPOINT_1, SystemTime::now());
+    }
+
+    assert_eq!(ledger.write_queue.sync_count(), 1);
+}
+
+#[test]
+fn ledger_commit_syncs_once() {
+    let (ledger, _db_file) = group_commit_ledger();
+
+    let guard = ledger.write_queue.wait(Writer::Testing);
+    let mut txn = ledger.rw_txn();
+    ledger
+        .store
+        .peer
+        .put(&mut txn, TEST_ENDPOINT_1, SystemTime::now());
+    ledger.commit(guard, &mut txn);
+    txn.renew();
+    drop(txn);
+
+    assert_eq!(ledger.write_queue.sync_count(), 1);
+}
+
+#[test]
+fn two_writers_share_one_sync() {
+    let (ledger, _db_file) = group_commit_ledger();
+
+    let mut txn1 = ledger.rw_txn();
+    ledger
+        .store
+        .peer
+        .put(&mut txn1, TEST_ENDPOINT_1, SystemTime::now());
+    txn1.commit_deferred();
+    let ticket1 = ledger.write_queue.committed();
+
+    let guard = ledger.write_queue.wait(Writer::Testing);
+    let mut txn2 = ledger.rw_txn();
+    ledger
+        .store
+        .peer
+        .put(&mut txn2, TEST_ENDPOINT_2, SystemTime::now());
+    ledger.commit(guard, &mut txn2);
+    ledger.write_queue.wait_durable(ticket1);
+
+    assert_eq!(ledger.write_queue.sync_count(), 1);
+}
+
+#[test]
+fn read_only_write_txn_does_not_sync() {
+    let (ledger, _db_file) = group_commit_ledger();
+
+    let mut txn = ledger.rw_txn();
+    txn.commit();
+
+    assert_eq!(ledger.write_queue.sync_count(), 0);
+}
+
+fn group_commit_ledger() -> (Ledger, TestDbFile) {
+    let db_file = TestDbFile::random();
+    let options = EnvOptions {
+        config: LmdbConfig {
+            sync: SyncStrategy::GroupCommit,
+            ..Default::default()
+        },
+        use_no_mem_init: false,
+    };
+    let store = LmdbStore::open(&db_file.path)
+        .options(&options)
+        .build()
+        .unwrap();
+    let mut ledger = Ledger::new(
+        Arc::new(store),
+        LEDGER_CONSTANTS_STUB.clone(),
+        Amount::zero(),
+        Arc::new(RepWeightCache::new()),
+    )
+    .unwrap();
+    ledger.enable_group_commit();
+    (ledger, db_file)
+}
@@ -1,4 +1,7 @@
-use std::sync::{atomic::Ordering, Arc};
+use std::{
+    collections::HashSet,
+    sync::{atomic::Ordering, Arc},
+};
 pub mod helpers;
 use crate::{
     ledger_constants::{DEV_GENESIS_BLOCK, DEV_GENESIS_PUB_KEY, LEDGER_CONSTANTS_STUB},
@@ -7,11 +10,12 @@ use crate::{
 };
 use rsban_core::{
     utils::{new_test_timestamp, TEST_ENDPOINT_1},
-    Account, Amount, BlockHash, PublicKey, QualifiedRoot, Root, SavedAccountChain,
-    TestBlockBuilder, DEV_GENESIS_KEY,
+    Account, Amount, BlockHash, PrivateKey, PublicKey, QualifiedRoot, Root, SavedAccountChain,
+    TestBlockBuilder, UnsavedBlockLatticeBuilder, DEV_GENESIS_KEY,
 };
 
 mod empty_ledger;
+mod group_commit;
 mod pruning;
 mod receivable_iteration;
 mod rollback_legacy_change;
@@ -566,6 +570,59 @@ fn block_confirmed() {
     );
 }
 
+#[test]
+fn plan_and_apply_confirmation() {
+    let ctx = LedgerContext::empty_dev();
+    let mut lattice = UnsavedBlockLatticeBuilder::new();
+    let destination = PrivateKey::new();
+    let send = lattice.genesis().send(&destination, Amount::raw(1));
+    let open = lattice.account(&destination).receive(&send);
+    let mut txn = ctx.ledger.rw_txn();
+    ctx.ledger.process(&mut txn, &send).unwrap();
+    ctx.ledger.process(&mut txn, &open).unwrap();
+
+    let mut planned = HashSet::new();
+    let plan = ctx
+        .ledger
+        .plan_confirmation(&txn, open.hash(), 1024, &mut planned);
+
+    // Planning doesn't cement anything
+    let hashes: Vec<_> = plan.blocks.iter().map(|b| b.hash()).collect();
+    assert_eq!(hashes, vec![send.hash(), open.hash()]);
+    assert_eq!(planned, HashSet::from([send.hash(), open.hash()]));
+    assert!(!ctx.ledger.confirmed().block_exists(&txn, &send.hash()));
+
+    let (cemented, complete) = ctx.ledger.apply_confirmation(&mut txn, plan.clone());
+    assert!(complete);
+    assert_eq!(cemented.len(), 2);
+    assert!(ctx.ledger.confirmed().block_exists(&txn, &open.hash()));
+
+    // Applying the same plan again doesn't cement anything
+    let (cemented, complete) = ctx.ledger.apply_confirmation(&mut txn, plan);
+    assert!(complete);
+    assert!(cemented.is_empty());
+}
+
+#[test]
+fn plan_confirmation_skips_planned_blocks() {
+    let ctx = LedgerContext::empty_dev();
+    let mut lattice = UnsavedBlockLatticeBuilder::new();
+    let destination = PrivateKey::new();
+    let send = lattice.genesis().send(&destination, Amount::raw(1));
+    let open = lattice.account(&destination).receive(&send);
+    let mut txn = ctx.ledger.rw_txn();
+    ctx.ledger.process(&mut txn, &send).unwrap();
+    ctx.ledger.process(&mut txn, &open).unwrap();
+
+    let mut planned = HashSet::from([send.hash()]);
+    let plan = ctx
+        .ledger
+        .plan_confirmation(&txn, open.hash(), 1024, &mut planned);
+
+    let hashes: Vec<_> = plan.blocks.iter().map(|b| b.hash()).collect();
+    assert_eq!(hashes, vec![open.hash()]);
+}
+
 #[test]
 fn ledger_cache() {
     let ctx = LedgerContext::empty();
@@ -637,6 +694,7 @@ fn ledger_cache() {
                 .cache
                 .cemented_count
                 .fetch_add(1, Ordering::Relaxed);
+            ctx.ledger.store.persist_counts(&mut txn);
             expected.cemented_count += 1;
         }
         cache_check(&ctx.ledger, &expected);
@@ -649,6 +707,7 @@ fn ledger_cache() {
                 .cache
                 .cemented_count
                 .fetch_add(1, Ordering::Relaxed);
+            ctx.ledger.store.persist_counts(&mut txn);
             expected.cemented_count += 1;
         }
         cache_check(&ctx.ledger, &expected);
@@ -661,6 +720,7 @@ fn ledger_cache() {
                 .cache
                 .pruned_count
                 .fetch_add(1, Ordering::Relaxed);
+            ctx.ledger.store.persist_counts(&mut txn);
             expected.pruned_count += 1;
         }
         cache_check(&ctx.ledger, &expected);
@@ -12,9 +12,11 @@ mod generate_cache_flags;
 mod ledger;
 mod ledger_constants;
 mod ledger_context;
+mod ledger_counts;
 mod ledger_set_any;
 mod ledger_set_confirmed;
 mod rep_weight_cache;
+mod rep_weight_table;
 mod rep_weights_updater;
 mod representative_block_finder;
 mod write_queue;
@@ -22,6 +24,8 @@ mod write_queue;
 #[cfg(test)]
 mod ledger_tests;
 
+pub use block_cementer::ConfirmationPlan;
+pub use block_insertion::BlockPrecheck;
 pub(crate) use block_rollback::BlockRollbackPerformer;
 pub use dependent_blocks_finder::*;
 pub use generate_cache_flags::GenerateCacheFlags;
@@ -33,6 +37,7 @@ pub use ledger_context::LedgerContext;
 pub use ledger_set_any::*;
 pub use ledger_set_confirmed::*;
 pub use rep_weight_cache::*;
+pub use rep_weight_table::RepWeightTable;
 pub use rep_weights_updater::*;
 pub(crate) use representative_block_finder::RepresentativeBlockFinder;
-pub use write_queue::{WriteGuard, WriteQueue, Writer};
+pub use write_queue::{CommitLatencyPercentiles, WriteGuard, WriteQueue, Writer};
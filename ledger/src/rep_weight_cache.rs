@@ -1,20 +1,24 @@
+use crate::RepWeightTable;
+use arc_swap::ArcSwap;
 use rsban_core::{utils::ContainerInfo, Account, Amount, PublicKey};
 use rsban_store_lmdb::LedgerCache;
 use std::{
-    collections::HashMap,
+    collections::BTreeMap,
     mem::size_of,
     sync::{
         atomic::{AtomicBool, Ordering},
-        Arc, RwLock, RwLockReadGuard,
+        Arc, Mutex,
     },
 };
 
 /// Returns the cached vote weight for the given representative.
 /// If the weight is below the cache limit it returns 0.
 /// During bootstrap it returns the preconfigured bootstrap weights.
+///
+/// Readers never take a lock: they load the last published snapshot.
 pub struct RepWeightCache {
-    weights: Arc<RwLock<HashMap<PublicKey, Amount>>>,
-    bootstrap_weights: RwLock<HashMap<PublicKey, Amount>>,
+    weights: Arc<PublishedRepWeights>,
+    bootstrap_weights: Arc<RepWeightTable>,
     max_blocks: u64,
     ledger_cache: Arc<LedgerCache>,
     check_bootstrap_weights: AtomicBool,
@@ -23,8 +27,8 @@ pub struct RepWeightCache {
 impl RepWeightCache {
     pub fn new() -> Self {
         Self {
-            weights: Arc::new(RwLock::new(HashMap::new())),
-            bootstrap_weights: RwLock::new(HashMap::new()),
+            weights: Arc::new(PublishedRepWeights::new()),
+            bootstrap_weights: Arc::new(RepWeightTable::new()),
             max_blocks: 0,
             ledger_cache: Arc::new(LedgerCache::new()),
             check_bootstrap_weights: AtomicBool::new(false),
@@ -32,24 +36,26 @@ impl RepWeightCache {
     }
 
     pub fn with_bootstrap_weights(
-        bootstrap_weights: HashMap<PublicKey, Amount>,
+        bootstrap_weights: RepWeightTable,
         max_blocks: u64,
         ledger_cache: Arc<LedgerCache>,
     ) -> Self {
         Self {
-            weights: Arc::new(RwLock::new(HashMap::new())),
-            bootstrap_weights: RwLock::new(bootstrap_weights),
+            weights: Arc::new(PublishedRepWeights::new()),
+            bootstrap_weights: Arc::new(bootstrap_weights),
             max_blocks,
             ledger_cache,
             check_bootstrap_weights: AtomicBool::new(true),
         }
     }
 
-    pub fn read(&self) -> RwLockReadGuard<HashMap<PublicKey, Amount>> {
+    /// Returns a snapshot of the current weights. The snapshot doesn't change
+    /// when the weights are updated afterwards
+    pub fn read(&self) -> Arc<RepWeightTable> {
         if self.use_bootstrap_weights() {
-            self.bootstrap_weights.read().unwrap()
+            Arc::clone(&self.bootstrap_weights)
         } else {
-            self.weights.read().unwrap()
+            self.weights.snapshot.load_full()
         }
     }
 
@@ -65,26 +71,19 @@ impl RepWeightCache {
     }
 
     pub fn weight(&self, rep: &PublicKey) -> Amount {
-        let weights = if self.use_bootstrap_weights() {
-            &self.bootstrap_weights
+        if self.use_bootstrap_weights() {
+            self.bootstrap_weights.weight(rep)
         } else {
-            &self.weights
-        };
-
-        weights
-            .read()
-            .unwrap()
-            .get(rep)
-            .cloned()
-            .unwrap_or_default()
+            self.weights.snapshot.load().weight(rep)
+        }
     }
 
     pub fn bootstrap_weight_max_blocks(&self) -> u64 {
         self.max_blocks
     }
 
-    pub fn bootstrap_weights(&self) -> HashMap<PublicKey, Amount> {
-        self.bootstrap_weights.read().unwrap().clone()
+    pub fn bootstrap_weights(&self) -> Arc<RepWeightTable> {
+        Arc::clone(&self.bootstrap_weights)
     }
 
     pub fn block_count(&self) -> u64 {
@@ -92,14 +91,16 @@ impl RepWeightCache {
     }
 
     pub fn len(&self) -> usize {
-        self.weights.read().unwrap().len()
+        self.weights.snapshot.load().len()
     }
 
     pub fn set(&self, account: PublicKey, weight: Amount) {
-        self.weights.write().unwrap().insert(account, weight);
+        self.weights.modify(|weights| {
+            weights.insert(account, weight);
+        });
     }
 
-    pub(super) fn inner(&self) -> Arc<RwLock<HashMap<PublicKey, Amount>>> {
+    pub(super) fn inner(&self) -> Arc<PublishedRepWeights> {
         self.weights.clone()
     }
 
@@ -107,3 +108,159 @@ impl RepWeightCache {
         [("rep_weights", self.len(), size_of::<(Account, Amount)>())].into()
     }
 }
+
+/// The writer side of the rep weights. All changes are applied to the
+/// pending weights and then published as a new immutable snapshot.
+/// While a batch is open the snapshot is only published when the batch ends.
+///
+/// Publishing copies the whole table, so writers which change many weights
+/// (block processing, rollbacks, cache generation) have to open a batch.
+/// A single change outside a batch costs one copy of the table.
+pub(crate) struct PublishedRepWeights {
+    pending: Mutex<PendingRepWeights>,
+    snapshot: ArcSwap<RepWeightTable>,
+}
+
+#[derive(Default)]
+struct PendingRepWeights {
+    weights: BTreeMap<PublicKey, Amount>,
+    open_batches: usize,
+    modified: bool,
+}
+
+impl PublishedRepWeights {
+    fn new() -> Self {
+        Self {
+            pending: Mutex::new(PendingRepWeights::default()),
+            snapshot: ArcSwap::from_pointee(RepWeightTable::new()),
+        }
+    }
+
+    pub fn modify(&self, f: impl FnOnce(&mut BTreeMap<PublicKey, Amount>)) {
+        let mut pending = self.pending.lock().unwrap();
+        f(&mut pending.weights);
+        if pending.open_batches == 0 {
+            self.publish(&pending);
+        } else {
+            pending.modified = true;
+        }
+    }
+
+    pub fn begin_batch(&self) {
+        self.pending.lock().unwrap().open_batches += 1;
+    }
+
+    pub fn end_batch(&self) {
+        let mut pending = self.pending.lock().unwrap();
+        pending.open_batches -= 1;
+        if pending.open_batches == 0 && pending.modified {
+            pending.modified = false;
+            self.publish(&pending);
+        }
+    }
+
+    /// Publishing while the pending lock is held guarantees that an older
+    /// snapshot never overwrites a newer one
+    fn publish(&self, pending: &PendingRepWeights) {
+        self.snapshot
+            .store(Arc::new(RepWeightTable::from(&pending.weights)));
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn snapshot_is_immutable() {
+        let cache = RepWeightCache::new();
+        let rep = PublicKey::from(1);
+        cache.set(rep, Amount::raw(1));
+        let snapshot = cache.read();
+
+        cache.set(rep, Amount::raw(2));
+
+        assert_eq!(snapshot.weight(&rep), Amount::raw(1));
+        assert_eq!(cache.weight(&rep), Amount::raw(2));
+    }
+
+    #[test]
+    fn publish_when_batch_ends() {
+        let cache = RepWeightCache::new();
+        let weights = cache.inner();
+        let rep = PublicKey::from(1);
+
+        weights.begin_batch();
+        cache.set(rep, Amount::raw(1));
+        assert_eq!(cache.weight(&rep), Amount::zero());
+        assert_eq!(cache.len(), 0);
+
+        weights.end_batch();
+        assert_eq!(cache.weight(&rep), Amount::raw(1));
+        assert_eq!(cache.len(), 1);
+    }
+
+    #[test]
+    fn nested_batches() {
+        let cache = RepWeightCache::new();
+        let weights = cache.inner();
+        let rep = PublicKey::from(1);
+
+        weights.begin_batch();
+        weights.begin_batch();
+        cache.set(rep, Amount::raw(1));
+        weights.end_batch();
+        assert_eq!(cache.weight(&rep), Amount::zero());
+
+        weights.end_batch();
+        assert_eq!(cache.weight(&rep), Amount::raw(1));
+    }
+
+    #[test]
+    fn publish_change_outside_batch_immediately() {
+        let cache = RepWeightCache::new();
+        let rep = PublicKey::from(1);
+
+        cache.set(rep, Amount::raw(1));
+        let snapshot = cache.read();
+
+        assert_eq!(snapshot.weight(&rep), Amount::raw(1));
+        assert!(Arc::ptr_eq(&snapshot, &cache.read()));
+    }
+
+    #[test]
+    fn publish_changes_from_before_a_batch() {
+        let cache = RepWeightCache::new();
+        let weights = cache.inner();
+        let rep1 = PublicKey::from(1);
+        let rep2 = PublicKey::from(2);
+
+        cache.set(rep1, Amount::raw(1));
+        weights.begin_batch();
+        cache.set(rep2, Amount::raw(2));
+
+        assert_eq!(cache.weight(&rep1), Amount::raw(1));
+        assert_eq!(cache.weight(&rep2), Amount::zero());
+
+        weights.end_batch();
+        assert_eq!(cache.weight(&rep2), Amount::raw(2));
+    }
+
+    #[test]
+    fn use_bootstrap_weights() {
+        let rep = PublicKey::from(1);
+        let ledger_cache = Arc::new(LedgerCache::new());
+        let cache = RepWeightCache::with_bootstrap_weights(
+            [(rep, Amount::raw(100))].into_iter().collect(),
+            2,
+            Arc::clone(&ledger_cache),
+        );
+        cache.set(rep, Amount::raw(1));
+        assert_eq!(cache.weight(&rep), Amount::raw(100));
+        assert_eq!(cache.read().weight(&rep), Amount::raw(100));
+
+        ledger_cache.block_count.store(2, Ordering::SeqCst);
+        assert_eq!(cache.weight(&rep), Amount::raw(1));
+        assert_eq!(cache.read().weight(&rep), Amount::raw(1));
+    }
+}
@@ -0,0 +1,125 @@
+use rsban_core::{Amount, PublicKey};
+use std::collections::{BTreeMap, HashMap};
+
+/// Immutable representative weights, sorted by representative.
+/// Lookups are a binary search over a single contiguous allocation.
+#[derive(Clone, Default, PartialEq, Eq, Debug)]
+pub struct RepWeightTable {
+    entries: Vec<(PublicKey, Amount)>,
+}
+
+impl RepWeightTable {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Creates the table from entries in any order.
+    /// If a representative occurs multiple times the last entry wins.
+    pub fn from_unsorted(mut entries: Vec<(PublicKey, Amount)>) -> Self {
+        entries.sort_by_key(|(rep, _)| *rep);
+        entries.dedup_by(|next, retained| {
+            if next.0 == retained.0 {
+                retained.1 = next.1;
+                true
+            } else {
+                false
+            }
+        });
+        Self { entries }
+    }
+
+    pub fn get(&self, rep: &PublicKey) -> Option<&Amount> {
+        self.entries
+            .binary_search_by_key(rep, |(r, _)| *r)
+            .ok()
+            .map(|i| &self.entries[i].1)
+    }
+
+    pub fn weight(&self, rep: &PublicKey) -> Amount {
+        self.get(rep).cloned().unwrap_or_default()
+    }
+
+    /// Iterates in ascending order of the representative
+    pub fn iter(&self) -> impl Iterator<Item = (&PublicKey, &Amount)> {
+        self.entries.iter().map(|(rep, weight)| (rep, weight))
+    }
+
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+}
+
+impl From<&BTreeMap<PublicKey, Amount>> for RepWeightTable {
+    fn from(weights: &BTreeMap<PublicKey, Amount>) -> Self {
+        // Already sorted, so no need to sort again
+        Self {
+            entries: weights.iter().map(|(r, w)| (*r, *w)).collect(),
+        }
+    }
+}
+
+impl From<HashMap<PublicKey, Amount>> for RepWeightTable {
+    fn from(weights: HashMap<PublicKey, Amount>) -> Self {
+        Self::from_unsorted(weights.into_iter().collect())
+    }
+}
+
+impl FromIterator<(PublicKey, Amount)> for RepWeightTable {
+    fn from_iter<T: IntoIterator<Item = (PublicKey, Amount)>>(iter: T) -> Self {
+        Self::from_unsorted(iter.into_iter().collect())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn empty() {
+        let table = RepWeightTable::new();
+        assert!(table.is_empty());
+        assert_eq!(table.get(&PublicKey::from(1)), None);
+        assert_eq!(table.weight(&PublicKey::from(1)), Amount::zero());
+    }
+
+    #[test]
+    fn lookup() {
+        let table = RepWeightTable::from_unsorted(vec![
+            (PublicKey::from(3), Amount::raw(30)),
+            (PublicKey::from(1), Amount::raw(10)),
+            (PublicKey::from(2), Amount::raw(20)),
+        ]);
+        assert_eq!(table.len(), 3);
+        assert_eq!(table.weight(&PublicKey::from(1)), Amount::raw(10));
+        assert_eq!(table.weight(&PublicKey::from(2)), Amount::raw(20));
+        assert_eq!(table.weight(&PublicKey::from(3)), Amount::raw(30));
+        assert_eq!(table.get(&PublicKey::from(4)), None);
+    }
+
+    #[test]
+    fn iterate_sorted() {
+        let table: RepWeightTable = [
+            (PublicKey::from(2), Amount::raw(20)),
+            (PublicKey::from(1), Amount::raw(10)),
+        ]
+        .into_iter()
+        .collect();
+        let reps: Vec<_> = table.iter().map(|(rep, _)| *rep).collect();
+        assert_eq!(reps, vec![PublicKey::from(1), PublicKey::from(2)]);
+    }
+
+    #[test]
+    fn last_duplicate_wins() {
+        let table = RepWeightTable::from_unsorted(vec![
+            (PublicKey::from(1), Amount::raw(10)),
+            (PublicKey::from(1), Amount::raw(11)),
+            (PublicKey::from(1), Amount::raw(12)),
+        ]);
+        assert_eq!(table.len(), 1);
+        assert_eq!(table.weight(&PublicKey::from(1)), Amount::raw(12));
+    }
+}
@@ -1,12 +1,12 @@
-use crate::RepWeightCache;
+use crate::{rep_weight_cache::PublishedRepWeights, RepWeightCache};
 use rsban_core::{Amount, PublicKey};
 use rsban_store_lmdb::{LmdbRepWeightStore, LmdbWriteTransaction};
-use std::collections::HashMap;
-use std::sync::{Arc, RwLock};
+use std::collections::{BTreeMap, HashMap};
+use std::sync::Arc;
 
 /// Updates the representative weights in the ledger and in the in-memory cache
 pub struct RepWeightsUpdater {
-    weight_cache: Arc<RwLock<HashMap<PublicKey, Amount>>>,
+    weight_cache: Arc<PublishedRepWeights>,
     store: Arc<LmdbRepWeightStore>,
     min_weight: Amount,
 }
@@ -20,16 +20,26 @@ impl RepWeightsUpdater {
         }
     }
 
+    /// Collects all cache updates until the returned guard is dropped,
+    /// so that readers see the weights of a whole batch at once
+    pub fn begin_batch(&self) -> RepWeightsBatch<'_> {
+        self.weight_cache.begin_batch();
+        RepWeightsBatch {
+            weight_cache: &self.weight_cache,
+        }
+    }
+
     /// Only use this method when loading rep weights from the database table
     pub fn copy_from(&self, other: &HashMap<PublicKey, Amount>) {
-        let mut guard_this = self.weight_cache.write().unwrap();
-        for (account, amount) in other {
-            let prev_amount = self.get(&guard_this, account);
-            self.put_cache(&mut guard_this, *account, prev_amount.wrapping_add(*amount));
-        }
+        self.weight_cache.modify(|weights| {
+            for (account, amount) in other {
+                let prev_amount = self.get(weights, account);
+                self.put_cache(weights, *account, prev_amount.wrapping_add(*amount));
+            }
+        });
     }
 
-    fn get(&self, weights: &HashMap<PublicKey, Amount>, account: &PublicKey) -> Amount {
+    fn get(&self, weights: &BTreeMap<PublicKey, Amount>, account: &PublicKey) -> Amount {
         weights.get(account).cloned().unwrap_or_default()
     }
 
@@ -42,13 +52,14 @@ impl RepWeightsUpdater {
         let previous_weight = self.store.get(tx, &representative).unwrap_or_default();
         let new_weight = previous_weight.wrapping_add(amount);
         self.put_store(tx, representative, previous_weight, new_weight);
-        let mut guard = self.weight_cache.write().unwrap();
-        self.put_cache(&mut guard, representative, new_weight);
+        self.weight_cache.modify(|weights| {
+            self.put_cache(weights, representative, new_weight);
+        });
     }
 
     fn put_cache(
         &self,
-        weights: &mut HashMap<PublicKey, Amount>,
+        weights: &mut BTreeMap<PublicKey, Amount>,
         representative: PublicKey,
         new_weight: Amount,
     ) {
@@ -77,8 +88,9 @@ impl RepWeightsUpdater {
 
     /// Only use this method when loading rep weights from the database table!
     pub fn representation_put(&self, representative: PublicKey, weight: Amount) {
-        let mut guard = self.weight_cache.write().unwrap();
-        self.put_cache(&mut guard, representative, weight);
+        self.weight_cache.modify(|weights| {
+            self.put_cache(weights, representative, weight);
+        });
     }
 
     pub fn representation_add_dual(
@@ -96,15 +108,27 @@ impl RepWeightsUpdater {
             let new_weight_2 = previous_weight_2.wrapping_add(amount_2);
             self.put_store(tx, rep_1, previous_weight_1, new_weight_1);
             self.put_store(tx, rep_2, previous_weight_2, new_weight_2);
-            let mut guard = self.weight_cache.write().unwrap();
-            self.put_cache(&mut guard, rep_1, new_weight_1);
-            self.put_cache(&mut guard, rep_2, new_weight_2);
+            self.weight_cache.modify(|weights| {
+                self.put_cache(weights, rep_1, new_weight_1);
+                self.put_cache(weights, rep_2, new_weight_2);
+            });
         } else {
             self.representation_add(tx, rep_1, amount_1.wrapping_add(amount_2));
         }
     }
 }
 
+/// Publishes the collected rep weight changes when dropped
+pub struct RepWeightsBatch<'a> {
+    weight_cache: &'a PublishedRepWeights,
+}
+
+impl<'a> Drop for RepWeightsBatch<'a> {
+    fn drop(&mut self) {
+        self.weight_cache.end_batch();
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -238,4 +262,24 @@ mod tests {
         assert_eq!(rep_weights.len(), 0);
         assert_eq!(put_tracker.output(), vec![(representative, 9.into())]);
     }
+
+    #[test]
+    fn publish_batch_on_drop() {
+        let env = Arc::new(LmdbEnv::new_null());
+        let store = Arc::new(LmdbRepWeightStore::new(Arc::clone(&env)).unwrap());
+        let mut txn = env.tx_begin_write();
+        let rep1 = PublicKey::from(1);
+        let rep2 = PublicKey::from(2);
+        let rep_weights = RepWeightCache::new();
+        let rep_weights_updater = RepWeightsUpdater::new(store, Amount::zero(), &rep_weights);
+
+        let batch = rep_weights_updater.begin_batch();
+        rep_weights_updater.representation_add(&mut txn, rep1, Amount::from(1));
+        rep_weights_updater.representation_add(&mut txn, rep2, Amount::from(2));
+        assert_eq!(rep_weights.len(), 0);
+
+        drop(batch);
+        assert_eq!(rep_weights.weight(&rep1), Amount::from(1));
+        assert_eq!(rep_weights.weight(&rep2), Amount::from(2));
+    }
 }
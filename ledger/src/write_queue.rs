@@ -1,7 +1,9 @@
 use std::{
     collections::VecDeque,
     sync::{Arc, Condvar, Mutex},
+    time::Duration,
 };
+use tracing::{error, warn};
 
 /** Distinct areas write locking is done, order is irrelevant */
 #[derive(FromPrimitive, Clone, Copy, PartialEq, Eq)]
@@ -53,6 +55,8 @@ impl Drop for WriteGuard {
 pub struct WriteQueue {
     data: Arc<WriteQueueData>,
     guard_finish_callback: Arc<dyn Fn() + Send + Sync>,
+    group_commit: Option<GroupCommit>,
+    commit_latencies: Mutex<CommitLatencies>,
 }
 
 struct WriteQueueData {
@@ -76,6 +80,67 @@ impl WriteQueue {
                 guard.pop_front();
                 data_clone.condition.notify_all();
             }),
+            group_commit: None,
+            commit_latencies: Mutex::new(CommitLatencies::new()),
+        }
+    }
+
+    /// Commits are not flushed to disk by the writers themselves. Instead the writers
+    /// wait in `wait_durable` for a flush, which is shared by every writer that
+    /// committed before the flush started. The flush happens outside of the write lock,
+    /// so the next writer can already write while the previous ones wait for the disk.
+    /// If the flush fails, the commits are not durable and the writers keep waiting
+    /// until a retried flush succeeds.
+    /// Write transactions that are committed outside of `Ledger::commit` wait for the
+    /// flush in their commit hook, see `Ledger::enable_group_commit`
+    pub fn with_group_commit(sync: Box<dyn Fn() -> anyhow::Result<()> + Send + Sync>) -> Self {
+        Self {
+            group_commit: Some(GroupCommit::new(sync)),
+            ..Self::new()
+        }
+    }
+
+    pub fn group_commit_enabled(&self) -> bool {
+        self.group_commit.is_some()
+    }
+
+    /// Registers a commit of a write transaction and returns its ticket
+    /// for `wait_durable`. Must be called after the transaction was committed
+    pub fn committed(&self) -> u64 {
+        match &self.group_commit {
+            Some(group_commit) => group_commit.committed(),
+            None => 0,
+        }
+    }
+
+    /// Blocks until the commit with the given ticket was flushed to disk.
+    /// Without group commit every commit already is durable
+    pub fn wait_durable(&self, ticket: u64) {
+        if let Some(group_commit) = &self.group_commit {
+            group_commit.wait_durable(ticket);
+        }
+    }
+
+    /// Time from committing until the commit is durable
+    pub fn add_commit_latency(&self, latency: Duration) {
+        self.commit_latencies.lock().unwrap().add(latency);
+    }
+
+    pub fn commit_latency(&self) -> CommitLatencyPercentiles {
+        self.commit_latencies.lock().unwrap().percentiles()
+    }
+
+    pub fn sync_count(&self) -> u64 {
+        match &self.group_commit {
+            Some(group_commit) => group_commit.state.lock().unwrap().sync_count,
+            None => 0,
+        }
+    }
+
+    pub fn sync_failures(&self) -> u64 {
+        match &self.group_commit {
+            Some(group_commit) => group_commit.state.lock().unwrap().sync_failures,
+            None => 0,
         }
     }
 
@@ -102,3 +167,257 @@ impl WriteQueue {
         WriteGuard::new(writer, Arc::clone(&self.guard_finish_callback))
     }
 }
+
+struct GroupCommit {
+    state: Mutex<GroupCommitState>,
+    condition: Condvar,
+    sync: Box<dyn Fn() -> anyhow::Result<()> + Send + Sync>,
+}
+
+struct GroupCommitState {
+    committed: u64,
+    synced: u64,
+    syncing: bool,
+    sync_count: u64,
+    sync_failures: u64,
+    consecutive_failures: u32,
+}
+
+impl GroupCommit {
+    /// Waiting time before a failed flush is tried again
+    const RETRY_DELAY: Duration = Duration::from_millis(100);
+    /// The state of the page cache is undefined after a failed sync, so a
+    /// persistent failure (disk full, I/O error) is fatal like a failed LMDB commit
+    const MAX_CONSECUTIVE_FAILURES: u32 = 3;
+
+    fn new(sync: Box<dyn Fn() -> anyhow::Result<()> + Send + Sync>) -> Self {
+        Self {
+            state: Mutex::new(GroupCommitState {
+                committed: 0,
+                synced: 0,
+                syncing: false,
+                sync_count: 0,
+                sync_failures: 0,
+                consecutive_failures: 0,
+            }),
+            condition: Condvar::new(),
+            sync,
+        }
+    }
+
+    fn committed(&self) -> u64 {
+        let mut state = self.state.lock().unwrap();
+        state.committed += 1;
+        state.committed
+    }
+
+    fn wait_durable(&self, ticket: u64) {
+        let mut state = self.state.lock().unwrap();
+        while state.synced < ticket {
+            if state.syncing {
+                // Another writer is flushing. Its flush might not include our commit,
+                // in which case we'll flush in the next round
+                state = self.condition.wait(state).unwrap();
+            } else {
+                // Flush all commits registered so far with a single sync
+                state.syncing = true;
+                let target = state.committed;
+                drop(state);
+                let result = (self.sync)();
+                state = self.state.lock().unwrap();
+                match result {
+                    Ok(()) => {
+                        state.syncing = false;
+                        state.synced = target;
+                        state.sync_count += 1;
+                        state.consecutive_failures = 0;
+                    }
+                    Err(e) => {
+                        state.sync_failures += 1;
+                        state.consecutive_failures += 1;
+                        if state.consecutive_failures >= Self::MAX_CONSECUTIVE_FAILURES {
+                            error!("Could not flush commits to disk: {:?}", e);
+                            // Waiting writers wake up to a poisoned lock and fail too
+                            self.condition.notify_all();
+                            panic!("Could not flush commits to disk: {:?}", e);
+                        }
+                        warn!("Could not flush commits to disk, retrying: {:?}", e);
+                        // Other writers wait instead of retrying immediately
+                        drop(state);
+                        std::thread::sleep(Self::RETRY_DELAY);
+                        state = self.state.lock().unwrap();
+                        state.syncing = false;
+                    }
+                }
+                self.condition.notify_all();
+            }
+        }
+    }
+}
+
+#[derive(Clone, Copy, Default, PartialEq, Eq, Debug)]
+pub struct CommitLatencyPercentiles {
+    pub count: usize,
+    pub p50: Duration,
+    pub p90: Duration,
+    pub p99: Duration,
+    pub max: Duration,
+}
+
+/// Keeps the latencies of the most recent commits
+struct CommitLatencies {
+    samples: VecDeque<Duration>,
+}
+
+impl CommitLatencies {
+    const MAX_SAMPLES: usize = 1024;
+
+    fn new() -> Self {
+        Self {
+            samples: VecDeque::with_capacity(Self::MAX_SAMPLES),
+        }
+    }
+
+    fn add(&mut self, latency: Duration) {
+        if self.samples.len() >= Self::MAX_SAMPLES {
+            self.samples.pop_front();
+        }
+        self.samples.push_back(latency);
+    }
+
+    fn percentiles(&self) -> CommitLatencyPercentiles {
+        if self.samples.is_empty() {
+            return Default::default();
+        }
+        let mut sorted: Vec<_> = self.samples.iter().copied().collect();
+        sorted.sort_unstable();
+        let percentile = |p: usize| sorted[(sorted.len() - 1) * p / 100];
+        CommitLatencyPercentiles {
+            count: sorted.len(),
+            p50: percentile(50),
+            p90: percentile(90),
+            p99: percentile(99),
+            max: *sorted.last().unwrap(),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    #[test]
+    fn without_group_commit_commits_are_durable() {
+        let queue = WriteQueue::new();
+        assert!(!queue.group_commit_enabled());
+        let ticket = queue.committed();
+        queue.wait_durable(ticket);
+        assert_eq!(queue.sync_count(), 0);
+    }
+
+    #[test]
+    fn group_commit_syncs_once_for_all_previous_commits() {
+        let syncs = Arc::new(AtomicUsize::new(0));
+        let syncs_clone = syncs.clone();
+        let queue = WriteQueue::with_group_commit(Box::new(move || {
+            syncs_clone.fetch_add(1, Ordering::SeqCst);
+            Ok(())
+        }));
+
+        let ticket1 = queue.committed();
+        let ticket2 = queue.committed();
+        let ticket3 = queue.committed();
+        queue.wait_durable(ticket3);
+        queue.wait_durable(ticket1);
+        queue.wait_durable(ticket2);
+
+        assert_eq!(syncs.load(Ordering::SeqCst), 1);
+        assert_eq!(queue.sync_count(), 1);
+
+        let ticket4 = queue.committed();
+        queue.wait_durable(ticket4);
+        assert_eq!(queue.sync_count(), 2);
+    }
+
+    #[test]
+    fn group_commit_from_multiple_threads() {
+        let queue = Arc::new(WriteQueue::with_group_commit(Box::new(|| {
+            std::thread::sleep(Duration::from_millis(1));
+            Ok(())
+        })));
+
+        let writers = [
+            Writer::BlockProcessor,
+            Writer::ConfirmationHeight,
+            Writer::Pruning,
+            Writer::VotingFinal,
+        ];
+        let handles: Vec<_> = writers
+            .into_iter()
+            .map(|writer| {
+                let queue = queue.clone();
+                std::thread::spawn(move || {
+                    for _ in 0..10 {
+                        let ticket = {
+                            let _guard = queue.wait(writer);
+                            queue.committed()
+                        };
+                        queue.wait_durable(ticket);
+                    }
+                })
+            })
+            .collect();
+        for handle in handles {
+            handle.join().unwrap();
+        }
+
+        let syncs = queue.sync_count();
+        assert!(syncs > 0 && syncs <= 40);
+    }
+
+    #[test]
+    fn retry_failed_sync() {
+        let attempts = Arc::new(AtomicUsize::new(0));
+        let attempts_clone = attempts.clone();
+        let queue = WriteQueue::with_group_commit(Box::new(move || {
+            if attempts_clone.fetch_add(1, Ordering::SeqCst) == 0 {
+                Err(anyhow::anyhow!("disk full"))
+            } else {
+                Ok(())
+            }
+        }));
+
+        let ticket = queue.committed();
+        queue.wait_durable(ticket);
+
+        assert_eq!(attempts.load(Ordering::SeqCst), 2);
+        assert_eq!(queue.sync_failures(), 1);
+        assert_eq!(queue.sync_count(), 1);
+    }
+
+    #[test]
+    #[should_panic(expected = "Could not flush commits to disk")]
+    fn persistent_sync_failure_is_fatal() {
+        let queue = WriteQueue::with_group_commit(Box::new(|| Err(anyhow::anyhow!("I/O error"))));
+        let ticket = queue.committed();
+        queue.wait_durable(ticket);
+    }
+
+    #[test]
+    fn commit_latency_percentiles() {
+        let queue = WriteQueue::new();
+        assert_eq!(queue.commit_latency(), CommitLatencyPercentiles::default());
+
+        for i in 1..=100 {
+            queue.add_commit_latency(Duration::from_millis(i));
+        }
+
+        let latency = queue.commit_latency();
+        assert_eq!(latency.count, 100);
+        assert_eq!(latency.p50, Duration::from_millis(50));
+        assert_eq!(latency.p90, Duration::from_millis(90));
+        assert_eq!(latency.p99, Duration::from_millis(99));
+        assert_eq!(latency.max, Duration::from_millis(100));
+    }
+}
@@ -4,7 +4,7 @@ use clap::{ArgGroup, Parser};
 use rsban_core::{Account, ConfirmationHeightInfo, Networks};
 use rsban_ledger::LedgerConstants;
 use rsban_node::config::NetworkConstants;
-use rsban_store_lmdb::{LmdbConfirmationHeightStore, LmdbEnv};
+use rsban_store_lmdb::{LmdbConfirmationHeightStore, LmdbEnv, LmdbVersionStore};
 use std::sync::Arc;
 
 #[derive(Parser)]
@@ -77,6 +77,9 @@ impl ConfirmationHeightArgs {
             println!("Confirmation heights of all accounts (except genesis which is set to 1) are set to 0");
         }
 
+        // The persisted cemented count is outdated now
+        LmdbVersionStore::new(env.clone())?.clear_counts(&mut txn);
+
         Ok(())
     }
 }
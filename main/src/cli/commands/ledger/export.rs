@@ -0,0 +1,47 @@
+use crate::cli::get_path;
+use anyhow::{Context, Result};
+use clap::{ArgGroup, Parser};
+use rsban_store_lmdb::{export_snapshot, LmdbStore};
+use std::{fs::File, io::BufWriter, path::PathBuf};
+
+#[derive(Parser)]
+#[command(group = ArgGroup::new("input")
+    .args(&["data_path", "network"]))]
+pub(crate) struct ExportArgs {
+    /// The file to which the ledger snapshot is written
+    #[arg(long)]
+    file: PathBuf,
+    /// Uses the supplied path as the data directory
+    #[arg(long, group = "input")]
+    data_path: Option<String>,
+    /// Uses the supplied network (live, test, beta or dev)
+    #[arg(long, group = "input")]
+    network: Option<String>,
+}
+
+impl ExportArgs {
+    pub(crate) fn export(&self) -> Result<()> {
+        let source_path = get_path(&self.data_path, &self.network).join("data.ldb");
+
+        println!(
+            "Exporting ledger snapshot of {:?} to {:?}",
+            source_path, self.file
+        );
+        println!("This may take a while...");
+
+        let store = LmdbStore::open(&source_path).build()?;
+        let file = File::create(&self.file)
+            .with_context(|| format!("Could not create {:?}", self.file))?;
+
+        // All tables are read from the same transaction, so the snapshot is consistent
+        let txn = store.tx_begin_read();
+        let counts = export_snapshot(&store, &txn, BufWriter::new(file))?;
+
+        println!(
+            "Export completed: {} accounts, {} blocks, {} cemented",
+            counts.account_count, counts.block_count, counts.cemented_count
+        );
+
+        Ok(())
+    }
+}
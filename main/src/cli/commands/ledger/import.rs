@@ -0,0 +1,69 @@
+use crate::cli::get_path;
+use anyhow::{bail, Context, Result};
+use clap::{ArgGroup, Parser};
+use rsban_store_lmdb::{import_snapshot, LmdbStore};
+use std::{fs, fs::File, io::BufReader, path::PathBuf};
+
+#[derive(Parser)]
+#[command(group = ArgGroup::new("input")
+    .args(&["data_path", "network"]))]
+pub(crate) struct ImportArgs {
+    /// The ledger snapshot which is imported
+    #[arg(long)]
+    file: PathBuf,
+    /// Uses the supplied path as the data directory
+    #[arg(long, group = "input")]
+    data_path: Option<String>,
+    /// Uses the supplied network (live, test, beta or dev)
+    #[arg(long, group = "input")]
+    network: Option<String>,
+}
+
+impl ImportArgs {
+    pub(crate) fn import(&self) -> Result<()> {
+        let data_path = get_path(&self.data_path, &self.network);
+        let target_path = data_path.join("data.ldb");
+        let import_path = data_path.join("import.ldb");
+
+        if target_path.exists() {
+            bail!(
+                "{:?} already exists. The snapshot can only be imported into a new ledger",
+                target_path
+            );
+        }
+
+        println!(
+            "Importing ledger snapshot {:?} into {:?}",
+            self.file, target_path
+        );
+        println!("This may take a while...");
+
+        let file =
+            File::open(&self.file).with_context(|| format!("Could not open {:?}", self.file))?;
+        // A partially imported ledger is never moved into place
+        let _ = fs::remove_file(&import_path);
+        let result = {
+            let store = LmdbStore::open(&import_path).build()?;
+            import_snapshot(&store, BufReader::new(file))
+        };
+        let counts = match result {
+            Ok(counts) => counts,
+            Err(e) => {
+                let _ = fs::remove_file(&import_path);
+                return Err(e);
+            }
+        };
+        fs::rename(&import_path, &target_path).context("Failed to move the imported ledger")?;
+        let _ = fs::remove_file(data_path.join("import.ldb-lock"));
+
+        println!(
+            "Import completed: {} accounts, {} blocks, {} cemented",
+            counts.account_count, counts.block_count, counts.cemented_count
+        );
+        if counts.pruned_count > 0 {
+            println!("The imported ledger is pruned. Start the node with --enable_pruning");
+        }
+
+        Ok(())
+    }
+}
@@ -32,11 +32,11 @@ impl RepresentativesArgs {
             Arc::new(RepWeightCache::new()),
         )?;
 
-        let rep_amounts = ledger.rep_weights.read().to_owned();
+        let rep_amounts = ledger.rep_weights.read();
         let mut total = Amount::zero();
 
-        for (account, amount) in rep_amounts {
-            total += amount;
+        for (account, amount) in rep_amounts.iter() {
+            total += *amount;
             println!(
                 "{} {:?} {}",
                 Account::from(account).encode_account(),
@@ -1,11 +1,15 @@
 use anyhow::Result;
 use clap::{CommandFactory, Parser, Subcommand};
 use clear::ClearCommand;
+use export::ExportArgs;
+use import::ImportArgs;
 use info::InfoCommand;
 use snapshot::SnapshotArgs;
 use vacuum::VacuumArgs;
 
 pub(crate) mod clear;
+pub(crate) mod export;
+pub(crate) mod import;
 pub(crate) mod info;
 pub(crate) mod snapshot;
 pub(crate) mod vacuum;
@@ -20,6 +24,10 @@ pub(crate) enum LedgerSubcommands {
     Vacuum(VacuumArgs),
     /// Similar to vacuum but does not replace the existing database
     Snapshot(SnapshotArgs),
+    /// Writes a checksummed snapshot of the ledger state to a file
+    Export(ExportArgs),
+    /// Creates a new ledger from a snapshot which was written by export
+    Import(ImportArgs),
 }
 
 #[derive(Parser)]
@@ -35,6 +43,8 @@ impl LedgerCommand {
             Some(LedgerSubcommands::Clear(command)) => command.run()?,
             Some(LedgerSubcommands::Vacuum(args)) => args.vacuum()?,
             Some(LedgerSubcommands::Snapshot(args)) => args.snapshot()?,
+            Some(LedgerSubcommands::Export(args)) => args.export()?,
+            Some(LedgerSubcommands::Import(args)) => args.import()?,
             None => LedgerCommand::command().print_long_help()?,
         }
 
@@ -1,6 +1,7 @@
 use bitvec::prelude::BitArray;
 use num_traits::FromPrimitive;
 use rsban_core::{
+    serialized_block_size,
     utils::{BufferWriter, Deserialize, Serialize, Stream, StreamExt},
     Account, Block, BlockHash, BlockType, Frontier,
 };
@@ -168,6 +169,10 @@ impl BlocksAckPayload {
     }
 
     pub fn deserialize(&mut self, stream: &mut dyn Stream) -> anyhow::Result<()> {
+        // Most blocks are state blocks, so reserving room for that many blocks
+        // usually avoids reallocating the VecDeque while the blocks are pushed
+        let expected = stream.in_avail()? / (serialized_block_size(BlockType::State) + 1);
+        self.0.reserve(expected.min(Self::MAX_BLOCKS));
         while let Ok(current) = Block::deserialize(stream) {
             if self.0.len() >= Self::MAX_BLOCKS {
                 bail!("too many blocks")
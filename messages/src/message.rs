@@ -74,6 +74,25 @@ impl Message {
         }
     }
 
+    /// Number of heap buffers owned by the decoded message: the vote hashes,
+    /// the requested roots, the pulled blocks or frontiers and unknown telemetry data.
+    /// All other fields are stored inline, and empty buffers allocate nothing
+    pub fn heap_buffers(&self) -> usize {
+        match &self {
+            Message::ConfirmAck(x) => (x.vote().hashes.capacity() > 0) as usize,
+            Message::ConfirmReq(x) => (x.roots_hashes.capacity() > 0) as usize,
+            Message::AscPullAck(x) => match &x.pull_type {
+                AscPullAckType::Blocks(blocks) => (blocks.blocks().capacity() > 0) as usize,
+                AscPullAckType::Frontiers(frontiers) => (frontiers.capacity() > 0) as usize,
+                AscPullAckType::AccountInfo(_) => 0,
+            },
+            Message::TelemetryAck(TelemetryAck(Some(data))) => {
+                (data.unknown_data.capacity() > 0) as usize
+            }
+            _ => 0,
+        }
+    }
+
     pub fn as_message_variant(&self) -> Option<&dyn MessageVariant> {
         match &self {
             Message::Keepalive(x) => Some(x),
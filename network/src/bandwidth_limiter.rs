@@ -19,6 +19,11 @@ impl RateLimiter {
         self.bucket.lock().unwrap().try_consume(message_size)
     }
 
+    /// The biggest message size which can pass at all
+    pub fn capacity(&self) -> usize {
+        self.bucket.lock().unwrap().capacity()
+    }
+
     pub fn reset(&self, limit_burst_ratio: f64, limit: usize) {
         self.bucket
             .lock()
@@ -70,6 +75,10 @@ impl BandwidthLimiter {
         self.select_limiter(limit_type).should_pass(buffer_size)
     }
 
+    pub fn capacity(&self, limit_type: TrafficType) -> usize {
+        self.select_limiter(limit_type).capacity()
+    }
+
     pub fn reset(&self, limit: usize, burst_ratio: f64, limit_type: TrafficType) {
         self.select_limiter(limit_type).reset(burst_ratio, limit);
     }
@@ -103,4 +112,13 @@ mod tests {
         assert_eq!(limiter.should_pass(1), true);
         assert_eq!(limiter.should_pass(1), false);
     }
+
+    #[test]
+    fn capacity() {
+        let limiter = RateLimiter::new(1.5, 10);
+        assert_eq!(limiter.capacity(), 15);
+        assert_eq!(limiter.should_pass(16), false);
+        limiter.reset(1.0, 0);
+        assert!(limiter.capacity() >= 1_000_000_000);
+    }
 }
@@ -1,7 +1,7 @@
 use crate::{
     bandwidth_limiter::BandwidthLimiter,
     utils::into_ipv6_socket_address,
-    write_queue::{WriteQueue, WriteQueueReceiver},
+    write_queue::{Entry, WriteQueue, WriteQueueReceiver},
     AsyncBufferReader, ChannelDirection, ChannelId, ChannelInfo, DropPolicy, NetworkObserver,
     NullNetworkObserver, TrafficType, WriteQueueAdapter,
 };
@@ -11,6 +11,8 @@ use rsban_nullable_clock::{SteadyClock, Timestamp};
 use rsban_nullable_tcp::TcpStream;
 use std::{
     fmt::Display,
+    io::IoSlice,
+    iter::once,
     net::{Ipv6Addr, SocketAddrV6},
     sync::{Arc, Weak},
     time::Duration,
@@ -32,6 +34,8 @@ pub struct Channel {
 
 impl Channel {
     const MAX_QUEUE_SIZE: usize = 128;
+    /// Maximum number of queued buffers which are written with a single syscall
+    const MAX_COALESCED_WRITES: usize = 64;
 
     fn new(
         channel_info: Arc<ChannelInfo>,
@@ -110,52 +114,26 @@ impl Channel {
 
         // process write queue:
         handle.spawn(async move {
+            let mut batch = Vec::with_capacity(Self::MAX_COALESCED_WRITES);
             loop {
+                batch.clear();
                 let res = select! {
                     _ = cancel_token.cancelled() =>{
                         return;
                     },
-                  res = receiver.pop() => res
+                  res = receiver.pop_batch(Self::MAX_COALESCED_WRITES, &mut batch) => res
                 };
 
-                if let Some((entry, _)) = res {
-                    let mut written = 0;
-                    let buffer = &entry.buffer;
-                    loop {
-                        select! {
-                            _ = cancel_token.cancelled() =>{
-                                return;
-                            }
-                            res = stream_l.writable() =>{
-                            match res {
-                            Ok(()) => match stream_l.try_write(&buffer[written..]) {
-                                Ok(n) => {
-                                    written += n;
-                                    if written >= buffer.len() {
-                                        observer.send_succeeded(written);
-                                        info.set_last_activity(clock.now());
-                                        break;
-                                    }
-                                }
-                                Err(ref e) if e.kind() == std::io::ErrorKind::WouldBlock => {
-                                    continue;
-                                }
-                                Err(_) => {
-                                    info.close();
-                                    return;
-                                }
-                            },
-                            Err(_) => {
-                                info.close();
-                                return;
-                            }
-                        }
-                            }
-                        }
-                    }
-                } else {
+                if !res {
                     break;
                 }
+
+                let written =
+                    write_coalesced(&stream_l, &batch, &*observer, &info, &clock, &cancel_token)
+                        .await;
+                if !written {
+                    return;
+                }
             }
             info.close();
         });
@@ -170,6 +148,11 @@ impl Channel {
         self.channel_id
     }
 
+    /// Completes once the channel was closed
+    pub async fn closed(&self) {
+        self.cancel_token.cancelled().await
+    }
+
     pub fn local_addr(&self) -> SocketAddrV6 {
         let no_addr = SocketAddrV6::new(Ipv6Addr::LOCALHOST, 0, 0, 0);
         let Some(stream) = self.stream.upgrade() else {
@@ -186,6 +169,17 @@ impl Channel {
         &self,
         buffer: &[u8],
         traffic_type: TrafficType,
+    ) -> anyhow::Result<()> {
+        self.send_shared(Arc::new(buffer.to_vec()), traffic_type)
+            .await
+    }
+
+    /// Like `send_buffer`, but the buffer is handed to the write queue as is
+    /// instead of being copied. Streaming servers use this with pooled buffers
+    pub async fn send_shared(
+        &self,
+        buffer: Arc<Vec<u8>>,
+        traffic_type: TrafficType,
     ) -> anyhow::Result<()> {
         if self.info.is_closed() {
             bail!("socket closed");
@@ -196,9 +190,18 @@ impl Channel {
             sleep(Duration::from_millis(20)).await;
         }
 
-        while !self.limiter.should_pass(buffer.len(), traffic_type) {
-            // TODO: better implementation
-            sleep(Duration::from_millis(20)).await;
+        // A streamed chunk can be bigger than the bucket of the limiter, if the
+        // limit is configured low. It would never pass as a whole, so it is
+        // metered in parts of at most the bucket size
+        let mut unmetered = buffer.len();
+        while unmetered > 0 {
+            let part = unmetered.min(self.limiter.capacity(traffic_type));
+            if self.limiter.should_pass(part, traffic_type) {
+                unmetered -= part;
+            } else {
+                // TODO: better implementation
+                sleep(Duration::from_millis(20)).await;
+            }
         }
 
         if self.info.is_closed() {
@@ -207,10 +210,7 @@ impl Channel {
 
         let buf_size = buffer.len();
 
-        let result = self
-            .write_queue
-            .insert(Arc::new(buffer.to_vec()), traffic_type) // TODO don't copy into vec. Split into fixed size packets
-            .await;
+        let result = self.write_queue.insert(buffer, traffic_type).await;
 
         if result.is_ok() {
             self.observer.send_succeeded(buf_size);
@@ -231,6 +231,28 @@ impl Channel {
         drop_policy: DropPolicy,
         traffic_type: TrafficType,
     ) -> bool {
+        if !self.can_try_send(buffer.len(), drop_policy, traffic_type) {
+            return false;
+        }
+        // TODO don't copy into vec. Split into fixed size packets
+        self.try_insert(Arc::new(buffer.to_vec()), traffic_type)
+    }
+
+    /// Like `try_send_buffer`, but the buffer is shared with the write queues
+    /// of other channels instead of being copied
+    pub fn try_send_shared(
+        &self,
+        buffer: &Arc<Vec<u8>>,
+        drop_policy: DropPolicy,
+        traffic_type: TrafficType,
+    ) -> bool {
+        if !self.can_try_send(buffer.len(), drop_policy, traffic_type) {
+            return false;
+        }
+        self.try_insert(Arc::clone(buffer), traffic_type)
+    }
+
+    fn can_try_send(&self, len: usize, drop_policy: DropPolicy, traffic_type: TrafficType) -> bool {
         if self.info.is_closed() {
             return false;
         }
@@ -239,16 +261,17 @@ impl Channel {
             return false;
         }
 
-        let should_pass = self.limiter.should_pass(buffer.len(), traffic_type);
+        let should_pass = self.limiter.should_pass(len, traffic_type);
         if !should_pass && drop_policy == DropPolicy::CanDrop {
-            return false;
+            false
         } else {
             // TODO notify bandwidth limiter that we are sending it anyway
+            true
         }
+    }
 
-        let (inserted, write_error) = self
-            .write_queue
-            .try_insert(Arc::new(buffer.to_vec()), traffic_type); // TODO don't copy into vec. Split into fixed size packets
+    fn try_insert(&self, buffer: Arc<Vec<u8>>, traffic_type: TrafficType) -> bool {
+        let (inserted, write_error) = self.write_queue.try_insert(buffer, traffic_type);
 
         if write_error {
             self.observer.send_failed();
@@ -279,6 +302,64 @@ impl Channel {
     }
 }
 
+/// Writes all buffers of the batch to the stream with as few syscalls as possible.
+/// returns: false if the channel got cancelled or the write failed
+async fn write_coalesced(
+    stream: &TcpStream,
+    batch: &[(Entry, TrafficType)],
+    observer: &dyn NetworkObserver,
+    info: &ChannelInfo,
+    clock: &SteadyClock,
+    cancel_token: &CancellationToken,
+) -> bool {
+    // The first entry which isn't written completely and how much of it was written
+    let mut index = 0;
+    let mut offset = 0;
+    while index < batch.len() {
+        select! {
+            _ = cancel_token.cancelled() => {
+                return false;
+            }
+            res = stream.writable() => {
+                if res.is_err() {
+                    info.close();
+                    return false;
+                }
+
+                let slices: Vec<_> = once(IoSlice::new(&batch[index].0.buffer[offset..]))
+                    .chain(batch[index + 1..].iter().map(|(e, _)| IoSlice::new(&e.buffer)))
+                    .collect();
+
+                match stream.try_write_vectored(&slices) {
+                    Ok(mut written) => {
+                        while index < batch.len() {
+                            let len = batch[index].0.buffer.len();
+                            let remaining = len - offset;
+                            if written < remaining {
+                                offset += written;
+                                break;
+                            }
+                            written -= remaining;
+                            observer.send_succeeded(len);
+                            info.set_last_activity(clock.now());
+                            index += 1;
+                            offset = 0;
+                        }
+                    }
+                    Err(ref e) if e.kind() == std::io::ErrorKind::WouldBlock => {
+                        continue;
+                    }
+                    Err(_) => {
+                        info.close();
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    true
+}
+
 impl Display for Channel {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         self.info.peer_addr().fmt(f)
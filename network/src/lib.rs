@@ -9,6 +9,7 @@ mod network_observer;
 mod peer_connector;
 pub mod peer_exclusion;
 mod response_server_spawner;
+mod shared_buffer_pool;
 mod tcp_listener;
 pub mod token_bucket;
 pub mod utils;
@@ -24,6 +25,7 @@ pub use network_observer::*;
 use num_derive::FromPrimitive;
 pub use peer_connector::*;
 pub use response_server_spawner::*;
+pub use shared_buffer_pool::SharedBufferPool;
 use std::fmt::{Debug, Display};
 pub use tcp_listener::*;
 
@@ -69,7 +71,7 @@ pub enum ChannelDirection {
     Outbound,
 }
 
-#[derive(FromPrimitive, Copy, Clone, Debug)]
+#[derive(FromPrimitive, Copy, Clone, Debug, PartialEq, Eq)]
 pub enum TrafficType {
     Generic,
     /// Ascending bootstrap (asc_pull_ack, asc_pull_req) traffic
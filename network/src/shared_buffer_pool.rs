@@ -0,0 +1,128 @@
+use std::sync::Arc;
+
+/// Buffers for messages which are sent to many channels at once.
+/// All write queues share the same buffer, and the buffer is reused
+/// as soon as every write queue has released it.
+pub struct SharedBufferPool {
+    buffers: Vec<Arc<Vec<u8>>>,
+    max_buffers: usize,
+}
+
+impl SharedBufferPool {
+    pub const DEFAULT_MAX_BUFFERS: usize = 32;
+
+    pub fn new(max_buffers: usize) -> Self {
+        Self {
+            buffers: Vec::new(),
+            max_buffers,
+        }
+    }
+
+    /// Returns a shared copy of `data` and whether a pooled buffer could be reused
+    pub fn get(&mut self, data: &[u8]) -> (Arc<Vec<u8>>, bool) {
+        self.get_with(|buffer| buffer.extend_from_slice(data))
+    }
+
+    /// Like `get`, but `fill` writes directly into the empty buffer,
+    /// so the data doesn't have to be assembled somewhere else first
+    pub fn get_with(&mut self, fill: impl FnOnce(&mut Vec<u8>)) -> (Arc<Vec<u8>>, bool) {
+        for buffer in &mut self.buffers {
+            if let Some(free) = Arc::get_mut(buffer) {
+                free.clear();
+                fill(free);
+                return (Arc::clone(buffer), true);
+            }
+        }
+
+        let mut data = Vec::new();
+        fill(&mut data);
+        let buffer = Arc::new(data);
+        if self.buffers.len() < self.max_buffers {
+            self.buffers.push(Arc::clone(&buffer));
+        }
+        (buffer, false)
+    }
+
+    pub fn len(&self) -> usize {
+        self.buffers.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.buffers.is_empty()
+    }
+}
+
+impl Default for SharedBufferPool {
+    fn default() -> Self {
+        Self::new(Self::DEFAULT_MAX_BUFFERS)
+    }
+}
+
+/// Buffers can't be shared between pools, so a clone starts empty
+impl Clone for SharedBufferPool {
+    fn clone(&self) -> Self {
+        Self::new(self.max_buffers)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn empty() {
+        let pool = SharedBufferPool::default();
+        assert!(pool.is_empty());
+    }
+
+    #[test]
+    fn reuse_released_buffer() {
+        let mut pool = SharedBufferPool::default();
+        let (buffer, reused) = pool.get(&[1, 2, 3]);
+        assert!(!reused);
+        assert_eq!(*buffer, vec![1, 2, 3]);
+        let address = buffer.as_ptr();
+        drop(buffer);
+
+        let (buffer, reused) = pool.get(&[4, 5]);
+        assert!(reused);
+        assert_eq!(*buffer, vec![4, 5]);
+        assert_eq!(buffer.as_ptr(), address);
+        assert_eq!(pool.len(), 1);
+    }
+
+    #[test]
+    fn dont_reuse_buffer_in_use() {
+        let mut pool = SharedBufferPool::default();
+        let (first, _) = pool.get(&[1]);
+        let (second, reused) = pool.get(&[2]);
+        assert!(!reused);
+        assert_eq!(*first, vec![1]);
+        assert_eq!(*second, vec![2]);
+        assert_eq!(pool.len(), 2);
+    }
+
+    #[test]
+    fn fill_reused_buffer_in_place() {
+        let mut pool = SharedBufferPool::default();
+        let (buffer, _) = pool.get_with(|b| b.resize(1024, 1));
+        let capacity = buffer.capacity();
+        drop(buffer);
+
+        let (buffer, reused) = pool.get_with(|b| {
+            assert!(b.is_empty());
+            b.push(2)
+        });
+        assert!(reused);
+        assert_eq!(*buffer, vec![2]);
+        assert_eq!(buffer.capacity(), capacity);
+    }
+
+    #[test]
+    fn max_buffers() {
+        let mut pool = SharedBufferPool::new(1);
+        let (_first, _) = pool.get(&[1]);
+        let (_second, _) = pool.get(&[2]);
+        assert_eq!(pool.len(), 1);
+    }
+}
@@ -83,6 +83,11 @@ impl TokenBucket {
         self.last_refill = Instant::now()
     }
 
+    /** The most tokens that can be consumed at once */
+    pub fn capacity(&self) -> usize {
+        self.max_token_count
+    }
+
     /** Returns the largest burst observed */
     #[allow(dead_code)]
     pub fn largest_burst(&self) -> usize {
@@ -76,8 +76,84 @@ impl WriteQueueReceiver {
             v = self.bootstrap.recv() => v.map(|i| (i, TrafficType::Bootstrap)),
         }
     }
+
+    /// Waits for the next entry and then takes all other entries which are ready,
+    /// so that they can be written with a single syscall.
+    /// returns: false if the queue was closed
+    pub async fn pop_batch(
+        &mut self,
+        max_entries: usize,
+        batch: &mut Vec<(Entry, TrafficType)>,
+    ) -> bool {
+        let Some(first) = self.pop().await else {
+            return false;
+        };
+        batch.push(first);
+        self.drain_ready(max_entries, batch);
+        true
+    }
+
+    /// Generic entries are still preferred over bootstrap entries
+    fn drain_ready(&mut self, max_entries: usize, batch: &mut Vec<(Entry, TrafficType)>) {
+        while batch.len() < max_entries {
+            match self.generic.try_recv() {
+                Ok(entry) => batch.push((entry, TrafficType::Generic)),
+                Err(_) => break,
+            }
+        }
+        while batch.len() < max_entries {
+            match self.bootstrap.try_recv() {
+                Ok(entry) => batch.push((entry, TrafficType::Bootstrap)),
+                Err(_) => break,
+            }
+        }
+    }
 }
 
 pub struct Entry {
     pub buffer: Arc<Vec<u8>>,
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn drain_ready_prefers_generic_entries() {
+        let (queue, mut receiver) = WriteQueue::new(8);
+        queue.try_insert(Arc::new(vec![1]), TrafficType::Bootstrap);
+        queue.try_insert(Arc::new(vec![2]), TrafficType::Generic);
+        queue.try_insert(Arc::new(vec![3]), TrafficType::Bootstrap);
+        queue.try_insert(Arc::new(vec![4]), TrafficType::Generic);
+
+        let mut batch = Vec::new();
+        receiver.drain_ready(10, &mut batch);
+
+        let drained: Vec<_> = batch.iter().map(|(e, t)| (e.buffer[0], *t)).collect();
+        assert_eq!(
+            drained,
+            vec![
+                (2, TrafficType::Generic),
+                (4, TrafficType::Generic),
+                (1, TrafficType::Bootstrap),
+                (3, TrafficType::Bootstrap),
+            ]
+        );
+    }
+
+    #[test]
+    fn drain_ready_max_entries() {
+        let (queue, mut receiver) = WriteQueue::new(8);
+        for i in 0..5 {
+            queue.try_insert(Arc::new(vec![i]), TrafficType::Generic);
+        }
+
+        let mut batch = Vec::new();
+        receiver.drain_ready(3, &mut batch);
+        assert_eq!(batch.len(), 3);
+
+        batch.clear();
+        receiver.drain_ready(3, &mut batch);
+        assert_eq!(batch.len(), 2);
+    }
+}
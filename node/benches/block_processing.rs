@@ -0,0 +1,104 @@
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use rsban_core::{Amount, Block, BlockHash, PrivateKey, UnsavedBlockLatticeBuilder};
+use rsban_ledger::LedgerContext;
+use rsban_network::ChannelId;
+use rsban_node::{
+    block_processing::{BlockProcessor, BlockSource},
+    cementation::{ConfirmingSet, ConfirmingSetConfig},
+    stats::Stats,
+};
+use std::{
+    sync::Arc,
+    thread,
+    time::{Duration, Instant},
+};
+
+const BATCH_SIZE: usize = 256;
+
+fn create_sends(lattice: &mut UnsavedBlockLatticeBuilder, count: usize) -> Vec<Block> {
+    (0..count)
+        .map(|_| {
+            lattice
+                .genesis()
+                .send(PrivateKey::new().account(), Amount::raw(1))
+        })
+        .collect()
+}
+
+/// Queues a whole batch and waits until the last block of it was processed,
+/// so this includes the queueing, the batching and the write transactions
+fn block_processor_batch(c: &mut Criterion) {
+    let ctx = LedgerContext::empty_dev();
+    let processor = BlockProcessor::new_test_instance(Arc::clone(&ctx.ledger));
+    processor.start();
+    let mut lattice = UnsavedBlockLatticeBuilder::new();
+
+    let mut group = c.benchmark_group("block_processor");
+    group.throughput(Throughput::Elements(BATCH_SIZE as u64));
+    group.bench_function("process_batch", |b| {
+        b.iter_custom(|iters| {
+            let mut total = Duration::ZERO;
+            for _ in 0..iters {
+                let mut blocks = create_sends(&mut lattice, BATCH_SIZE);
+                let last = blocks.pop().unwrap();
+                let start = Instant::now();
+                for block in blocks {
+                    processor.add(block, BlockSource::Bootstrap, ChannelId::LOOPBACK);
+                }
+                processor
+                    .add_blocking(Arc::new(last), BlockSource::Bootstrap)
+                    .unwrap()
+                    .unwrap();
+                total += start.elapsed();
+            }
+            total
+        })
+    });
+    group.finish();
+    processor.stop();
+}
+
+/// Cements a chain of `BATCH_SIZE` blocks starting from its frontier
+fn confirming_set_cementation(c: &mut Criterion) {
+    let ctx = LedgerContext::empty_dev();
+    let ledger = Arc::clone(&ctx.ledger);
+    let confirming_set = ConfirmingSet::new(
+        ConfirmingSetConfig::default(),
+        Arc::clone(&ledger),
+        Arc::new(Stats::default()),
+    );
+    confirming_set.start();
+    let mut lattice = UnsavedBlockLatticeBuilder::new();
+
+    let mut group = c.benchmark_group("confirming_set");
+    group.throughput(Throughput::Elements(BATCH_SIZE as u64));
+    group.bench_function("cement_chain", |b| {
+        b.iter_custom(|iters| {
+            let mut total = Duration::ZERO;
+            for _ in 0..iters {
+                let blocks = create_sends(&mut lattice, BATCH_SIZE);
+                {
+                    let mut txn = ledger.rw_txn();
+                    for block in &blocks {
+                        ledger.process(&mut txn, block).unwrap();
+                    }
+                }
+                let frontier: BlockHash = blocks.last().unwrap().hash();
+                let expected = ledger.cemented_count() + BATCH_SIZE as u64;
+
+                let start = Instant::now();
+                confirming_set.add(frontier);
+                while ledger.cemented_count() < expected {
+                    thread::yield_now();
+                }
+                total += start.elapsed();
+            }
+            total
+        })
+    });
+    group.finish();
+    confirming_set.stop();
+}
+
+criterion_group!(benches, block_processor_batch, confirming_set_cementation);
+criterion_main!(benches);
@@ -0,0 +1,109 @@
+use criterion::{criterion_group, criterion_main, BatchSize, BenchmarkId, Criterion, Throughput};
+use rsban_core::{Amount, BlockHash, PrivateKey, Vote, VoteSource, DEV_GENESIS_KEY};
+use rsban_network::ChannelId;
+use rsban_node::{
+    consensus::{ShardedVoteCache, VoteCacheConfig},
+    stats::Stats,
+};
+use std::{collections::HashMap, sync::Arc, time::Duration};
+use test_helpers::{assert_timely, setup_chain, start_election, System};
+
+const VOTE_POOL_SIZE: usize = 4096;
+
+fn create_votes(count: usize) -> Vec<Arc<Vote>> {
+    (0..count)
+        .map(|_| {
+            Arc::new(Vote::new(
+                &PrivateKey::new(),
+                Vote::TIMESTAMP_MIN,
+                0,
+                vec![BlockHash::random()],
+            ))
+        })
+        .collect()
+}
+
+/// Votes are signed in the setup, so only the validation and the routing is measured
+fn vote_processor(c: &mut Criterion) {
+    let mut system = System::new();
+    let mut config = System::default_config_without_backlog_population();
+    config.hinted_scheduler.enabled = false;
+    config.optimistic_scheduler.enabled = false;
+    let node = system.build_node().config(config).finish();
+
+    let blocks = setup_chain(&node, 1, &DEV_GENESIS_KEY, false);
+    let hash = blocks[0].hash();
+    start_election(&node, &hash);
+    assert_timely(Duration::from_secs(5), || {
+        node.active.election(&blocks[0].qualified_root()).is_some()
+    });
+
+    let channel_id = ChannelId::from(42);
+    let mut group = c.benchmark_group("vote_processor");
+    group.throughput(Throughput::Elements(1));
+
+    // No election for the voted hash, so the vote ends up in the vote cache
+    group.bench_function("vote_blocking_cached", |b| {
+        b.iter_batched(
+            || create_votes(1).pop().unwrap(),
+            |vote| {
+                node.vote_processor
+                    .vote_blocking(&vote, channel_id, VoteSource::Live)
+            },
+            BatchSize::SmallInput,
+        )
+    });
+
+    // Votes without weight, so the election stays active
+    group.bench_function("vote_blocking_active_election", |b| {
+        b.iter_batched(
+            || {
+                Arc::new(Vote::new(
+                    &PrivateKey::new(),
+                    Vote::TIMESTAMP_MIN,
+                    0,
+                    vec![hash],
+                ))
+            },
+            |vote| {
+                node.vote_processor
+                    .vote_blocking(&vote, channel_id, VoteSource::Live)
+            },
+            BatchSize::SmallInput,
+        )
+    });
+    group.finish();
+}
+
+fn vote_cache(c: &mut Criterion) {
+    let votes = create_votes(VOTE_POOL_SIZE);
+    let no_results = HashMap::new();
+
+    let mut group = c.benchmark_group("vote_cache");
+    group.throughput(Throughput::Elements(1));
+    group.bench_function("insert", |b| {
+        let cache = ShardedVoteCache::new(VoteCacheConfig::default(), Arc::new(Stats::default()));
+        let mut next = 0;
+        b.iter(|| {
+            cache.insert(&votes[next], Amount::raw(next as u128), &no_results);
+            next = (next + 1) % votes.len();
+        })
+    });
+    group.finish();
+
+    let mut group = c.benchmark_group("vote_cache_top");
+    for entries in [256, VOTE_POOL_SIZE] {
+        let cache = ShardedVoteCache::new(VoteCacheConfig::default(), Arc::new(Stats::default()));
+        for (i, vote) in votes.iter().take(entries).enumerate() {
+            cache.insert(vote, Amount::raw(i as u128), &no_results);
+        }
+        group.throughput(Throughput::Elements(entries as u64));
+        group.bench_with_input(BenchmarkId::from_parameter(entries), &cache, |b, cache| {
+            b.iter(|| cache.top(Amount::zero()))
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, vote_processor, vote_cache);
+criterion_main!(benches);
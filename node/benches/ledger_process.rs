@@ -0,0 +1,172 @@
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use rsban_core::{Amount, Block, PrivateKey, PublicKey, UnsavedBlockLatticeBuilder};
+use rsban_ledger::LedgerContext;
+use std::time::{Duration, Instant};
+
+/// A ledger on a temporary LMDB database. The in-memory null store can't be used here,
+/// because every block depends on the blocks that were written before it
+struct LedgerBench {
+    ctx: LedgerContext,
+    lattice: UnsavedBlockLatticeBuilder,
+}
+
+impl LedgerBench {
+    fn new() -> Self {
+        Self {
+            ctx: LedgerContext::empty_dev(),
+            lattice: UnsavedBlockLatticeBuilder::new(),
+        }
+    }
+
+    fn process_untimed(&self, blocks: &[Block]) {
+        let ledger = &self.ctx.ledger;
+        let mut txn = ledger.rw_txn();
+        for block in blocks {
+            ledger.process(&mut txn, block).unwrap();
+        }
+    }
+
+    /// Only the block insertion is measured, not the commit of the transaction
+    fn process_timed(&self, blocks: &[Block]) -> Duration {
+        let ledger = &self.ctx.ledger;
+        let mut txn = ledger.rw_txn();
+        let start = Instant::now();
+        for block in blocks {
+            ledger.process(&mut txn, block).unwrap();
+        }
+        let elapsed = start.elapsed();
+        txn.commit();
+        elapsed
+    }
+}
+
+/// `prepare` creates `iters` blocks of the benchmarked type and writes
+/// any blocks they depend on to the ledger
+fn bench_block_type(
+    c: &mut Criterion,
+    name: &str,
+    mut bench: LedgerBench,
+    mut prepare: impl FnMut(&mut LedgerBench, u64) -> Vec<Block>,
+) {
+    let mut group = c.benchmark_group("ledger_process");
+    group.throughput(Throughput::Elements(1));
+    group.bench_function(name, |b| {
+        b.iter_custom(|iters| {
+            let blocks = prepare(&mut bench, iters);
+            bench.process_timed(&blocks)
+        })
+    });
+    group.finish();
+}
+
+fn state_blocks(c: &mut Criterion) {
+    bench_block_type(c, "send", LedgerBench::new(), |bench, iters| {
+        (0..iters)
+            .map(|_| {
+                bench
+                    .lattice
+                    .genesis()
+                    .send(PrivateKey::new().account(), Amount::raw(1))
+            })
+            .collect()
+    });
+
+    let receiver = PrivateKey::new();
+    let mut bench = LedgerBench::new();
+    let send = bench
+        .lattice
+        .genesis()
+        .send(receiver.account(), Amount::raw(1));
+    let open = bench.lattice.account(&receiver).receive(&send);
+    bench.process_untimed(&[send, open]);
+    bench_block_type(c, "receive", bench, |bench, iters| {
+        let sends: Vec<_> = (0..iters)
+            .map(|_| {
+                bench
+                    .lattice
+                    .genesis()
+                    .send(receiver.account(), Amount::raw(1))
+            })
+            .collect();
+        bench.process_untimed(&sends);
+        sends
+            .iter()
+            .map(|send| bench.lattice.account(&receiver).receive(send))
+            .collect()
+    });
+
+    bench_block_type(c, "change", LedgerBench::new(), |bench, iters| {
+        (0..iters)
+            .map(|i| bench.lattice.genesis().change(PublicKey::from(i + 1)))
+            .collect()
+    });
+}
+
+fn legacy_blocks(c: &mut Criterion) {
+    bench_block_type(c, "legacy_send", LedgerBench::new(), |bench, iters| {
+        (0..iters)
+            .map(|_| {
+                bench
+                    .lattice
+                    .genesis()
+                    .legacy_send(PrivateKey::new().account(), Amount::raw(1))
+            })
+            .collect()
+    });
+
+    bench_block_type(c, "legacy_open", LedgerBench::new(), |bench, iters| {
+        let keys: Vec<_> = (0..iters).map(|_| PrivateKey::new()).collect();
+        let sends: Vec<_> = keys
+            .iter()
+            .map(|key| {
+                bench
+                    .lattice
+                    .genesis()
+                    .legacy_send(key.account(), Amount::raw(1))
+            })
+            .collect();
+        bench.process_untimed(&sends);
+        keys.iter()
+            .zip(&sends)
+            .map(|(key, send)| bench.lattice.account(key).legacy_open(send))
+            .collect()
+    });
+
+    let receiver = PrivateKey::new();
+    let mut bench = LedgerBench::new();
+    let send = bench
+        .lattice
+        .genesis()
+        .legacy_send(receiver.account(), Amount::raw(1));
+    let open = bench.lattice.account(&receiver).legacy_open(&send);
+    bench.process_untimed(&[send, open]);
+    bench_block_type(c, "legacy_receive", bench, |bench, iters| {
+        let sends: Vec<_> = (0..iters)
+            .map(|_| {
+                bench
+                    .lattice
+                    .genesis()
+                    .legacy_send(receiver.account(), Amount::raw(1))
+            })
+            .collect();
+        bench.process_untimed(&sends);
+        sends
+            .iter()
+            .map(|send| bench.lattice.account(&receiver).legacy_receive(send))
+            .collect()
+    });
+
+    bench_block_type(c, "legacy_change", LedgerBench::new(), |bench, iters| {
+        (0..iters)
+            .map(|i| {
+                bench
+                    .lattice
+                    .genesis()
+                    .legacy_change(PublicKey::from(i + 1))
+            })
+            .collect()
+    });
+}
+
+criterion_group!(benches, state_blocks, legacy_blocks);
+criterion_main!(benches);
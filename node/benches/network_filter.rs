@@ -0,0 +1,72 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use rsban_node::transport::{DefaultNetworkFilterHasher, NetworkFilter};
+use std::{
+    sync::Arc,
+    thread,
+    time::{Duration, Instant},
+};
+
+const FILTER_SIZE: usize = 1024 * 1024;
+const THREAD_COUNTS: [usize; 4] = [1, 4, 16, 64];
+
+/// Calls `apply_digest` from `threads` threads at the same time, like the
+/// message deserializers of many channels do. A single shard is the behaviour
+/// of the filter with one global lock.
+fn concurrent_apply(c: &mut Criterion) {
+    let mut group = c.benchmark_group("network_filter_apply");
+    for shards in [
+        1,
+        NetworkFilter::<DefaultNetworkFilterHasher>::DEFAULT_SHARDS,
+    ] {
+        let filter = Arc::new(NetworkFilter::with_shards(
+            DefaultNetworkFilterHasher::new(),
+            FILTER_SIZE,
+            shards,
+        ));
+        for threads in THREAD_COUNTS {
+            group.throughput(Throughput::Elements(2 * threads as u64));
+            group.bench_with_input(
+                BenchmarkId::new(format!("{shards}_shards"), threads),
+                &threads,
+                |b, &threads| {
+                    b.iter_custom(|iters| run_threads(&filter, threads, iters));
+                },
+            );
+        }
+    }
+    group.finish();
+}
+
+/// Every thread applies `iters` digests twice. Returns the time until all threads finished
+fn run_threads(filter: &Arc<NetworkFilter>, threads: usize, iters: u64) -> Duration {
+    let start = Instant::now();
+    let handles: Vec<_> = (0..threads)
+        .map(|t| {
+            let filter = Arc::clone(filter);
+            thread::spawn(move || {
+                let mut digest = (t as u128) << 64;
+                for _ in 0..iters {
+                    // Every message is received twice
+                    filter.apply_digest(digest);
+                    filter.apply_digest(digest);
+                    digest = digest.wrapping_add(0x9e37_79b9_7f4a_7c15);
+                }
+            })
+        })
+        .collect();
+    for handle in handles {
+        handle.join().unwrap();
+    }
+    start.elapsed()
+}
+
+fn apply_bytes(c: &mut Criterion) {
+    let filter = NetworkFilter::new(FILTER_SIZE);
+    let message = [42u8; 256];
+    c.bench_function("network_filter_apply_bytes", |b| {
+        b.iter(|| filter.apply(&message))
+    });
+}
+
+criterion_group!(benches, concurrent_apply, apply_bytes);
+criterion_main!(benches);
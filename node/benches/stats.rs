@@ -0,0 +1,61 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use rsban_node::stats::{DetailType, Direction, StatType, Stats, StatsJsonWriterV2};
+use std::{
+    sync::Arc,
+    thread,
+    time::{Duration, Instant},
+};
+
+const THREAD_COUNTS: [usize; 3] = [1, 4, 16];
+
+/// All threads increment the same counter, which is the worst case for contention
+fn concurrent_inc(c: &mut Criterion) {
+    let stats = Arc::new(Stats::default());
+    let mut group = c.benchmark_group("stats_inc");
+    for threads in THREAD_COUNTS {
+        group.throughput(Throughput::Elements(threads as u64));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(threads),
+            &threads,
+            |b, &threads| {
+                b.iter_custom(|iters| run_threads(&stats, threads, iters));
+            },
+        );
+    }
+    group.finish();
+}
+
+/// Every thread increments the counter `iters` times. Returns the time until all threads finished
+fn run_threads(stats: &Arc<Stats>, threads: usize, iters: u64) -> Duration {
+    let start = Instant::now();
+    let handles: Vec<_> = (0..threads)
+        .map(|_| {
+            let stats = Arc::clone(stats);
+            thread::spawn(move || {
+                for _ in 0..iters {
+                    stats.inc(StatType::Ledger, DetailType::Send);
+                }
+            })
+        })
+        .collect();
+    for handle in handles {
+        handle.join().unwrap();
+    }
+    start.elapsed()
+}
+
+fn log_counters(c: &mut Criterion) {
+    let stats = Stats::default();
+    stats.inc(StatType::Ledger, DetailType::Send);
+    stats.inc_dir(StatType::Message, DetailType::Publish, Direction::Out);
+    c.bench_function("stats_log_counters", |b| {
+        b.iter(|| {
+            let mut sink = StatsJsonWriterV2::new();
+            stats.log_counters(&mut sink).unwrap();
+            sink.finish()
+        })
+    });
+}
+
+criterion_group!(benches, concurrent_inc, log_counters);
+criterion_main!(benches);
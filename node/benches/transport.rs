@@ -0,0 +1,72 @@
+use criterion::{criterion_group, criterion_main, BatchSize, BenchmarkId, Criterion, Throughput};
+use rsban_core::work::WorkThresholds;
+use rsban_messages::{ConfirmAck, Keepalive, Message, MessageSerializer, ProtocolInfo, Publish};
+use rsban_node::transport::{FairQueue, MessageDeserializer, NetworkFilter, VecBufferReader};
+use std::sync::Arc;
+
+const BATCH_SIZE: usize = 256;
+
+/// Fills the queue from all sources and takes one batch out of it again
+fn fair_queue_next_batch(c: &mut Criterion) {
+    let mut group = c.benchmark_group("fair_queue_next_batch");
+    group.throughput(Throughput::Elements(BATCH_SIZE as u64));
+    for sources in [1usize, 16, 128] {
+        let mut queue: FairQueue<usize, u64> =
+            FairQueue::new(Box::new(|_: &usize| BATCH_SIZE), Box::new(|_: &usize| 1));
+        group.bench_with_input(
+            BenchmarkId::from_parameter(sources),
+            &sources,
+            |b, &sources| {
+                b.iter(|| {
+                    for i in 0..BATCH_SIZE {
+                        queue.push(i % sources, i as u64);
+                    }
+                    queue.next_batch(BATCH_SIZE)
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+fn message_deserializer(c: &mut Criterion) {
+    let runtime = tokio::runtime::Builder::new_current_thread()
+        .build()
+        .unwrap();
+    let protocol = ProtocolInfo::default();
+    let messages = [
+        ("publish", Message::Publish(Publish::new_test_instance())),
+        (
+            "confirm_ack",
+            Message::ConfirmAck(ConfirmAck::new_test_instance()),
+        ),
+        ("keepalive", Message::Keepalive(Keepalive::default())),
+    ];
+
+    let mut group = c.benchmark_group("message_deserializer");
+    group.throughput(Throughput::Elements(1));
+    for (name, message) in messages {
+        let buffer = MessageSerializer::new(protocol)
+            .serialize(&message)
+            .to_vec();
+        group.bench_function(name, |b| {
+            b.iter_batched(
+                // A fresh filter, because publish and confirm_ack duplicates get dropped
+                || {
+                    MessageDeserializer::new(
+                        protocol,
+                        WorkThresholds::new(0, 0, 0),
+                        Arc::new(NetworkFilter::new(1024)),
+                        VecBufferReader::new(buffer.clone()),
+                    )
+                },
+                |mut deserializer| runtime.block_on(deserializer.read()).unwrap(),
+                BatchSize::SmallInput,
+            )
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, fair_queue_next_batch, message_deserializer);
+criterion_main!(benches);
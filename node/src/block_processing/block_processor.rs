@@ -2,18 +2,19 @@ use super::UncheckedMap;
 use crate::{
     stats::{DetailType, StatType, Stats},
     transport::{FairQueue, FairQueueInfo},
+    utils::{AdaptiveBatchConfig, AdaptiveBatchSize, BatchLoop, Executor, TaskPriority},
 };
 use rsban_core::{
     utils::ContainerInfo, work::WorkThresholds, Block, BlockType, Epoch, HashOrAccount, Networks,
     SavedBlock, UncheckedInfo,
 };
-use rsban_ledger::{BlockStatus, Ledger, Writer};
+use rsban_ledger::{BlockPrecheck, BlockStatus, Ledger, Writer};
 use rsban_network::{ChannelId, DeadChannelCleanupStep};
 use rsban_store_lmdb::LmdbWriteTransaction;
 use std::{
     collections::VecDeque,
     mem::size_of,
-    sync::{Arc, Condvar, Mutex, MutexGuard},
+    sync::{Arc, Condvar, Mutex, MutexGuard, OnceLock},
     thread::JoinHandle,
     time::{Duration, Instant},
 };
@@ -56,7 +57,7 @@ pub struct BlockProcessorContext {
     pub source: BlockSource,
     callback: Option<BlockProcessorCallback>,
     pub arrival: Instant,
-    waiter: Arc<BlockProcessorWaiter>,
+    waiter: Option<Arc<BlockProcessorWaiter>>,
 }
 
 impl BlockProcessorContext {
@@ -71,22 +72,40 @@ impl BlockProcessorContext {
             source,
             arrival: Instant::now(),
             callback,
-            waiter: Arc::new(BlockProcessorWaiter::new()),
+            waiter: Some(Arc::new(BlockProcessorWaiter::new())),
+        }
+    }
+
+    /// For blocks of a chain segment, which nobody waits for individually
+    fn without_waiter(block: Block, source: BlockSource, arrival: Instant) -> Self {
+        Self {
+            block: Mutex::new(block),
+            saved_block: Mutex::new(None),
+            source,
+            arrival,
+            callback: None,
+            waiter: None,
         }
     }
 
     pub fn set_result(&self, result: BlockStatus) {
-        self.waiter.set_result(result);
+        if let Some(waiter) = &self.waiter {
+            waiter.set_result(result);
+        }
     }
 
     pub fn get_waiter(&self) -> Arc<BlockProcessorWaiter> {
-        self.waiter.clone()
+        self.waiter
+            .clone()
+            .expect("block was added without a waiter")
     }
 }
 
 impl Drop for BlockProcessorContext {
     fn drop(&mut self) {
-        self.waiter.cancel()
+        if let Some(waiter) = &self.waiter {
+            waiter.cancel()
+        }
     }
 }
 
@@ -137,13 +156,28 @@ pub struct BlockProcessorConfig {
     pub priority_local: usize,
     pub batch_max_time: Duration,
     pub full_size: usize,
+    /// Overrides the adaptive batch sizes with a fixed size if it's not 0
     pub batch_size: usize,
+    /// Batch sizing while live or local blocks are queued. Small batches
+    /// keep the write lock short, so that live blocks are confirmed quickly
+    pub live_batch: AdaptiveBatchConfig,
+    /// Batch sizing while only bootstrap blocks are queued. Large batches
+    /// make the most of each write transaction
+    pub bootstrap_batch: AdaptiveBatchConfig,
     pub work_thresholds: WorkThresholds,
+    /// Extra threads for the stateless block checks. The processing thread does checks as well
+    pub signature_checker_threads: usize,
 }
 
 impl BlockProcessorConfig {
     pub const DEFAULT_BATCH_SIZE: usize = 0;
     pub const DEFAULT_FULL_SIZE: usize = 65536;
+    pub const DEFAULT_LIVE_BATCH: AdaptiveBatchConfig =
+        AdaptiveBatchConfig::new(16, 256, Duration::from_millis(50));
+
+    pub fn default_bootstrap_batch(batch_max_time: Duration) -> AdaptiveBatchConfig {
+        AdaptiveBatchConfig::new(64, 4096, batch_max_time / 2)
+    }
 
     pub fn new(work_thresholds: WorkThresholds) -> Self {
         Self {
@@ -156,6 +190,9 @@ impl BlockProcessorConfig {
             batch_max_time: Duration::from_millis(500),
             full_size: Self::DEFAULT_FULL_SIZE,
             batch_size: Self::DEFAULT_BATCH_SIZE,
+            live_batch: Self::DEFAULT_LIVE_BATCH,
+            bootstrap_batch: Self::default_bootstrap_batch(Duration::from_millis(500)),
+            signature_checker_threads: 0,
         }
     }
 
@@ -192,10 +229,40 @@ impl BlockProcessor {
             BlockSource::Forced | BlockSource::Unknown => 1,
         });
 
+        // A fixed batch size from the command line overrides both profiles
+        let batch_config = |adaptive: AdaptiveBatchConfig| {
+            if config.batch_size > 0 {
+                AdaptiveBatchConfig::fixed(config.batch_size)
+            } else {
+                adaptive
+            }
+        };
+        let live_batch = AdaptiveBatchSize::new(
+            batch_config(config.live_batch),
+            stats.clone(),
+            DetailType::Live,
+        );
+        let bootstrap_batch = AdaptiveBatchSize::new(
+            batch_config(config.bootstrap_batch),
+            stats.clone(),
+            DetailType::Bootstrap,
+        );
+
+        let precheck_pool = if config.signature_checker_threads > 0 {
+            Some(Mutex::new(scoped_threadpool::Pool::new(
+                config.signature_checker_threads as u32,
+            )))
+        } else {
+            None
+        };
+
         Self {
             processor_loop: Arc::new(BlockProcessorLoop {
                 mutex: Mutex::new(BlockProcessorImpl {
                     queue: FairQueue::new(max_size_query, priority_query),
+                    segments: VecDeque::new(),
+                    segment_blocks: 0,
+                    segment_turn: false,
                     last_log: None,
                     stopped: false,
                 }),
@@ -204,10 +271,14 @@ impl BlockProcessor {
                 unchecked_map,
                 config,
                 stats,
+                precheck_pool,
+                live_batch,
+                bootstrap_batch,
                 blocks_rolled_back: Mutex::new(None),
                 block_rolled_back: Mutex::new(Vec::new()),
                 block_processed: Mutex::new(Vec::new()),
                 batch_processed: Mutex::new(Vec::new()),
+                batch_loop: OnceLock::new(),
             }),
             thread: Mutex::new(None),
         }
@@ -239,6 +310,27 @@ impl BlockProcessor {
         );
     }
 
+    /// Processes the batches as `LedgerWrite` tasks of the executor instead of
+    /// on a dedicated thread. Only one batch runs at a time
+    pub fn start_on(&self, executor: &Arc<Executor>) {
+        let processor_loop = Arc::downgrade(&self.processor_loop);
+        let batch_loop = BatchLoop::new(
+            executor,
+            TaskPriority::LedgerWrite,
+            1,
+            Box::new(move || {
+                processor_loop
+                    .upgrade()
+                    .is_some_and(|processor_loop| processor_loop.run_batch())
+            }),
+        );
+        assert!(
+            self.processor_loop.batch_loop.set(batch_loop).is_ok(),
+            "block processor already started"
+        );
+        self.processor_loop.wake();
+    }
+
     pub fn stop(&self) {
         self.processor_loop.mutex.lock().unwrap().stopped = true;
         self.processor_loop.condition.notify_all();
@@ -246,6 +338,9 @@ impl BlockProcessor {
         if let Some(join_handle) = join_handle {
             join_handle.join().unwrap();
         }
+        if let Some(batch_loop) = self.processor_loop.batch_loop.get() {
+            batch_loop.stop();
+        }
     }
 
     pub fn total_queue_len(&self) -> usize {
@@ -289,6 +384,19 @@ impl BlockProcessor {
             .add(block, source, channel_id, Some(callback))
     }
 
+    /// Adds a verified segment of an account chain, ordered from the oldest to the newest block.
+    /// The segment bypasses the fair queue and is inserted in a single write transaction,
+    /// together with the segments queued after it, up to the bootstrap batch size.
+    /// The callback is called with the result of the last block.
+    pub fn add_chain(
+        &self,
+        blocks: Vec<Block>,
+        source: BlockSource,
+        callback: Option<BlockProcessorCallback>,
+    ) -> bool {
+        self.processor_loop.add_chain(blocks, source, callback)
+    }
+
     pub fn add_blocking(
         &self,
         block: Arc<Block>,
@@ -338,46 +446,97 @@ pub(crate) struct BlockProcessorLoop {
     unchecked_map: Arc<UncheckedMap>,
     config: BlockProcessorConfig,
     stats: Arc<Stats>,
+    precheck_pool: Option<Mutex<scoped_threadpool::Pool>>,
+    live_batch: AdaptiveBatchSize,
+    bootstrap_batch: AdaptiveBatchSize,
     blocks_rolled_back: Mutex<Option<Box<dyn Fn(Vec<SavedBlock>, SavedBlock) + Send + Sync>>>,
     block_rolled_back: Mutex<Vec<Box<dyn Fn(&Block) + Send + Sync>>>,
     block_processed: Mutex<Vec<Box<dyn Fn(BlockStatus, &BlockProcessorContext) + Send + Sync>>>,
     batch_processed:
         Mutex<Vec<Box<dyn Fn(&[(BlockStatus, Arc<BlockProcessorContext>)]) + Send + Sync>>>,
+    /// Set when the batches run on the executor instead of the processing thread
+    batch_loop: OnceLock<Arc<BatchLoop>>,
 }
 
 impl BlockProcessorLoop {
     pub fn run(&self) {
         let mut guard = self.mutex.lock().unwrap();
         while !guard.stopped {
-            if !guard.queue.is_empty() {
-                if guard.should_log() {
-                    info!(
-                        "{} blocks (+ {} forced) in processing_queue",
-                        guard.queue.len(),
-                        guard
-                            .queue
-                            .queue_len(&(BlockSource::Forced, ChannelId::LOOPBACK))
-                    );
-                }
+            if guard.has_work() {
+                self.process_next(guard);
+                guard = self.mutex.lock().unwrap();
+            } else {
+                self.condition.notify_one();
+                guard = self.condition.wait(guard).unwrap();
+            }
+        }
+    }
+
+    /// Processes the next batch or chain segment, if there is one.
+    /// Returns true if there is more work
+    fn run_batch(&self) -> bool {
+        let guard = self.mutex.lock().unwrap();
+        if guard.stopped || !guard.has_work() {
+            return false;
+        }
+        self.process_next(guard);
+        let guard = self.mutex.lock().unwrap();
+        !guard.stopped && guard.has_work()
+    }
 
-                let mut processed = self.process_batch(guard);
+    fn process_next(&self, mut guard: MutexGuard<BlockProcessorImpl>) {
+        if guard.should_log() {
+            info!(
+                "{} blocks (+ {} forced, {} in chain segments) in processing_queue",
+                guard.queue.len(),
+                guard
+                    .queue
+                    .queue_len(&(BlockSource::Forced, ChannelId::LOOPBACK)),
+                guard.segment_blocks
+            );
+        }
 
-                // Set results for futures when not holding the lock
-                for (result, context) in processed.iter_mut() {
-                    if let Some(cb) = &context.callback {
-                        cb(*result);
+        let (mut processed, segment_callbacks) =
+            match guard.next_segments(self.bootstrap_batch.current()) {
+                Some(segments) => {
+                    drop(guard);
+                    let mut contexts = Vec::new();
+                    let mut callbacks = Vec::with_capacity(segments.len());
+                    for segment in segments {
+                        contexts.extend(segment.contexts);
+                        // Segments are never empty, so this is the index of the segment's last block
+                        callbacks.push((contexts.len() - 1, segment.callback));
                     }
-                    context.set_result(*result);
+                    (
+                        self.process_contexts(contexts, Some(&self.bootstrap_batch)),
+                        callbacks,
+                    )
                 }
+                None => (self.process_batch(guard), Vec::new()),
+            };
 
-                self.notify_batch_processed(&processed);
-
-                guard = self.mutex.lock().unwrap();
-            } else {
-                self.condition.notify_one();
-                guard = self.condition.wait(guard).unwrap();
+        // Set results for futures when not holding the lock
+        for (result, context) in processed.iter_mut() {
+            if let Some(cb) = &context.callback {
+                cb(*result);
+            }
+            context.set_result(*result);
+        }
+        for (last, callback) in segment_callbacks {
+            if let (Some(cb), Some((result, _))) = (callback, processed.get(last)) {
+                cb(*result);
             }
         }
+
+        self.notify_batch_processed(&processed);
+    }
+
+    /// Wakes up the processing thread or submits a batch to the executor
+    fn wake(&self) {
+        self.condition.notify_all();
+        if let Some(batch_loop) = self.batch_loop.get() {
+            batch_loop.notify();
+        }
     }
 
     fn notify_batch_processed(&self, blocks: &Vec<(BlockStatus, Arc<BlockProcessorContext>)>) {
@@ -460,6 +619,75 @@ impl BlockProcessorLoop {
         )
     }
 
+    pub fn add_chain(
+        &self,
+        blocks: Vec<Block>,
+        source: BlockSource,
+        callback: Option<BlockProcessorCallback>,
+    ) -> bool {
+        debug_assert!(source != BlockSource::Forced);
+        if blocks.is_empty() {
+            return false;
+        }
+        if !blocks
+            .iter()
+            .all(|block| self.config.work_thresholds.validate_entry_block(block))
+        {
+            // The rest of the segment can't be inserted without the block
+            self.stats
+                .inc(StatType::Blockprocessor, DetailType::InsufficientWork);
+            return false;
+        }
+
+        self.stats
+            .inc(StatType::Blockprocessor, DetailType::ProcessChain);
+        self.stats.add(
+            StatType::Blockprocessor,
+            DetailType::Process,
+            blocks.len() as u64,
+        );
+        debug!(
+            "Processing chain segment (async): {} blocks, first: {} (source: {:?})",
+            blocks.len(),
+            blocks[0].hash(),
+            source
+        );
+
+        let arrival = Instant::now();
+        let contexts: Vec<_> = blocks
+            .into_iter()
+            .map(|block| {
+                Arc::new(BlockProcessorContext::without_waiter(
+                    block, source, arrival,
+                ))
+            })
+            .collect();
+
+        let added = {
+            let mut guard = self.mutex.lock().unwrap();
+            if guard.segment_blocks + contexts.len() > self.config.max_system_queue {
+                false
+            } else {
+                guard.segment_blocks += contexts.len();
+                guard.segments.push_back(ChainSegment {
+                    contexts,
+                    source,
+                    callback,
+                });
+                true
+            }
+        };
+        if added {
+            self.wake();
+        } else {
+            self.stats
+                .inc(StatType::Blockprocessor, DetailType::Overfill);
+            self.stats
+                .inc(StatType::BlockprocessorOverfill, source.into());
+        }
+        added
+    }
+
     pub fn add_blocking(
         &self,
         block: Arc<Block>,
@@ -503,15 +731,16 @@ impl BlockProcessorLoop {
 
     // TODO: Remove and replace all checks with calls to size (block_source)
     pub fn total_queue_len(&self) -> usize {
-        self.mutex.lock().unwrap().queue.len()
+        let guard = self.mutex.lock().unwrap();
+        guard.queue.len() + guard.segment_blocks
     }
 
     pub fn queue_len(&self, source: BlockSource) -> usize {
-        self.mutex
-            .lock()
-            .unwrap()
+        let guard = self.mutex.lock().unwrap();
+        guard
             .queue
             .sum_queue_len((source, ChannelId::MIN)..=(source, ChannelId::MAX))
+            + guard.segment_len(source)
     }
 
     fn add_impl(&self, context: Arc<BlockProcessorContext>, channel_id: ChannelId) -> bool {
@@ -522,7 +751,7 @@ impl BlockProcessorLoop {
             added = guard.queue.push((source, channel_id), context);
         }
         if added {
-            self.condition.notify_all();
+            self.wake();
         } else {
             self.stats
                 .inc(StatType::Blockprocessor, DetailType::Overfill);
@@ -552,11 +781,47 @@ impl BlockProcessorLoop {
         &self,
         mut guard: MutexGuard<BlockProcessorImpl>,
     ) -> Vec<(BlockStatus, Arc<BlockProcessorContext>)> {
-        let batch = self.next_batch(&mut guard, 256);
+        let batch_size = self.batch_size_for(&guard);
+        let batch = self.next_batch(&mut guard, batch_size.current());
         drop(guard);
+        self.process_contexts(batch.into(), Some(batch_size))
+    }
 
+    /// Bootstrap blocks are processed in large batches, unless live blocks are waiting
+    fn batch_size_for(&self, data: &BlockProcessorImpl) -> &AdaptiveBatchSize {
+        let bootstrap_len = data.queue.sum_queue_len(
+            (BlockSource::Bootstrap, ChannelId::MIN)..=(BlockSource::Unchecked, ChannelId::MAX),
+        );
+        if bootstrap_len == data.queue.len() {
+            &self.bootstrap_batch
+        } else {
+            &self.live_batch
+        }
+    }
+
+    /// Inserts the blocks in a single write transaction.
+    /// The write lock hold time is fed back into the batch size, if there is one
+    fn process_contexts(
+        &self,
+        batch: Vec<Arc<BlockProcessorContext>>,
+        batch_size: Option<&AdaptiveBatchSize>,
+    ) -> Vec<(BlockStatus, Arc<BlockProcessorContext>)> {
+        let dequeued = Instant::now();
+        let queue_latency = batch
+            .iter()
+            .map(|ctx| ctx.arrival)
+            .min()
+            .map(|arrival| dequeued.saturating_duration_since(arrival));
+        let precheck_timer = dequeued;
+        let prechecks = self.precheck_batch(&batch);
+        self.add_timing(DetailType::Precheck, precheck_timer);
+
+        let wait_timer = Instant::now();
         let mut write_guard = self.ledger.write_queue.wait(Writer::BlockProcessor);
+        self.add_timing(DetailType::WriteLockWait, wait_timer);
         let mut tx = self.ledger.rw_txn();
+        // Rep weight readers see the changes of the whole batch at once
+        let rep_weights_batch = self.ledger.rep_weights_updater.begin_batch();
 
         let timer = Instant::now();
 
@@ -565,7 +830,7 @@ impl BlockProcessorLoop {
         let mut number_of_forced_processed = 0;
 
         let mut processed = Vec::new();
-        for ctx in batch {
+        for (ctx, precheck) in batch.into_iter().zip(prechecks.iter()) {
             let force = ctx.source == BlockSource::Forced;
 
             (write_guard, tx) = self.ledger.refresh_if_needed(write_guard, tx);
@@ -578,10 +843,25 @@ impl BlockProcessorLoop {
 
             number_of_blocks_processed += 1;
 
-            let result = self.process_one(&mut tx, &ctx);
+            let result = self.process_one(&mut tx, &ctx, precheck);
             processed.push((result, ctx));
         }
 
+        self.ledger.commit(write_guard, &mut tx);
+        drop(rep_weights_batch);
+        self.add_timing(DetailType::WriteLockHeld, timer);
+        if let Some(batch_size) = batch_size {
+            batch_size.update(number_of_blocks_processed, timer.elapsed(), queue_latency);
+        }
+
+        self.stats.block_latency().processed(
+            processed
+                .iter()
+                .filter(|(status, _)| *status == BlockStatus::Progress)
+                .map(|(_, ctx)| (ctx.block.lock().unwrap().hash(), ctx.source, ctx.arrival)),
+            dequeued,
+        );
+
         if number_of_blocks_processed != 0 && timer.elapsed() > Duration::from_millis(100) {
             debug!(
                 "Processed {} blocks ({} blocks were forced) in {} ms",
@@ -593,16 +873,84 @@ impl BlockProcessorLoop {
         processed
     }
 
+    /// Runs the stateless checks (signature, work difficulty, hash) for the whole batch
+    /// in parallel, so that the write transaction only has to do the stateful checks.
+    /// The batch is split evenly across the checker threads. Chunks of at least
+    /// `SignatureBatch::MIN_BATCH_SIZE` blocks get their signatures batch verified
+    /// Smaller chunks aren't worth handing over to another thread
+    const MIN_PRECHECK_CHUNK: usize = 16;
+
+    fn precheck_batch(&self, batch: &[Arc<BlockProcessorContext>]) -> Vec<BlockPrecheck> {
+        let epochs = &self.ledger.constants.epochs;
+        let work = &self.ledger.constants.work;
+        let precheck_chunk = |contexts: &[Arc<BlockProcessorContext>],
+                              results: &mut [BlockPrecheck]| {
+            let blocks: Vec<_> = contexts
+                .iter()
+                .map(|ctx| ctx.block.lock().unwrap())
+                .collect();
+            let blocks: Vec<&Block> = blocks.iter().map(|block| &**block).collect();
+            let prechecks = BlockPrecheck::new_batch(&blocks, epochs, work);
+            for (result, precheck) in results.iter_mut().zip(prechecks) {
+                *result = precheck;
+            }
+        };
+
+        let mut prechecks = vec![BlockPrecheck::default(); batch.len()];
+        match &self.precheck_pool {
+            Some(pool) if batch.len() >= 2 * Self::MIN_PRECHECK_CHUNK => {
+                let mut pool = pool.lock().unwrap();
+                let chunk_count =
+                    (pool.thread_count() as usize + 1).min(batch.len() / Self::MIN_PRECHECK_CHUNK);
+                self.stats
+                    .inc(StatType::Blockprocessor, DetailType::PrecheckParallel);
+                // Every chunk gets at least MIN_PRECHECK_CHUNK blocks
+                let mut chunks = Vec::with_capacity(chunk_count);
+                let (mut contexts, mut results) = (batch, prechecks.as_mut_slice());
+                for remaining in (1..=chunk_count).rev() {
+                    let size = contexts.len() / remaining;
+                    let (chunk_contexts, rest_contexts) = contexts.split_at(size);
+                    let (chunk_results, rest_results) =
+                        std::mem::take(&mut results).split_at_mut(size);
+                    chunks.push((chunk_contexts, chunk_results));
+                    (contexts, results) = (rest_contexts, rest_results);
+                }
+                pool.scoped(|scope| {
+                    let mut chunks = chunks.into_iter();
+                    // The processing thread checks the first chunk itself
+                    let first = chunks.next();
+                    for (contexts, results) in chunks {
+                        scope.execute(move || precheck_chunk(contexts, results));
+                    }
+                    if let Some((contexts, results)) = first {
+                        precheck_chunk(contexts, results);
+                    }
+                });
+            }
+            _ => precheck_chunk(batch, &mut prechecks),
+        }
+        prechecks
+    }
+
+    fn add_timing(&self, stage: DetailType, start: Instant) {
+        self.stats.add(
+            StatType::BlockprocessorTiming,
+            stage,
+            start.elapsed().as_micros() as u64,
+        );
+    }
+
     pub fn process_one(
         &self,
         txn: &mut LmdbWriteTransaction,
         context: &BlockProcessorContext,
+        precheck: &BlockPrecheck,
     ) -> BlockStatus {
-        let mut block = context.block.lock().unwrap().clone();
+        let block = context.block.lock().unwrap().clone();
         let hash = block.hash();
         let mut saved_block = None;
 
-        let result = match self.ledger.process(txn, &mut block) {
+        let result = match self.ledger.process_prechecked(txn, &block, precheck) {
             Ok(saved) => {
                 saved_block = Some(saved.clone());
                 *context.saved_block.lock().unwrap() = Some(saved);
@@ -727,6 +1075,11 @@ impl BlockProcessorLoop {
         let guard = self.mutex.lock().unwrap();
         ContainerInfo::builder()
             .leaf("blocks", guard.queue.len(), size_of::<Arc<Block>>())
+            .leaf(
+                "chain_segment_blocks",
+                guard.segment_blocks,
+                size_of::<Arc<BlockProcessorContext>>(),
+            )
             .leaf(
                 "forced",
                 guard
@@ -734,18 +1087,69 @@ impl BlockProcessorLoop {
                     .queue_len(&(BlockSource::Forced, ChannelId::LOOPBACK)),
                 size_of::<Arc<Block>>(),
             )
+            .leaf("live_batch_size", self.live_batch.current(), 0)
+            .leaf("bootstrap_batch_size", self.bootstrap_batch.current(), 0)
             .node("queue", guard.queue.container_info())
             .finish()
     }
 }
 
+/// Consecutive blocks of one account chain, which are inserted together
+struct ChainSegment {
+    contexts: Vec<Arc<BlockProcessorContext>>,
+    source: BlockSource,
+    callback: Option<BlockProcessorCallback>,
+}
+
 struct BlockProcessorImpl {
     pub queue: FairQueue<(BlockSource, ChannelId), Arc<BlockProcessorContext>>,
+    segments: VecDeque<ChainSegment>,
+    /// Number of blocks in all queued segments
+    segment_blocks: usize,
+    /// Segments and batches from the fair queue take turns, so neither can starve the other
+    segment_turn: bool,
     pub last_log: Option<Instant>,
     stopped: bool,
 }
 
 impl BlockProcessorImpl {
+    fn has_work(&self) -> bool {
+        !self.queue.is_empty() || !self.segments.is_empty()
+    }
+
+    /// Takes the queued segments in order, as long as they fit into `max_blocks`.
+    /// The first segment is always taken, even if it is bigger
+    fn next_segments(&mut self, max_blocks: usize) -> Option<Vec<ChainSegment>> {
+        if self.segments.is_empty() {
+            return None;
+        }
+        if !self.queue.is_empty() && !self.segment_turn {
+            self.segment_turn = true;
+            return None;
+        }
+        self.segment_turn = false;
+        let mut segments = Vec::new();
+        let mut blocks = 0;
+        while let Some(segment) = self.segments.front() {
+            if !segments.is_empty() && blocks + segment.contexts.len() > max_blocks {
+                break;
+            }
+            let segment = self.segments.pop_front().unwrap();
+            blocks += segment.contexts.len();
+            segments.push(segment);
+        }
+        self.segment_blocks -= blocks;
+        Some(segments)
+    }
+
+    fn segment_len(&self, source: BlockSource) -> usize {
+        self.segments
+            .iter()
+            .filter(|segment| segment.source == source)
+            .map(|segment| segment.contexts.len())
+            .sum()
+    }
+
     fn next(&mut self) -> Arc<BlockProcessorContext> {
         debug_assert!(!self.queue.is_empty()); // This should be checked before calling next
         if !self.queue.is_empty() {
@@ -821,4 +1225,145 @@ mod tests {
 
         assert_eq!(block_processor.total_queue_len(), 0);
     }
+
+    #[test]
+    fn add_chain_segment() {
+        let block_processor = BlockProcessor::new(
+            BlockProcessorConfig::new(WorkThresholds::new_stub()),
+            Arc::new(Ledger::new_null()),
+            Arc::new(UncheckedMap::default()),
+            Arc::new(Stats::default()),
+        );
+        let blocks: Vec<_> = (0..3u64)
+            .map(|i| Block::new_test_instance_with_key(i + 1))
+            .collect();
+
+        assert!(block_processor.add_chain(blocks, BlockSource::Bootstrap, None));
+
+        assert_eq!(block_processor.queue_len(BlockSource::Bootstrap), 3);
+        assert_eq!(block_processor.queue_len(BlockSource::Live), 0);
+        assert_eq!(block_processor.total_queue_len(), 3);
+    }
+
+    #[test]
+    fn reject_chain_segment_with_insufficient_work() {
+        let block_processor = BlockProcessor::new(
+            BlockProcessorConfig::new(WorkThresholds::new_stub()),
+            Arc::new(Ledger::new_null()),
+            Arc::new(UncheckedMap::default()),
+            Arc::new(Stats::default()),
+        );
+        let mut block = Block::new_test_instance_with_key(2);
+        block.set_work(3);
+
+        let added = block_processor.add_chain(
+            vec![Block::new_test_instance_with_key(1), block],
+            BlockSource::Bootstrap,
+            None,
+        );
+
+        assert_eq!(added, false);
+        assert_eq!(block_processor.total_queue_len(), 0);
+    }
+
+    #[test]
+    fn chain_segments_take_turns_with_fair_queue() {
+        let block_processor = BlockProcessor::new(
+            BlockProcessorConfig::new(WorkThresholds::new_stub()),
+            Arc::new(Ledger::new_null()),
+            Arc::new(UncheckedMap::default()),
+            Arc::new(Stats::default()),
+        );
+        block_processor.add_chain(
+            vec![Block::new_test_instance()],
+            BlockSource::Bootstrap,
+            None,
+        );
+        block_processor.add(
+            Block::new_test_instance_with_key(42),
+            BlockSource::Live,
+            ChannelId::LOOPBACK,
+        );
+
+        let mut guard = block_processor.processor_loop.mutex.lock().unwrap();
+        assert!(guard.next_segments(usize::MAX).is_none());
+        assert!(guard.next_segments(usize::MAX).is_some());
+        assert_eq!(guard.segment_blocks, 0);
+    }
+
+    #[test]
+    fn drain_queued_chain_segments_into_one_batch() {
+        let block_processor = BlockProcessor::new(
+            BlockProcessorConfig::new(WorkThresholds::new_stub()),
+            Arc::new(Ledger::new_null()),
+            Arc::new(UncheckedMap::default()),
+            Arc::new(Stats::default()),
+        );
+        for key in [1, 3, 5] {
+            let blocks = vec![
+                Block::new_test_instance_with_key(key),
+                Block::new_test_instance_with_key(key + 1),
+            ];
+            block_processor.add_chain(blocks, BlockSource::Bootstrap, None);
+        }
+
+        let mut guard = block_processor.processor_loop.mutex.lock().unwrap();
+        let segments = guard.next_segments(5).unwrap();
+        let firsts: Vec<_> = segments
+            .iter()
+            .map(|segment| segment.contexts[0].block.lock().unwrap().hash())
+            .collect();
+        assert_eq!(
+            firsts,
+            vec![
+                Block::new_test_instance_with_key(1).hash(),
+                Block::new_test_instance_with_key(3).hash()
+            ]
+        );
+        assert_eq!(guard.segment_blocks, 2);
+
+        // A segment bigger than the limit is still taken on its own
+        assert_eq!(guard.next_segments(1).unwrap().len(), 1);
+        assert_eq!(guard.segment_blocks, 0);
+    }
+
+    #[test]
+    fn precheck_batch_in_parallel() {
+        let mut config = BlockProcessorConfig::new(WorkThresholds::new_stub());
+        config.signature_checker_threads = 2;
+        let ledger = Arc::new(Ledger::new_null());
+        let unchecked = Arc::new(UncheckedMap::default());
+        let stats = Arc::new(Stats::default());
+        let block_processor = BlockProcessor::new(config, ledger.clone(), unchecked, stats.clone());
+
+        let batch: Vec<_> = (0..50u64)
+            .map(|i| {
+                Arc::new(BlockProcessorContext::new(
+                    Block::new_test_instance_with_key(i + 1),
+                    BlockSource::Live,
+                    None,
+                ))
+            })
+            .collect();
+
+        let prechecks = block_processor.processor_loop.precheck_batch(&batch);
+
+        assert_eq!(prechecks.len(), batch.len());
+        for (ctx, precheck) in batch.iter().zip(prechecks.iter()) {
+            let block = ctx.block.lock().unwrap();
+            assert_eq!(
+                *precheck,
+                BlockPrecheck::new(&block, &ledger.constants.epochs, &ledger.constants.work)
+            );
+            assert!(precheck.valid_signer.is_some());
+        }
+        assert_eq!(
+            stats.count(
+                StatType::Blockprocessor,
+                DetailType::PrecheckParallel,
+                Direction::In
+            ),
+            1
+        );
+    }
 }
@@ -1,14 +1,18 @@
 use crate::stats::{DetailType, StatType, Stats};
 use rsban_core::{utils::ContainerInfo, BlockHash, HashOrAccount, UncheckedInfo, UncheckedKey};
+use rsban_store_lmdb::{LmdbUncheckedStore, LmdbWriteTransaction};
 use std::{
     cmp::Ordering,
     collections::{BTreeMap, VecDeque},
     mem::size_of,
     ops::DerefMut,
-    sync::{Arc, Condvar, Mutex},
+    sync::{atomic, atomic::AtomicUsize, Arc, Condvar, Mutex},
     thread::JoinHandle,
 };
 
+/// Maximum number of evicted entries which are written to the overflow in one write transaction
+const SPILL_BATCH_SIZE: usize = 256;
+
 pub struct UncheckedMap {
     join_handle: Mutex<Option<JoinHandle<()>>>,
     thread: Arc<UncheckedMapThread>,
@@ -16,10 +20,22 @@ pub struct UncheckedMap {
     condition: Arc<Condvar>,
     stats: Arc<Stats>,
     max_unchecked_blocks: usize,
+    overflow: Option<Arc<UncheckedOverflow>>,
 }
 
 impl UncheckedMap {
     pub fn new(max_unchecked_blocks: usize, stats: Arc<Stats>, disable_delete: bool) -> Self {
+        Self::with_overflow(max_unchecked_blocks, stats, disable_delete, None)
+    }
+
+    /// With an overflow the entries which are evicted from memory are spilled to disk
+    /// instead of being dropped
+    pub fn with_overflow(
+        max_unchecked_blocks: usize,
+        stats: Arc<Stats>,
+        disable_delete: bool,
+        overflow: Option<Arc<UncheckedOverflow>>,
+    ) -> Self {
         let mutable = Arc::new(Mutex::new(ThreadMutableData::new()));
         let condition = Arc::new(Condvar::new());
 
@@ -29,6 +45,7 @@ impl UncheckedMap {
             condition: condition.clone(),
             stats: stats.clone(),
             back_buffer: Mutex::new(VecDeque::new()),
+            overflow: overflow.clone(),
         });
 
         Self {
@@ -38,6 +55,7 @@ impl UncheckedMap {
             condition,
             stats,
             max_unchecked_blocks,
+            overflow,
         }
     }
 
@@ -65,19 +83,47 @@ impl UncheckedMap {
 
     pub fn exists(&self, key: &UncheckedKey) -> bool {
         let lock = self.mutable.lock().unwrap();
-        lock.entries_container.exists(key)
+        if lock.entries_container.exists(key) || lock.spill_queue.exists(key) {
+            return true;
+        }
+        drop(lock);
+        self.overflow.as_ref().is_some_and(|o| o.exists(key))
     }
 
     pub fn put(&self, dependency: HashOrAccount, info: UncheckedInfo) {
-        let mut lock = self.mutable.lock().unwrap();
         let key = UncheckedKey::new(dependency.into(), info.block.hash());
+        let mut lock = self.mutable.lock().unwrap();
+        if lock.spill_queue.exists(&key) {
+            return;
+        }
         let inserted = lock.entries_container.insert(Entry::new(key, info));
+        let mut spilling = false;
+        let mut dropped = false;
         if lock.entries_container.len() > self.max_unchecked_blocks {
-            lock.entries_container.pop_front();
+            let evicted = lock.entries_container.pop_front();
+            if let Some(evicted) = evicted {
+                // The evicted entry is written to disk by the unchecked thread, so that
+                // put never waits for LMDB
+                if self.overflow.is_some() && lock.spill_queue.len() < self.max_unchecked_blocks {
+                    lock.spill_queue.insert(evicted);
+                    spilling = true;
+                } else if self.overflow.is_some() {
+                    dropped = true;
+                }
+            }
         }
+        drop(lock);
+
         if inserted {
             self.stats.inc(StatType::Unchecked, DetailType::Put);
         }
+        if spilling {
+            self.condition.notify_all();
+        }
+        if dropped {
+            self.stats
+                .inc(StatType::Unchecked, DetailType::OverflowFull);
+        }
     }
 
     pub fn get(&self, hash: &HashOrAccount) -> Vec<UncheckedInfo> {
@@ -90,12 +136,28 @@ impl UncheckedMap {
             },
             || true,
         );
+        lock.spill_queue.for_each_with_dependency(
+            hash,
+            |_, info| {
+                result.push(info.clone());
+            },
+            || true,
+        );
+        drop(lock);
+        if let Some(overflow) = &self.overflow {
+            result.extend(overflow.get_dependents(hash).into_iter().map(|(_, i)| i));
+        }
         result
     }
 
     pub fn clear(&self) {
         let mut lock = self.mutable.lock().unwrap();
         lock.entries_container.clear();
+        lock.spill_queue.clear();
+        drop(lock);
+        if let Some(overflow) = &self.overflow {
+            overflow.clear();
+        }
     }
 
     pub fn trigger(&self, dependency: &HashOrAccount) {
@@ -108,17 +170,40 @@ impl UncheckedMap {
 
     pub fn remove(&self, key: &UncheckedKey) {
         let mut lock = self.mutable.lock().unwrap();
-        lock.entries_container.remove(key);
+        let removed = lock.entries_container.remove(key);
+        if removed.is_none() {
+            // The entry may be in a spill batch which is being written right now. Deleting it
+            // from disk waits for that write transaction, so it can't be resurrected
+            lock.spill_queue.remove(key);
+        }
+        drop(lock);
+        if removed.is_none() {
+            if let Some(overflow) = &self.overflow {
+                overflow.remove(std::slice::from_ref(key));
+            }
+        }
     }
 
+    /// Number of entries in memory and on disk
     pub fn len(&self) -> usize {
-        let lock = self.mutable.lock().unwrap();
-        lock.entries_container.len()
+        self.memory_len() + self.spill_queue_len() + self.overflow_len()
     }
 
     pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    fn memory_len(&self) -> usize {
         let lock = self.mutable.lock().unwrap();
-        lock.entries_container.is_empty()
+        lock.entries_container.len()
+    }
+
+    fn spill_queue_len(&self) -> usize {
+        self.mutable.lock().unwrap().spill_queue.len()
+    }
+
+    fn overflow_len(&self) -> usize {
+        self.overflow.as_ref().map(|o| o.len()).unwrap_or_default()
     }
 
     pub fn entries_size() -> usize {
@@ -134,6 +219,7 @@ impl UncheckedMap {
         size_of::<HashOrAccount>()
     }
 
+    /// Only visits the entries in memory
     pub fn for_each(
         &self,
         action: impl FnMut(&UncheckedKey, &UncheckedInfo),
@@ -146,12 +232,23 @@ impl UncheckedMap {
     pub fn for_each_with_dependency(
         &self,
         dependency: &HashOrAccount,
-        action: impl FnMut(&UncheckedKey, &UncheckedInfo),
-        predicate: impl FnMut() -> bool,
+        mut action: impl FnMut(&UncheckedKey, &UncheckedInfo),
+        mut predicate: impl FnMut() -> bool,
     ) {
         let lock = self.mutable.lock().unwrap();
         lock.entries_container
-            .for_each_with_dependency(dependency, action, predicate)
+            .for_each_with_dependency(dependency, &mut action, &mut predicate);
+        lock.spill_queue
+            .for_each_with_dependency(dependency, &mut action, &mut predicate);
+        drop(lock);
+        if let Some(overflow) = &self.overflow {
+            for (key, info) in overflow.get_dependents(dependency) {
+                if !predicate() {
+                    break;
+                }
+                action(&key, &info);
+            }
+        }
     }
 
     pub fn set_satisfied_observer(&self, callback: Box<dyn Fn(&UncheckedInfo) + Send>) {
@@ -160,7 +257,9 @@ impl UncheckedMap {
 
     pub fn container_info(&self) -> ContainerInfo {
         [
-            ("entries", self.len(), Self::entries_size()),
+            ("entries", self.memory_len(), Self::entries_size()),
+            ("spill_queue", self.spill_queue_len(), Self::entries_size()),
+            ("overflow", self.overflow_len(), 0),
             ("queries", self.buffer_count(), Self::buffer_entry_size()),
         ]
         .into()
@@ -185,6 +284,8 @@ struct ThreadMutableData {
     buffer: VecDeque<HashOrAccount>,
     writing_back_buffer: bool,
     entries_container: EntriesContainer,
+    /// Entries evicted from memory which the unchecked thread still has to write to the overflow
+    spill_queue: EntriesContainer,
     satisfied_callback: Option<Box<dyn Fn(&UncheckedInfo) + Send>>,
 }
 
@@ -195,6 +296,7 @@ impl ThreadMutableData {
             buffer: VecDeque::new(),
             writing_back_buffer: false,
             entries_container: EntriesContainer::new(),
+            spill_queue: EntriesContainer::new(),
             satisfied_callback: None,
         }
     }
@@ -206,6 +308,7 @@ pub struct UncheckedMapThread {
     condition: Arc<Condvar>,
     stats: Arc<Stats>,
     back_buffer: Mutex<VecDeque<HashOrAccount>>,
+    overflow: Option<Arc<UncheckedOverflow>>,
 }
 
 impl UncheckedMapThread {
@@ -221,17 +324,54 @@ impl UncheckedMapThread {
                 lock = self.mutable.lock().unwrap();
                 lock.writing_back_buffer = false;
                 back_buffer_lock.clear();
+            } else if !lock.spill_queue.is_empty() && self.overflow.is_some() {
+                drop(lock);
+                self.spill_batch();
+                lock = self.mutable.lock().unwrap();
             } else {
                 lock = self
                     .condition
                     .wait_while(lock, |other_lock| {
-                        !other_lock.stopped && other_lock.buffer.is_empty()
+                        !other_lock.stopped
+                            && other_lock.buffer.is_empty()
+                            && (other_lock.spill_queue.is_empty() || self.overflow.is_none())
                     })
                     .unwrap();
             }
         }
     }
 
+    /// Writes up to SPILL_BATCH_SIZE evicted entries to the overflow in a single write transaction.
+    /// The entries stay in the spill queue until they are committed, so that lookups always find
+    /// them either in memory or on disk.
+    fn spill_batch(&self) {
+        let Some(overflow) = &self.overflow else {
+            return;
+        };
+        let mut txn = overflow.store.env().tx_begin_write();
+        let batch: Vec<Entry> = {
+            let lock = self.mutable.lock().unwrap();
+            lock.spill_queue
+                .iter()
+                .take(SPILL_BATCH_SIZE)
+                .cloned()
+                .collect()
+        };
+        let (spilled, full) = overflow.put_batch(&mut txn, &batch);
+        txn.commit();
+
+        let mut lock = self.mutable.lock().unwrap();
+        for entry in &batch {
+            lock.spill_queue.remove(&entry.key);
+        }
+        drop(lock);
+
+        self.stats
+            .add(StatType::Unchecked, DetailType::Spilled, spilled as u64);
+        self.stats
+            .add(StatType::Unchecked, DetailType::OverflowFull, full as u64);
+    }
+
     fn process_queries(&self, back_buffer: &VecDeque<HashOrAccount>) {
         for item in back_buffer {
             self.query_impl(item);
@@ -257,6 +397,137 @@ impl UncheckedMapThread {
                 lock.entries_container.remove(key);
             }
         }
+        // Spilling happens on this thread, so nothing in the spill queue is in flight here
+        delete_queue.clear();
+        lock.spill_queue.for_each_with_dependency(
+            hash,
+            |key, info| {
+                delete_queue.push(key.clone());
+                self.stats.inc(StatType::Unchecked, DetailType::Satisfied);
+                if let Some(callback) = &lock.satisfied_callback {
+                    callback(info);
+                }
+            },
+            || true,
+        );
+        if !self.disable_delete {
+            for key in &delete_queue {
+                lock.spill_queue.remove(key);
+            }
+        }
+        drop(lock);
+
+        if let Some(overflow) = &self.overflow {
+            self.query_overflow(overflow, hash);
+        }
+    }
+
+    fn query_overflow(&self, overflow: &UncheckedOverflow, hash: &HashOrAccount) {
+        let entries = overflow.get_dependents(hash);
+        if entries.is_empty() {
+            return;
+        }
+
+        let lock = self.mutable.lock().unwrap();
+        for (_, info) in &entries {
+            self.stats.inc(StatType::Unchecked, DetailType::Satisfied);
+            self.stats
+                .inc(StatType::Unchecked, DetailType::SatisfiedFromDisk);
+            if let Some(callback) = &lock.satisfied_callback {
+                callback(info);
+            }
+        }
+        drop(lock);
+
+        if !self.disable_delete {
+            let keys: Vec<_> = entries.into_iter().map(|(k, _)| k).collect();
+            overflow.remove(&keys);
+        }
+    }
+}
+
+/// The on-disk tier of the unchecked map. It receives the entries which are evicted from memory,
+/// so that blocks with missing dependencies don't have to be downloaded again.
+/// The table is emptied on startup, just like the in-memory map starts empty.
+pub struct UncheckedOverflow {
+    store: LmdbUncheckedStore,
+    max_entries: usize,
+    len: AtomicUsize,
+}
+
+impl UncheckedOverflow {
+    pub fn new(store: LmdbUncheckedStore, max_entries: usize) -> Self {
+        let mut txn = store.env().tx_begin_write();
+        store.clear(&mut txn);
+        txn.commit();
+        Self {
+            store,
+            max_entries,
+            len: AtomicUsize::new(0),
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.len.load(atomic::Ordering::Relaxed)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Writes the entries with the given transaction.
+    /// Returns the number of spilled entries and the number of entries dropped because the
+    /// overflow is full
+    fn put_batch(&self, txn: &mut LmdbWriteTransaction, entries: &[Entry]) -> (usize, usize) {
+        let mut spilled = 0;
+        let mut full = 0;
+        for entry in entries {
+            if self.len() >= self.max_entries {
+                full += 1;
+            } else if !self.store.exists(&*txn, &entry.key) {
+                self.store.put(txn, &entry.key, &entry.info);
+                self.len.fetch_add(1, atomic::Ordering::Relaxed);
+                spilled += 1;
+            }
+        }
+        (spilled, full)
+    }
+
+    fn exists(&self, key: &UncheckedKey) -> bool {
+        if self.is_empty() {
+            return false;
+        }
+        let txn = self.store.env().tx_begin_read();
+        self.store.exists(&txn, key)
+    }
+
+    fn get_dependents(&self, dependency: &HashOrAccount) -> Vec<(UncheckedKey, UncheckedInfo)> {
+        if self.is_empty() {
+            return Vec::new();
+        }
+        let txn = self.store.env().tx_begin_read();
+        self.store.get_dependents(&txn, dependency)
+    }
+
+    fn remove(&self, keys: &[UncheckedKey]) {
+        if self.is_empty() {
+            return;
+        }
+        let mut txn = self.store.env().tx_begin_write();
+        for key in keys {
+            if self.store.exists(&txn, key) {
+                self.store.del(&mut txn, key);
+                self.len.fetch_sub(1, atomic::Ordering::Relaxed);
+            }
+        }
+        txn.commit();
+    }
+
+    fn clear(&self) {
+        let mut txn = self.store.env().tx_begin_write();
+        self.store.clear(&mut txn);
+        txn.commit();
+        self.len.store(0, atomic::Ordering::Relaxed);
     }
 }
 
@@ -398,6 +669,7 @@ impl EntriesContainer {
 #[cfg(test)]
 mod tests {
     use rsban_core::Block;
+    use rsban_store_lmdb::LmdbEnv;
 
     use super::*;
 
@@ -499,6 +771,38 @@ mod tests {
         assert_eq!(container.exists(&entry.key), false);
     }
 
+    #[test]
+    fn evicted_entries_are_spilled_in_batches_by_the_thread() {
+        let env = Arc::new(LmdbEnv::new_null());
+        let store = LmdbUncheckedStore::new(env).unwrap();
+        let overflow = Arc::new(UncheckedOverflow::new(store, 100));
+        let unchecked = UncheckedMap::with_overflow(
+            1,
+            Arc::new(Stats::default()),
+            false,
+            Some(overflow.clone()),
+        );
+        let evicted = UncheckedInfo::new(Block::new_test_instance_with_key(1));
+        let kept = UncheckedInfo::new(Block::new_test_instance_with_key(2));
+        let dependency = HashOrAccount::from(42);
+        let evicted_key = UncheckedKey::new(dependency.into(), evicted.block.hash());
+
+        unchecked.put(dependency, evicted.clone());
+        unchecked.put(dependency, kept);
+
+        // The evicted entry waits for the unchecked thread, but is still visible
+        assert_eq!(unchecked.memory_len(), 1);
+        assert_eq!(unchecked.spill_queue_len(), 1);
+        assert_eq!(overflow.len(), 0);
+        assert!(unchecked.exists(&evicted_key));
+        assert_eq!(unchecked.get(&dependency).len(), 2);
+
+        unchecked.thread.spill_batch();
+
+        assert_eq!(unchecked.spill_queue_len(), 0);
+        assert_eq!(overflow.len(), 1);
+    }
+
     fn test_entry<T: Into<BlockHash>>(hash: T) -> Entry {
         Entry::new(
             UncheckedKey::new(hash.into(), BlockHash::default()),
@@ -1,23 +1,37 @@
 use rsban_core::{utils::ContainerInfo, Account, BlockHash, PendingKey};
 use rsban_ledger::Ledger;
 use rsban_store_lmdb::LmdbReadTransaction;
-use std::{collections::VecDeque, sync::Arc};
+use std::{
+    collections::VecDeque,
+    sync::{
+        atomic::{AtomicUsize, Ordering},
+        Arc, Condvar, Mutex,
+    },
+    thread::JoinHandle,
+};
 
 const BATCH_SIZE: usize = 512;
 
+/// How many accounts the prefetch thread reads ahead of the consumer
+const PREFETCH_CAPACITY: usize = BATCH_SIZE * 16;
+
+/// Scans the account and pending tables for accounts to bootstrap.
+/// When the prefetch thread is running, the tables are read in the background into
+/// a bounded buffer, so that `next` never has to wait for the disk.
+/// Without the prefetch thread the tables are read synchronously when the queue runs empty.
 pub(crate) struct DatabaseScan {
     queue: VecDeque<Account>,
-    accounts_iterator: AccountDatabaseIterator,
-    pending_iterator: PendingDatabaseIterator,
-    ledger: Arc<Ledger>,
+    /// None while the prefetch thread owns the scanner
+    scanner: Option<DatabaseScanner>,
+    prefetch: Arc<PrefetchBuffer>,
 }
 
 impl DatabaseScan {
     pub fn new(ledger: Arc<Ledger>) -> Self {
+        let prefetch = Arc::new(PrefetchBuffer::new(PREFETCH_CAPACITY));
         Self {
-            accounts_iterator: AccountDatabaseIterator::new(ledger.clone()),
-            pending_iterator: PendingDatabaseIterator::new(ledger.clone()),
-            ledger,
+            scanner: Some(DatabaseScanner::new(ledger, Arc::clone(&prefetch))),
+            prefetch,
             queue: Default::default(),
         }
     }
@@ -37,26 +51,199 @@ impl DatabaseScan {
     }
 
     fn fill(&mut self) {
-        let tx = self.ledger.read_txn();
-        let set1 = self.accounts_iterator.next_batch(&tx, BATCH_SIZE);
-        let set2 = self.pending_iterator.next_batch(&tx, BATCH_SIZE);
-        self.queue.extend(set1);
-        self.queue.extend(set2);
+        match &mut self.scanner {
+            Some(scanner) => scanner.fill(&mut self.queue),
+            None => self.prefetch.take_all(&mut self.queue),
+        }
+    }
+
+    /// Moves the database reads to a background thread
+    pub fn start_prefetch(&mut self) -> Option<JoinHandle<()>> {
+        let mut scanner = self.scanner.take()?;
+        let prefetch = Arc::clone(&self.prefetch);
+        Some(
+            std::thread::Builder::new()
+                .name("Bootstrap db scan".to_string())
+                .spawn(move || {
+                    while prefetch.wait_for_space(scanner.pass_completed()) {
+                        scanner.prefetch_batch();
+                    }
+                })
+                .unwrap(),
+        )
+    }
+
+    pub fn stop_prefetch(&self) {
+        self.prefetch.stop();
     }
 
     pub fn warmed_up(&self) -> bool {
-        self.accounts_iterator.warmed_up() && self.pending_iterator.warmed_up()
+        self.prefetch.accounts_completed.load(Ordering::Relaxed) > 0
+            && self.prefetch.pending_completed.load(Ordering::Relaxed) > 0
     }
 
     pub fn container_info(&self) -> ContainerInfo {
         [
-            ("accounts_iterator", self.accounts_iterator.completed, 0),
-            ("pending_iterator", self.pending_iterator.completed, 0),
+            (
+                "accounts_iterator",
+                self.prefetch.accounts_completed.load(Ordering::Relaxed),
+                0,
+            ),
+            (
+                "pending_iterator",
+                self.prefetch.pending_completed.load(Ordering::Relaxed),
+                0,
+            ),
+            (
+                "prefetched",
+                self.prefetch.len(),
+                std::mem::size_of::<Account>(),
+            ),
         ]
         .into()
     }
 }
 
+struct DatabaseScanner {
+    ledger: Arc<Ledger>,
+    accounts_iterator: AccountDatabaseIterator,
+    pending_iterator: PendingDatabaseIterator,
+    prefetch: Arc<PrefetchBuffer>,
+    /// The tables which were read to the end since the prefetch buffer was last drained
+    accounts_pass_done: bool,
+    pending_pass_done: bool,
+}
+
+impl DatabaseScanner {
+    fn new(ledger: Arc<Ledger>, prefetch: Arc<PrefetchBuffer>) -> Self {
+        Self {
+            accounts_iterator: AccountDatabaseIterator::new(ledger.clone()),
+            pending_iterator: PendingDatabaseIterator::new(ledger.clone()),
+            ledger,
+            prefetch,
+            accounts_pass_done: false,
+            pending_pass_done: false,
+        }
+    }
+
+    fn pass_completed(&self) -> bool {
+        self.accounts_pass_done && self.pending_pass_done
+    }
+
+    fn fill(&mut self, queue: &mut VecDeque<Account>) {
+        let tx = self.ledger.read_txn();
+        let set1 = self.accounts_iterator.next_batch(&tx, BATCH_SIZE);
+        let set2 = self.pending_iterator.next_batch(&tx, BATCH_SIZE);
+        queue.extend(set1);
+        queue.extend(set2);
+        self.update_completed();
+    }
+
+    fn prefetch_batch(&mut self) {
+        // A table which was read to the end is only read again after the buffer was drained.
+        // Otherwise a ledger which is smaller than the buffer would fill it with duplicates
+        if self.prefetch.len() == 0 {
+            self.accounts_pass_done = false;
+            self.pending_pass_done = false;
+        }
+
+        // The read transaction is only held for a single batch,
+        // so that LMDB can reuse the pages freed by concurrent writes
+        let (set1, set2) = {
+            let tx = self.ledger.read_txn();
+            let mut set1 = Vec::new();
+            if !self.accounts_pass_done {
+                let completed = self.accounts_iterator.completed;
+                set1 = self.accounts_iterator.next_batch(&tx, BATCH_SIZE);
+                self.accounts_pass_done = self.accounts_iterator.completed > completed;
+            }
+            let mut set2 = Vec::new();
+            if !self.pending_pass_done {
+                let completed = self.pending_iterator.completed;
+                set2 = self.pending_iterator.next_batch(&tx, BATCH_SIZE);
+                self.pending_pass_done = self.pending_iterator.completed > completed;
+            }
+            (set1, set2)
+        };
+        self.prefetch.push(set1.into_iter().chain(set2));
+        self.update_completed();
+    }
+
+    fn update_completed(&self) {
+        self.prefetch
+            .accounts_completed
+            .store(self.accounts_iterator.completed, Ordering::Relaxed);
+        self.prefetch
+            .pending_completed
+            .store(self.pending_iterator.completed, Ordering::Relaxed);
+    }
+}
+
+/// Bounded buffer between the prefetch thread and the consumer
+struct PrefetchBuffer {
+    capacity: usize,
+    state: Mutex<PrefetchState>,
+    condition: Condvar,
+    accounts_completed: AtomicUsize,
+    pending_completed: AtomicUsize,
+}
+
+struct PrefetchState {
+    queue: VecDeque<Account>,
+    stopped: bool,
+}
+
+impl PrefetchBuffer {
+    fn new(capacity: usize) -> Self {
+        Self {
+            capacity,
+            state: Mutex::new(PrefetchState {
+                queue: VecDeque::with_capacity(capacity + 2 * BATCH_SIZE),
+                stopped: false,
+            }),
+            condition: Condvar::new(),
+            accounts_completed: AtomicUsize::new(0),
+            pending_completed: AtomicUsize::new(0),
+        }
+    }
+
+    fn len(&self) -> usize {
+        self.state.lock().unwrap().queue.len()
+    }
+
+    /// Blocks until there is room for another batch. After a completed pass over
+    /// the tables it also waits until the buffer was drained. Returns false if stopped
+    fn wait_for_space(&self, pass_completed: bool) -> bool {
+        let guard = self.state.lock().unwrap();
+        let guard = self
+            .condition
+            .wait_while(guard, |s| {
+                !s.stopped
+                    && (s.queue.len() >= self.capacity || (pass_completed && !s.queue.is_empty()))
+            })
+            .unwrap();
+        !guard.stopped
+    }
+
+    fn push(&self, accounts: impl IntoIterator<Item = Account>) {
+        self.state.lock().unwrap().queue.extend(accounts);
+    }
+
+    /// Moves all prefetched accounts into `target` without waiting
+    fn take_all(&self, target: &mut VecDeque<Account>) {
+        {
+            let mut guard = self.state.lock().unwrap();
+            target.extend(guard.queue.drain(..));
+        }
+        self.condition.notify_all();
+    }
+
+    fn stop(&self) {
+        self.state.lock().unwrap().stopped = true;
+        self.condition.notify_all();
+    }
+}
+
 struct AccountDatabaseIterator {
     ledger: Arc<Ledger>,
     next: Account,
@@ -188,7 +375,78 @@ impl PendingDatabaseIterator {
 mod tests {
     use super::*;
     use rsban_core::{PrivateKey, UnsavedBlockLatticeBuilder};
-    use rsban_ledger::LedgerContext;
+    use rsban_ledger::{LedgerContext, DEV_GENESIS_ACCOUNT};
+    use std::time::Duration;
+    use test_helpers::assert_timely;
+
+    #[test]
+    fn synchronous_scan() {
+        let ledger_ctx = LedgerContext::empty_dev();
+        let mut scan = DatabaseScan::new(ledger_ctx.ledger.clone());
+        assert!(!scan.warmed_up());
+
+        let account = scan.next(|_| true);
+
+        assert_eq!(account, *DEV_GENESIS_ACCOUNT);
+        assert!(scan.warmed_up());
+    }
+
+    #[test]
+    fn prefetch_scan() {
+        let ledger_ctx = LedgerContext::empty_dev();
+        let mut scan = DatabaseScan::new(ledger_ctx.ledger.clone());
+        let prefetch_thread = scan.start_prefetch().unwrap();
+        // Can only be started once
+        assert!(scan.start_prefetch().is_none());
+
+        assert_timely(Duration::from_secs(5), || scan.warmed_up());
+        let mut found = false;
+        assert_timely(Duration::from_secs(5), || {
+            found |= scan.next(|_| true) == *DEV_GENESIS_ACCOUNT;
+            found
+        });
+
+        scan.stop_prefetch();
+        prefetch_thread.join().unwrap();
+    }
+
+    #[test]
+    fn prefetch_buffer_is_bounded() {
+        let buffer = PrefetchBuffer::new(2);
+        assert!(buffer.wait_for_space(false));
+        buffer.push([Account::from(1), Account::from(2)]);
+        assert_eq!(buffer.len(), 2);
+
+        let mut target = VecDeque::new();
+        buffer.take_all(&mut target);
+        assert_eq!(target.len(), 2);
+        assert_eq!(buffer.len(), 0);
+        assert!(buffer.wait_for_space(true));
+
+        buffer.stop();
+        assert!(!buffer.wait_for_space(false));
+    }
+
+    #[test]
+    fn prefetch_stops_at_end_of_tables() {
+        let ledger_ctx = LedgerContext::empty_dev();
+        let mut scan = DatabaseScan::new(ledger_ctx.ledger.clone());
+        let prefetch_thread = scan.start_prefetch().unwrap();
+
+        assert_timely(Duration::from_secs(5), || scan.warmed_up());
+        // The next pass only starts when the genesis account was taken from the buffer
+        std::thread::sleep(Duration::from_millis(100));
+        assert_eq!(scan.prefetch.len(), 1);
+        assert_eq!(scan.prefetch.accounts_completed.load(Ordering::Relaxed), 1);
+
+        assert_eq!(scan.next(|_| true), *DEV_GENESIS_ACCOUNT);
+        assert_timely(Duration::from_secs(5), || {
+            scan.prefetch.accounts_completed.load(Ordering::Relaxed) == 2
+        });
+
+        scan.stop_prefetch();
+        prefetch_thread.join().unwrap();
+    }
 
     #[test]
     fn pending_database_scanner() {
@@ -71,6 +71,7 @@ struct Threads {
     timeout: JoinHandle<()>,
     priorities: JoinHandle<()>,
     database: Option<JoinHandle<()>>,
+    database_prefetch: Option<JoinHandle<()>>,
     dependencies: Option<JoinHandle<()>>,
 }
 
@@ -112,7 +113,11 @@ impl BootstrapAscending {
     }
 
     pub fn stop(&self) {
-        self.mutex.lock().unwrap().stopped = true;
+        {
+            let mut guard = self.mutex.lock().unwrap();
+            guard.stopped = true;
+            guard.database_scan.stop_prefetch();
+        }
         self.condition.notify_all();
         let threads = self.threads.lock().unwrap().take();
         if let Some(threads) = threads {
@@ -121,6 +126,9 @@ impl BootstrapAscending {
             if let Some(database) = threads.database {
                 database.join().unwrap();
             }
+            if let Some(prefetch) = threads.database_prefetch {
+                prefetch.join().unwrap();
+            }
             if let Some(dependencies) = threads.dependencies {
                 dependencies.join().unwrap();
             }
@@ -527,32 +535,35 @@ impl BootstrapAscending {
                     blocks.pop_front();
                 }
 
-                while let Some(block) = blocks.pop_front() {
-                    if blocks.is_empty() {
-                        // It's the last block submitted for this account chain, reset timestamp to allow more requests
-                        let stats = self.stats.clone();
-                        let data = self.mutex.clone();
-                        let condition = self.condition.clone();
-                        let account = tag.account;
-                        self.block_processor.add_with_callback(
-                            block,
-                            BlockSource::Bootstrap,
-                            ChannelId::LOOPBACK,
-                            Box::new(move |_| {
-                                stats.inc(StatType::BootstrapAscending, DetailType::TimestampReset);
-                                {
-                                    let mut guard = data.lock().unwrap();
-                                    guard.accounts.timestamp_reset(&account);
-                                }
-                                condition.notify_all();
-                            }),
-                        );
-                    } else {
-                        self.block_processor.add(
-                            block,
-                            BlockSource::Bootstrap,
-                            ChannelId::LOOPBACK,
-                        );
+                if !blocks.is_empty() {
+                    // Once the last block of the segment is processed, reset the timestamp to allow more requests
+                    let stats = self.stats.clone();
+                    let data = self.mutex.clone();
+                    let condition = self.condition.clone();
+                    let account = tag.account;
+                    let added = self.block_processor.add_chain(
+                        blocks.into(),
+                        BlockSource::Bootstrap,
+                        Some(Box::new(move |_| {
+                            stats.inc(StatType::BootstrapAscending, DetailType::TimestampReset);
+                            {
+                                let mut guard = data.lock().unwrap();
+                                guard.accounts.timestamp_reset(&account);
+                            }
+                            condition.notify_all();
+                        })),
+                    );
+                    if !added {
+                        // The callback is never called for a rejected segment. Reset the timestamp
+                        // now, otherwise the account would stay blocked until the request times out
+                        self.stats
+                            .inc(StatType::BootstrapAscending, DetailType::TimestampReset);
+                        self.mutex
+                            .lock()
+                            .unwrap()
+                            .accounts
+                            .timestamp_reset(&tag.account);
+                        self.condition.notify_all();
                     }
                 }
 
@@ -736,16 +747,16 @@ impl BootstrapAscendingExt for Arc<BootstrapAscending> {
             .spawn(Box::new(move || self_l.run_priorities()))
             .unwrap();
 
-        let database = if self.config.enable_database_scan {
+        let (database, database_prefetch) = if self.config.enable_database_scan {
+            let prefetch = self.mutex.lock().unwrap().database_scan.start_prefetch();
             let self_l = Arc::clone(self);
-            Some(
-                std::thread::Builder::new()
-                    .name("Bootstrap asc".to_string())
-                    .spawn(Box::new(move || self_l.run_database()))
-                    .unwrap(),
-            )
+            let database = std::thread::Builder::new()
+                .name("Bootstrap asc".to_string())
+                .spawn(Box::new(move || self_l.run_database()))
+                .unwrap();
+            (Some(database), prefetch)
         } else {
-            None
+            (None, None)
         };
 
         let dependencies = if self.config.enable_dependency_walker {
@@ -770,6 +781,7 @@ impl BootstrapAscendingExt for Arc<BootstrapAscending> {
             timeout,
             priorities,
             database,
+            database_prefetch,
             dependencies,
         });
     }
@@ -1,3 +1,4 @@
+use super::bootstrap_limits::{STREAM_BUFFERS, STREAM_CHUNK_MAX_READ_TIME_MS, STREAM_CHUNK_SIZE};
 use crate::{
     transport::{ResponseServer, ResponseServerExt},
     utils::ThreadPool,
@@ -5,10 +6,11 @@ use crate::{
 use rsban_core::{Account, Amount, BlockHash, PendingInfo, PendingKey};
 use rsban_ledger::Ledger;
 use rsban_messages::{BulkPullAccount, BulkPullAccountFlags};
-use rsban_network::TrafficType;
+use rsban_network::{SharedBufferPool, TrafficType};
 use std::{
     collections::HashSet,
     sync::{Arc, Mutex, Weak},
+    time::{Duration, Instant},
 };
 use tracing::{debug, trace};
 
@@ -23,6 +25,7 @@ struct BulkPullAccountServerImpl {
     pending_include_address: bool,
     invalid_request: bool,
     tokio: tokio::runtime::Handle,
+    buffers: SharedBufferPool,
 }
 
 impl BulkPullAccountServerImpl {
@@ -60,113 +63,145 @@ impl BulkPullAccountServerImpl {
         self.current_key.send_block_hash = BlockHash::zero();
     }
 
-    fn send_frontier(&self, server: Arc<Mutex<BulkPullAccountServerImpl>>) {
+    fn send_frontier(&mut self, server: Arc<Mutex<BulkPullAccountServerImpl>>) {
         /*
          * This function is really the entry point into this class,
          * so handle the invalid_request case by terminating the
          * request without any response
          */
         if !self.invalid_request {
-            let stream_transaction = self.ledger.read_txn();
-
-            // Get account balance and frontier block hash
-            let account_frontier_hash = self
-                .ledger
-                .any()
-                .account_head(&stream_transaction, &self.request.account)
-                .unwrap_or_default();
-            let account_frontier_balance = self
-                .ledger
-                .any()
-                .account_balance(&stream_transaction, &self.request.account)
-                .unwrap_or_default();
-
-            // Write the frontier block hash and balance into a buffer
-            let mut send_buffer = Vec::new();
-            {
-                send_buffer.extend_from_slice(account_frontier_hash.as_bytes());
-                send_buffer.extend_from_slice(&account_frontier_balance.to_be_bytes());
-            }
+            // The frontier goes out together with the first chunk of entries
+            self.send_chunk(server, true);
+        }
+    }
+
+    fn send_next_block(&mut self, server: Arc<Mutex<BulkPullAccountServerImpl>>) {
+        self.send_chunk(server, false);
+    }
+
+    fn send_chunk(&mut self, server: Arc<Mutex<BulkPullAccountServerImpl>>, with_frontier: bool) {
+        let mut finished = false;
+        let mut buffers = std::mem::take(&mut self.buffers);
+        let (send_buffer, _) =
+            buffers.get_with(|buffer| finished = self.fill_response(buffer, with_frontier));
+        self.buffers = buffers;
+        if finished {
+            debug!("Done sending blocks");
+        }
 
-            let connection_l = self.connection.clone();
-            let workers = self.thread_pool.clone();
-            // Send the buffer to the requestor
-            self.tokio.spawn(async move {
-                if connection_l
-                    .channel()
-                    .send_buffer(&send_buffer, TrafficType::Bootstrap)
-                    .await
-                    .is_ok()
-                {
+        let connection = self.connection.clone();
+        let workers = self.thread_pool.clone();
+        self.tokio.spawn(async move {
+            let result = connection
+                .channel()
+                .send_shared(send_buffer, TrafficType::Bootstrap)
+                .await;
+            match result {
+                Ok(()) if finished => {
+                    tokio::spawn(async move { connection.run().await });
+                }
+                Ok(()) => {
                     if let Some(workers) = workers.upgrade() {
                         workers.push_task(Box::new(move || {
                             let server2 = Arc::clone(&server);
                             server.lock().unwrap().send_next_block(server2);
                         }));
                     }
-                } else {
-                    debug!("Unable to bulk send block");
                 }
-            });
+                Err(_) => debug!("Unable to bulk send block"),
+            }
+        });
+    }
+
+    fn fill_response(&mut self, buffer: &mut Vec<u8>, with_frontier: bool) -> bool {
+        if with_frontier {
+            self.append_frontier(buffer);
         }
+        self.fill_chunk(buffer)
     }
 
-    fn send_next_block(&mut self, server: Arc<Mutex<BulkPullAccountServerImpl>>) {
-        /*
-         * Get the next item from the queue, it is a tuple with the key (which
-         * contains the account and hash) and data (which contains the amount)
-         */
-        if let Some((block_info_key, block_info)) = self.get_next() {
-            /*
-             * If we have a new item, emit it to the socket
-             */
+    fn append_frontier(&self, buffer: &mut Vec<u8>) {
+        let stream_transaction = self.ledger.read_txn();
+
+        // Get account balance and frontier block hash
+        let account_frontier_hash = self
+            .ledger
+            .any()
+            .account_head(&stream_transaction, &self.request.account)
+            .unwrap_or_default();
+        let account_frontier_balance = self
+            .ledger
+            .any()
+            .account_balance(&stream_transaction, &self.request.account)
+            .unwrap_or_default();
+
+        // Write the frontier block hash and balance into the buffer
+        buffer.extend_from_slice(account_frontier_hash.as_bytes());
+        buffer.extend_from_slice(&account_frontier_balance.to_be_bytes());
+    }
 
-            let mut send_buffer = Vec::new();
-            if self.pending_address_only {
-                trace!(pending = %block_info.source, "Sending pending");
-                send_buffer.extend_from_slice(block_info.source.as_bytes());
-            } else {
-                trace!(block = %block_info_key.send_block_hash, "Sending block");
-                send_buffer.extend_from_slice(block_info_key.send_block_hash.as_bytes());
-                send_buffer.extend_from_slice(&block_info.amount.to_be_bytes());
-
-                if self.pending_include_address {
-                    // Write the source address as well, if requested
-                    send_buffer.extend_from_slice(block_info.source.as_bytes());
-                }
+    /// Appends receivable entries until the buffer holds about a chunk or the read
+    /// transaction was open for too long. Returns true when all entries were sent,
+    /// in which case the final sequence was appended too
+    fn fill_chunk(&mut self, buffer: &mut Vec<u8>) -> bool {
+        let ledger = Arc::clone(&self.ledger);
+        let tx = ledger.read_txn();
+        let started = Instant::now();
+        let max_read_time = Duration::from_millis(STREAM_CHUNK_MAX_READ_TIME_MS);
+        let mut stream = ledger.any().account_receivable_upper_bound(
+            &tx,
+            self.current_key.receiving_account,
+            self.current_key.send_block_hash,
+        );
+
+        while buffer.len() < STREAM_CHUNK_SIZE {
+            let Some((key, info)) = stream.next() else {
+                self.append_final_sequence(buffer);
+                return true;
+            };
+            self.current_key = key.clone();
+            if self.should_send(&info) {
+                self.append_entry(buffer, &key, &info);
             }
+            if started.elapsed() >= max_read_time {
+                break;
+            }
+        }
+        false
+    }
 
-            let connection = self.connection.clone();
-            let workers = self.thread_pool.clone();
-            self.tokio.spawn(async move {
-                if connection
-                    .channel()
-                    .send_buffer(&send_buffer, TrafficType::Bootstrap)
-                    .await
-                    .is_ok()
-                {
-                    if let Some(workers) = workers.upgrade() {
-                        workers.push_task(Box::new(move || {
-                            let server2 = Arc::clone(&server);
-                            server.lock().unwrap().send_next_block(server2);
-                        }));
-                    }
-                } else {
-                    debug!("Unable to bulk send block");
-                }
-            });
+    fn append_entry(&self, buffer: &mut Vec<u8>, key: &PendingKey, info: &PendingInfo) {
+        if self.pending_address_only {
+            trace!(pending = %info.source, "Sending pending");
+            buffer.extend_from_slice(info.source.as_bytes());
         } else {
-            /*
-             * Otherwise, finalize the connection
-             */
-            debug!("Done sending blocks");
+            trace!(block = %key.send_block_hash, "Sending block");
+            buffer.extend_from_slice(key.send_block_hash.as_bytes());
+            buffer.extend_from_slice(&info.amount.to_be_bytes());
+
+            if self.pending_include_address {
+                // Write the source address as well, if requested
+                buffer.extend_from_slice(info.source.as_bytes());
+            }
+        }
+    }
+
+    fn append_final_sequence(&self, buffer: &mut Vec<u8>) {
+        /*
+         * The "bulk_pull_account" final sequence is a final block of all
+         * zeros.  If we are sending only account public keys (with the
+         * "pending_address_only" flag) then it will be 256-bits of zeros,
+         * otherwise it will be either 384-bits of zeros (if the
+         * "pending_include_address" flag is not set) or 640-bits of zeros
+         * (if that flag is set).
+         */
+        buffer.extend_from_slice(Account::zero().as_bytes());
 
-            let conn = self.connection.clone();
-            let pending_address_only = self.pending_address_only;
-            let pending_include_address = self.pending_include_address;
-            self.tokio.spawn(async move {
-                send_finished(&conn, pending_address_only, pending_include_address).await;
-            });
+        if !self.pending_address_only {
+            buffer.extend_from_slice(&Amount::zero().to_be_bytes());
+            if self.pending_include_address {
+                buffer.extend_from_slice(Account::zero().as_bytes());
+            }
         }
     }
 
@@ -189,79 +224,44 @@ impl BulkPullAccountServerImpl {
             };
 
             self.current_key = key.clone();
-
-            /*
-             * Skip entries where the amount is less than the requested
-             * minimum
-             */
-            if info.amount < self.request.minimum_amount {
-                continue;
+            if self.should_send(&info) {
+                return Some((key, info));
             }
-
-            /*
-             * If the pending_address_only flag is set, de-duplicate the
-             * responses.  The responses are the address of the sender,
-             * so they are part of the pending table's information
-             * and not key, so we have to de-duplicate them manually.
-             */
-            if self.pending_address_only {
-                if !self.deduplication.insert(info.source) {
-                    /*
-                     * If the deduplication map gets too
-                     * large, clear it out.  This may
-                     * result in some duplicates getting
-                     * sent to the client, but we do not
-                     * want to commit too much memory
-                     */
-                    if self.deduplication.len() > 4096 {
-                        self.deduplication.clear();
-                    }
-                    continue;
-                }
-            }
-
-            return Some((key.clone(), info.clone()));
         }
 
         None
     }
-}
 
-async fn send_finished(
-    connection: &Arc<ResponseServer>,
-    pending_address_only: bool,
-    pending_include_address: bool,
-) {
-    /*
-     * The "bulk_pull_account" final sequence is a final block of all
-     * zeros.  If we are sending only account public keys (with the
-     * "pending_address_only" flag) then it will be 256-bits of zeros,
-     * otherwise it will be either 384-bits of zeros (if the
-     * "pending_include_address" flag is not set) or 640-bits of zeros
-     * (if that flag is set).
-     */
-    let mut send_buffer = Vec::new();
-    {
-        send_buffer.extend_from_slice(Account::zero().as_bytes());
-
-        if !pending_address_only {
-            send_buffer.extend_from_slice(&Amount::zero().to_be_bytes());
-            if pending_include_address {
-                send_buffer.extend_from_slice(Account::zero().as_bytes());
+    fn should_send(&mut self, info: &PendingInfo) -> bool {
+        /*
+         * Skip entries where the amount is less than the requested
+         * minimum
+         */
+        if info.amount < self.request.minimum_amount {
+            return false;
+        }
+
+        /*
+         * If the pending_address_only flag is set, de-duplicate the
+         * responses.  The responses are the address of the sender,
+         * so they are part of the pending table's information
+         * and not key, so we have to de-duplicate them manually.
+         */
+        if self.pending_address_only && !self.deduplication.insert(info.source) {
+            /*
+             * If the deduplication map gets too
+             * large, clear it out.  This may
+             * result in some duplicates getting
+             * sent to the client, but we do not
+             * want to commit too much memory
+             */
+            if self.deduplication.len() > 4096 {
+                self.deduplication.clear();
             }
+            return false;
         }
-    }
 
-    if connection
-        .channel()
-        .send_buffer(&send_buffer, TrafficType::Bootstrap)
-        .await
-        .is_ok()
-    {
-        let conn = connection.clone();
-        tokio::spawn(async move { conn.run().await });
-    } else {
-        debug!("Could not finish bulk pull");
+        true
     }
 }
 
@@ -288,6 +288,7 @@ impl BulkPullAccountServer {
             pending_include_address: false,
             invalid_request: false,
             tokio,
+            buffers: SharedBufferPool::new(STREAM_BUFFERS),
         };
         /*
          * Setup the streaming response for the first call to "send_frontier" and  "send_next_block"
@@ -303,6 +304,19 @@ impl BulkPullAccountServer {
         self.server.lock().unwrap().send_frontier(server2);
     }
 
+    /// Fills the next chunk of the response like `send_frontier` does for the
+    /// first chunk, but returns it instead of sending it.
+    /// The flag is true if the response is complete
+    pub fn next_chunk(&self, with_frontier: bool) -> (Vec<u8>, bool) {
+        let mut buffer = Vec::new();
+        let finished = self
+            .server
+            .lock()
+            .unwrap()
+            .fill_response(&mut buffer, with_frontier);
+        (buffer, finished)
+    }
+
     pub fn get_next(&self) -> Option<(PendingKey, PendingInfo)> {
         self.server.lock().unwrap().get_next()
     }
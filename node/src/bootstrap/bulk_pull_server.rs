@@ -1,12 +1,17 @@
+use super::bootstrap_limits::{STREAM_BUFFERS, STREAM_CHUNK_MAX_READ_TIME_MS, STREAM_CHUNK_SIZE};
 use crate::{
     transport::{ResponseServer, ResponseServerExt},
     utils::ThreadPool,
 };
-use rsban_core::{utils::MemoryStream, Account, Block, BlockHash, BlockType};
+use rsban_core::{utils::BufferReader, Account, Block, BlockHash, BlockType};
 use rsban_ledger::Ledger;
 use rsban_messages::BulkPull;
-use rsban_network::TrafficType;
-use std::sync::{Arc, Mutex, Weak};
+use rsban_network::{SharedBufferPool, TrafficType};
+use rsban_store_lmdb::LmdbReadTransaction;
+use std::{
+    sync::{Arc, Mutex, Weak},
+    time::{Duration, Instant},
+};
 use tracing::{debug, trace};
 
 /**
@@ -46,6 +51,7 @@ impl BulkPullServer {
             ledger,
             thread_pool: Arc::downgrade(&thread_pool),
             tokio,
+            buffers: SharedBufferPool::new(STREAM_BUFFERS),
         };
 
         server_impl.set_current_end();
@@ -94,6 +100,14 @@ impl BulkPullServer {
         self.server_impl.lock().unwrap().get_next()
     }
 
+    /// Fills the next chunk of the response like `send_next`, but returns it
+    /// instead of sending it. The flag is true if the response is complete
+    pub fn next_chunk(&self) -> (Vec<u8>, bool) {
+        let mut buffer = Vec::new();
+        let finished = self.server_impl.lock().unwrap().fill_chunk(&mut buffer);
+        (buffer, finished)
+    }
+
     pub fn send_next(&mut self) {
         let impl_clone = self.server_impl.clone();
         self.server_impl.lock().unwrap().send_next(impl_clone);
@@ -110,6 +124,7 @@ struct BulkPullServerImpl {
     max_count: u32,
     current: BlockHash,
     request: BulkPull,
+    buffers: SharedBufferPool,
 }
 
 impl BulkPullServerImpl {
@@ -188,6 +203,18 @@ impl BulkPullServerImpl {
     }
 
     pub fn get_next(&mut self) -> Option<Block> {
+        let txn = self.ledger.read_txn();
+        let mut bytes = Vec::new();
+        self.next_block(&txn, &mut bytes)?;
+        Some(
+            Block::deserialize(&mut BufferReader::new(&bytes))
+                .expect("ledger contains an invalid block"),
+        )
+    }
+
+    /// Appends the next block to `buffer` as it is sent over the wire and returns its hash.
+    /// The block is read through a borrowed view, so it never gets decoded.
+    fn next_block(&mut self, txn: &LmdbReadTransaction, buffer: &mut Vec<u8>) -> Option<BlockHash> {
         let mut send_current = false;
         let mut set_current_to_end = false;
 
@@ -223,17 +250,15 @@ impl BulkPullServerImpl {
 
         let mut result = None;
         if send_current {
-            {
-                let txn = self.ledger.read_txn();
-                result = self.ledger.any().get_block(&txn, &self.current);
-            }
-
-            if let Some(result) = &result {
+            let view = self.ledger.any().get_block_view(txn, &self.current);
+            if let Some(view) = view {
+                buffer.extend_from_slice(view.block_bytes());
+                result = Some(self.current);
                 if !set_current_to_end {
                     let next = if self.ascending() {
-                        result.successor().unwrap_or_default()
+                        view.successor().unwrap_or_default()
                     } else {
-                        result.previous()
+                        view.previous()
                     };
                     if !next.is_zero() {
                         self.current = next;
@@ -256,54 +281,55 @@ impl BulkPullServerImpl {
          */
         self.include_start = false;
 
-        result.map(|b| b.into())
+        result
     }
 
-    pub fn send_finished(&self, server_impl: Arc<Mutex<Self>>) {
-        let send_buffer = Arc::new(vec![BlockType::NotABlock as u8]);
-        debug!("Bulk sending finished");
+    /// Fills `buffer` with raw blocks until it holds about a chunk or the read
+    /// transaction was open for too long. Returns true when the response is
+    /// complete, in which case the not-a-block terminator was appended too
+    fn fill_chunk(&mut self, buffer: &mut Vec<u8>) -> bool {
+        let txn = self.ledger.read_txn();
+        let started = Instant::now();
+        let max_read_time = Duration::from_millis(STREAM_CHUNK_MAX_READ_TIME_MS);
+        while buffer.len() < STREAM_CHUNK_SIZE {
+            let Some(hash) = self.next_block(&txn, buffer) else {
+                buffer.push(BlockType::NotABlock as u8);
+                return true;
+            };
+            trace!(block = %hash, remote = %self.connection.remote_endpoint(), "Sending block");
+            if started.elapsed() >= max_read_time {
+                break;
+            }
+        }
+        false
+    }
+
+    pub fn send_next(&mut self, server_impl: Arc<Mutex<Self>>) {
+        let mut finished = false;
+        let mut buffers = std::mem::take(&mut self.buffers);
+        let (send_buffer, _) = buffers.get_with(|buffer| finished = self.fill_chunk(buffer));
+        self.buffers = buffers;
+        if finished {
+            debug!("Bulk sending finished");
+        }
 
         let conn = self.connection.clone();
         self.tokio.spawn(async move {
-            match conn
+            let result = conn
                 .channel()
-                .send_buffer(&send_buffer, TrafficType::Bootstrap)
-                .await
-            {
-                Ok(()) => {
-                    let guard = server_impl.lock().unwrap();
-                    let connection = guard.connection.clone();
-                    guard.tokio.spawn(async move { connection.run().await });
+                .send_shared(send_buffer, TrafficType::Bootstrap)
+                .await;
+            match result {
+                Ok(()) if finished => {
+                    tokio::spawn(async move { conn.run().await });
                 }
-                Err(e) => debug!("Unable to send not-a-block ({:?})", e),
-            }
-        });
-    }
-
-    pub fn send_next(&mut self, server_impl: Arc<Mutex<Self>>) {
-        if let Some(block) = self.get_next() {
-            trace!(block = %block.hash(), remote = %self.connection.remote_endpoint(), "Sending block");
-            let mut stream = MemoryStream::new();
-
-            block.serialize(&mut stream);
-            let send_buffer = Arc::new(stream.to_vec());
-            let conn = self.connection.clone();
-            self.tokio.spawn(async move {
-                if conn
-                    .channel()
-                    .send_buffer(&send_buffer, TrafficType::Bootstrap)
-                    .await
-                    .is_ok()
-                {
+                Ok(()) => {
                     let server_impl_clone = server_impl.clone();
                     server_impl.lock().unwrap().sent_action(server_impl_clone);
-                } else {
-                    debug!("Unable to bulk send block");
                 }
-            });
-        } else {
-            self.send_finished(server_impl);
-        }
+                Err(e) => debug!("Unable to bulk send blocks ({:?})", e),
+            }
+        });
     }
 
     fn sent_action(&mut self, server_impl: Arc<Mutex<Self>>) {
@@ -1,3 +1,4 @@
+use super::bootstrap_limits::{STREAM_BUFFERS, STREAM_CHUNK_SIZE};
 use crate::{
     transport::{ResponseServer, ResponseServerExt},
     utils::ThreadPool,
@@ -5,7 +6,7 @@ use crate::{
 use rsban_core::{utils::seconds_since_epoch, Account, BlockHash};
 use rsban_ledger::Ledger;
 use rsban_messages::FrontierReq;
-use rsban_network::TrafficType;
+use rsban_network::{SharedBufferPool, TrafficType};
 use std::{
     collections::VecDeque,
     sync::{Arc, Mutex, Weak},
@@ -36,6 +37,7 @@ impl FrontierReqServer {
                 thread_pool: Arc::downgrade(&thread_pool),
                 ledger,
                 tokio,
+                buffers: SharedBufferPool::new(STREAM_BUFFERS),
             })),
         };
         result.server_impl.lock().unwrap().next();
@@ -47,6 +49,14 @@ impl FrontierReqServer {
         self.server_impl.lock().unwrap().send_next(server_clone);
     }
 
+    /// Fills the next chunk of the response like `send_next`, but returns it
+    /// instead of sending it. The flag is true if the response is complete
+    pub fn next_chunk(&self) -> (Vec<u8>, bool) {
+        let mut buffer = Vec::new();
+        let finished = self.server_impl.lock().unwrap().fill_chunk(&mut buffer);
+        (buffer, finished)
+    }
+
     pub fn current(&self) -> Account {
         self.server_impl.lock().unwrap().current
     }
@@ -66,6 +76,7 @@ struct FrontierReqServerImpl {
     thread_pool: Weak<dyn ThreadPool>,
     ledger: Arc<Ledger>,
     tokio: tokio::runtime::Handle,
+    buffers: SharedBufferPool,
 }
 
 impl FrontierReqServerImpl {
@@ -74,59 +85,57 @@ impl FrontierReqServerImpl {
     }
 
     pub fn send_next(&mut self, server: Arc<Mutex<FrontierReqServerImpl>>) {
-        if !self.current.is_zero() && self.count < self.request.count as usize {
+        let mut finished = false;
+        let mut buffers = std::mem::take(&mut self.buffers);
+        let (send_buffer, _) = buffers.get_with(|buffer| finished = self.fill_chunk(buffer));
+        self.buffers = buffers;
+        if finished {
+            debug!("Frontier sending finished");
+        }
+
+        let conn = self.connection.clone();
+        self.tokio.spawn(async move {
+            let result = conn
+                .channel()
+                .send_shared(send_buffer, TrafficType::Generic)
+                .await;
+            match result {
+                Ok(()) if finished => {
+                    tokio::spawn(async move { conn.run().await });
+                }
+                Ok(()) => {
+                    let server2 = server.clone();
+                    server.lock().unwrap().sent_action(server2);
+                }
+                Err(e) => debug!("Error sending frontier pairs: {:?}", e),
+            }
+        });
+    }
+
+    /// Packs frontier pairs into `buffer` until it holds about a chunk.
+    /// Returns true when the response is complete, in which case the
+    /// terminating zero pair was appended too
+    fn fill_chunk(&mut self, buffer: &mut Vec<u8>) -> bool {
+        while buffer.len() < STREAM_CHUNK_SIZE {
+            if self.current.is_zero() || self.count >= self.request.count as usize {
+                buffer.extend_from_slice(Account::zero().as_bytes());
+                buffer.extend_from_slice(BlockHash::zero().as_bytes());
+                return true;
+            }
+
             trace!(
                 account = %self.current,
                 frontier = %self.frontier,
                 socket = %self.connection.remote_endpoint(),
                 "Sending frontier");
 
-            let mut send_buffer = Vec::with_capacity(64);
-            send_buffer.extend_from_slice(self.current.as_bytes());
-            send_buffer.extend_from_slice(self.frontier.as_bytes());
-            debug_assert!(!self.current.is_zero());
             debug_assert!(!self.frontier.is_zero());
+            buffer.extend_from_slice(self.current.as_bytes());
+            buffer.extend_from_slice(self.frontier.as_bytes());
+            self.count += 1;
             self.next();
-
-            let conn = self.connection.clone();
-            self.tokio.spawn(async move {
-                match conn
-                    .channel()
-                    .send_buffer(&send_buffer, TrafficType::Generic)
-                    .await
-                {
-                    Ok(()) => {
-                        let server2 = server.clone();
-                        server.lock().unwrap().sent_action(server2);
-                    }
-                    Err(e) => debug!("Error sending frontier pair: {:?}", e),
-                }
-            });
-        } else {
-            let connection = self.connection.clone();
-            self.tokio.spawn(async move {
-                Self::send_finished(connection).await;
-            });
         }
-    }
-
-    async fn send_finished(connection: Arc<ResponseServer>) {
-        let mut send_buffer = Vec::with_capacity(64);
-        send_buffer.extend_from_slice(Account::zero().as_bytes());
-        send_buffer.extend_from_slice(BlockHash::zero().as_bytes());
-        debug!("Frontier sending finished");
-
-        match connection
-            .channel()
-            .send_buffer(&send_buffer, TrafficType::Generic)
-            .await
-        {
-            Ok(()) => {
-                let connection = connection.clone();
-                tokio::spawn(async move { connection.run().await });
-            }
-            Err(e) => debug!("Error sending frontier finish: {:?}", e),
-        };
+        false
     }
 
     pub fn next(&mut self) {
@@ -187,7 +196,6 @@ impl FrontierReqServerImpl {
             return;
         };
 
-        self.count += 1;
         thread_pool.push_task(Box::new(move || {
             let server_clone = Arc::clone(&server);
             server.lock().unwrap().send_next(server_clone);
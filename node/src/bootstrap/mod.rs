@@ -55,6 +55,14 @@ pub mod bootstrap_limits {
     pub const LAZY_BATCH_PULL_COUNT_RESIZE_BLOCKS_LIMIT: u64 = 4 * 1024 * 1024;
     pub const LAZY_BATCH_PULL_COUNT_RESIZE_RATIO: f64 = 2.0;
     pub const BULK_PUSH_COST_LIMIT: u64 = 200;
+    /// Bulk pull and frontier responses are streamed in chunks of about this size.
+    /// Chunks bigger than the capacity of the bandwidth limiter are metered in parts
+    /// of at most that capacity, so they are rate limited but always pass
+    pub const STREAM_CHUNK_SIZE: usize = 16 * 1024;
+    /// Upper bound for how long a read transaction is kept open while filling a chunk
+    pub const STREAM_CHUNK_MAX_READ_TIME_MS: u64 = 5;
+    /// One chunk can be filled while the previous one is still in the write queue
+    pub const STREAM_BUFFERS: usize = 2;
 }
 
 #[derive(Clone, Copy, FromPrimitive, Debug, PartialEq, Eq)]
@@ -1,19 +1,22 @@
 use crate::{
     consensus::Election,
     stats::{DetailType, StatType, Stats},
-    utils::{ThreadPool, ThreadPoolImpl},
+    utils::{
+        AdaptiveBatchConfig, AdaptiveBatchSize, Executor, ExecutorLane, TaskPriority, ThreadPool,
+        ThreadPoolImpl,
+    },
 };
 use rsban_core::{utils::ContainerInfo, BlockHash, SavedBlock};
-use rsban_ledger::{Ledger, WriteGuard, Writer};
+use rsban_ledger::{ConfirmationPlan, Ledger, WriteGuard, Writer};
 use rsban_store_lmdb::LmdbWriteTransaction;
 use std::{
     collections::{HashSet, VecDeque},
     sync::{
         atomic::{AtomicBool, Ordering},
-        Arc, Condvar, Mutex,
+        mpsc, Arc, Condvar, Mutex,
     },
     thread::JoinHandle,
-    time::Duration,
+    time::{Duration, Instant},
 };
 use tracing::debug;
 
@@ -21,18 +24,28 @@ use super::ordered_entries::{Entry, OrderedEntries};
 
 #[derive(Clone, Debug, PartialEq)]
 pub struct ConfirmingSetConfig {
+    /// Maximum number of blocks which are cemented in one write transaction
     pub batch_size: usize,
+    /// The batch size adapts so that cementing a batch takes about this long
+    pub batch_time: Duration,
     /// Maximum number of dependent blocks to be stored in memory during processing
     pub max_blocks: usize,
     pub max_queued_notifications: usize,
+    /// Number of threads which resolve the dependencies of the next batch
+    /// while the current batch gets cemented
+    pub resolver_threads: usize,
 }
 
 impl Default for ConfirmingSetConfig {
     fn default() -> Self {
         Self {
             batch_size: 256,
+            batch_time: Duration::from_millis(250),
             max_blocks: 128 * 128,
             max_queued_notifications: 8,
+            resolver_threads: std::thread::available_parallelism()
+                .map(|i| i.get().min(4))
+                .unwrap_or(1),
         }
     }
 }
@@ -48,6 +61,11 @@ impl ConfirmingSet {
         Self {
             join_handle: Mutex::new(None),
             thread: Arc::new(ConfirmingSetThread {
+                batch_size: AdaptiveBatchSize::new(
+                    AdaptiveBatchConfig::new(16, config.batch_size, config.batch_time),
+                    stats.clone(),
+                    DetailType::ConfirmingSet,
+                ),
                 mutex: Mutex::new(ConfirmingSetImpl {
                     set: OrderedEntries::default(),
                     current: HashSet::new(),
@@ -59,6 +77,7 @@ impl ConfirmingSet {
                 config,
                 observers: Arc::new(Mutex::new(Observers::default())),
                 notification_workers: ThreadPoolImpl::create(1, "Conf notif"),
+                resolvers: Mutex::new(None),
             }),
         }
     }
@@ -100,7 +119,28 @@ impl ConfirmingSet {
     }
 
     pub fn start(&self) {
+        let resolvers = (self.thread.config.resolver_threads > 0).then(|| {
+            Arc::new(ThreadPoolImpl::create(
+                self.thread.config.resolver_threads,
+                "Conf resolver",
+            )) as Arc<dyn ThreadPool>
+        });
+        self.start_with(resolvers);
+    }
+
+    /// Resolves the dependencies as `Cementing` tasks of the executor instead of on
+    /// dedicated resolver threads. The writer keeps its own thread
+    pub fn start_on(&self, executor: &Arc<Executor>) {
+        let resolvers = (self.thread.config.resolver_threads > 0).then(|| {
+            Arc::new(ExecutorLane::new(executor.clone(), TaskPriority::Cementing))
+                as Arc<dyn ThreadPool>
+        });
+        self.start_with(resolvers);
+    }
+
+    fn start_with(&self, resolvers: Option<Arc<dyn ThreadPool>>) {
         debug_assert!(self.join_handle.lock().unwrap().is_none());
+        *self.thread.resolvers.lock().unwrap() = resolvers;
 
         let thread = Arc::clone(&self.thread);
         *self.join_handle.lock().unwrap() = Some(
@@ -117,6 +157,10 @@ impl ConfirmingSet {
         if let Some(handle) = handle {
             handle.join().unwrap();
         }
+        let resolvers = self.thread.resolvers.lock().unwrap().take();
+        if let Some(resolvers) = resolvers {
+            resolvers.stop();
+        }
         self.thread.notification_workers.stop();
     }
 
@@ -139,7 +183,10 @@ impl ConfirmingSet {
 
     pub fn container_info(&self) -> ContainerInfo {
         let guard = self.thread.mutex.lock().unwrap();
-        [("set", guard.set.len(), std::mem::size_of::<BlockHash>())].into()
+        ContainerInfo::builder()
+            .leaf("set", guard.set.len(), std::mem::size_of::<BlockHash>())
+            .leaf("batch_size", self.thread.batch_size.current(), 0)
+            .finish()
     }
 }
 
@@ -162,8 +209,11 @@ struct ConfirmingSetThread {
     ledger: Arc<Ledger>,
     stats: Arc<Stats>,
     config: ConfirmingSetConfig,
+    batch_size: AdaptiveBatchSize,
     notification_workers: ThreadPoolImpl,
     observers: Arc<Mutex<Observers>>,
+    /// Resolves the chunks of the next batch. None while the set isn't running
+    resolvers: Mutex<Option<Arc<dyn ThreadPool>>>,
 }
 
 impl ConfirmingSetThread {
@@ -199,36 +249,113 @@ impl ConfirmingSetThread {
         self.mutex.lock().unwrap().set.len()
     }
 
-    fn run(&self) {
-        let mut guard = self.mutex.lock().unwrap();
-        while !self.stopped.load(Ordering::SeqCst) {
-            if !guard.set.is_empty() {
-                let batch = guard.next_batch(self.config.batch_size);
-
-                // Keep track of the blocks we're currently cementing, so that the .contains (...) check is accurate
-                debug_assert!(guard.current.is_empty());
-                for entry in &batch {
-                    guard.current.insert(entry.hash);
+    /// Cementing is pipelined: while the current batch is written, the dependencies
+    /// of the next batch are resolved with read-only transactions
+    fn run(self: &Arc<Self>) {
+        let mut resolved: Option<ResolvedBatch> = None;
+        loop {
+            let next = {
+                let mut guard = self.mutex.lock().unwrap();
+                if resolved.is_none() {
+                    guard = self
+                        .condition
+                        .wait_while(guard, |i| {
+                            i.set.is_empty() && !self.stopped.load(Ordering::SeqCst)
+                        })
+                        .unwrap();
+                }
+                if self.stopped.load(Ordering::SeqCst) {
+                    return;
                 }
 
-                drop(guard);
+                if guard.set.is_empty() {
+                    None
+                } else {
+                    let batch = guard.next_batch(self.batch_size.current());
+                    // Keep track of the blocks we're currently cementing, so that the .contains (...) check is accurate
+                    for entry in &batch {
+                        guard.current.insert(entry.hash);
+                    }
+                    Some(batch)
+                }
+            };
 
+            let resolving = next.map(|batch| self.resolve(batch));
+            if let Some(batch) = resolved.take() {
                 self.run_batch(batch);
-                guard = self.mutex.lock().unwrap();
-            } else {
-                guard = self
-                    .condition
-                    .wait_while(guard, |i| {
-                        i.set.is_empty() && !self.stopped.load(Ordering::SeqCst)
-                    })
-                    .unwrap();
             }
+            resolved = resolving.map(|batch| batch.wait());
+        }
+    }
+
+    /// Hands the chunks of the batch to the resolvers.
+    /// Without resolvers the chunks are resolved right away
+    fn resolve(self: &Arc<Self>, entries: VecDeque<Entry>) -> ResolvingBatch {
+        let hashes: Vec<_> = entries.iter().map(|e| e.hash).collect();
+        let chunk_size = hashes
+            .len()
+            .div_ceil(self.config.resolver_threads.max(1))
+            .max(1);
+
+        let resolvers = self.resolvers.lock().unwrap().clone();
+        let (reply, results) = mpsc::channel();
+        let mut chunk_lens = Vec::new();
+        for (index, chunk) in hashes.chunks(chunk_size).enumerate() {
+            chunk_lens.push(chunk.len());
+            let job = ResolveJob {
+                index,
+                hashes: chunk.to_vec(),
+                reply: reply.clone(),
+            };
+            match &resolvers {
+                Some(resolvers) => {
+                    // A job which a stopped pool drops never replies, so the writer resolves it
+                    let thread = Arc::clone(self);
+                    resolvers.push_task(Box::new(move || thread.run_job(job)));
+                }
+                None => self.run_job(job),
+            }
+        }
+
+        ResolvingBatch {
+            entries,
+            chunk_lens,
+            results,
         }
     }
 
+    fn run_job(&self, job: ResolveJob) {
+        let plans = self.resolve_chunk(&job.hashes);
+        // The writer doesn't wait for the plans anymore if it stopped
+        let _ = job.reply.send((job.index, plans));
+    }
+
+    /// Every block is planned only once per chunk, so the plan of an entry
+    /// relies on the plans of the entries before it.
+    /// Entries which don't fit into the plan limit get resolved again by the writer
+    fn resolve_chunk(&self, hashes: &[BlockHash]) -> Vec<Option<ConfirmationPlan>> {
+        let tx = self.ledger.read_txn();
+        let mut planned = HashSet::new();
+        hashes
+            .iter()
+            .map(|hash| {
+                if planned.len() >= self.config.max_blocks || self.stopped.load(Ordering::Relaxed) {
+                    return None;
+                }
+                let plan =
+                    self.ledger
+                        .plan_confirmation(&tx, *hash, self.config.max_blocks, &mut planned);
+                self.stats
+                    .inc(StatType::ConfirmingSet, DetailType::Resolved);
+                Some(plan)
+            })
+            .collect()
+    }
+
     fn notify(&self, cemented: &mut VecDeque<Context>) {
         let mut batch = VecDeque::new();
         std::mem::swap(&mut batch, cemented);
+        let cemented_at = Instant::now();
 
         let mut guard = self.mutex.lock().unwrap();
 
@@ -252,6 +379,9 @@ impl ConfirmingSetThread {
         let stats = self.stats.clone();
         self.notification_workers.push_task(Box::new(move || {
             stats.inc(StatType::ConfirmingSet, DetailType::Notify);
+            stats
+                .block_latency()
+                .cemented(batch.iter().map(|i| i.block.hash()), cemented_at);
             observers.lock().unwrap().notify_batch(batch);
         }));
     }
@@ -266,8 +396,7 @@ impl ConfirmingSetThread {
         if cemented.len() >= self.config.max_blocks {
             self.stats
                 .inc(StatType::ConfirmingSet, DetailType::NotifyIntermediate);
-            drop(write_guard);
-            tx.commit();
+            self.ledger.commit(write_guard, &mut tx);
 
             self.notify(cemented);
 
@@ -277,17 +406,22 @@ impl ConfirmingSetThread {
         (write_guard, tx)
     }
 
-    fn run_batch(&self, batch: VecDeque<Entry>) {
+    fn run_batch(&self, batch: ResolvedBatch) {
         let mut cemented = VecDeque::new();
         let mut already_cemented = VecDeque::new();
+        let hashes: Vec<_> = batch.entries.iter().map(|e| e.hash).collect();
 
         {
             let mut write_guard = self.ledger.write_queue.wait(Writer::ConfirmationHeight);
             let mut tx = self.ledger.rw_txn();
+            let timer = Instant::now();
+            // Once a plan couldn't be applied, the plans after it might depend on it
+            let mut plans_valid = true;
 
-            for entry in batch {
+            for (entry, plan) in batch.entries.into_iter().zip(batch.plans) {
                 let hash = entry.hash;
                 let election = entry.election;
+                let mut plan = if plans_valid { plan } else { None };
                 let mut cemented_count = 0;
                 let mut success = false;
                 loop {
@@ -311,9 +445,21 @@ impl ConfirmingSetThread {
                         break;
                     }
 
-                    let added = self
-                        .ledger
-                        .confirm_max(&mut tx, hash, self.config.max_blocks);
+                    let added = match plan.take() {
+                        Some(plan) => {
+                            let (added, complete) = self.ledger.apply_confirmation(&mut tx, plan);
+                            if !complete {
+                                self.stats
+                                    .inc(StatType::ConfirmingSet, DetailType::PlanInvalidated);
+                                plans_valid = false;
+                            }
+                            added
+                        }
+                        // Not resolved in advance or the block implicitly confirms more than the plan limit
+                        None => self
+                            .ledger
+                            .confirm_max(&mut tx, hash, self.config.max_blocks),
+                    };
                     let added_len = added.len();
                     if !added.is_empty() {
                         // Confirming this block may implicitly confirm more
@@ -342,6 +488,11 @@ impl ConfirmingSetThread {
                     }
                 }
 
+                if plan.is_some() {
+                    // The plan was never applied
+                    plans_valid = false;
+                }
+
                 if success {
                     self.stats
                         .inc(StatType::ConfirmingSet, DetailType::CementedHash);
@@ -355,20 +506,77 @@ impl ConfirmingSetThread {
                     debug!("Failed to cement block: {}", hash);
                 }
             }
+
+            self.ledger.commit(write_guard, &mut tx);
+            self.batch_size.update(hashes.len(), timer.elapsed(), None);
         }
 
         self.notify(&mut cemented);
+        self.notify_already_cemented(already_cemented);
 
-        {
-            let mut guard = self.observers.lock().unwrap();
+        let mut guard = self.mutex.lock().unwrap();
+        for hash in &hashes {
+            guard.current.remove(hash);
+        }
+    }
+
+    /// Delivered by the same worker as the cemented notifications, so the order is kept
+    fn notify_already_cemented(&self, already_cemented: VecDeque<BlockHash>) {
+        let observers = self.observers.clone();
+        self.notification_workers.push_task(Box::new(move || {
+            let mut guard = observers.lock().unwrap();
             for callback in &mut guard.already_cemented {
                 callback(&already_cemented)
             }
+        }));
+    }
+}
+
+/// A chunk of a batch, whose dependencies are resolved by a resolver
+struct ResolveJob {
+    index: usize,
+    hashes: Vec<BlockHash>,
+    reply: mpsc::Sender<(usize, Vec<Option<ConfirmationPlan>>)>,
+}
+
+/// A batch whose chunks are being resolved
+struct ResolvingBatch {
+    entries: VecDeque<Entry>,
+    chunk_lens: Vec<usize>,
+    results: mpsc::Receiver<(usize, Vec<Option<ConfirmationPlan>>)>,
+}
+
+impl ResolvingBatch {
+    /// Waits for the plans of all chunks. Chunks whose resolver died get no plans,
+    /// so the writer resolves their entries itself
+    fn wait(self) -> ResolvedBatch {
+        let mut chunks: Vec<Option<Vec<Option<ConfirmationPlan>>>> =
+            self.chunk_lens.iter().map(|_| None).collect();
+        for _ in 0..chunks.len() {
+            match self.results.recv() {
+                Ok((index, plans)) => chunks[index] = Some(plans),
+                Err(_) => break,
+            }
+        }
+
+        let plans = chunks
+            .into_iter()
+            .zip(&self.chunk_lens)
+            .flat_map(|(plans, len)| plans.unwrap_or_else(|| (0..*len).map(|_| None).collect()))
+            .collect();
+        ResolvedBatch {
+            entries: self.entries,
+            plans,
         }
-        self.mutex.lock().unwrap().current.clear();
     }
 }
 
+/// A batch with the cementing plans of its entries
+struct ResolvedBatch {
+    entries: VecDeque<Entry>,
+    plans: Vec<Option<ConfirmationPlan>>,
+}
+
 struct ConfirmingSetImpl {
     set: OrderedEntries,
     current: HashSet<BlockHash>,
@@ -424,8 +632,12 @@ pub(crate) struct Context {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use rsban_core::{ConfirmationHeightInfo, SavedAccountChain};
+    use rsban_core::{
+        Amount, ConfirmationHeightInfo, PrivateKey, SavedAccountChain, UnsavedBlockLatticeBuilder,
+    };
+    use rsban_ledger::LedgerContext;
     use std::time::Duration;
+    use test_helpers::assert_timely_eq;
 
     #[test]
     fn add_exists() {
@@ -476,4 +688,112 @@ mod tests {
             .1;
         assert_eq!(result.timed_out(), false);
     }
+
+    #[test]
+    fn cement_dependencies_before_dependents() {
+        let ctx = LedgerContext::empty_dev();
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let key = PrivateKey::new();
+        let send1 = lattice.genesis().send(&key, Amount::raw(1));
+        let send2 = lattice.genesis().send(&key, Amount::raw(1));
+        let open = lattice.account(&key).receive(&send1);
+        let receive = lattice.account(&key).receive(&send2);
+        {
+            let mut tx = ctx.ledger.rw_txn();
+            for block in [&send1, &send2, &open, &receive] {
+                ctx.ledger.process(&mut tx, block).unwrap();
+            }
+        }
+
+        let confirming_set = ConfirmingSet::new(
+            ConfirmingSetConfig {
+                resolver_threads: 2,
+                ..Default::default()
+            },
+            Arc::clone(&ctx.ledger),
+            Arc::new(Stats::default()),
+        );
+        let cemented = Arc::new(Mutex::new(Vec::new()));
+        let cemented_l = Arc::clone(&cemented);
+        confirming_set.on_cemented(Box::new(move |block| {
+            cemented_l.lock().unwrap().push(block.hash());
+        }));
+        confirming_set.start();
+
+        confirming_set.add(receive.hash());
+        confirming_set.add(open.hash());
+
+        assert_timely_eq(Duration::from_secs(5), || cemented.lock().unwrap().len(), 4);
+        let cemented = cemented.lock().unwrap().clone();
+        let position = |hash: BlockHash| cemented.iter().position(|h| *h == hash).unwrap();
+        assert!(position(send1.hash()) < position(open.hash()));
+        assert!(position(send2.hash()) < position(receive.hash()));
+        assert!(position(open.hash()) < position(receive.hash()));
+        assert_eq!(ctx.ledger.cemented_count(), 5);
+        confirming_set.stop();
+    }
+
+    #[test]
+    fn resolve_on_the_writer_without_resolver_threads() {
+        let ctx = LedgerContext::empty_dev();
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let key = PrivateKey::new();
+        let send = lattice.genesis().send(&key, Amount::raw(1));
+        let open = lattice.account(&key).receive(&send);
+        {
+            let mut tx = ctx.ledger.rw_txn();
+            for block in [&send, &open] {
+                ctx.ledger.process(&mut tx, block).unwrap();
+            }
+        }
+
+        let stats = Arc::new(Stats::default());
+        let confirming_set = ConfirmingSet::new(
+            ConfirmingSetConfig {
+                resolver_threads: 0,
+                ..Default::default()
+            },
+            Arc::clone(&ctx.ledger),
+            stats.clone(),
+        );
+        confirming_set.start();
+        assert!(confirming_set.thread.resolvers.lock().unwrap().is_none());
+
+        confirming_set.add(open.hash());
+
+        assert_timely_eq(Duration::from_secs(5), || ctx.ledger.cemented_count(), 3);
+        confirming_set.stop();
+    }
+
+    #[test]
+    fn resolve_on_the_executor() {
+        let ctx = LedgerContext::empty_dev();
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let key = PrivateKey::new();
+        let send = lattice.genesis().send(&key, Amount::raw(1));
+        let open = lattice.account(&key).receive(&send);
+        {
+            let mut tx = ctx.ledger.rw_txn();
+            for block in [&send, &open] {
+                ctx.ledger.process(&mut tx, block).unwrap();
+            }
+        }
+
+        let executor = Arc::new(Executor::new_test_instance());
+        let confirming_set = ConfirmingSet::new(
+            ConfirmingSetConfig {
+                resolver_threads: 2,
+                ..Default::default()
+            },
+            Arc::clone(&ctx.ledger),
+            Arc::new(Stats::default()),
+        );
+        confirming_set.start_on(&executor);
+
+        confirming_set.add(open.hash());
+
+        assert_timely_eq(Duration::from_secs(5), || ctx.ledger.cemented_count(), 3);
+        confirming_set.stop();
+        assert!(executor.metrics()[TaskPriority::Cementing as usize].executed > 0);
+    }
 }
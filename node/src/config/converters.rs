@@ -9,18 +9,21 @@ use std::time::Duration;
 impl From<&GlobalConfig> for BlockProcessorConfig {
     fn from(value: &GlobalConfig) -> Self {
         let config = &value.node_config.block_processor;
+        let batch_max_time =
+            Duration::from_millis(value.node_config.block_processor_batch_max_time_ms as u64);
         Self {
             max_peer_queue: config.max_peer_queue,
             priority_local: config.priority_local,
             priority_bootstrap: config.priority_bootstrap,
             priority_live: config.priority_live,
             max_system_queue: config.max_system_queue,
-            batch_max_time: Duration::from_millis(
-                value.node_config.block_processor_batch_max_time_ms as u64,
-            ),
+            batch_max_time,
             full_size: value.flags.block_processor_full_size,
             batch_size: value.flags.block_processor_batch_size,
+            live_batch: BlockProcessorConfig::DEFAULT_LIVE_BATCH,
+            bootstrap_batch: BlockProcessorConfig::default_bootstrap_batch(batch_max_time),
             work_thresholds: value.network_params.work.clone(),
+            signature_checker_threads: value.node_config.signature_checker_threads as usize,
         }
     }
 }
@@ -39,6 +39,9 @@ pub struct NodeConfig {
     pub io_threads: u32,
     pub network_threads: u32,
     pub work_threads: u32,
+    /// Hash several nonces at once with the vector instructions of the CPU.
+    /// Disabling it falls back to hashing one nonce at a time
+    pub work_simd: bool,
     pub background_threads: u32,
     pub signature_checker_threads: u32,
     pub enable_voting: bool,
@@ -74,6 +77,10 @@ pub struct NodeConfig {
     pub max_queued_requests: u32,
     pub request_aggregator_threads: u32,
     pub max_unchecked_blocks: u32,
+    /// Unchecked blocks beyond `max_unchecked_blocks` are spilled to disk, up to this many. 0 disables the overflow
+    pub max_unchecked_overflow_blocks: u32,
+    /// Maximum size in bytes of the unchecked overflow database
+    pub unchecked_overflow_map_size: usize,
     pub rep_crawler_weight_minimum: Amount,
     pub work_peers: Vec<Peer>,
     pub secondary_work_peers: Vec<Peer>,
@@ -236,6 +243,7 @@ impl NodeConfig {
             io_threads: max(parallelism, 4) as u32,
             network_threads: max(parallelism, 4) as u32,
             work_threads: max(parallelism, 4) as u32,
+            work_simd: true,
             background_threads: max(parallelism, 4) as u32,
             /* Use half available threads on the system for signature checking. The calling thread does checks as well, so these are extra worker threads */
             signature_checker_threads: (parallelism / 2) as u32,
@@ -283,6 +291,8 @@ impl NodeConfig {
             max_queued_requests: 512,
             request_aggregator_threads: max(parallelism, 4) as u32,
             max_unchecked_blocks: 65536,
+            max_unchecked_overflow_blocks: 0,
+            unchecked_overflow_map_size: 64 * 1024 * 1024 * 1024,
             rep_crawler_weight_minimum: Amount::decode_hex("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF")
                 .unwrap(),
             work_peers: Vec::new(),
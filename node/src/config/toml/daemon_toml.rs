@@ -101,15 +101,18 @@ mod tests {
         tcp_incoming_connections_max = 999
         tcp_io_timeout = 999
         unchecked_cutoff_time = 999
+        unchecked_overflow_map_size = 999
         use_memory_pools = false
         vote_generator_delay = 999
         vote_generator_threshold = 9
         vote_minimum = "999"
         work_peers = ["dev.org:999"]
         work_threads = 999
+        work_simd = false
         max_work_generate_multiplier = 999
         request_aggregator_threads = 999
         max_unchecked_blocks = 999
+        max_unchecked_overflow_blocks = 999
         frontiers_confirmation = "always"
 
         [node.backlog_population]
@@ -412,6 +415,10 @@ mod tests {
             deserialized.node.unchecked_cutoff_time_s,
             default_cfg.node.unchecked_cutoff_time_s
         );
+        assert_ne!(
+            deserialized.node.unchecked_overflow_map_size,
+            default_cfg.node.unchecked_overflow_map_size
+        );
         assert_ne!(
             deserialized.node.use_memory_pools,
             default_cfg.node.use_memory_pools
@@ -433,6 +440,7 @@ mod tests {
             deserialized.node.work_threads,
             default_cfg.node.work_threads
         );
+        assert_ne!(deserialized.node.work_simd, default_cfg.node.work_simd);
         assert_ne!(
             deserialized.node.max_work_generate_multiplier,
             default_cfg.node.max_work_generate_multiplier
@@ -445,6 +453,10 @@ mod tests {
             deserialized.node.max_unchecked_blocks,
             default_cfg.node.max_unchecked_blocks
         );
+        assert_ne!(
+            deserialized.node.max_unchecked_overflow_blocks,
+            default_cfg.node.max_unchecked_overflow_blocks
+        );
         assert_ne!(
             deserialized.node.backlog.enabled,
             default_cfg.node.backlog.enabled
@@ -25,6 +25,7 @@ impl From<&LmdbToml> for LmdbConfig {
                 "nosync_safe" => SyncStrategy::NosyncSafe,
                 "nosync_unsafe" => SyncStrategy::NosyncUnsafe,
                 "nosync_unsafe_large_memory" => SyncStrategy::NosyncUnsafeLargeMemory,
+                "group_commit" => SyncStrategy::GroupCommit,
                 _ => panic!("Invalid sync value"),
             }
         }
@@ -46,6 +47,7 @@ impl From<&LmdbConfig> for LmdbToml {
                 SyncStrategy::NosyncSafe => "nosync_safe".to_string(),
                 SyncStrategy::NosyncUnsafe => "nosync_unsafe".to_string(),
                 SyncStrategy::NosyncUnsafeLargeMemory => "nosync_unsafe_large_memory".to_string(),
+                SyncStrategy::GroupCommit => "group_commit".to_string(),
             }),
             max_databases: Some(config.max_databases),
             map_size: Some(config.map_size),
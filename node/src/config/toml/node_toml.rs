@@ -29,6 +29,7 @@ pub struct NodeToml {
     pub io_threads: Option<u32>,
     pub max_queued_requests: Option<u32>,
     pub max_unchecked_blocks: Option<u32>,
+    pub max_unchecked_overflow_blocks: Option<u32>,
     pub max_work_generate_multiplier: Option<f64>,
     pub network_threads: Option<u32>,
     pub online_weight_minimum: Option<String>,
@@ -45,12 +46,14 @@ pub struct NodeToml {
     pub tcp_incoming_connections_max: Option<u32>,
     pub tcp_io_timeout: Option<i64>,
     pub unchecked_cutoff_time: Option<i64>,
+    pub unchecked_overflow_map_size: Option<usize>,
     pub use_memory_pools: Option<bool>,
     pub vote_generator_delay: Option<i64>,
     pub vote_generator_threshold: Option<u32>,
     pub vote_minimum: Option<String>,
     pub work_peers: Option<Vec<String>>,
     pub work_threads: Option<u32>,
+    pub work_simd: Option<bool>,
     pub active_elections: Option<ActiveElectionsToml>,
     pub block_processor: Option<BlockProcessorToml>,
     pub bootstrap_ascending: Option<BootstrapAscendingToml>,
@@ -145,6 +148,9 @@ impl NodeConfig {
         if let Some(max_unchecked_blocks) = toml.max_unchecked_blocks {
             self.max_unchecked_blocks = max_unchecked_blocks;
         }
+        if let Some(max_unchecked_overflow_blocks) = toml.max_unchecked_overflow_blocks {
+            self.max_unchecked_overflow_blocks = max_unchecked_overflow_blocks;
+        }
         if let Some(max_work_generate_multiplier) = toml.max_work_generate_multiplier {
             self.max_work_generate_multiplier = max_work_generate_multiplier;
         }
@@ -207,6 +213,9 @@ impl NodeConfig {
         if let Some(unchecked_cutoff_time_s) = toml.unchecked_cutoff_time {
             self.unchecked_cutoff_time_s = unchecked_cutoff_time_s;
         }
+        if let Some(unchecked_overflow_map_size) = toml.unchecked_overflow_map_size {
+            self.unchecked_overflow_map_size = unchecked_overflow_map_size;
+        }
         if let Some(use_memory_pools) = toml.use_memory_pools {
             self.use_memory_pools = use_memory_pools;
         }
@@ -228,6 +237,9 @@ impl NodeConfig {
         if let Some(work_threads) = toml.work_threads {
             self.work_threads = work_threads;
         }
+        if let Some(work_simd) = toml.work_simd {
+            self.work_simd = work_simd;
+        }
         if let Some(optimistic_scheduler_toml) = &toml.optimistic_scheduler {
             self.optimistic_scheduler = optimistic_scheduler_toml.into();
         }
@@ -365,6 +377,7 @@ impl From<&NodeConfig> for NodeToml {
             io_threads: Some(config.io_threads),
             max_queued_requests: Some(config.max_queued_requests),
             max_unchecked_blocks: Some(config.max_unchecked_blocks),
+            max_unchecked_overflow_blocks: Some(config.max_unchecked_overflow_blocks),
             max_work_generate_multiplier: Some(config.max_work_generate_multiplier),
             network_threads: Some(config.network_threads),
             online_weight_minimum: Some(config.online_weight_minimum.to_string_dec()),
@@ -395,6 +408,7 @@ impl From<&NodeConfig> for NodeToml {
             tcp_incoming_connections_max: Some(config.tcp_incoming_connections_max),
             tcp_io_timeout: Some(config.tcp_io_timeout_s),
             unchecked_cutoff_time: Some(config.unchecked_cutoff_time_s),
+            unchecked_overflow_map_size: Some(config.unchecked_overflow_map_size),
             use_memory_pools: Some(config.use_memory_pools),
             vote_generator_delay: Some(config.vote_generator_delay_ms),
             vote_generator_threshold: Some(config.vote_generator_threshold),
@@ -407,6 +421,7 @@ impl From<&NodeConfig> for NodeToml {
                     .collect(),
             ),
             work_threads: Some(config.work_threads),
+            work_simd: Some(config.work_simd),
             optimistic_scheduler: Some((&config.optimistic_scheduler).into()),
             hinted_scheduler: Some((&config.hinted_scheduler).into()),
             priority_bucket: Some((&config.priority_bucket).into()),
@@ -1,8 +1,8 @@
 use super::{
     confirmation_solicitor::ConfirmationSolicitor, election_schedulers::ElectionSchedulers,
     Election, ElectionBehavior, ElectionData, ElectionState, ElectionStatus, ElectionStatusType,
-    RecentlyConfirmedCache, VoteApplier, VoteCache, VoteCacheProcessor, VoteGenerators, VoteRouter,
-    NEXT_ELECTION_ID,
+    RecentlyConfirmedCache, ShardedVoteCache, VoteApplier, VoteCacheProcessor, VoteGenerators,
+    VoteRouter, NEXT_ELECTION_ID,
 };
 use crate::{
     block_processing::BlockProcessor,
@@ -10,7 +10,7 @@ use crate::{
     config::{NodeConfig, NodeFlags},
     consensus::VoteApplierExt,
     representatives::OnlineReps,
-    stats::{DetailType, Direction, Sample, StatType, Stats},
+    stats::{DetailType, Direction, LatencyStage, Sample, StatType, Stats},
     transport::{MessagePublisher, NetworkFilter},
     utils::HardenedConstants,
     wallets::Wallets,
@@ -91,7 +91,7 @@ pub struct ActiveElections {
     network_filter: Arc<NetworkFilter>,
     network_info: Arc<RwLock<NetworkInfo>>,
     election_schedulers: RwLock<Option<Weak<ElectionSchedulers>>>,
-    vote_cache: Arc<Mutex<VoteCache>>,
+    vote_cache: Arc<ShardedVoteCache>,
     stats: Arc<Stats>,
     active_started_observer: Mutex<Vec<Box<dyn Fn(BlockHash) + Send + Sync>>>,
     active_stopped_observer: Mutex<Vec<Box<dyn Fn(BlockHash) + Send + Sync>>>,
@@ -116,7 +116,7 @@ impl ActiveElections {
         vote_generators: Arc<VoteGenerators>,
         network_filter: Arc<NetworkFilter>,
         network_info: Arc<RwLock<NetworkInfo>>,
-        vote_cache: Arc<Mutex<VoteCache>>,
+        vote_cache: Arc<ShardedVoteCache>,
         stats: Arc<Stats>,
         election_end: ElectionEndCallback,
         online_reps: Arc<Mutex<OnlineReps>>,
@@ -469,7 +469,7 @@ impl ActiveElections {
         };
 
         // Replace if lowest tally is below inactive cache new block weight
-        let inactive_existing = self.vote_cache.lock().unwrap().find(hash);
+        let inactive_existing = self.vote_cache.find(hash);
         let inactive_tally = votes_tally(&inactive_existing);
         if inactive_tally > Amount::zero() && sorted.len() < ELECTION_MAX_BLOCKS {
             // If count of tally items is less than 10, remove any block without tally
@@ -1355,6 +1355,9 @@ impl ActiveElectionsExt for Arc<ActiveElections> {
             debug_assert!(election_result.is_some());
 
             self.vote_cache_processor.trigger(hash);
+            self.stats
+                .block_latency()
+                .stage_reached(&hash, LatencyStage::ElectionStarted);
 
             {
                 let callbacks = self.active_started_observer.lock().unwrap();
@@ -2,11 +2,10 @@ use rsban_core::{
     utils::{BufferReader, Deserialize, StreamExt},
     Account, Amount, Networks, PublicKey,
 };
-use rsban_ledger::RepWeightCache;
-use std::collections::HashMap;
+use rsban_ledger::{RepWeightCache, RepWeightTable};
 use tracing::info;
 
-pub(crate) fn get_bootstrap_weights(network: Networks) -> (u64, HashMap<PublicKey, Amount>) {
+pub(crate) fn get_bootstrap_weights(network: Networks) -> (u64, RepWeightTable) {
     let buffer = get_bootstrap_weights_bin(network);
     deserialize_bootstrap_weights(buffer)
 }
@@ -19,9 +18,10 @@ fn get_bootstrap_weights_bin(network: Networks) -> &'static [u8] {
     }
 }
 
-fn deserialize_bootstrap_weights(buffer: &[u8]) -> (u64, HashMap<PublicKey, Amount>) {
+/// Reads the weights straight into the compact table layout
+fn deserialize_bootstrap_weights(buffer: &[u8]) -> (u64, RepWeightTable) {
     let mut reader = BufferReader::new(buffer);
-    let mut weights = HashMap::new();
+    let mut weights = Vec::with_capacity(buffer.len() / (32 + 16));
     let mut max_blocks = 0;
     if let Ok(count) = reader.read_u128_be() {
         max_blocks = count as u64;
@@ -32,15 +32,15 @@ fn deserialize_bootstrap_weights(buffer: &[u8]) -> (u64, HashMap<PublicKey, Amou
             let Ok(weight) = Amount::deserialize(&mut reader) else {
                 break;
             };
-            weights.insert(account, weight);
+            weights.push((account, weight));
         }
     }
 
-    (max_blocks, weights)
+    (max_blocks, RepWeightTable::from_unsorted(weights))
 }
 
 pub(crate) fn log_bootstrap_weights(weight_cache: &RepWeightCache) {
-    let mut bootstrap_weights = weight_cache.bootstrap_weights();
+    let bootstrap_weights = weight_cache.bootstrap_weights();
     if !bootstrap_weights.is_empty() {
         info!(
             "Initial bootstrap height: {}",
@@ -53,13 +53,13 @@ pub(crate) fn log_bootstrap_weights(weight_cache: &RepWeightCache) {
             info!("Using predefined representative weights, since block count is less than bootstrap threshold");
             info!("************************************ Bootstrap weights ************************************");
             // Sort the weights
-            let mut sorted_weights = bootstrap_weights.drain().collect::<Vec<_>>();
+            let mut sorted_weights = bootstrap_weights.iter().collect::<Vec<_>>();
             sorted_weights.sort_by(|(_, weight_a), (_, weight_b)| weight_b.cmp(weight_a));
 
             for (rep, weight) in sorted_weights {
                 info!(
                     "Using bootstrap rep weight: {} -> {}",
-                    Account::from(&rep).encode_account(),
+                    Account::from(rep).encode_account(),
                     weight.format_balance(0)
                 );
             }
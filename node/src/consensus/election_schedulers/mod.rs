@@ -8,7 +8,7 @@ use crate::{
 use super::{
     ActiveElections, HintedScheduler, HintedSchedulerExt, ManualScheduler, ManualSchedulerExt,
     OptimisticScheduler, OptimisticSchedulerExt, PriorityScheduler, PrioritySchedulerExt,
-    VoteCache,
+    ShardedVoteCache,
 };
 use rsban_core::{utils::ContainerInfo, Account, AccountInfo, ConfirmationHeightInfo, SavedBlock};
 use rsban_ledger::Ledger;
@@ -31,7 +31,7 @@ impl ElectionSchedulers {
         active_elections: Arc<ActiveElections>,
         ledger: Arc<Ledger>,
         stats: Arc<Stats>,
-        vote_cache: Arc<Mutex<VoteCache>>,
+        vote_cache: Arc<ShardedVoteCache>,
         confirming_set: Arc<ConfirmingSet>,
         online_reps: Arc<Mutex<OnlineReps>>,
     ) -> Self {
@@ -1,4 +1,4 @@
-use super::{ActiveElections, ElectionBehavior, VoteCache};
+use super::{ActiveElections, ElectionBehavior, ShardedVoteCache};
 use crate::{
     cementation::ConfirmingSet,
     consensus::ActiveElectionsExt,
@@ -59,7 +59,7 @@ pub struct HintedScheduler {
     ledger: Arc<Ledger>,
     confirming_set: Arc<ConfirmingSet>,
     stats: Arc<Stats>,
-    vote_cache: Arc<Mutex<VoteCache>>,
+    vote_cache: Arc<ShardedVoteCache>,
     online_reps: Arc<Mutex<OnlineReps>>,
     stopped: AtomicBool,
     stopped_mutex: Mutex<()>,
@@ -72,7 +72,7 @@ impl HintedScheduler {
         active: Arc<ActiveElections>,
         ledger: Arc<Ledger>,
         stats: Arc<Stats>,
-        vote_cache: Arc<Mutex<VoteCache>>,
+        vote_cache: Arc<ShardedVoteCache>,
         confirming_set: Arc<ConfirmingSet>,
         online_reps: Arc<Mutex<OnlineReps>>,
     ) -> Self {
@@ -141,7 +141,7 @@ impl HintedScheduler {
             tx.refresh_if_needed();
 
             // Check if block exists
-            if let Some(block) = self.ledger.any().get_block(tx, &current_hash) {
+            if let Some(block) = self.ledger.any().get_block_view(tx, &current_hash) {
                 // Ensure block is not already confirmed
                 if self.confirming_set.contains(&current_hash)
                     || self
@@ -151,16 +151,16 @@ impl HintedScheduler {
                 {
                     self.stats
                         .inc(StatType::Hinting, DetailType::AlreadyConfirmed);
-                    self.vote_cache.lock().unwrap().erase(&current_hash); // Remove from vote cache
+                    self.vote_cache.erase(&current_hash); // Remove from vote cache
                     continue; // Move on to the next item in the stack
                 }
 
                 if check_dependents {
                     // Perform a depth-first search of the dependency graph
-                    if !self.ledger.dependents_confirmed(tx, &block) {
+                    if !self.ledger.dependents_confirmed_view(tx, &block) {
                         self.stats
                             .inc(StatType::Hinting, DetailType::DependentUnconfirmed);
-                        let dependents = self.ledger.dependent_blocks(tx, &block);
+                        let dependents = self.ledger.dependent_blocks_view(&block);
                         for dependent_hash in dependents.iter() {
                             // Avoid visiting the same block twice
                             if !dependent_hash.is_zero() && visited.insert(*dependent_hash) {
@@ -172,6 +172,7 @@ impl HintedScheduler {
                 }
 
                 // Try to insert it into AEC as hinted election
+                let block = block.to_saved_block();
                 let (inserted, _) = self.active.insert(block, ElectionBehavior::Hinted, None);
                 self.stats.inc(
                     StatType::Hinting,
@@ -194,7 +195,7 @@ impl HintedScheduler {
         let minimum_final_tally = self.final_tally_threshold();
 
         // Get the list before db transaction starts to avoid unnecessary slowdowns
-        let tops = self.vote_cache.lock().unwrap().top(minimum_tally);
+        let tops = self.vote_cache.top(minimum_tally);
 
         let mut tx = self.ledger.read_txn();
 
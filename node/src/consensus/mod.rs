@@ -12,6 +12,7 @@ mod priority_scheduler;
 mod process_live_dispatcher;
 mod recently_confirmed_cache;
 mod rep_tiers;
+mod sharded_vote_cache;
 mod vote_applier;
 mod vote_broadcaster;
 mod vote_cache;
@@ -34,6 +35,7 @@ pub use priority_scheduler::*;
 pub use process_live_dispatcher::*;
 pub use recently_confirmed_cache::*;
 pub use rep_tiers::*;
+pub use sharded_vote_cache::ShardedVoteCache;
 pub use vote_applier::*;
 pub use vote_broadcaster::*;
 pub use vote_cache::{CacheEntry, TopEntry, VoteCache, VoteCacheConfig, VoterEntry};
@@ -1,94 +1,206 @@
-use std::{
-    collections::{HashMap, VecDeque},
-    sync::Mutex,
-};
+use std::sync::Mutex;
 
+use crate::utils::FixedHashIndex;
 use rsban_core::{utils::ContainerInfo, BlockHash, QualifiedRoot};
 
 pub struct RecentlyConfirmedCache {
     mutex: Mutex<RecentlyConfirmedCacheImpl>,
-    max_len: usize,
 }
 
 impl RecentlyConfirmedCache {
     pub fn new(max_len: usize) -> Self {
         Self {
-            mutex: Mutex::new(RecentlyConfirmedCacheImpl {
-                sequential: VecDeque::new(),
-                by_root: HashMap::new(),
-                by_hash: HashMap::new(),
-            }),
-            max_len,
+            mutex: Mutex::new(RecentlyConfirmedCacheImpl::new(max_len.max(1))),
         }
     }
 
     pub fn put(&self, root: QualifiedRoot, hash: BlockHash) -> bool {
-        let mut guard = self.mutex.lock().unwrap();
-        if guard.by_hash.contains_key(&hash) || guard.by_root.contains_key(&root) {
-            return false;
-        }
-        guard.sequential.push_back(hash);
-        guard.by_root.insert(root.clone(), hash);
-        guard.by_hash.insert(hash, root);
-        if guard.sequential.len() > self.max_len {
-            if let Some(old_hash) = guard.sequential.pop_front() {
-                if let Some(old_root) = guard.by_hash.remove(&old_hash) {
-                    guard.by_root.remove(&old_root);
-                }
-            }
-        }
-        true
+        self.mutex.lock().unwrap().put(root, hash)
     }
 
     pub fn erase(&self, hash: &BlockHash) {
-        let mut guard = self.mutex.lock().unwrap();
-        if let Some(root) = guard.by_hash.remove(hash) {
-            guard.by_root.remove(&root);
-            guard.sequential.retain(|i| i != hash);
-        }
+        self.mutex.lock().unwrap().erase(hash);
     }
 
     pub fn root_exists(&self, root: &QualifiedRoot) -> bool {
-        self.mutex.lock().unwrap().by_root.contains_key(root)
+        self.mutex.lock().unwrap().by_root.get(root).is_some()
     }
 
     pub fn hash_exists(&self, hash: &BlockHash) -> bool {
-        self.mutex.lock().unwrap().by_hash.contains_key(hash)
+        self.mutex.lock().unwrap().by_hash.get(hash).is_some()
     }
 
     pub fn clear(&self) {
-        let mut guard = self.mutex.lock().unwrap();
-        guard.sequential.clear();
-        guard.by_root.clear();
-        guard.by_hash.clear();
+        self.mutex.lock().unwrap().clear();
     }
 
     pub fn len(&self) -> usize {
-        self.mutex.lock().unwrap().sequential.len()
+        self.mutex.lock().unwrap().by_hash.len()
     }
 
     pub fn back(&self) -> Option<(QualifiedRoot, BlockHash)> {
-        let guard = self.mutex.lock().unwrap();
-        guard
-            .sequential
-            .back()
-            .map(|hash| (guard.by_hash.get(hash).unwrap().clone(), *hash))
+        self.mutex.lock().unwrap().back()
     }
 
     pub fn container_info(&self) -> ContainerInfo {
         [(
             "confirmed",
             self.len(),
-            std::mem::size_of::<BlockHash>() * 3 + std::mem::size_of::<QualifiedRoot>(),
+            std::mem::size_of::<Option<(QualifiedRoot, BlockHash)>>()
+                + 2 * FixedHashIndex::<QualifiedRoot>::bucket_size()
+                + 2 * FixedHashIndex::<BlockHash>::bucket_size(),
         )]
         .into()
     }
 }
 
+/// A fixed size ring buffer in confirmation order. The oldest entry is
+/// overwritten when the ring is full. Both lookups go through open addressing
+/// indices, which point to the position of the entry in the ring.
 struct RecentlyConfirmedCacheImpl {
-    by_root: HashMap<QualifiedRoot, BlockHash>,
-    by_hash: HashMap<BlockHash, QualifiedRoot>,
-    sequential: VecDeque<BlockHash>,
+    ring: Box<[Option<(QualifiedRoot, BlockHash)>]>,
+    /// Position of the oldest entry
+    head: usize,
+    /// Number of positions from head up to and including the newest entry.
+    /// Erased entries leave holes, so this can be larger than the entry count
+    used: usize,
+    by_root: FixedHashIndex<QualifiedRoot>,
+    by_hash: FixedHashIndex<BlockHash>,
+}
+
+impl RecentlyConfirmedCacheImpl {
+    fn new(max_len: usize) -> Self {
+        Self {
+            ring: vec![None; max_len].into_boxed_slice(),
+            head: 0,
+            used: 0,
+            by_root: FixedHashIndex::new(max_len),
+            by_hash: FixedHashIndex::new(max_len),
+        }
+    }
+
+    fn put(&mut self, root: QualifiedRoot, hash: BlockHash) -> bool {
+        if self.by_hash.get(&hash).is_some() || self.by_root.get(&root).is_some() {
+            return false;
+        }
+        if self.used == self.ring.len() {
+            self.pop_front();
+        }
+        let pos = self.position(self.used);
+        self.used += 1;
+        self.by_root.insert(root.clone(), pos as u32);
+        self.by_hash.insert(hash, pos as u32);
+        self.ring[pos] = Some((root, hash));
+        true
+    }
+
+    fn erase(&mut self, hash: &BlockHash) {
+        let Some(pos) = self.by_hash.remove(hash) else {
+            return;
+        };
+        if let Some((root, _)) = self.ring[pos as usize].take() {
+            self.by_root.remove(&root);
+        }
+        self.trim();
+    }
+
+    fn back(&self) -> Option<(QualifiedRoot, BlockHash)> {
+        if self.used == 0 {
+            return None;
+        }
+        self.ring[self.position(self.used - 1)].clone()
+    }
+
+    fn clear(&mut self) {
+        self.ring.fill(None);
+        self.head = 0;
+        self.used = 0;
+        self.by_root.clear();
+        self.by_hash.clear();
+    }
+
+    fn pop_front(&mut self) {
+        if let Some((root, hash)) = self.ring[self.head].take() {
+            self.by_root.remove(&root);
+            self.by_hash.remove(&hash);
+        }
+        self.head = self.position(1);
+        self.used -= 1;
+    }
+
+    /// Drops holes at both ends, so that head and back always point to entries
+    fn trim(&mut self) {
+        while self.used > 0 && self.ring[self.head].is_none() {
+            self.head = self.position(1);
+            self.used -= 1;
+        }
+        while self.used > 0 && self.ring[self.position(self.used - 1)].is_none() {
+            self.used -= 1;
+        }
+    }
+
+    fn position(&self, offset: usize) -> usize {
+        (self.head + offset) % self.ring.len()
+    }
 }
 
-impl RecentlyConfirmedCacheImpl {}
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use rsban_core::Root;
+
+    fn entry(i: u64) -> (QualifiedRoot, BlockHash) {
+        (
+            QualifiedRoot::new(Root::from(i), BlockHash::from(i + 1000)),
+            BlockHash::from(i),
+        )
+    }
+
+    #[test]
+    fn put_and_lookup() {
+        let cache = RecentlyConfirmedCache::new(3);
+        let (root, hash) = entry(1);
+        assert!(cache.put(root.clone(), hash));
+        assert!(!cache.put(root.clone(), hash));
+        assert!(cache.root_exists(&root));
+        assert!(cache.hash_exists(&hash));
+        assert_eq!(cache.len(), 1);
+        assert_eq!(cache.back(), Some((root, hash)));
+    }
+
+    #[test]
+    fn overwrite_oldest_when_full() {
+        let cache = RecentlyConfirmedCache::new(3);
+        for i in 1..=4 {
+            let (root, hash) = entry(i);
+            cache.put(root, hash);
+        }
+        assert_eq!(cache.len(), 3);
+        assert!(!cache.hash_exists(&entry(1).1));
+        assert!(!cache.root_exists(&entry(1).0));
+        assert!(cache.hash_exists(&entry(2).1));
+        assert_eq!(cache.back(), Some(entry(4)));
+    }
+
+    #[test]
+    fn erase() {
+        let cache = RecentlyConfirmedCache::new(3);
+        for i in 1..=3 {
+            let (root, hash) = entry(i);
+            cache.put(root, hash);
+        }
+        cache.erase(&entry(3).1);
+        assert_eq!(cache.len(), 2);
+        assert!(!cache.root_exists(&entry(3).0));
+        assert_eq!(cache.back(), Some(entry(2)));
+
+        let (root, hash) = entry(4);
+        cache.put(root, hash);
+        assert_eq!(cache.len(), 3);
+        assert!(cache.hash_exists(&entry(1).1));
+
+        cache.clear();
+        assert_eq!(cache.len(), 0);
+        assert_eq!(cache.back(), None);
+    }
+}
@@ -0,0 +1,244 @@
+use super::{
+    vote_cache::{cacheable_hashes, sort_top},
+    CacheEntry, TopEntry, VoteCache, VoteCacheConfig,
+};
+use crate::stats::{DetailType, StatType, Stats};
+#[cfg(test)]
+use mock_instant::thread_local::Instant;
+use rsban_core::{utils::ContainerInfo, Amount, BlockHash, Vote, VoteCode};
+#[cfg(not(test))]
+use std::time::Instant;
+use std::{
+    collections::HashMap,
+    mem::size_of,
+    sync::{Arc, Mutex},
+};
+
+/// A `VoteCache` which is split into independently locked shards keyed by block hash.
+/// Vote ingestion only locks the shard of the voted hash, and `top()` locks one shard at a
+/// time just long enough to take a snapshot of its candidates, so the hinted and optimistic
+/// schedulers never stall the vote processors.
+/// The size limit is enforced per shard, so the oldest entry of the full shard gets evicted.
+pub struct ShardedVoteCache {
+    config: VoteCacheConfig,
+    shards: Vec<Mutex<VoteCache>>,
+    last_cleanup: Mutex<Instant>,
+    stats: Arc<Stats>,
+}
+
+impl ShardedVoteCache {
+    pub const DEFAULT_SHARDS: usize = 16;
+
+    pub fn new(config: VoteCacheConfig, stats: Arc<Stats>) -> Self {
+        Self::with_shards(config, stats, Self::DEFAULT_SHARDS)
+    }
+
+    pub fn with_shards(config: VoteCacheConfig, stats: Arc<Stats>, shards: usize) -> Self {
+        let shards = shards.max(1);
+        let shard_config = VoteCacheConfig {
+            max_size: config.max_size.div_ceil(shards).max(1),
+            ..config.clone()
+        };
+        Self {
+            shards: (0..shards)
+                .map(|_| Mutex::new(VoteCache::new(shard_config.clone(), Arc::clone(&stats))))
+                .collect(),
+            last_cleanup: Mutex::new(Instant::now()),
+            config,
+            stats,
+        }
+    }
+
+    fn shard(&self, hash: &BlockHash) -> &Mutex<VoteCache> {
+        // Block hashes are uniformly distributed, so any part of it can be used
+        let suffix = u64::from_be_bytes(hash.as_bytes()[24..].try_into().unwrap());
+        &self.shards[(suffix % self.shards.len() as u64) as usize]
+    }
+
+    /// Adds a new vote to cache
+    pub fn insert(
+        &self,
+        vote: &Arc<Vote>,
+        rep_weight: Amount,
+        results: &HashMap<BlockHash, VoteCode>,
+    ) {
+        // Results map should be empty or have the same hashes as the vote
+        debug_assert!(results.is_empty() || vote.hashes.iter().all(|h| results.contains_key(h)));
+
+        for hash in cacheable_hashes(vote, results) {
+            self.shard(hash)
+                .lock()
+                .unwrap()
+                .insert_hash(vote, hash, rep_weight);
+        }
+    }
+
+    pub fn empty(&self) -> bool {
+        self.shards.iter().all(|s| s.lock().unwrap().empty())
+    }
+
+    pub fn size(&self) -> usize {
+        self.shards.iter().map(|s| s.lock().unwrap().size()).sum()
+    }
+
+    /// Tries to find an entry associated with block hash
+    pub fn find(&self, hash: &BlockHash) -> Vec<Arc<Vote>> {
+        self.shard(hash).lock().unwrap().find(hash)
+    }
+
+    /// Removes an entry associated with block hash, does nothing if entry does not exist
+    /// return true if hash existed and was erased, false otherwise
+    pub fn erase(&self, hash: &BlockHash) -> bool {
+        self.shard(hash).lock().unwrap().erase(hash)
+    }
+
+    pub fn clear(&self) {
+        for shard in &self.shards {
+            shard.lock().unwrap().clear();
+        }
+    }
+
+    /// Returns blocks with highest observed tally, greater than `min_tally`
+    /// The blocks are sorted in descending order by final tally, then by tally
+    pub fn top(&self, min_tally: impl Into<Amount>) -> Vec<TopEntry> {
+        let min_tally = min_tally.into();
+        self.stats.inc(StatType::VoteCache, DetailType::Top);
+        self.cleanup_if_needed();
+
+        let mut results = Vec::new();
+        for shard in &self.shards {
+            let snapshot = shard.lock().unwrap().top_unsorted(min_tally);
+            results.extend(snapshot);
+        }
+        // Sorting happens without holding any shard lock
+        sort_top(&mut results);
+        results
+    }
+
+    fn cleanup_if_needed(&self) {
+        {
+            let mut last_cleanup = self.last_cleanup.lock().unwrap();
+            if last_cleanup.elapsed() < self.config.age_cutoff / 2 {
+                return;
+            }
+            *last_cleanup = Instant::now();
+        }
+
+        self.stats.inc(StatType::VoteCache, DetailType::Cleanup);
+        for shard in &self.shards {
+            shard.lock().unwrap().remove_expired();
+        }
+    }
+
+    pub fn container_info(&self) -> ContainerInfo {
+        [("cache", self.size(), size_of::<CacheEntry>())].into()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stats::Direction;
+    use mock_instant::thread_local::MockClock;
+    use rsban_core::PrivateKey;
+    use std::time::Duration;
+
+    #[test]
+    fn construction() {
+        let cache = create_sharded_cache(4);
+        assert_eq!(cache.size(), 0);
+        assert!(cache.empty());
+        assert!(cache.find(&BlockHash::from(1)).is_empty());
+    }
+
+    #[test]
+    fn insert_into_different_shards() {
+        let cache = create_sharded_cache(4);
+        let hashes: Vec<_> = (1..=8u64).map(BlockHash::from).collect();
+        let vote = Arc::new(Vote::new(&PrivateKey::new(), 1, 0, hashes.clone()));
+
+        cache.insert(&vote, Amount::raw(7), &HashMap::new());
+
+        assert_eq!(cache.size(), 8);
+        for hash in &hashes {
+            assert_eq!(cache.find(hash), vec![vote.clone()]);
+        }
+    }
+
+    #[test]
+    fn insert_only_cacheable_results() {
+        let cache = create_sharded_cache(4);
+        let hash1 = BlockHash::from(1);
+        let hash2 = BlockHash::from(2);
+        let vote = Arc::new(Vote::new(&PrivateKey::new(), 1, 0, vec![hash1, hash2]));
+        let results = HashMap::from([(hash1, VoteCode::Vote), (hash2, VoteCode::Replay)]);
+
+        cache.insert(&vote, Amount::raw(7), &results);
+
+        assert_eq!(cache.find(&hash1).len(), 1);
+        assert!(cache.find(&hash2).is_empty());
+    }
+
+    #[test]
+    fn erase() {
+        let cache = create_sharded_cache(4);
+        let hash = BlockHash::from(1);
+        add_test_vote(&cache, &hash, Amount::raw(1));
+        assert!(cache.erase(&hash));
+        assert!(!cache.erase(&hash));
+        assert!(cache.empty());
+    }
+
+    #[test]
+    fn top_merges_all_shards() {
+        let cache = create_sharded_cache(4);
+        for i in 1..=10u64 {
+            add_test_vote(&cache, &BlockHash::from(i), Amount::raw(i as u128));
+        }
+
+        let top = cache.top(5);
+
+        let tallies: Vec<_> = top.iter().map(|e| e.tally).collect();
+        let expected: Vec<_> = (5..=10u128).rev().map(Amount::raw).collect();
+        assert_eq!(tallies, expected);
+    }
+
+    #[test]
+    fn top_age_cutoff() {
+        let stats = Arc::new(Stats::new(Default::default()));
+        let cache = ShardedVoteCache::with_shards(test_config(), Arc::clone(&stats), 4);
+        add_test_vote(&cache, &BlockHash::from(1), Amount::raw(1));
+        add_test_vote(&cache, &BlockHash::from(2), Amount::raw(1));
+
+        MockClock::advance(Duration::from_secs(150));
+        assert_eq!(cache.top(0).len(), 2);
+        MockClock::advance(Duration::from_secs(150));
+        assert_eq!(cache.top(0).len(), 0);
+        // Cleaning all shards counts as a single cleanup
+        assert_eq!(
+            stats.count(StatType::VoteCache, DetailType::Cleanup, Direction::In),
+            2
+        );
+    }
+
+    fn test_config() -> VoteCacheConfig {
+        VoteCacheConfig {
+            max_size: 100,
+            max_voters: 80,
+            age_cutoff: Duration::from_secs(5 * 60),
+        }
+    }
+
+    fn create_sharded_cache(shards: usize) -> ShardedVoteCache {
+        ShardedVoteCache::with_shards(
+            test_config(),
+            Arc::new(Stats::new(Default::default())),
+            shards,
+        )
+    }
+
+    fn add_test_vote(cache: &ShardedVoteCache, hash: &BlockHash, rep_weight: Amount) {
+        let vote = Arc::new(Vote::new(&PrivateKey::new(), 0, 0, vec![*hash]));
+        cache.insert(&vote, rep_weight, &HashMap::new());
+    }
+}
@@ -4,7 +4,7 @@ use crate::{
     config::NodeConfig,
     consensus::{ElectionState, VoteInfo},
     representatives::OnlineReps,
-    stats::{DetailType, StatType, Stats},
+    stats::{DetailType, LatencyStage, StatType, Stats},
     utils::ThreadPool,
     wallets::Wallets,
     NetworkParams,
@@ -293,6 +293,10 @@ impl VoteApplierExt for Arc<VoteApplier> {
             );
 
             self.stats.inc(StatType::Election, DetailType::ConfirmOnce);
+            self.stats.block_latency().stage_reached(
+                &status.winner.as_ref().unwrap().hash(),
+                LatencyStage::Confirmed,
+            );
             trace!(
                 qualified_root = ?election.qualified_root,
                 "election confirmed"
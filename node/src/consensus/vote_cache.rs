@@ -65,22 +65,12 @@ impl VoteCache {
         // Results map should be empty or have the same hashes as the vote
         debug_assert!(results.is_empty() || vote.hashes.iter().all(|h| results.contains_key(h)));
 
-        // If results map is empty, insert all hashes (meant for testing)
-        if results.is_empty() {
-            for hash in &vote.hashes {
-                self.insert_impl(vote, hash, rep_weight);
-            }
-        } else {
-            for (hash, code) in results {
-                // Cache votes with a corresponding active election (indicated by `vote_code::vote`) in case that election gets dropped
-                if matches!(code, VoteCode::Vote | VoteCode::Indeterminate) {
-                    self.insert_impl(vote, hash, rep_weight)
-                }
-            }
+        for hash in cacheable_hashes(vote, results) {
+            self.insert_hash(vote, hash, rep_weight);
         }
     }
 
-    fn insert_impl(&mut self, vote: &Arc<Vote>, hash: &BlockHash, rep_weight: Amount) {
+    pub(crate) fn insert_hash(&mut self, vote: &Arc<Vote>, hash: &BlockHash, rep_weight: Amount) {
         let cache_entry_exists = self.cache.modify_by_hash(hash, |existing| {
             self.stats.inc(StatType::VoteCache, DetailType::Update);
             existing.vote(vote, rep_weight, self.config.max_voters);
@@ -139,6 +129,13 @@ impl VoteCache {
             self.last_cleanup = Instant::now();
         }
 
+        let mut results = self.top_unsorted(min_tally);
+        sort_top(&mut results);
+        results
+    }
+
+    /// Collects the entries with a tally of at least `min_tally` without sorting them
+    pub(crate) fn top_unsorted(&self, min_tally: Amount) -> Vec<TopEntry> {
         let mut results = Vec::new();
         for entry in self.cache.iter_by_tally_desc() {
             let tally = entry.tally();
@@ -151,22 +148,16 @@ impl VoteCache {
                 final_tally: entry.final_tally(),
             })
         }
-
-        // Sort by final tally then by normal tally, descending
-        results.sort_by(|a, b| {
-            let res = b.final_tally.cmp(&b.final_tally);
-            if res == Ordering::Equal {
-                b.tally.cmp(&a.tally)
-            } else {
-                res
-            }
-        });
-
         results
     }
 
     fn cleanup(&mut self) {
         self.stats.inc(StatType::VoteCache, DetailType::Cleanup);
+        self.remove_expired();
+    }
+
+    /// Removes all entries which didn't receive a vote within `age_cutoff`
+    pub(crate) fn remove_expired(&mut self) {
         let to_delete: Vec<_> = self
             .cache
             .iter()
@@ -183,6 +174,36 @@ impl VoteCache {
     }
 }
 
+/// Returns the hashes of the vote that should be cached.
+/// If results map is empty, all hashes are returned (meant for testing)
+pub(crate) fn cacheable_hashes<'a>(
+    vote: &'a Vote,
+    results: &'a HashMap<BlockHash, VoteCode>,
+) -> Vec<&'a BlockHash> {
+    if results.is_empty() {
+        vote.hashes.iter().collect()
+    } else {
+        results
+            .iter()
+            // Cache votes with a corresponding active election (indicated by `vote_code::vote`) in case that election gets dropped
+            .filter(|(_, code)| matches!(code, VoteCode::Vote | VoteCode::Indeterminate))
+            .map(|(hash, _)| hash)
+            .collect()
+    }
+}
+
+/// Sort by final tally then by normal tally, descending
+pub(crate) fn sort_top(entries: &mut [TopEntry]) {
+    entries.sort_by(|a, b| {
+        let res = b.final_tally.cmp(&a.final_tally);
+        if res == Ordering::Equal {
+            b.tally.cmp(&a.tally)
+        } else {
+            res
+        }
+    });
+}
+
 #[derive(PartialEq, Eq, Debug)]
 pub struct TopEntry {
     pub hash: BlockHash,
@@ -238,16 +259,14 @@ impl CacheEntry {
         }
     }
 
-    fn calculate_tally(&mut self) -> (Amount, Amount) {
-        let mut tally = Amount::zero();
-        let mut final_tally = Amount::zero();
-        for voter in self.voters.iter_unordered() {
-            tally = tally.wrapping_add(voter.weight);
-            if voter.vote.is_final() {
-                final_tally = final_tally.wrapping_add(voter.weight);
-            }
-        }
-        (tally, final_tally)
+    fn add_to_tally(&mut self, voter: &VoterEntry) {
+        self.tally = self.tally.wrapping_add(voter.weight);
+        self.final_tally = self.final_tally.wrapping_add(voter.final_weight());
+    }
+
+    fn remove_from_tally(&mut self, voter: &VoterEntry) {
+        self.tally = self.tally.wrapping_sub(voter.weight);
+        self.final_tally = self.final_tally.wrapping_sub(voter.final_weight());
     }
 
     pub fn tally(&self) -> Amount {
@@ -270,23 +289,30 @@ impl CacheEntry {
     pub fn vote(&mut self, vote: &Arc<Vote>, rep_weight: Amount, max_voters: usize) -> bool {
         let updated = self.vote_impl(vote, rep_weight, max_voters);
         if updated {
-            (self.tally, self.final_tally) = self.calculate_tally();
             self.last_vote = Instant::now();
         }
         updated
     }
 
+    /// The tallies are maintained incrementally, so that no vote has to iterate over all voters
     fn vote_impl(&mut self, vote: &Arc<Vote>, rep_weight: Amount, max_voters: usize) -> bool {
         let representative = vote.voting_account;
 
-        if let Some(existing) = self.voters.find(&representative) {
+        if let Some(existing) = self.voters.find(&representative).cloned() {
             // We already have a vote from this rep
-            // Update timestamp if newer but tally remains unchanged as we already counted this rep weight
-            // It is not essential to keep tally up to date if rep voting weight changes, elections do tally calculations independently, so in the worst case scenario only our queue ordering will be a bit off
+            // Replace it if the new one is newer. The old entry is taken out of the tallies and the
+            // new one added with the current rep weight, so the final tally picks up a vote that
+            // became final and both tallies follow weight changes of the rep
             if vote.timestamp() > existing.vote.timestamp() {
                 let was_final = existing.vote.is_final();
                 self.voters
                     .modify(&representative, Arc::clone(vote), rep_weight);
+                self.remove_from_tally(&existing);
+                self.add_to_tally(&VoterEntry::new(
+                    representative,
+                    rep_weight,
+                    Arc::clone(vote),
+                ));
                 return !was_final && vote.is_final(); // Tally changed only if the vote became final
             } else {
                 return false;
@@ -302,15 +328,15 @@ impl CacheEntry {
 
         // Vote from a new representative, add it to the list and update tally
         if should_add {
-            self.voters.insert(VoterEntry::new(
-                representative,
-                rep_weight,
-                Arc::clone(&vote),
-            ));
+            let voter = VoterEntry::new(representative, rep_weight, Arc::clone(&vote));
+            self.add_to_tally(&voter);
+            self.voters.insert(voter);
 
             // If we have reached the maximum number of voters, remove the lowest weight voter
             if self.voters.len() >= max_voters {
-                self.voters.remove_lowest_weight();
+                for removed in self.voters.remove_lowest_weight() {
+                    self.remove_from_tally(&removed);
+                }
             }
             return true;
         }
@@ -482,11 +508,14 @@ impl OrderedVoters {
             .map(|(weight, _reps)| *weight)
     }
 
-    pub fn remove_lowest_weight(&mut self) {
-        if let Some((_, reps)) = self.by_weight.pop_first() {
-            for rep in reps {
-                self.by_representative.remove(&rep);
-            }
+    /// Removes all voters with the lowest weight and returns them
+    pub fn remove_lowest_weight(&mut self) -> Vec<VoterEntry> {
+        match self.by_weight.pop_first() {
+            Some((_, reps)) => reps
+                .iter()
+                .filter_map(|rep| self.by_representative.remove(rep))
+                .collect(),
+            None => Vec::new(),
         }
     }
 
@@ -836,6 +865,52 @@ mod tests {
         assert!(vote.is_final());
     }
 
+    #[test]
+    fn tally_follows_vote_updates() {
+        let mut cache = create_vote_cache();
+        let hash = BlockHash::from(1);
+        let rep = PrivateKey::new();
+        cache.insert(
+            &create_vote(&rep, &hash, 1),
+            Amount::raw(9),
+            &HashMap::new(),
+        );
+        add_test_vote(&mut cache, &hash, Amount::raw(2));
+
+        // The rep's weight changed and the vote became final
+        cache.insert(
+            &create_final_vote(&rep, &hash),
+            Amount::raw(10),
+            &HashMap::new(),
+        );
+
+        assert_eq!(
+            cache.top(0),
+            vec![TopEntry {
+                hash,
+                tally: Amount::raw(12),
+                final_tally: Amount::raw(10)
+            }]
+        );
+    }
+
+    #[test]
+    fn tally_excludes_removed_voters() {
+        let mut cache = VoteCache::new(
+            VoteCacheConfig {
+                max_voters: 2,
+                ..test_config()
+            },
+            Arc::new(Stats::new(Default::default())),
+        );
+        let hash = BlockHash::from(1);
+        add_test_vote(&mut cache, &hash, Amount::raw(5));
+        add_test_vote(&mut cache, &hash, Amount::raw(7));
+
+        assert_eq!(cache.find(&hash).len(), 1);
+        assert_eq!(cache.top(0)[0].tally, Amount::raw(7));
+    }
+
     #[test]
     fn top_empty() {
         let mut cache = create_vote_cache();
@@ -878,6 +953,34 @@ mod tests {
         assert_eq!(top[2].hash, hash1);
     }
 
+    #[test]
+    fn sort_top_by_final_tally_first() {
+        let entry = |hash: u64, tally: u128, final_tally: u128| TopEntry {
+            hash: BlockHash::from(hash),
+            tally: Amount::raw(tally),
+            final_tally: Amount::raw(final_tally),
+        };
+        let mut entries = vec![
+            entry(1, 10, 0),
+            entry(2, 3, 3),
+            entry(3, 5, 3),
+            entry(4, 1, 7),
+        ];
+
+        sort_top(&mut entries);
+
+        let hashes: Vec<_> = entries.iter().map(|e| e.hash).collect();
+        assert_eq!(
+            hashes,
+            vec![
+                BlockHash::from(4),
+                BlockHash::from(3),
+                BlockHash::from(2),
+                BlockHash::from(1)
+            ]
+        );
+    }
+
     #[test]
     fn top_min_tally() {
         let mut cache = create_vote_cache();
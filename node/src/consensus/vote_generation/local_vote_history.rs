@@ -1,25 +1,34 @@
+use crate::utils::FixedHashIndex;
 use rsban_core::{utils::ContainerInfo, BlockHash, Root, Vote};
 use std::{
-    collections::{BTreeMap, HashMap, HashSet},
     mem::size_of,
     sync::{Arc, Mutex},
 };
 
+const NO_SLOT: u32 = u32::MAX;
+
+/// The votes which were generated recently by this node.
+/// The votes live in a fixed size slab and all votes of a root are chained together.
+/// When the slab is full, a slot is reclaimed with the CLOCK algorithm: votes which
+/// were looked up since the last sweep of the clock hand get a second chance.
 pub struct LocalVoteHistory {
     data: Mutex<LocalVoteHistoryData>,
-    max_cache: usize,
 }
 
-#[derive(Default)]
 struct LocalVoteHistoryData {
-    history: BTreeMap<usize, LocalVote>,
-    history_by_root: HashMap<Root, HashSet<usize>>,
+    slots: Vec<Slot>,
+    free: Vec<u32>,
+    by_root: FixedHashIndex<Root>,
+    hand: usize,
+    len: usize,
+    max_cache: usize,
 }
 
-impl LocalVoteHistoryData {
-    fn new() -> Self {
-        Default::default()
-    }
+struct Slot {
+    vote: Option<LocalVote>,
+    /// Next slot of the same root
+    next: u32,
+    referenced: bool,
 }
 
 struct LocalVote {
@@ -30,129 +39,171 @@ struct LocalVote {
 
 impl LocalVoteHistory {
     pub fn new(max_cache: usize) -> Self {
+        debug_assert!(max_cache > 0);
         Self {
-            data: Mutex::new(LocalVoteHistoryData::new()),
-            max_cache,
+            data: Mutex::new(LocalVoteHistoryData::new(max_cache.max(1))),
         }
     }
 
     pub fn add(&self, root: &Root, hash: &BlockHash, vote: &Arc<Vote>) {
-        let mut data_lk = self.data.lock().unwrap();
-        let data: &mut LocalVoteHistoryData = &mut data_lk;
-        clean(data, self.max_cache);
+        let mut data = self.data.lock().unwrap();
 
         let mut add_vote = true;
-        let mut remove_root = false;
-        let mut ids_to_delete = Vec::new();
         // Erase any vote that is not for this hash, or duplicate by account, and if new timestamp is higher
-        if let Some(ids) = data.history_by_root.get_mut(root) {
-            for &i in ids.iter() {
-                let current = &data.history[&i];
-                if &current.hash != hash
-                    || (vote.voting_account == current.vote.voting_account
-                        && current.vote.timestamp() <= vote.timestamp())
-                {
-                    ids_to_delete.push(i);
-                } else if vote.voting_account == current.vote.voting_account
-                    && current.vote.timestamp() > vote.timestamp()
-                {
-                    add_vote = false;
-                }
+        let mut current = data.first(root);
+        while current != NO_SLOT {
+            let slot = &data.slots[current as usize];
+            let next = slot.next;
+            let existing = slot.vote.as_ref().unwrap();
+            if &existing.hash != hash
+                || (vote.voting_account == existing.vote.voting_account
+                    && existing.vote.timestamp() <= vote.timestamp())
+            {
+                data.remove(current);
+            } else if vote.voting_account == existing.vote.voting_account
+                && existing.vote.timestamp() > vote.timestamp()
+            {
+                add_vote = false;
             }
-
-            for &i in &ids_to_delete {
-                ids.remove(&i);
-                data.history.remove(&i);
-                remove_root = ids.is_empty();
-            }
-        }
-
-        if remove_root && !add_vote {
-            data.history_by_root.remove(root);
+            current = next;
         }
 
         // Do not add new vote to cache if representative account is same and timestamp is lower
         if add_vote {
-            let id = data
-                .history
-                .iter()
-                .next_back()
-                .map(|(k, _)| k + 1)
-                .unwrap_or_default();
-            data.history.insert(
-                id,
-                LocalVote {
-                    root: root.to_owned(),
-                    hash: hash.to_owned(),
-                    vote: vote.clone(),
-                },
-            );
-            data.history_by_root
-                .entry(root.to_owned())
-                .or_default()
-                .insert(id);
+            data.insert(LocalVote {
+                root: *root,
+                hash: *hash,
+                vote: vote.clone(),
+            });
         }
     }
 
     pub fn erase(&self, root: &Root) {
-        let mut data_lk = self.data.lock().unwrap();
-        if let Some(removed) = data_lk.history_by_root.remove(root) {
-            for &id in &removed {
-                data_lk.history.remove(&id);
+        let mut data = self.data.lock().unwrap();
+        loop {
+            let first = data.first(root);
+            if first == NO_SLOT {
+                break;
             }
+            data.remove(first);
         }
     }
 
     pub fn votes(&self, root: &Root, hash: &BlockHash, is_final: bool) -> Vec<Arc<Vote>> {
-        let data_lk = self.data.lock().unwrap();
+        let mut data = self.data.lock().unwrap();
         let mut result = Vec::new();
-        if let Some(ids) = data_lk.history_by_root.get(root) {
-            for &id in ids.iter() {
-                let entry = &data_lk.history[&id];
-                if &entry.hash == hash && (!is_final || entry.vote.timestamp() == u64::MAX) {
-                    result.push(entry.vote.clone())
-                }
+        let mut current = data.first(root);
+        while current != NO_SLOT {
+            let slot = &mut data.slots[current as usize];
+            let entry = slot.vote.as_ref().unwrap();
+            if &entry.hash == hash && (!is_final || entry.vote.timestamp() == u64::MAX) {
+                result.push(entry.vote.clone());
+                slot.referenced = true;
             }
+            current = slot.next;
         }
         result
     }
 
     pub fn exists(&self, root: &Root) -> bool {
-        let data_lk = self.data.lock().unwrap();
-        data_lk.history_by_root.contains_key(root)
+        self.data.lock().unwrap().first(root) != NO_SLOT
     }
 
     pub fn size(&self) -> usize {
-        self.data.lock().unwrap().history.len()
+        self.data.lock().unwrap().len
     }
 
     pub fn container_info(&self) -> ContainerInfo {
         [(
             "history",
-            self.data.lock().unwrap().history.len(),
-            size_of::<LocalVote>(),
+            self.size(),
+            size_of::<Slot>() + 2 * FixedHashIndex::<Root>::bucket_size(),
         )]
         .into()
     }
 }
 
-fn clean(data: &mut LocalVoteHistoryData, max_cache: usize) {
-    debug_assert!(max_cache > 0);
-    while data.history.len() > max_cache {
-        let (id, root) = {
-            let (id, vote) = data.history.iter().next().unwrap();
-            (*id, vote.root)
+impl LocalVoteHistoryData {
+    fn new(max_cache: usize) -> Self {
+        Self {
+            slots: Vec::with_capacity(max_cache),
+            free: Vec::new(),
+            by_root: FixedHashIndex::new(max_cache),
+            hand: 0,
+            len: 0,
+            max_cache,
+        }
+    }
+
+    fn first(&self, root: &Root) -> u32 {
+        self.by_root.get(root).unwrap_or(NO_SLOT)
+    }
+
+    fn insert(&mut self, vote: LocalVote) {
+        let index = self.allocate();
+        // Allocation can evict a vote of the same root, so the chain is read afterwards
+        let next = self.first(&vote.root);
+        self.by_root.insert(vote.root, index);
+        self.slots[index as usize] = Slot {
+            vote: Some(vote),
+            next,
+            referenced: false,
         };
-        data.history.remove(&id);
-        let mut root_empty = false;
-        if let Some(root) = data.history_by_root.get_mut(&root) {
-            root.remove(&id);
-            root_empty = root.is_empty();
+        self.len += 1;
+    }
+
+    fn allocate(&mut self) -> u32 {
+        if let Some(index) = self.free.pop() {
+            return index;
+        }
+        if self.slots.len() < self.max_cache {
+            self.slots.push(Slot {
+                vote: None,
+                next: NO_SLOT,
+                referenced: false,
+            });
+            return (self.slots.len() - 1) as u32;
+        }
+        loop {
+            let index = self.hand;
+            self.hand = (self.hand + 1) % self.slots.len();
+            let slot = &mut self.slots[index];
+            if slot.referenced {
+                slot.referenced = false;
+            } else {
+                self.remove(index as u32);
+                return self.free.pop().unwrap();
+            }
         }
+    }
+
+    fn remove(&mut self, index: u32) {
+        let slot = &mut self.slots[index as usize];
+        let Some(removed) = slot.vote.take() else {
+            return;
+        };
+        let next = slot.next;
+        slot.next = NO_SLOT;
+        slot.referenced = false;
 
-        if root_empty {
-            data.history_by_root.remove(&root);
+        // Unlink the slot from the chain of its root
+        let first = self.first(&removed.root);
+        if first == index {
+            if next == NO_SLOT {
+                self.by_root.remove(&removed.root);
+            } else {
+                self.by_root.insert(removed.root, next);
+            }
+        } else {
+            let mut current = first;
+            while self.slots[current as usize].next != index {
+                current = self.slots[current as usize].next;
+            }
+            self.slots[current as usize].next = next;
         }
+
+        self.free.push(index);
+        self.len -= 1;
     }
 }
 
@@ -251,4 +302,41 @@ mod tests {
         assert_eq!(votes.len(), 1);
         assert!(Arc::ptr_eq(&votes[0], &vote3));
     }
+
+    #[test]
+    fn evict_unreferenced_vote_when_full() {
+        let history = LocalVoteHistory::new(2);
+        let vote = Arc::new(Vote::null());
+        let hash = BlockHash::from(10);
+        history.add(&Root::from(1), &hash, &vote);
+        history.add(&Root::from(2), &hash, &vote);
+        assert_eq!(history.votes(&Root::from(1), &hash, false).len(), 1);
+
+        history.add(&Root::from(3), &hash, &vote);
+
+        assert_eq!(history.size(), 2);
+        assert!(history.exists(&Root::from(1)));
+        assert!(!history.exists(&Root::from(2)));
+        assert!(history.exists(&Root::from(3)));
+    }
+
+    #[test]
+    fn erase() {
+        let history = LocalVoteHistory::new(256);
+        let root = Root::from(1);
+        let hash = BlockHash::from(2);
+        history.add(&root, &hash, &Arc::new(Vote::null()));
+        history.add(
+            &root,
+            &hash,
+            &Arc::new(Vote::new(&PrivateKey::new(), 0, 0, Vec::new())),
+        );
+        history.add(&Root::from(2), &hash, &Arc::new(Vote::null()));
+
+        history.erase(&root);
+
+        assert_eq!(history.size(), 1);
+        assert!(!history.exists(&root));
+        assert!(history.exists(&Root::from(2)));
+    }
 }
@@ -1,10 +1,11 @@
 use super::{
-    request_aggregator_impl::{AggregateResult, RequestAggregatorImpl},
+    request_aggregator_impl::{AggregateResult, RequestAggregatorImpl, ResolvedRequests},
     VoteGenerators,
 };
 use crate::{
     stats::{DetailType, Direction, StatType, Stats},
     transport::FairQueue,
+    utils::{BatchLoop, Executor, TaskPriority},
 };
 use rsban_core::{utils::ContainerInfo, BlockHash, Root};
 use rsban_ledger::Ledger;
@@ -12,7 +13,7 @@ use rsban_network::{ChannelId, DeadChannelCleanupStep, NetworkInfo, TrafficType}
 use rsban_store_lmdb::{LmdbReadTransaction, Transaction};
 use std::{
     cmp::{max, min},
-    sync::{Arc, Condvar, Mutex, MutexGuard, RwLock},
+    sync::{Arc, Condvar, Mutex, MutexGuard, OnceLock, RwLock},
     thread::JoinHandle,
 };
 
@@ -50,6 +51,8 @@ pub struct RequestAggregator {
     condition: Arc<Condvar>,
     threads: Mutex<Vec<JoinHandle<()>>>,
     network: Arc<RwLock<NetworkInfo>>,
+    /// Set when the batches run on the executor instead of dedicated threads
+    batch_loop: OnceLock<Arc<BatchLoop>>,
 }
 
 impl RequestAggregator {
@@ -73,22 +76,14 @@ impl RequestAggregator {
             })),
             threads: Mutex::new(Vec::new()),
             network,
+            batch_loop: OnceLock::new(),
         }
     }
 
     pub fn start(&self) {
         let mut guard = self.threads.lock().unwrap();
         for _ in 0..self.config.threads {
-            let aggregator_loop = RequestAggregatorLoop {
-                mutex: self.state.clone(),
-                condition: self.condition.clone(),
-                stats: self.stats.clone(),
-                config: self.config.clone(),
-                ledger: self.ledger.clone(),
-                vote_generators: self.vote_generators.clone(),
-                network: self.network.clone(),
-            };
-
+            let aggregator_loop = self.create_loop();
             guard.push(
                 std::thread::Builder::new()
                     .name("Req aggregator".to_string())
@@ -98,6 +93,35 @@ impl RequestAggregator {
         }
     }
 
+    /// Processes the batches as `Votes` tasks of the executor instead of on
+    /// dedicated threads. As many batches as there were threads run at the same time
+    pub fn start_on(&self, executor: &Arc<Executor>) {
+        let aggregator_loop = self.create_loop();
+        let batch_loop = BatchLoop::new(
+            executor,
+            TaskPriority::Votes,
+            self.config.threads,
+            Box::new(move || aggregator_loop.run_once()),
+        );
+        assert!(
+            self.batch_loop.set(batch_loop.clone()).is_ok(),
+            "request aggregator already started"
+        );
+        batch_loop.notify();
+    }
+
+    fn create_loop(&self) -> RequestAggregatorLoop {
+        RequestAggregatorLoop {
+            mutex: self.state.clone(),
+            condition: self.condition.clone(),
+            stats: self.stats.clone(),
+            config: self.config.clone(),
+            ledger: self.ledger.clone(),
+            vote_generators: self.vote_generators.clone(),
+            network: self.network.clone(),
+        }
+    }
+
     pub fn request(&self, request: RequestType, channel_id: ChannelId) -> bool {
         if request.is_empty() {
             return false;
@@ -116,6 +140,9 @@ impl RequestAggregator {
                 request_len as u64,
             );
             self.condition.notify_one();
+            if let Some(batch_loop) = self.batch_loop.get() {
+                batch_loop.notify();
+            }
         } else {
             self.stats
                 .inc(StatType::RequestAggregator, DetailType::Overfill);
@@ -150,6 +177,9 @@ impl RequestAggregator {
         for thread in threads {
             thread.join().unwrap();
         }
+        if let Some(batch_loop) = self.batch_loop.get() {
+            batch_loop.stop();
+        }
     }
 
     /// Returns the number of currently queued request pools
@@ -207,6 +237,16 @@ impl RequestAggregatorLoop {
         }
     }
 
+    /// Processes the next batch, if there is one. Returns true if more requests are queued
+    fn run_once(&self) -> bool {
+        let state = self.mutex.lock().unwrap();
+        if state.stopped || state.queue.is_empty() {
+            return false;
+        }
+        let state = self.run_batch(state);
+        !state.stopped && !state.queue.is_empty()
+    }
+
     fn run_batch<'a>(
         &'a self,
         mut state: MutexGuard<'a, RequestAggregatorState>,
@@ -215,9 +255,13 @@ impl RequestAggregatorLoop {
         drop(state);
 
         let mut tx = self.ledger.read_txn();
+        let mut resolved = ResolvedRequests::new();
 
         for (channel_id, request) in &batch {
-            tx.refresh_if_needed();
+            if tx.refresh_if_needed() {
+                // Cached lookups must not outlive the snapshot they were read from
+                resolved.clear();
+            }
 
             let queue_full = self
                 .network
@@ -226,7 +270,7 @@ impl RequestAggregatorLoop {
                 .is_queue_full(*channel_id, TrafficType::Generic);
 
             if !queue_full {
-                self.process(&tx, request, *channel_id);
+                self.process(&tx, &mut resolved, request, *channel_id);
             } else {
                 self.stats.inc_dir(
                     StatType::RequestAggregator,
@@ -239,8 +283,14 @@ impl RequestAggregatorLoop {
         self.mutex.lock().unwrap()
     }
 
-    fn process(&self, tx: &LmdbReadTransaction, request: &RequestType, channel_id: ChannelId) {
-        let remaining = self.aggregate(tx, request);
+    fn process(
+        &self,
+        tx: &LmdbReadTransaction,
+        resolved: &mut ResolvedRequests,
+        request: &RequestType,
+        channel_id: ChannelId,
+    ) {
+        let remaining = self.aggregate(tx, resolved, request);
 
         if !remaining.remaining_normal.is_empty() {
             self.stats
@@ -277,8 +327,14 @@ impl RequestAggregatorLoop {
 
     /// Aggregate requests and send cached votes to channel.
     /// Return the remaining hashes that need vote generation for each block for regular & final vote generators
-    fn aggregate(&self, tx: &LmdbReadTransaction, requests: &RequestType) -> AggregateResult {
-        let mut aggregator = RequestAggregatorImpl::new(&self.ledger, &self.stats, tx);
+    /// Requests for (hash, root) pairs that were already resolved in the same batch reuse that result
+    fn aggregate(
+        &self,
+        tx: &LmdbReadTransaction,
+        resolved: &mut ResolvedRequests,
+        requests: &RequestType,
+    ) -> AggregateResult {
+        let mut aggregator = RequestAggregatorImpl::new(&self.ledger, &self.stats, tx, resolved);
         aggregator.add_votes(requests);
         aggregator.get_result()
     }
@@ -1,23 +1,50 @@
 use crate::stats::{DetailType, StatType, Stats};
-use rsban_core::{BlockHash, Root, SavedBlock};
+use rsban_core::{BlockHash, Root, SavedBlock, SavedBlockView};
 use rsban_ledger::Ledger;
 use rsban_store_lmdb::LmdbReadTransaction;
+use std::collections::HashMap;
+
+/// Outcome of the ledger lookup for a single (hash, root) request
+#[derive(Clone)]
+pub(super) struct Resolution {
+    final_blocks: Vec<SavedBlock>,
+    status: RequestStatus,
+}
+
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+enum RequestStatus {
+    Final,
+    NonFinal,
+    Unknown,
+}
+
+/// Requests of a batch which were already resolved. Different peers usually
+/// ask for the same roots during an election, so every distinct (hash, root)
+/// is only looked up once per batch
+pub(super) type ResolvedRequests = HashMap<(BlockHash, Root), Resolution>;
 
 pub(super) struct RequestAggregatorImpl<'a> {
     ledger: &'a Ledger,
     stats: &'a Stats,
     tx: &'a LmdbReadTransaction,
+    resolved: &'a mut ResolvedRequests,
 
     pub to_generate: Vec<SavedBlock>,
     pub to_generate_final: Vec<SavedBlock>,
 }
 
 impl<'a> RequestAggregatorImpl<'a> {
-    pub fn new(ledger: &'a Ledger, stats: &'a Stats, tx: &'a LmdbReadTransaction) -> Self {
+    pub fn new(
+        ledger: &'a Ledger,
+        stats: &'a Stats,
+        tx: &'a LmdbReadTransaction,
+        resolved: &'a mut ResolvedRequests,
+    ) -> Self {
         Self {
             ledger,
             stats,
             tx,
+            resolved,
             to_generate: Vec::new(),
             to_generate_final: Vec::new(),
         }
@@ -25,75 +52,105 @@ impl<'a> RequestAggregatorImpl<'a> {
 
     pub fn add_votes(&mut self, requests: &[(BlockHash, Root)]) {
         for (hash, root) in requests {
-            let mut generate_final_vote = false;
-            let mut block = None;
-
-            // 2. Final votes
-            let final_vote_hashes = self.ledger.store.final_vote.get(self.tx, *root);
-            if !final_vote_hashes.is_empty() {
-                generate_final_vote = true;
-                block = self.ledger.any().get_block(self.tx, &final_vote_hashes[0]);
-                // Allow same root vote
-                if let Some(b) = &block {
-                    if final_vote_hashes.len() > 1 {
-                        // WTF? This shouldn't be done like this
-                        self.to_generate_final.push(b.clone());
-                        block = self.ledger.any().get_block(self.tx, &final_vote_hashes[1]);
-                        debug_assert!(final_vote_hashes.len() == 2);
-                    }
+            let resolution = match self.resolved.get(&(*hash, *root)) {
+                Some(resolution) => {
+                    self.stats
+                        .inc(StatType::Requests, DetailType::RequestsCoalesced);
+                    resolution.clone()
                 }
-            }
+                None => {
+                    let resolution = self.resolve(hash, root);
+                    self.resolved.insert((*hash, *root), resolution.clone());
+                    resolution
+                }
+            };
+
+            self.to_generate_final.extend(resolution.final_blocks);
+            let detail = match resolution.status {
+                RequestStatus::Final => DetailType::RequestsFinal,
+                RequestStatus::NonFinal => DetailType::RequestsNonFinal,
+                RequestStatus::Unknown => DetailType::RequestsUnknown,
+            };
+            self.stats.inc(StatType::Requests, detail);
+        }
+    }
+
+    fn resolve(&self, hash: &BlockHash, root: &Root) -> Resolution {
+        let mut generate_final_vote = false;
+        let mut block = None;
+        let mut final_blocks = Vec::new();
 
-            // 4. Ledger by hash
-            if block.is_none() {
-                block = self.ledger.any().get_block(self.tx, hash);
-                // Confirmation status. Generate final votes for confirmed
-                if let Some(b) = &block {
-                    let conf_height = self
+        // 2. Final votes
+        let final_vote_hashes = self.ledger.store.final_vote.get(self.tx, *root);
+        if !final_vote_hashes.is_empty() {
+            generate_final_vote = true;
+            block = self
+                .ledger
+                .any()
+                .get_block_view(self.tx, &final_vote_hashes[0]);
+            // Allow same root vote
+            if let Some(b) = &block {
+                if final_vote_hashes.len() > 1 {
+                    // WTF? This shouldn't be done like this
+                    final_blocks.push(b.to_saved_block());
+                    block = self
                         .ledger
-                        .store
-                        .confirmation_height
-                        .get(self.tx, &b.account())
-                        .unwrap_or_default();
-                    generate_final_vote = conf_height.height >= b.height();
+                        .any()
+                        .get_block_view(self.tx, &final_vote_hashes[1]);
+                    debug_assert!(final_vote_hashes.len() == 2);
                 }
             }
+        }
 
-            // 5. Ledger by root
-            if block.is_none() && !root.is_zero() {
-                // Search for block root
-                let successor = self.ledger.any().block_successor(self.tx, &(*root).into());
-                if let Some(successor) = successor {
-                    let successor_block = self.ledger.any().get_block(self.tx, &successor).unwrap();
-                    block = Some(successor_block);
-
-                    // Confirmation status. Generate final votes for confirmed successor
-                    if let Some(b) = &block {
-                        let conf_height = self
-                            .ledger
-                            .store
-                            .confirmation_height
-                            .get(self.tx, &b.account())
-                            .unwrap_or_default();
-                        generate_final_vote = conf_height.height >= b.height();
-                    }
-                }
+        // 4. Ledger by hash
+        if block.is_none() {
+            block = self.ledger.any().get_block_view(self.tx, hash);
+            // Confirmation status. Generate final votes for confirmed
+            if let Some(b) = &block {
+                generate_final_vote = self.is_confirmed(b);
             }
+        }
 
-            if let Some(block) = block {
-                if generate_final_vote {
-                    self.to_generate_final.push(block);
-                    self.stats
-                        .inc(StatType::Requests, DetailType::RequestsFinal);
-                } else {
-                    self.stats
-                        .inc(StatType::Requests, DetailType::RequestsNonFinal);
-                }
-            } else {
-                self.stats
-                    .inc(StatType::Requests, DetailType::RequestsUnknown);
+        // 5. Ledger by root
+        if block.is_none() && !root.is_zero() {
+            // Search for block root
+            let successor = self.ledger.any().block_successor(self.tx, &(*root).into());
+            if let Some(successor) = successor {
+                let successor_block = self
+                    .ledger
+                    .any()
+                    .get_block_view(self.tx, &successor)
+                    .unwrap();
+
+                // Confirmation status. Generate final votes for confirmed successor
+                generate_final_vote = self.is_confirmed(&successor_block);
+                block = Some(successor_block);
             }
         }
+
+        let status = match block {
+            Some(block) if generate_final_vote => {
+                final_blocks.push(block.to_saved_block());
+                RequestStatus::Final
+            }
+            Some(_) => RequestStatus::NonFinal,
+            None => RequestStatus::Unknown,
+        };
+
+        Resolution {
+            final_blocks,
+            status,
+        }
+    }
+
+    fn is_confirmed(&self, block: &SavedBlockView) -> bool {
+        let conf_height = self
+            .ledger
+            .store
+            .confirmation_height
+            .get(self.tx, &block.account())
+            .unwrap_or_default();
+        conf_height.height >= block.height()
     }
 
     pub fn get_result(self) -> AggregateResult {
@@ -108,3 +165,70 @@ pub(super) struct AggregateResult {
     pub remaining_normal: Vec<SavedBlock>,
     pub remaining_final: Vec<SavedBlock>,
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stats::Direction;
+    use rsban_core::ConfirmationHeightInfo;
+
+    #[test]
+    fn resolve_identical_requests_once() {
+        let block = SavedBlock::new_test_instance();
+        let ledger = Ledger::new_null_builder()
+            .block(&block)
+            .confirmation_height(
+                &block.account(),
+                &ConfirmationHeightInfo::new(block.height(), block.hash()),
+            )
+            .finish();
+        let stats = Stats::default();
+        let tx = ledger.read_txn();
+        let mut resolved = ResolvedRequests::new();
+        let request = [(block.hash(), block.root())];
+
+        // Two peers asking for the same root
+        for _ in 0..2 {
+            let mut aggregator = RequestAggregatorImpl::new(&ledger, &stats, &tx, &mut resolved);
+            aggregator.add_votes(&request);
+            let result = aggregator.get_result();
+            assert_eq!(result.remaining_final, vec![block.clone()]);
+        }
+
+        assert_eq!(resolved.len(), 1);
+        assert_eq!(
+            stats.count(StatType::Requests, DetailType::RequestsFinal, Direction::In),
+            2
+        );
+        assert_eq!(
+            stats.count(
+                StatType::Requests,
+                DetailType::RequestsCoalesced,
+                Direction::In
+            ),
+            1
+        );
+    }
+
+    #[test]
+    fn unknown_request() {
+        let ledger = Ledger::new_null();
+        let stats = Stats::default();
+        let tx = ledger.read_txn();
+        let mut resolved = ResolvedRequests::new();
+
+        let mut aggregator = RequestAggregatorImpl::new(&ledger, &stats, &tx, &mut resolved);
+        aggregator.add_votes(&[(BlockHash::from(1), Root::from(2))]);
+        let result = aggregator.get_result();
+
+        assert!(result.remaining_final.is_empty());
+        assert_eq!(
+            stats.count(
+                StatType::Requests,
+                DetailType::RequestsUnknown,
+                Direction::In
+            ),
+            1
+        );
+    }
+}
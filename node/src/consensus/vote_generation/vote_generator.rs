@@ -309,6 +309,10 @@ impl SharedState {
     }
 
     fn reply(&self, request: (Vec<(Root, BlockHash)>, ChannelId)) {
+        let channel_id = request.1;
+        // Votes which were recently signed for one peer are sent as they are to
+        // every other peer asking for the same root, instead of signing again
+        let mut cached_votes: Vec<Arc<Vote>> = Vec::new();
         let mut i = request.0.iter().peekable();
         while i.peek().is_some() && !self.stopped.load(Ordering::SeqCst) {
             let mut hashes = Vec::with_capacity(VoteGenerator::MAX_HASHES);
@@ -319,7 +323,11 @@ impl SharedState {
                     let Some((root, hash)) = i.next() else {
                         break;
                     };
-                    if !roots.contains(root) {
+                    // Spacing allows voting for the same hash again, so the cache
+                    // has to be checked first to avoid signing a second vote
+                    if !roots.contains(root)
+                        && !self.add_cached_votes(root, hash, &mut cached_votes)
+                    {
                         if spacing.votable(root, hash) {
                             roots.push(*root);
                             hashes.push(*hash);
@@ -338,15 +346,7 @@ impl SharedState {
                     hashes.len() as u64,
                 );
                 self.vote(&hashes, &roots, |vote| {
-                    let channel_id = &request.1;
-                    let confirm =
-                        Message::ConfirmAck(ConfirmAck::new_with_own_vote((*vote).clone()));
-                    self.message_publisher.lock().unwrap().try_send(
-                        *channel_id,
-                        &confirm,
-                        DropPolicy::CanDrop,
-                        TrafficType::Generic,
-                    );
+                    self.send_vote(channel_id, &vote);
                     self.stats.inc_dir(
                         StatType::Requests,
                         DetailType::RequestsGeneratedVotes,
@@ -355,10 +355,54 @@ impl SharedState {
                 });
             }
         }
+        for vote in &cached_votes {
+            self.send_vote(channel_id, vote);
+        }
+        self.stats.add_dir(
+            StatType::Requests,
+            DetailType::RequestsCachedVotes,
+            Direction::In,
+            cached_votes.len() as u64,
+        );
         self.stats
             .inc(StatType::VoteGenerator, DetailType::GeneratorReplies);
     }
 
+    /// Collects the votes of the local vote history for this hash.
+    /// A vote which covers several requested hashes is only collected once
+    fn add_cached_votes(
+        &self,
+        root: &Root,
+        hash: &BlockHash,
+        cached_votes: &mut Vec<Arc<Vote>>,
+    ) -> bool {
+        let votes = self.history.votes(root, hash, self.is_final);
+        if votes.is_empty() {
+            return false;
+        }
+        self.stats.inc_dir(
+            StatType::Requests,
+            DetailType::RequestsCachedHashes,
+            Direction::In,
+        );
+        for vote in votes {
+            if !cached_votes.iter().any(|v| Arc::ptr_eq(v, &vote)) {
+                cached_votes.push(vote);
+            }
+        }
+        true
+    }
+
+    fn send_vote(&self, channel_id: ChannelId, vote: &Vote) {
+        let confirm = Message::ConfirmAck(ConfirmAck::new_with_own_vote(vote.clone()));
+        self.message_publisher.lock().unwrap().try_send(
+            channel_id,
+            &confirm,
+            DropPolicy::CanDrop,
+            TrafficType::Generic,
+        );
+    }
+
     fn process_batch(&self, batch: VecDeque<(Root, BlockHash)>) {
         let mut verified = VecDeque::new();
 
@@ -371,6 +415,8 @@ impl SharedState {
                     verified.push_back((*root, *hash));
                 }
             }
+            // Final votes must be on disk before they are sent
+            self.ledger.commit(write_guard, &mut tx);
         } else {
             let mut tx = self.ledger.read_txn();
             for (root, hash) in &batch {
@@ -432,3 +478,117 @@ struct Queues {
     candidates: VecDeque<(Root, BlockHash)>,
     requests: VecDeque<(Vec<(Root, BlockHash)>, ChannelId)>,
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{
+        consensus::{RepTiers, VoteProcessorConfig, VoteProcessorQueue},
+        representatives::OnlineReps,
+        NetworkParams,
+    };
+    use rsban_core::{Amount, Networks, PrivateKey};
+    use rsban_ledger::RepWeightCache;
+    use rsban_store_lmdb::LmdbEnv;
+
+    #[tokio::test]
+    async fn reply_with_cached_vote() {
+        let (state, sent) = create_shared_state();
+        let roots = [Root::from(1), Root::from(2)];
+        let hashes = vec![BlockHash::from(3), BlockHash::from(4)];
+        let vote = Arc::new(Vote::new(&PrivateKey::from(42), 1000, 0, hashes.clone()));
+        {
+            let mut spacing = state.spacing.lock().unwrap();
+            for (root, hash) in roots.iter().zip(&hashes) {
+                state.history.add(root, hash, &vote);
+                spacing.flag(root, hash);
+            }
+        }
+        let request: Vec<_> = roots.iter().cloned().zip(hashes.iter().cloned()).collect();
+
+        state.reply((request.clone(), ChannelId::from(1)));
+        state.reply((request.clone(), ChannelId::from(1)));
+        state.reply((request, ChannelId::from(2)));
+
+        let ack = Message::ConfirmAck(ConfirmAck::new_with_own_vote((*vote).clone()));
+        assert_eq!(
+            *sent.lock().unwrap(),
+            vec![
+                (ChannelId::from(1), ack.clone()),
+                (ChannelId::from(1), ack.clone()),
+                (ChannelId::from(2), ack),
+            ]
+        );
+        let cached = state.history.votes(&roots[0], &hashes[0], false);
+        assert_eq!(cached.len(), 1);
+        assert!(Arc::ptr_eq(&cached[0], &vote));
+        assert_eq!(
+            state.stats.count(
+                StatType::Requests,
+                DetailType::RequestsGeneratedHashes,
+                Direction::In
+            ),
+            0
+        );
+        assert_eq!(
+            state.stats.count(
+                StatType::Requests,
+                DetailType::RequestsCachedVotes,
+                Direction::In
+            ),
+            3
+        );
+    }
+
+    fn create_shared_state() -> (SharedState, Arc<Mutex<Vec<(ChannelId, Message)>>>) {
+        let handle = tokio::runtime::Handle::current();
+        let stats = Arc::new(Stats::default());
+        let sent = Arc::new(Mutex::new(Vec::new()));
+        let sent_clone = sent.clone();
+        let mut message_publisher = MessagePublisher::new_null(handle.clone());
+        message_publisher.set_published_callback(Arc::new(move |channel_id, message| {
+            sent_clone
+                .lock()
+                .unwrap()
+                .push((channel_id, message.clone()));
+        }));
+        let online_reps = Arc::new(Mutex::new(OnlineReps::new(
+            Arc::new(RepWeightCache::new()),
+            Duration::default(),
+            Amount::zero(),
+        )));
+        let rep_tiers = Arc::new(RepTiers::new(
+            Arc::new(RepWeightCache::new()),
+            NetworkParams::new(Networks::BananoDevNetwork),
+            online_reps,
+            stats.clone(),
+        ));
+        let vote_broadcaster = Arc::new(VoteBroadcaster::new(
+            Arc::new(VoteProcessorQueue::new(
+                VoteProcessorConfig::new(1),
+                stats.clone(),
+                rep_tiers,
+            )),
+            MessagePublisher::new_null(handle.clone()),
+        ));
+        let state = SharedState {
+            ledger: Arc::new(Ledger::new_null()),
+            wallets: Arc::new(Wallets::new_null_with_env(
+                Arc::new(LmdbEnv::new_null()),
+                handle,
+            )),
+            history: Arc::new(LocalVoteHistory::new(256)),
+            message_publisher: Mutex::new(message_publisher),
+            is_final: false,
+            condition: Condvar::new(),
+            stopped: AtomicBool::new(false),
+            queues: Mutex::new(Queues::default()),
+            stats,
+            vote_broadcaster,
+            spacing: Mutex::new(VoteSpacing::new(Duration::from_secs(60))),
+            vote_generator_delay: Duration::from_millis(100),
+            vote_generator_threshold: 3,
+        };
+        (state, sent)
+    }
+}
@@ -1,15 +1,19 @@
-use super::{VoteProcessorQueue, VoteRouter};
-use crate::stats::{DetailType, StatType, Stats};
-use rsban_core::{Vote, VoteCode, VoteSource};
+use super::{RepTier, VoteProcessorQueue, VoteRouter};
+use crate::{
+    stats::{DetailType, StatType, Stats},
+    utils::{AdaptiveBatchConfig, AdaptiveBatchSize, BatchLoop, Executor, TaskPriority},
+};
+use rsban_core::{SignatureBatch, Vote, VoteCode, VoteSource};
 use rsban_network::ChannelId;
 use std::{
     cmp::{max, min},
+    collections::VecDeque,
     sync::{
         atomic::{AtomicU64, Ordering},
         Arc, Mutex,
     },
     thread::JoinHandle,
-    time::Instant,
+    time::{Duration, Instant},
 };
 use tracing::{debug, trace};
 
@@ -19,7 +23,10 @@ pub struct VoteProcessorConfig {
     pub max_non_pr_queue: usize,
     pub pr_priority: usize,
     pub threads: usize,
+    /// Maximum number of votes per batch
     pub batch_size: usize,
+    /// The batch size adapts so that processing a batch takes about this long
+    pub batch_time: Duration,
     pub max_triggered: usize,
 }
 
@@ -31,6 +38,7 @@ impl VoteProcessorConfig {
             pr_priority: 3,
             threads: max(1, min(4, parallelism / 2)),
             batch_size: 1024,
+            batch_time: Duration::from_millis(100),
             max_triggered: 16384,
         }
     }
@@ -45,6 +53,7 @@ pub struct VoteProcessor {
     vote_router: Arc<VoteRouter>,
     stats: Arc<Stats>,
     vote_processed: Mutex<Vec<VoteProcessedCallback2>>,
+    batch_size: AdaptiveBatchSize,
     pub total_processed: AtomicU64,
 }
 
@@ -55,10 +64,21 @@ impl VoteProcessor {
         stats: Arc<Stats>,
         on_vote: VoteProcessedCallback2,
     ) -> Self {
+        // Smaller batches can't be batch verified
+        let batch_size = AdaptiveBatchSize::new(
+            AdaptiveBatchConfig::new(
+                SignatureBatch::MIN_BATCH_SIZE,
+                queue.config.batch_size,
+                queue.config.batch_time,
+            ),
+            stats.clone(),
+            DetailType::VoteProcessor,
+        );
         Self {
             queue,
             vote_router,
             stats,
+            batch_size,
             vote_processed: Mutex::new(vec![on_vote]),
             threads: Mutex::new(Vec::new()),
             total_processed: AtomicU64::new(0),
@@ -76,35 +96,64 @@ impl VoteProcessor {
         for handle in handles {
             handle.join().unwrap()
         }
+        if let Some(batch_loop) = self.queue.batch_loop() {
+            batch_loop.stop();
+        }
     }
 
     pub fn run(&self) {
         loop {
             self.stats.inc(StatType::VoteProcessor, DetailType::Loop);
 
-            let batch = self.queue.wait_for_votes(self.queue.config.batch_size);
+            let batch = self.queue.wait_for_votes(self.batch_size.current());
             if batch.is_empty() {
                 break; //stopped
             }
+            self.process_batch(batch);
+        }
+    }
 
-            let start = Instant::now();
+    /// Processes the next batch without waiting for votes. Returns true if more votes are queued
+    fn run_batch(&self) -> bool {
+        self.stats.inc(StatType::VoteProcessor, DetailType::Loop);
+        let batch = self.queue.next_votes(self.batch_size.current());
+        if batch.is_empty() {
+            return false;
+        }
+        self.process_batch(batch);
+        !self.queue.is_empty()
+    }
 
-            for ((_, channel_id), (vote, source)) in &batch {
-                self.vote_blocking(vote, *channel_id, *source);
-            }
+    fn process_batch(&self, batch: VecDeque<((RepTier, ChannelId), (Arc<Vote>, VoteSource))>) {
+        let start = Instant::now();
 
-            self.total_processed
-                .fetch_add(batch.len() as u64, Ordering::SeqCst);
-
-            let elapsed_millis = start.elapsed().as_millis();
-            if batch.len() == self.queue.config.batch_size && elapsed_millis > 100 {
-                debug!(
-                    "Processed {} votes in {} milliseconds (rate of {} votes per second)",
-                    batch.len(),
-                    elapsed_millis,
-                    (batch.len() * 1000) / elapsed_millis as usize
-                );
-            }
+        if batch.len() < SignatureBatch::MIN_BATCH_SIZE {
+            // Not enough votes were queued, so the signatures are verified one by one
+            self.stats.add(
+                StatType::VoteProcessor,
+                DetailType::SignaturesUnbatched,
+                batch.len() as u64,
+            );
+        }
+        let signatures_valid = Vote::validate_batch(batch.iter().map(|(_, (vote, _))| &**vote));
+        for (((_, channel_id), (vote, source)), valid) in batch.iter().zip(signatures_valid) {
+            self.process_validated(vote, *channel_id, *source, valid);
+        }
+
+        self.total_processed
+            .fetch_add(batch.len() as u64, Ordering::SeqCst);
+
+        let elapsed = start.elapsed();
+        self.batch_size.update(batch.len(), elapsed, None);
+
+        let elapsed_millis = elapsed.as_millis();
+        if batch.len() == self.queue.config.batch_size && elapsed_millis > 100 {
+            debug!(
+                "Processed {} votes in {} milliseconds (rate of {} votes per second)",
+                batch.len(),
+                elapsed_millis,
+                (batch.len() * 1000) / elapsed_millis as usize
+            );
         }
     }
 
@@ -113,9 +162,19 @@ impl VoteProcessor {
         vote: &Arc<Vote>,
         channel_id: ChannelId,
         source: VoteSource,
+    ) -> VoteCode {
+        self.process_validated(vote, channel_id, source, vote.validate().is_ok())
+    }
+
+    fn process_validated(
+        &self,
+        vote: &Arc<Vote>,
+        channel_id: ChannelId,
+        source: VoteSource,
+        signature_valid: bool,
     ) -> VoteCode {
         let mut result = VoteCode::Invalid;
-        if vote.validate().is_ok() {
+        if signature_valid {
             let vote_results = self.vote_router.vote(vote, source);
 
             // Aggregate results for individual hashes
@@ -162,6 +221,9 @@ impl Drop for VoteProcessor {
 
 pub trait VoteProcessorExt {
     fn start(&self);
+    /// Processes the batches as `Votes` tasks of the executor instead of on
+    /// dedicated threads. As many batches as there were threads run at the same time
+    fn start_on(&self, executor: &Arc<Executor>);
 }
 
 impl VoteProcessorExt for Arc<VoteProcessor> {
@@ -180,4 +242,20 @@ impl VoteProcessorExt for Arc<VoteProcessor> {
             )
         }
     }
+
+    fn start_on(&self, executor: &Arc<Executor>) {
+        let processor = Arc::downgrade(self);
+        let batch_loop = BatchLoop::new(
+            executor,
+            TaskPriority::Votes,
+            self.queue.config.threads,
+            Box::new(move || {
+                processor
+                    .upgrade()
+                    .is_some_and(|processor| processor.run_batch())
+            }),
+        );
+        self.queue.set_batch_loop(batch_loop.clone());
+        batch_loop.notify();
+    }
 }
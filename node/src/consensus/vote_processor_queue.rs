@@ -2,13 +2,14 @@ use super::{RepTier, RepTiers, VoteProcessorConfig};
 use crate::{
     stats::{DetailType, StatType, Stats},
     transport::{FairQueue, FairQueueInfo},
+    utils::BatchLoop,
 };
 use rsban_core::{utils::ContainerInfo, Vote, VoteSource};
 use rsban_network::{ChannelId, DeadChannelCleanupStep};
 use std::{
     collections::VecDeque,
     mem::size_of,
-    sync::{Arc, Condvar, Mutex},
+    sync::{Arc, Condvar, Mutex, OnceLock},
 };
 use strum::IntoEnumIterator;
 
@@ -18,6 +19,8 @@ pub struct VoteProcessorQueue {
     pub config: VoteProcessorConfig,
     stats: Arc<Stats>,
     rep_tiers: Arc<RepTiers>,
+    /// Set when the votes are processed on the executor instead of the processing threads
+    batch_loop: OnceLock<Arc<BatchLoop>>,
 }
 
 impl VoteProcessorQueue {
@@ -43,6 +46,7 @@ impl VoteProcessorQueue {
             config,
             stats,
             rep_tiers,
+            batch_loop: OnceLock::new(),
         }
     }
 
@@ -67,6 +71,9 @@ impl VoteProcessorQueue {
             self.stats.inc(StatType::VoteProcessor, DetailType::Process);
             self.stats.inc(StatType::VoteProcessorTier, tier.into());
             self.condition.notify_one();
+            if let Some(batch_loop) = self.batch_loop.get() {
+                batch_loop.notify();
+            }
         } else {
             self.stats
                 .inc(StatType::VoteProcessor, DetailType::Overfill);
@@ -94,6 +101,30 @@ impl VoteProcessorQueue {
         }
     }
 
+    /// Returns the next batch without waiting. The batch is empty if there are no votes
+    pub(crate) fn next_votes(
+        &self,
+        max_batch_size: usize,
+    ) -> VecDeque<((RepTier, ChannelId), (Arc<Vote>, VoteSource))> {
+        let mut guard = self.data.lock().unwrap();
+        if guard.stopped {
+            return VecDeque::new();
+        }
+        guard.queue.next_batch(max_batch_size)
+    }
+
+    /// Every queued vote notifies the batch loop
+    pub(crate) fn set_batch_loop(&self, batch_loop: Arc<BatchLoop>) {
+        assert!(
+            self.batch_loop.set(batch_loop).is_ok(),
+            "vote processor already started"
+        );
+    }
+
+    pub(crate) fn batch_loop(&self) -> Option<&Arc<BatchLoop>> {
+        self.batch_loop.get()
+    }
+
     pub fn clear(&self) {
         {
             let mut guard = self.data.lock().unwrap();
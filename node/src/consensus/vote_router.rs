@@ -1,4 +1,4 @@
-use super::{Election, RecentlyConfirmedCache, VoteApplier, VoteCache};
+use super::{Election, RecentlyConfirmedCache, ShardedVoteCache, VoteApplier};
 use crate::consensus::VoteApplierExt;
 use rsban_core::{utils::ContainerInfo, BlockHash, Vote, VoteCode, VoteSource};
 use rsban_ledger::RepWeightCache;
@@ -19,13 +19,13 @@ pub struct VoteRouter {
     vote_processed_observers: Mutex<Vec<VoteProcessedCallback>>,
     recently_confirmed: Arc<RecentlyConfirmedCache>,
     vote_applier: Arc<VoteApplier>,
-    vote_cache: Arc<Mutex<VoteCache>>,
+    vote_cache: Arc<ShardedVoteCache>,
     rep_weights: Arc<RepWeightCache>,
 }
 
 impl VoteRouter {
     pub fn new(
-        vote_cache: Arc<Mutex<VoteCache>>,
+        vote_cache: Arc<ShardedVoteCache>,
         recently_confirmed: Arc<RecentlyConfirmedCache>,
         vote_applier: Arc<VoteApplier>,
         rep_weights: Arc<RepWeightCache>,
@@ -168,10 +168,7 @@ impl VoteRouter {
         // Cache the votes that didn't match any election
         if source != VoteSource::Cache {
             let rep_weight = self.rep_weights.weight(&vote.voting_account);
-            self.vote_cache
-                .lock()
-                .unwrap()
-                .insert(vote, rep_weight, &results);
+            self.vote_cache.insert(vote, rep_weight, &results);
         }
 
         self.on_vote_processed(vote, source, &results);
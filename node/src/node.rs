@@ -1,21 +1,21 @@
 use crate::{
     block_processing::{
         BacklogPopulation, BlockProcessor, BlockProcessorCleanup, BlockSource,
-        LocalBlockBroadcaster, LocalBlockBroadcasterExt, UncheckedMap,
+        LocalBlockBroadcaster, LocalBlockBroadcasterExt, UncheckedMap, UncheckedOverflow,
     },
     bootstrap::{
         BootstrapAscending, BootstrapAscendingExt, BootstrapInitiator, BootstrapInitiatorExt,
         BootstrapServer, BootstrapServerCleanup, OngoingBootstrap, OngoingBootstrapExt,
     },
-    cementation::ConfirmingSet,
+    cementation::{ConfirmingSet, ConfirmingSetConfig},
     config::{GlobalConfig, NodeConfig, NodeFlags},
     consensus::{
         election_schedulers::ElectionSchedulers, get_bootstrap_weights, log_bootstrap_weights,
         ActiveElections, ActiveElectionsExt, ElectionStatusType, LocalVoteHistory,
         ProcessLiveDispatcher, ProcessLiveDispatcherExt, RecentlyConfirmedCache, RepTiers,
-        RequestAggregator, RequestAggregatorCleanup, VoteApplier, VoteBroadcaster, VoteCache,
-        VoteCacheProcessor, VoteGenerators, VoteProcessor, VoteProcessorExt, VoteProcessorQueue,
-        VoteProcessorQueueCleanup, VoteRouter,
+        RequestAggregator, RequestAggregatorCleanup, ShardedVoteCache, VoteApplier,
+        VoteBroadcaster, VoteCacheProcessor, VoteGenerators, VoteProcessor, VoteProcessorExt,
+        VoteProcessorQueue, VoteProcessorQueueCleanup, VoteRouter,
     },
     monitor::Monitor,
     node_id_key_file::NodeIdKeyFile,
@@ -32,7 +32,8 @@ use crate::{
         RealtimeMessageHandler, SynCookies,
     },
     utils::{
-        LongRunningTransactionLogger, ThreadPool, ThreadPoolImpl, TimerThread, TxnTrackingConfig,
+        Executor, ExecutorConfig, ExecutorLane, LongRunningTransactionLogger, TaskPriority,
+        ThreadPool, ThreadPoolImpl, TimerThread, TxnTrackingConfig,
     },
     wallets::{Wallets, WalletsExt},
     work::DistributedWorkFactory,
@@ -45,7 +46,7 @@ use rsban_core::{
     Account, Amount, Block, BlockHash, BlockType, Networks, NodeId, PrivateKey, Root, SavedBlock,
     VoteCode, VoteSource,
 };
-use rsban_ledger::{BlockStatus, Ledger, RepWeightCache};
+use rsban_ledger::{BlockStatus, Ledger, RepWeightCache, RepWeightTable};
 use rsban_messages::{ConfirmAck, Message, Publish};
 use rsban_network::{
     ChannelId, DeadChannelCleanup, DropPolicy, Network, NetworkCleanup, NetworkInfo, PeerConnector,
@@ -55,12 +56,12 @@ use rsban_nullable_clock::{SteadyClock, SystemTimeFactory};
 use rsban_nullable_http_client::{HttpClient, Url};
 use rsban_output_tracker::OutputListenerMt;
 use rsban_store_lmdb::{
-    EnvOptions, LmdbConfig, LmdbEnv, LmdbStore, NullTransactionTracker, SyncStrategy,
-    TransactionTracker,
+    EnvOptions, LmdbConfig, LmdbEnv, LmdbStore, LmdbUncheckedStore, NullTransactionTracker,
+    SyncStrategy, TransactionTracker,
 };
 use serde::Serialize;
 use std::{
-    collections::{HashMap, VecDeque},
+    collections::VecDeque,
     path::{Path, PathBuf},
     sync::{
         atomic::{AtomicBool, Ordering},
@@ -79,6 +80,8 @@ pub struct Node {
     pub config: NodeConfig,
     pub network_params: NetworkParams,
     pub stats: Arc<Stats>,
+    /// Runs the tasks of the worker pools below
+    pub executor: Arc<Executor>,
     pub workers: Arc<dyn ThreadPool>,
     pub bootstrap_workers: Arc<dyn ThreadPool>,
     wallet_workers: Arc<dyn ThreadPool>,
@@ -100,7 +103,7 @@ pub struct Node {
     pub vote_processor_queue: Arc<VoteProcessorQueue>,
     pub history: Arc<LocalVoteHistory>,
     pub confirming_set: Arc<ConfirmingSet>,
-    pub vote_cache: Arc<Mutex<VoteCache>>,
+    pub vote_cache: Arc<ShardedVoteCache>,
     pub block_processor: Arc<BlockProcessor>,
     pub wallets: Arc<Wallets>,
     pub vote_generators: Arc<VoteGenerators>,
@@ -235,7 +238,7 @@ impl Node {
         {
             get_bootstrap_weights(network_params.network.current_network)
         } else {
-            (0, HashMap::new())
+            (0, RepWeightTable::new())
         };
 
         let rep_weights = Arc::new(RepWeightCache::with_bootstrap_weights(
@@ -252,25 +255,51 @@ impl Node {
         )
         .expect("Could not initialize ledger");
         ledger.set_observer(Arc::new(LedgerStats::new(stats.clone())));
+        if config.lmdb_config.sync == SyncStrategy::GroupCommit {
+            ledger.enable_group_commit();
+        }
         let ledger = Arc::new(ledger);
 
         log_bootstrap_weights(&ledger.rep_weights);
 
         let syn_cookies = Arc::new(SynCookies::new(network_params.network.max_peers_per_ip));
 
-        let workers: Arc<dyn ThreadPool> = Arc::new(ThreadPoolImpl::create(
-            config.background_threads as usize,
-            "Worker".to_string(),
+        // The worker pools, the batch loops of the block processor, vote processor and
+        // request aggregator and the confirming set's resolvers share one thread per core. Each priority is limited to the number of threads
+        // its components had before, and the executor gets additional threads on small
+        // machines, so that these limits still fit.
+        let executor = Arc::new(Executor::new(
+            ExecutorConfig::new()
+                .max_running(TaskPriority::LedgerWrite, 1)
+                .max_running(
+                    TaskPriority::Cementing,
+                    config.confirming_set.resolver_threads.max(1),
+                )
+                .max_running(
+                    TaskPriority::Votes,
+                    1 + config.vote_processor.threads + config.request_aggregator.threads,
+                )
+                .max_running(
+                    TaskPriority::Bootstrap,
+                    config.bootstrap_serving_threads as usize,
+                )
+                .max_running(
+                    TaskPriority::Housekeeping,
+                    config.background_threads as usize,
+                ),
+        ));
+        let workers: Arc<dyn ThreadPool> = Arc::new(ExecutorLane::new(
+            executor.clone(),
+            TaskPriority::Housekeeping,
         ));
+        // Wallet tasks wait for work generation, so they keep their own thread
         let wallet_workers: Arc<dyn ThreadPool> =
             Arc::new(ThreadPoolImpl::create(1, "Wallet work"));
         let election_workers: Arc<dyn ThreadPool> =
-            Arc::new(ThreadPoolImpl::create(1, "Election work"));
+            Arc::new(ExecutorLane::new(executor.clone(), TaskPriority::Votes));
 
-        let bootstrap_workers: Arc<dyn ThreadPool> = Arc::new(ThreadPoolImpl::create(
-            config.bootstrap_serving_threads as usize,
-            "Bootstrap work",
-        ));
+        let bootstrap_workers: Arc<dyn ThreadPool> =
+            Arc::new(ExecutorLane::new(executor.clone(), TaskPriority::Bootstrap));
 
         let network_info = Arc::new(RwLock::new(NetworkInfo::new(global_config.into())));
 
@@ -318,10 +347,32 @@ impl Node {
             enable_ongoing_broadcasts: !flags.disable_providing_telemetry_metrics,
         };
 
-        let unchecked = Arc::new(UncheckedMap::new(
+        let unchecked_overflow = if config.max_unchecked_overflow_blocks > 0 && !is_nulled {
+            let mut unchecked_path = application_path.clone();
+            unchecked_path.push("unchecked.ldb");
+            // The overflow is emptied on every start, so it doesn't need to survive a crash
+            let mut unchecked_lmdb_config = config.lmdb_config.clone();
+            unchecked_lmdb_config.sync = SyncStrategy::NosyncUnsafe;
+            unchecked_lmdb_config.map_size = config.unchecked_overflow_map_size;
+            let unchecked_options = EnvOptions {
+                config: unchecked_lmdb_config,
+                use_no_mem_init: true,
+            };
+            let unchecked_env =
+                Arc::new(LmdbEnv::new_with_options(unchecked_path, &unchecked_options).unwrap());
+            Some(Arc::new(UncheckedOverflow::new(
+                LmdbUncheckedStore::new(unchecked_env).unwrap(),
+                config.max_unchecked_overflow_blocks as usize,
+            )))
+        } else {
+            None
+        };
+
+        let unchecked = Arc::new(UncheckedMap::with_overflow(
             config.max_unchecked_blocks as usize,
             stats.clone(),
             flags.disable_block_processor_unchecked_deletion,
+            unchecked_overflow,
         ));
 
         let online_weight_sampler = Arc::new(OnlineWeightSampler::new(
@@ -390,15 +441,18 @@ impl Node {
         let history = Arc::new(LocalVoteHistory::new(network_params.voting.max_cache));
 
         let confirming_set = Arc::new(ConfirmingSet::new(
-            config.confirming_set.clone(),
+            ConfirmingSetConfig {
+                batch_time: config.confirming_set_batch_time,
+                ..config.confirming_set.clone()
+            },
             ledger.clone(),
             stats.clone(),
         ));
 
-        let vote_cache = Arc::new(Mutex::new(VoteCache::new(
+        let vote_cache = Arc::new(ShardedVoteCache::new(
             config.vote_cache.clone(),
             stats.clone(),
-        )));
+        ));
 
         let recently_confirmed = Arc::new(RecentlyConfirmedCache::new(
             config.active_elections.confirmation_cache,
@@ -1056,6 +1110,7 @@ impl Node {
             ongoing_bootstrap,
             peer_connector,
             node_id,
+            executor,
             workers,
             bootstrap_workers,
             wallet_workers,
@@ -1114,7 +1169,7 @@ impl Node {
     pub fn container_info(&self) -> ContainerInfo {
         let tcp_channels = self.network_info.read().unwrap().container_info();
         let online_reps = self.online_reps.lock().unwrap().container_info();
-        let vote_cache = self.vote_cache.lock().unwrap().container_info();
+        let vote_cache = self.vote_cache.container_info();
 
         let network = ContainerInfo::builder()
             .node("tcp_channels", tcp_channels)
@@ -1123,6 +1178,7 @@ impl Node {
 
         ContainerInfo::builder()
             .node("work", self.work.container_info())
+            .node("executor", self.executor.container_info())
             .node("ledger", self.ledger.container_info())
             .node("active", self.active.container_info())
             .node(
@@ -1360,6 +1416,14 @@ impl NodeExt for Arc<Node> {
             panic!("Genesis block not found!");
         }
 
+        // The counters were loaded from the meta table, check them without delaying the startup
+        let ledger = self.ledger.clone();
+        self.workers.push_task(Box::new(move || {
+            if !ledger.validate_counts() {
+                warn!("Persisted ledger counts were inconsistent and have been corrected");
+            }
+        }));
+
         self.long_inactivity_cleanup();
         self.network_threads.lock().unwrap().start();
         self.message_processor.lock().unwrap().start();
@@ -1410,14 +1474,14 @@ impl NodeExt for Arc<Node> {
         self.wallets.start();
         self.rep_tiers.start();
         if self.config.enable_vote_processor {
-            self.vote_processor.start();
+            self.vote_processor.start_on(&self.executor);
         }
         self.vote_cache_processor.start();
-        self.block_processor.start();
+        self.block_processor.start_on(&self.executor);
         self.active.start();
         self.vote_generators.start();
-        self.request_aggregator.start();
-        self.confirming_set.start();
+        self.request_aggregator.start_on(&self.executor);
+        self.confirming_set.start_on(&self.executor);
         self.election_schedulers
             .start(self.config.priority_scheduler_enabled);
         self.backlog_population.start();
@@ -1494,6 +1558,7 @@ impl NodeExt for Arc<Node> {
         self.wallets.stop();
         self.stats.stop();
         self.workers.stop();
+        self.executor.stop();
         self.local_block_broadcaster.stop();
         self.message_processor.lock().unwrap().stop();
         self.network_threads.lock().unwrap().stop(); // Stop network last to avoid killing in-use sockets
@@ -176,10 +176,11 @@ impl NodeBuilder {
 
         let flags = self.flags.unwrap_or_default();
         let work = self.work.unwrap_or_else(|| {
-            Arc::new(WorkPoolImpl::new(
+            Arc::new(WorkPoolImpl::with_simd(
                 network_params.work.clone(),
                 config.work_threads as usize,
                 Duration::from_nanos(config.pow_sleep_interval_ns as u64),
+                config.work_simd,
             ))
         });
 
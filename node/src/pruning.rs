@@ -81,7 +81,7 @@ impl LedgerPruning {
             // Pruning write operation
             transaction_write_count = 0;
             if !pruning_targets.is_empty() && !self.stopped.load(Ordering::SeqCst) {
-                let _scoped_write_guard = self.ledger.write_queue.wait(Writer::Pruning);
+                let write_guard = self.ledger.write_queue.wait(Writer::Pruning);
                 let mut tx = self.ledger.rw_txn();
                 while !pruning_targets.is_empty()
                     && transaction_write_count < batch_size_a
@@ -94,6 +94,8 @@ impl LedgerPruning {
                     transaction_write_count += account_pruned_count;
                     pruning_targets.pop_front();
                 }
+                // Release the write queue before waiting for the group commit
+                self.ledger.commit(write_guard, &mut tx);
                 pruned_count += transaction_write_count;
 
                 debug!("Pruned blocks: {}", pruned_count);
@@ -0,0 +1,423 @@
+use super::{DetailType, LatencyHistogram, LatencySummary};
+use crate::block_processing::BlockSource;
+use rsban_core::BlockHash;
+use std::{
+    collections::{HashMap, VecDeque},
+    sync::{
+        atomic::{AtomicUsize, Ordering},
+        Mutex, RwLock,
+    },
+    time::{Duration, Instant},
+};
+use strum::IntoEnumIterator;
+use strum_macros::EnumIter;
+
+/// The points in the life of a block at which its latency is measured.
+/// Every latency is the time since the block arrived at the block processor.
+#[derive(Copy, Clone, PartialEq, Eq, Debug, EnumIter)]
+pub enum LatencyStage {
+    /// Taken out of the block processor queue
+    Queued,
+    /// Inserted into the ledger
+    Processed,
+    ElectionStarted,
+    /// Quorum reached
+    Confirmed,
+    Cemented,
+}
+
+impl LatencyStage {
+    pub const COUNT: usize = LatencyStage::Cemented as usize + 1;
+
+    pub fn as_str(&self) -> &'static str {
+        match self {
+            LatencyStage::Queued => "queued",
+            LatencyStage::Processed => "processed",
+            LatencyStage::ElectionStarted => "election_started",
+            LatencyStage::Confirmed => "confirmed",
+            LatencyStage::Cemented => "cemented",
+        }
+    }
+}
+
+/// The latencies of a single block from arrival until cementation
+#[derive(Clone, Debug, PartialEq)]
+pub struct BlockTrace {
+    pub hash: BlockHash,
+    pub source: BlockSource,
+    pub stages: [Option<Duration>; LatencyStage::COUNT],
+}
+
+impl BlockTrace {
+    pub fn latency(&self, stage: LatencyStage) -> Option<Duration> {
+        self.stages[stage as usize]
+    }
+}
+
+pub type BlockTracedCallback = Box<dyn Fn(&BlockTrace) + Send + Sync>;
+
+/// Follows blocks from the block processor to the confirming set and records
+/// the latency of each stage in a histogram per stage and block source.
+/// The number of followed blocks is bounded. When the tracker is full, the block
+/// which was followed the longest is dropped, so blocks which never get cemented
+/// can't grow the tracker without limit or keep new blocks out.
+/// Bootstrapped and unchecked blocks arrive in bulk, only a sample of them is followed.
+pub struct BlockLatencyTracker {
+    histograms: Vec<LatencyHistogram>,
+    sources: usize,
+    shards: Vec<Mutex<TrackedBlocks>>,
+    max_per_shard: usize,
+    sample_counter: AtomicUsize,
+    traced_observers: RwLock<Vec<BlockTracedCallback>>,
+}
+
+impl BlockLatencyTracker {
+    pub const DEFAULT_MAX_TRACKED: usize = 64 * 1024;
+    /// Untracked after this time, even if the block never gets cemented
+    const MAX_AGE: Duration = Duration::from_secs(600);
+    const SHARDS: usize = 16;
+    /// Only every nth bootstrapped or unchecked block is followed
+    const BULK_SAMPLE_INTERVAL: usize = 16;
+
+    pub fn new(max_tracked: usize) -> Self {
+        let sources = BlockSource::iter().count();
+        let shards = Self::SHARDS.min(max_tracked).max(1);
+        Self {
+            histograms: (0..LatencyStage::COUNT * sources)
+                .map(|_| LatencyHistogram::new())
+                .collect(),
+            sources,
+            shards: (0..shards)
+                .map(|_| Mutex::new(TrackedBlocks::default()))
+                .collect(),
+            max_per_shard: max_tracked.div_ceil(shards),
+            sample_counter: AtomicUsize::new(0),
+            traced_observers: RwLock::new(Vec::new()),
+        }
+    }
+
+    fn shard(&self, hash: &BlockHash) -> &Mutex<TrackedBlocks> {
+        &self.shards[hash.as_bytes()[31] as usize % self.shards.len()]
+    }
+
+    fn should_follow(&self, source: BlockSource) -> bool {
+        match source {
+            BlockSource::Bootstrap | BlockSource::BootstrapLegacy | BlockSource::Unchecked => {
+                self.sample_counter.fetch_add(1, Ordering::Relaxed) % Self::BULK_SAMPLE_INTERVAL
+                    == 0
+            }
+            _ => true,
+        }
+    }
+
+    /// Called for every followed block once it is cemented.
+    /// Traces are only built while there is at least one observer.
+    pub fn on_block_traced(&self, observer: BlockTracedCallback) {
+        self.traced_observers.write().unwrap().push(observer);
+    }
+
+    pub fn record(&self, stage: LatencyStage, source: BlockSource, latency: Duration) {
+        self.histogram(stage, source).record(latency);
+    }
+
+    pub fn histogram(&self, stage: LatencyStage, source: BlockSource) -> &LatencyHistogram {
+        &self.histograms[stage as usize * self.sources + source as usize]
+    }
+
+    /// Records the queue and processing latencies of newly inserted blocks
+    /// and starts following them
+    pub fn processed(
+        &self,
+        blocks: impl IntoIterator<Item = (BlockHash, BlockSource, Instant)>,
+        dequeued: Instant,
+    ) {
+        let now = Instant::now();
+        for (hash, source, arrival) in blocks {
+            let queued = dequeued.saturating_duration_since(arrival);
+            let processed = now.saturating_duration_since(arrival);
+            self.record(LatencyStage::Queued, source, queued);
+            self.record(LatencyStage::Processed, source, processed);
+
+            if !self.should_follow(source) {
+                continue;
+            }
+            let mut stages = [None; LatencyStage::COUNT];
+            stages[LatencyStage::Queued as usize] = Some(queued);
+            stages[LatencyStage::Processed as usize] = Some(processed);
+            self.shard(&hash).lock().unwrap().insert(
+                hash,
+                TrackedBlock {
+                    source,
+                    arrival,
+                    inserted: now,
+                    stages,
+                },
+                self.max_per_shard,
+            );
+        }
+    }
+
+    /// Records the latency of the stage, unless it was already recorded for the block
+    pub fn stage_reached(&self, hash: &BlockHash, stage: LatencyStage) {
+        let now = Instant::now();
+        let mut guard = self.shard(hash).lock().unwrap();
+        if let Some(block) = guard.blocks.get_mut(hash) {
+            if block.stages[stage as usize].is_none() {
+                let latency = now.saturating_duration_since(block.arrival);
+                block.stages[stage as usize] = Some(latency);
+                self.record(stage, block.source, latency);
+            }
+        }
+    }
+
+    /// Records the cementation latency and stops following the blocks
+    pub fn cemented(&self, hashes: impl IntoIterator<Item = BlockHash>, now: Instant) {
+        let observers = self.traced_observers.read().unwrap();
+        let mut traces = Vec::new();
+        for hash in hashes {
+            let removed = self.shard(&hash).lock().unwrap().blocks.remove(&hash);
+            if let Some(mut block) = removed {
+                let latency = now.saturating_duration_since(block.arrival);
+                block.stages[LatencyStage::Cemented as usize] = Some(latency);
+                self.record(LatencyStage::Cemented, block.source, latency);
+                if !observers.is_empty() {
+                    traces.push(BlockTrace {
+                        hash,
+                        source: block.source,
+                        stages: block.stages,
+                    });
+                }
+            }
+        }
+
+        for trace in &traces {
+            for observer in observers.iter() {
+                observer(trace);
+            }
+        }
+    }
+
+    pub fn tracked(&self) -> usize {
+        self.shards
+            .iter()
+            .map(|shard| shard.lock().unwrap().blocks.len())
+            .sum()
+    }
+
+    /// Summaries of all histograms which contain at least one value
+    pub fn summaries(&self) -> Vec<(LatencyStage, BlockSource, LatencySummary)> {
+        let mut result = Vec::new();
+        for stage in LatencyStage::iter() {
+            for source in BlockSource::iter() {
+                let summary = self.histogram(stage, source).summary();
+                if summary.count > 0 {
+                    result.push((stage, source, summary));
+                }
+            }
+        }
+        result
+    }
+
+    pub fn clear(&self) {
+        for histogram in &self.histograms {
+            histogram.clear();
+        }
+        for shard in &self.shards {
+            let mut guard = shard.lock().unwrap();
+            guard.blocks.clear();
+            guard.order.clear();
+        }
+    }
+}
+
+impl Default for BlockLatencyTracker {
+    fn default() -> Self {
+        Self::new(Self::DEFAULT_MAX_TRACKED)
+    }
+}
+
+impl BlockSource {
+    pub fn as_str(&self) -> &'static str {
+        DetailType::from(*self).as_str()
+    }
+}
+
+#[derive(Default)]
+struct TrackedBlocks {
+    blocks: HashMap<BlockHash, TrackedBlock>,
+    /// Insertion order of the blocks. Contains stale entries of blocks which
+    /// were already cemented, they are skipped when the front is popped.
+    order: VecDeque<(BlockHash, Instant)>,
+}
+
+impl TrackedBlocks {
+    fn insert(&mut self, hash: BlockHash, block: TrackedBlock, max_blocks: usize) {
+        let now = block.inserted;
+        while let Some(&(oldest, inserted)) = self.order.front() {
+            let followed = self.is_followed(&oldest, inserted);
+            if followed
+                && self.blocks.len() < max_blocks
+                && now.saturating_duration_since(inserted) < BlockLatencyTracker::MAX_AGE
+            {
+                break;
+            }
+            self.order.pop_front();
+            if followed {
+                self.blocks.remove(&oldest);
+            }
+        }
+
+        self.order.push_back((hash, now));
+        self.blocks.insert(hash, block);
+
+        // Blocks which are cemented quickly leave only stale entries behind
+        if self.order.len() > max_blocks * 2 {
+            let blocks = &self.blocks;
+            self.order
+                .retain(|(hash, inserted)| Self::is_followed_in(blocks, hash, *inserted));
+        }
+    }
+
+    fn is_followed(&self, hash: &BlockHash, inserted: Instant) -> bool {
+        Self::is_followed_in(&self.blocks, hash, inserted)
+    }
+
+    fn is_followed_in(
+        blocks: &HashMap<BlockHash, TrackedBlock>,
+        hash: &BlockHash,
+        inserted: Instant,
+    ) -> bool {
+        blocks
+            .get(hash)
+            .is_some_and(|block| block.inserted == inserted)
+    }
+}
+
+struct TrackedBlock {
+    source: BlockSource,
+    arrival: Instant,
+    /// When the tracker started to follow the block
+    inserted: Instant,
+    stages: [Option<Duration>; LatencyStage::COUNT],
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::{Arc, Mutex};
+
+    #[test]
+    fn follow_block_until_cemented() {
+        let tracker = BlockLatencyTracker::default();
+        let traces = Arc::new(Mutex::new(Vec::new()));
+        let traces2 = traces.clone();
+        tracker.on_block_traced(Box::new(move |trace| {
+            traces2.lock().unwrap().push(trace.clone())
+        }));
+        let hash = BlockHash::from(1);
+        let arrival = Instant::now();
+
+        tracker.processed([(hash, BlockSource::Live, arrival)], arrival);
+        tracker.stage_reached(&hash, LatencyStage::ElectionStarted);
+        tracker.stage_reached(&hash, LatencyStage::Confirmed);
+        assert_eq!(tracker.tracked(), 1);
+        tracker.cemented([hash], Instant::now());
+
+        assert_eq!(tracker.tracked(), 0);
+        let traces = traces.lock().unwrap();
+        assert_eq!(traces.len(), 1);
+        assert_eq!(traces[0].hash, hash);
+        assert_eq!(traces[0].source, BlockSource::Live);
+        for stage in LatencyStage::iter() {
+            assert!(traces[0].latency(stage).is_some(), "{:?}", stage);
+        }
+
+        let summaries = tracker.summaries();
+        assert_eq!(summaries.len(), LatencyStage::COUNT);
+        assert!(summaries
+            .iter()
+            .all(|(_, source, summary)| *source == BlockSource::Live && summary.count == 1));
+    }
+
+    #[test]
+    fn record_stage_once() {
+        let tracker = BlockLatencyTracker::default();
+        let hash = BlockHash::from(1);
+        let now = Instant::now();
+        tracker.processed([(hash, BlockSource::Bootstrap, now)], now);
+        tracker.stage_reached(&hash, LatencyStage::ElectionStarted);
+        tracker.stage_reached(&hash, LatencyStage::ElectionStarted);
+        assert_eq!(
+            tracker
+                .histogram(LatencyStage::ElectionStarted, BlockSource::Bootstrap)
+                .summary()
+                .count,
+            1
+        );
+    }
+
+    #[test]
+    fn ignore_untracked_blocks() {
+        let tracker = BlockLatencyTracker::default();
+        tracker.stage_reached(&BlockHash::from(1), LatencyStage::Confirmed);
+        tracker.cemented([BlockHash::from(1)], Instant::now());
+        assert!(tracker.summaries().is_empty());
+    }
+
+    #[test]
+    fn bounded() {
+        let tracker = BlockLatencyTracker::new(2);
+        let now = Instant::now();
+        tracker.processed(
+            (1..=3).map(|i| (BlockHash::from(i), BlockSource::Live, now)),
+            now,
+        );
+        assert_eq!(tracker.tracked(), 2);
+        // Histograms still receive all blocks
+        assert_eq!(
+            tracker
+                .histogram(LatencyStage::Processed, BlockSource::Live)
+                .summary()
+                .count,
+            3
+        );
+    }
+
+    #[test]
+    fn drop_oldest_block_when_full() {
+        let tracker = BlockLatencyTracker::new(1);
+        let now = Instant::now();
+        tracker.processed([(BlockHash::from(1), BlockSource::Live, now)], now);
+        tracker.processed([(BlockHash::from(2), BlockSource::Live, now)], now);
+        assert_eq!(tracker.tracked(), 1);
+
+        tracker.cemented([BlockHash::from(1), BlockHash::from(2)], Instant::now());
+        assert_eq!(
+            tracker
+                .histogram(LatencyStage::Cemented, BlockSource::Live)
+                .summary()
+                .count,
+            1
+        );
+        assert_eq!(tracker.tracked(), 0);
+    }
+
+    #[test]
+    fn sample_bootstrapped_blocks() {
+        let tracker = BlockLatencyTracker::default();
+        let now = Instant::now();
+        let count = BlockLatencyTracker::BULK_SAMPLE_INTERVAL as u64 * 4;
+        tracker.processed(
+            (0..count).map(|i| (BlockHash::from(i), BlockSource::Bootstrap, now)),
+            now,
+        );
+        assert_eq!(tracker.tracked(), 4);
+        assert_eq!(
+            tracker
+                .histogram(LatencyStage::Processed, BlockSource::Bootstrap)
+                .summary()
+                .count,
+            count
+        );
+    }
+}
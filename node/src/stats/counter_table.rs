@@ -0,0 +1,316 @@
+use super::{DetailType, Direction, StatType, StatsConfig, StatsLogSink};
+use anyhow::Result;
+use num_traits::FromPrimitive;
+use once_cell::sync::Lazy;
+use std::{
+    alloc::{alloc_zeroed, handle_alloc_error, Layout},
+    ptr,
+    sync::atomic::{AtomicU64, AtomicUsize, Ordering},
+    time::SystemTime,
+};
+
+/// Upper limit for the number of shards. More threads than shards share a shard
+const MAX_SHARDS: usize = 16;
+
+/// Dense counters for every combination of stat type, detail type and direction.
+/// The index of a counter is computed from the enum discriminants, so counting
+/// needs no lookup and no lock. Every thread writes to its own shard and the
+/// shards are summed on read, so hot counters don't bounce between CPU caches.
+pub(crate) struct CounterTable {
+    layout: CounterLayout,
+    shards: Box<[Box<[AtomicU64]>]>,
+}
+
+impl CounterTable {
+    pub fn new() -> Self {
+        let shard_count = std::thread::available_parallelism()
+            .map(|i| i.get())
+            .unwrap_or(1)
+            .min(MAX_SHARDS);
+        Self::with_shards(shard_count)
+    }
+
+    pub fn with_shards(shard_count: usize) -> Self {
+        let layout = *COUNTER_LAYOUT;
+        let shards = (0..shard_count.max(1))
+            .map(|_| zeroed_counters(layout.len()))
+            .collect();
+        Self { layout, shards }
+    }
+
+    #[inline]
+    pub fn add(&self, stat_type: StatType, detail: DetailType, dir: Direction, value: u64) {
+        let shard = &self.shards[current_shard() % self.shards.len()];
+        shard[self.layout.index(stat_type, detail, dir)].fetch_add(value, Ordering::Relaxed);
+    }
+
+    pub fn get(&self, stat_type: StatType, detail: DetailType, dir: Direction) -> u64 {
+        self.sum(self.layout.index(stat_type, detail, dir))
+    }
+
+    /// Sum of all details of the given type, excluding `DetailType::All`
+    pub fn count_all(&self, stat_type: StatType, dir: Direction) -> u64 {
+        (1..self.layout.detail_types)
+            .map(|detail| {
+                self.sum(
+                    self.layout
+                        .raw_index(stat_type as usize, detail, dir as usize),
+                )
+            })
+            .sum()
+    }
+
+    /// Counters which are incremented concurrently may keep a part of their value
+    pub fn clear(&self) {
+        for shard in self.shards.iter() {
+            for counter in shard.iter() {
+                // Only write to counters that were used, so that untouched pages stay unmapped
+                if counter.load(Ordering::Relaxed) != 0 {
+                    counter.store(0, Ordering::Relaxed);
+                }
+            }
+        }
+    }
+
+    fn sum(&self, index: usize) -> u64 {
+        self.shards
+            .iter()
+            .map(|shard| shard[index].load(Ordering::Relaxed))
+            .sum()
+    }
+
+    /// Writes all counters that were used since the last clear, sorted by stat type,
+    /// detail type and direction. The `all` counter of a stat type is written
+    /// whenever any of its details was used.
+    pub fn log(
+        &self,
+        sink: &mut dyn StatsLogSink,
+        config: &StatsConfig,
+        time: SystemTime,
+    ) -> Result<()> {
+        sink.begin()?;
+        if sink.entries() >= config.log_rotation_count {
+            sink.rotate()?;
+        }
+
+        if config.log_headers {
+            let walltime = SystemTime::now();
+            sink.write_header("counters", walltime)?;
+        }
+
+        let mut values = vec![0; self.layout.detail_types * self.layout.directions];
+        for stat_type in 0..self.layout.stat_types {
+            for detail in 0..self.layout.detail_types {
+                for dir in 0..self.layout.directions {
+                    values[detail * self.layout.directions + dir] =
+                        self.sum(self.layout.raw_index(stat_type, detail, dir));
+                }
+            }
+
+            let mut used = vec![false; self.layout.directions];
+            for (i, value) in values.iter().enumerate() {
+                if *value != 0 {
+                    used[i % self.layout.directions] = true;
+                }
+            }
+            if !used.iter().any(|i| *i) {
+                continue;
+            }
+
+            let type_str = StatType::from_usize(stat_type).unwrap().as_str();
+            for detail in 0..self.layout.detail_types {
+                for dir in 0..self.layout.directions {
+                    let value = values[detail * self.layout.directions + dir];
+                    let is_all = detail == DetailType::All as usize;
+                    if value != 0 || (is_all && used[dir]) {
+                        sink.write_counter_entry(
+                            time,
+                            type_str,
+                            DetailType::from_usize(detail).unwrap().as_str(),
+                            Direction::from_usize(dir).unwrap().as_str(),
+                            value,
+                        )?;
+                    }
+                }
+            }
+        }
+        sink.inc_entries();
+        sink.finalize();
+        Ok(())
+    }
+}
+
+/// The dimensions of the counter table, derived from the stat enums
+#[derive(Clone, Copy)]
+struct CounterLayout {
+    stat_types: usize,
+    detail_types: usize,
+    directions: usize,
+}
+
+impl CounterLayout {
+    fn from_enums() -> Self {
+        Self {
+            stat_types: variant_count(StatType::from_usize),
+            detail_types: variant_count(DetailType::from_usize),
+            directions: variant_count(Direction::from_usize),
+        }
+    }
+
+    fn len(&self) -> usize {
+        self.stat_types * self.detail_types * self.directions
+    }
+
+    #[inline]
+    fn index(&self, stat_type: StatType, detail: DetailType, dir: Direction) -> usize {
+        self.raw_index(stat_type as usize, detail as usize, dir as usize)
+    }
+
+    #[inline]
+    fn raw_index(&self, stat_type: usize, detail: usize, dir: usize) -> usize {
+        (stat_type * self.detail_types + detail) * self.directions + dir
+    }
+}
+
+/// The enums have contiguous discriminants starting at 0
+fn variant_count<T>(from_usize: impl Fn(usize) -> Option<T>) -> usize {
+    (0..).take_while(|i| from_usize(*i).is_some()).count()
+}
+
+static COUNTER_LAYOUT: Lazy<CounterLayout> = Lazy::new(CounterLayout::from_enums);
+
+static NEXT_SHARD: AtomicUsize = AtomicUsize::new(0);
+
+thread_local! {
+    static SHARD: usize = NEXT_SHARD.fetch_add(1, Ordering::Relaxed);
+}
+
+#[inline]
+fn current_shard() -> usize {
+    SHARD.with(|i| *i)
+}
+
+/// Zeroed memory is handed out lazily by the OS, so counters which are
+/// never used don't occupy physical memory
+fn zeroed_counters(len: usize) -> Box<[AtomicU64]> {
+    let layout = Layout::array::<AtomicU64>(len).unwrap();
+    assert!(layout.size() > 0);
+    // SAFETY: the allocation has the layout of an `[AtomicU64]` of length `len`,
+    // and all zero bytes are a valid `AtomicU64`
+    unsafe {
+        let counters = alloc_zeroed(layout) as *mut AtomicU64;
+        if counters.is_null() {
+            handle_alloc_error(layout);
+        }
+        Box::from_raw(ptr::slice_from_raw_parts_mut(counters, len))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stats::StatsJsonWriterV2;
+
+    #[test]
+    fn layout_covers_all_variants() {
+        let layout = *COUNTER_LAYOUT;
+        assert_eq!(layout.directions, 2);
+        assert!(StatType::from_usize(layout.stat_types - 1).is_some());
+        assert!(StatType::from_usize(layout.stat_types).is_none());
+        assert!(DetailType::from_usize(layout.detail_types - 1).is_some());
+        assert!(DetailType::from_usize(layout.detail_types).is_none());
+    }
+
+    #[test]
+    fn indices_are_unique() {
+        let layout = *COUNTER_LAYOUT;
+        let indices = [
+            layout.index(StatType::Ledger, DetailType::Send, Direction::In),
+            layout.index(StatType::Ledger, DetailType::Send, Direction::Out),
+            layout.index(StatType::Ledger, DetailType::Receive, Direction::In),
+            layout.index(StatType::Vote, DetailType::Send, Direction::In),
+        ];
+        for (i, a) in indices.iter().enumerate() {
+            assert!(*a < layout.len());
+            for b in &indices[i + 1..] {
+                assert_ne!(a, b);
+            }
+        }
+    }
+
+    #[test]
+    fn sum_shards() {
+        let table = CounterTable::with_shards(4);
+        std::thread::scope(|s| {
+            for _ in 0..8 {
+                s.spawn(|| {
+                    for _ in 0..100 {
+                        table.add(StatType::Ledger, DetailType::Send, Direction::In, 1);
+                    }
+                });
+            }
+        });
+        assert_eq!(
+            table.get(StatType::Ledger, DetailType::Send, Direction::In),
+            800
+        );
+        assert_eq!(
+            table.get(StatType::Ledger, DetailType::Send, Direction::Out),
+            0
+        );
+    }
+
+    #[test]
+    fn count_all_excludes_all_detail() {
+        let table = CounterTable::with_shards(1);
+        table.add(StatType::Ledger, DetailType::All, Direction::In, 100);
+        table.add(StatType::Ledger, DetailType::Send, Direction::In, 2);
+        table.add(StatType::Ledger, DetailType::Receive, Direction::In, 3);
+        table.add(StatType::Ledger, DetailType::Receive, Direction::Out, 4);
+        assert_eq!(table.count_all(StatType::Ledger, Direction::In), 5);
+    }
+
+    #[test]
+    fn clear() {
+        let table = CounterTable::with_shards(2);
+        table.add(StatType::Ledger, DetailType::Send, Direction::In, 2);
+        table.clear();
+        assert_eq!(
+            table.get(StatType::Ledger, DetailType::Send, Direction::In),
+            0
+        );
+    }
+
+    #[test]
+    fn log_used_counters() {
+        let table = CounterTable::with_shards(1);
+        table.add(StatType::Ledger, DetailType::Send, Direction::In, 2);
+        table.add(StatType::Vote, DetailType::All, Direction::Out, 3);
+        let mut sink = StatsJsonWriterV2::new();
+        table
+            .log(&mut sink, &StatsConfig::new(), SystemTime::now())
+            .unwrap();
+
+        let json = sink.finish();
+        let entries = json["entries"].as_array().unwrap();
+        let entries: Vec<_> = entries
+            .iter()
+            .map(|e| {
+                (
+                    e["type"].as_str().unwrap(),
+                    e["detail"].as_str().unwrap(),
+                    e["dir"].as_str().unwrap(),
+                    e["value"].as_str().unwrap(),
+                )
+            })
+            .collect();
+        assert_eq!(
+            entries,
+            vec![
+                ("ledger", "all", "in", "0"),
+                ("ledger", "send", "in", "2"),
+                ("vote", "all", "out", "3"),
+            ]
+        );
+    }
+}
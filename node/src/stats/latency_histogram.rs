@@ -0,0 +1,194 @@
+use std::{
+    sync::atomic::{AtomicU64, Ordering},
+    time::Duration,
+};
+
+/// Each power of two is divided into 2^SUB_BUCKET_BITS buckets,
+/// which bounds the relative error of a percentile to 1/16
+const SUB_BUCKET_BITS: u32 = 4;
+const SUB_BUCKETS: usize = 1 << SUB_BUCKET_BITS;
+/// Latencies are recorded in microseconds and clamped to 2^36 µs (~19 hours)
+const MAX_EXPONENT: u32 = 36;
+const MAX_VALUE: u64 = (1 << MAX_EXPONENT) - 1;
+const BUCKETS: usize = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS) as usize * SUB_BUCKETS;
+
+/// A lock free histogram with logarithmic buckets, in the spirit of HdrHistogram.
+/// Recording is a few relaxed atomic adds, so it can stay enabled on a live node.
+pub struct LatencyHistogram {
+    buckets: Box<[AtomicU64]>,
+    sum: AtomicU64,
+    max: AtomicU64,
+}
+
+impl LatencyHistogram {
+    pub fn new() -> Self {
+        Self {
+            buckets: (0..BUCKETS).map(|_| AtomicU64::new(0)).collect(),
+            sum: AtomicU64::new(0),
+            max: AtomicU64::new(0),
+        }
+    }
+
+    pub fn record(&self, latency: Duration) {
+        let value = (latency.as_micros() as u64).min(MAX_VALUE);
+        self.buckets[bucket_index(value)].fetch_add(1, Ordering::Relaxed);
+        self.sum.fetch_add(value, Ordering::Relaxed);
+        self.max.fetch_max(value, Ordering::Relaxed);
+    }
+
+    pub fn clear(&self) {
+        for bucket in self.buckets.iter() {
+            bucket.store(0, Ordering::Relaxed);
+        }
+        self.sum.store(0, Ordering::Relaxed);
+        self.max.store(0, Ordering::Relaxed);
+    }
+
+    pub fn summary(&self) -> LatencySummary {
+        let counts: Vec<u64> = self
+            .buckets
+            .iter()
+            .map(|i| i.load(Ordering::Relaxed))
+            .collect();
+        let count: u64 = counts.iter().sum();
+        let max = self.max.load(Ordering::Relaxed);
+        let sum = self.sum.load(Ordering::Relaxed);
+        let mean = if count == 0 { 0 } else { sum / count };
+        LatencySummary {
+            count,
+            sum,
+            mean,
+            p50: percentile(&counts, count, max, 0.5),
+            p90: percentile(&counts, count, max, 0.9),
+            p99: percentile(&counts, count, max, 0.99),
+            p999: percentile(&counts, count, max, 0.999),
+            max,
+        }
+    }
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Latencies in microseconds
+#[derive(Clone, Copy, Default, PartialEq, Eq, Debug)]
+pub struct LatencySummary {
+    pub count: u64,
+    /// The exact sum of all recorded latencies
+    pub sum: u64,
+    pub mean: u64,
+    pub p50: u64,
+    pub p90: u64,
+    pub p99: u64,
+    pub p999: u64,
+    pub max: u64,
+}
+
+fn bucket_index(value: u64) -> usize {
+    if value < SUB_BUCKETS as u64 {
+        return value as usize;
+    }
+    let exponent = 63 - value.leading_zeros();
+    let shift = exponent - SUB_BUCKET_BITS;
+    let sub_bucket = ((value >> shift) as usize) & (SUB_BUCKETS - 1);
+    SUB_BUCKETS + shift as usize * SUB_BUCKETS + sub_bucket
+}
+
+/// The highest value which falls into the given bucket
+fn bucket_upper_bound(index: usize) -> u64 {
+    if index < SUB_BUCKETS {
+        return index as u64;
+    }
+    let shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    let sub_bucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    let lower = ((SUB_BUCKETS + sub_bucket) as u64) << shift;
+    lower + (1 << shift) - 1
+}
+
+fn percentile(counts: &[u64], count: u64, max: u64, quantile: f64) -> u64 {
+    if count == 0 {
+        return 0;
+    }
+    let target = ((count as f64 * quantile).ceil() as u64).max(1);
+    let mut seen = 0;
+    for (index, bucket_count) in counts.iter().enumerate() {
+        seen += bucket_count;
+        if seen >= target {
+            return bucket_upper_bound(index).min(max);
+        }
+    }
+    max
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn empty() {
+        let histogram = LatencyHistogram::new();
+        assert_eq!(histogram.summary(), LatencySummary::default());
+    }
+
+    #[test]
+    fn bucket_bounds() {
+        for value in [0, 1, 15, 16, 17, 31, 32, 33, 1000, 123_456, MAX_VALUE] {
+            let index = bucket_index(value);
+            assert!(index < BUCKETS);
+            assert!(bucket_upper_bound(index) >= value);
+            if index > 0 {
+                assert!(bucket_upper_bound(index - 1) < value);
+            }
+        }
+    }
+
+    #[test]
+    fn relative_error_is_bounded() {
+        for value in [100u64, 1_000, 54_321, 10_000_000] {
+            let upper = bucket_upper_bound(bucket_index(value));
+            assert!((upper - value) as f64 / value as f64 <= 1.0 / SUB_BUCKETS as f64);
+        }
+    }
+
+    #[test]
+    fn percentiles() {
+        let histogram = LatencyHistogram::new();
+        for ms in 1..=100 {
+            histogram.record(Duration::from_millis(ms));
+        }
+        let summary = histogram.summary();
+        assert_eq!(summary.count, 100);
+        assert_eq!(summary.max, 100_000);
+        assert_eq!(summary.sum, 5_050_000);
+        assert_eq!(summary.mean, 50_500);
+        assert!(
+            summary.p50 >= 50_000 && summary.p50 < 53_200,
+            "{}",
+            summary.p50
+        );
+        assert!(
+            summary.p99 >= 99_000 && summary.p99 <= 100_000,
+            "{}",
+            summary.p99
+        );
+        assert_eq!(summary.p999, 100_000);
+    }
+
+    #[test]
+    fn clamp_huge_values() {
+        let histogram = LatencyHistogram::new();
+        histogram.record(Duration::from_secs(u32::MAX as u64));
+        assert_eq!(histogram.summary().max, MAX_VALUE);
+    }
+
+    #[test]
+    fn clear() {
+        let histogram = LatencyHistogram::new();
+        histogram.record(Duration::from_millis(1));
+        histogram.clear();
+        assert_eq!(histogram.summary(), LatencySummary::default());
+    }
+}
@@ -1,9 +1,14 @@
 pub mod adapters;
+mod block_latency;
+mod counter_table;
+mod latency_histogram;
 mod stats;
 mod stats_config;
 mod stats_enums;
 mod stats_log_sink;
 
+pub use block_latency::*;
+pub use latency_histogram::{LatencyHistogram, LatencySummary};
 pub use stats::*;
 pub use stats_config::StatsConfig;
 pub use stats_enums::*;
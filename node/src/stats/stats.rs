@@ -1,4 +1,5 @@
-use super::{DetailType, Direction, Sample, StatType};
+use super::counter_table::CounterTable;
+use super::{BlockLatencyTracker, DetailType, Direction, Sample, StatType};
 use super::{StatFileWriter, StatsConfig, StatsLogSink};
 use anyhow::Result;
 use bounded_vec_deque::BoundedVecDeque;
@@ -7,7 +8,7 @@ use rsban_core::utils::get_env_bool;
 use rsban_messages::MessageType;
 use std::{
     collections::BTreeMap,
-    sync::{atomic::AtomicU64, Arc, Condvar, Mutex, RwLock},
+    sync::{Arc, Condvar, Mutex, RwLock},
     thread::JoinHandle,
     time::{Duration, Instant, SystemTime},
 };
@@ -15,6 +16,8 @@ use tracing::debug;
 
 pub struct Stats {
     config: StatsConfig,
+    counters: Arc<CounterTable>,
+    block_latency: BlockLatencyTracker,
     mutables: Arc<RwLock<StatMutables>>,
     thread: Mutex<Option<JoinHandle<()>>>,
     stats_loop: Arc<StatsLoop>,
@@ -29,8 +32,8 @@ impl Default for Stats {
 
 impl Stats {
     pub fn new(config: StatsConfig) -> Self {
+        let counters = Arc::new(CounterTable::new());
         let mutables = Arc::new(RwLock::new(StatMutables {
-            counters: BTreeMap::new(),
             samplers: BTreeMap::new(),
             timestamp: Instant::now(),
         }));
@@ -39,6 +42,7 @@ impl Stats {
             thread: Mutex::new(None),
             stats_loop: Arc::new(StatsLoop {
                 condition: Condvar::new(),
+                counters: Arc::clone(&counters),
                 mutables: Arc::clone(&mutables),
                 config,
                 loop_state: Mutex::new(StatsLoopState {
@@ -47,6 +51,8 @@ impl Stats {
                     log_last_sample_writeout: Instant::now(),
                 }),
             }),
+            counters,
+            block_latency: BlockLatencyTracker::default(),
             mutables,
             enable_logging: get_env_bool("NANO_LOG_STATS").unwrap_or(false),
         }
@@ -92,29 +98,7 @@ impl Stats {
         }
 
         self.log_add(stat_type, detail, dir, value);
-
-        let key = CounterKey::new(stat_type, detail, dir);
-
-        // This is a two-step process to avoid exclusively locking the mutex in the common case
-        {
-            let lock = self.mutables.read().unwrap();
-
-            if let Some(counter) = lock.counters.get(&key) {
-                counter.add(value);
-                return;
-            }
-        }
-        // Not found, create a new entry
-        {
-            let mut lock = self.mutables.write().unwrap();
-            let counter = lock.counters.entry(key).or_insert(CounterEntry::new());
-            counter.add(value);
-
-            let all_key = CounterKey::new(stat_type, DetailType::All, dir);
-            if key != all_key {
-                lock.counters.entry(all_key).or_insert(CounterEntry::new());
-            }
-        }
+        self.counters.add(stat_type, detail, dir, value);
     }
 
     fn log_add(&self, stat_type: StatType, detail: DetailType, dir: Direction, value: u64) {
@@ -138,32 +122,9 @@ impl Stats {
         }
 
         self.log_add(stat_type, detail, dir, value);
-
-        let key = CounterKey::new(stat_type, detail, dir);
-        let all_key = CounterKey::new(stat_type, DetailType::All, dir);
-
-        // This is a two-step process to avoid exclusively locking the mutex in the common case
-        {
-            let lock = self.mutables.read().unwrap();
-
-            if let Some(counter) = lock.counters.get(&key) {
-                counter.add(value);
-                if key != all_key {
-                    let all_counter = lock.counters.get(&all_key).unwrap();
-                    all_counter.add(value);
-                }
-                return;
-            }
-        }
-        // Not found, create a new entry
-        {
-            let mut lock = self.mutables.write().unwrap();
-            let counter = lock.counters.entry(key).or_insert(CounterEntry::new());
-            counter.add(value);
-            if key != all_key {
-                let all_counter = lock.counters.entry(all_key).or_insert(CounterEntry::new());
-                all_counter.add(value);
-            }
+        self.counters.add(stat_type, detail, dir, value);
+        if detail != DetailType::All {
+            self.counters.add(stat_type, DetailType::All, dir, value);
         }
     }
 
@@ -220,8 +181,7 @@ impl Stats {
     /// Log counters to the given log link
     pub fn log_counters(&self, sink: &mut dyn StatsLogSink) -> Result<()> {
         let now = SystemTime::now();
-        let lock = self.mutables.write().unwrap();
-        lock.log_counters_impl(sink, &self.config, now)
+        self.counters.log(sink, &self.config, now)
     }
 
     /// Log samples to the given log sink
@@ -231,6 +191,25 @@ impl Stats {
         lock.log_samples_impl(sink, &self.config, now)
     }
 
+    /// Log the latency histograms of the block lifecycle to the given log sink
+    pub fn log_latencies(&self, sink: &mut dyn StatsLogSink) -> Result<()> {
+        let now = SystemTime::now();
+        sink.begin()?;
+        if self.config.log_headers {
+            sink.write_header("latencies", now)?;
+        }
+        for (stage, source, summary) in self.block_latency.summaries() {
+            sink.write_latency_entry(now, stage.as_str(), source.as_str(), &summary)?;
+        }
+        sink.inc_entries();
+        sink.finalize();
+        Ok(())
+    }
+
+    pub fn block_latency(&self) -> &BlockLatencyTracker {
+        &self.block_latency
+    }
+
     /// Returns the duration since `clear()` was last called, or node startup if it's never called.
     pub fn last_reset(&self) -> Duration {
         let lock = self.mutables.read().unwrap();
@@ -240,54 +219,20 @@ impl Stats {
     /// Clear all stats
     pub fn clear(&self) {
         let mut lock = self.mutables.write().unwrap();
-        lock.counters.clear();
+        self.counters.clear();
+        self.block_latency.clear();
         lock.samplers.clear();
         lock.timestamp = Instant::now();
     }
     ///
     /// Returns current value for the given counter at the type level
     pub fn count_all(&self, stat_type: StatType, dir: Direction) -> u64 {
-        let guard = self.mutables.read().unwrap();
-        let start = CounterKey::new(stat_type, DetailType::All, dir);
-        let mut result = 0u64;
-        for (key, entry) in guard.counters.range(start..) {
-            if key.stat_type != stat_type {
-                break;
-            }
-            if key.dir == dir && key.detail != DetailType::All {
-                result += u64::from(entry);
-            }
-        }
-        result
+        self.counters.count_all(stat_type, dir)
     }
 
     /// Returns current value for the given counter at the type level
     pub fn count(&self, stat_type: StatType, detail: DetailType, dir: Direction) -> u64 {
-        let key = CounterKey::new(stat_type, detail, dir);
-        self.mutables
-            .read()
-            .unwrap()
-            .counters
-            .get(&key)
-            .map(|i| i.into())
-            .unwrap_or_default()
-    }
-}
-
-#[derive(PartialEq, Eq, PartialOrd, Ord, Clone, Copy)]
-struct CounterKey {
-    stat_type: StatType,
-    detail: DetailType,
-    dir: Direction,
-}
-
-impl CounterKey {
-    fn new(stat_type: StatType, detail: DetailType, dir: Direction) -> Self {
-        Self {
-            stat_type,
-            detail,
-            dir,
-        }
+        self.counters.get(stat_type, detail, dir)
     }
 }
 
@@ -309,7 +254,6 @@ pub enum StatCategory {
 
 struct StatMutables {
     /// Stat entries are sorted by key to simplify processing of log output
-    counters: BTreeMap<CounterKey, CounterEntry>,
     samplers: BTreeMap<SamplerKey, SamplerEntry>,
 
     /// Time of last clear() call
@@ -342,52 +286,6 @@ impl StatMutables {
         sink.finalize();
         Ok(())
     }
-
-    /// Unlocked implementation of log_counters() to avoid using recursive locking
-    fn log_counters_impl(
-        &self,
-        sink: &mut dyn StatsLogSink,
-        config: &StatsConfig,
-        time: SystemTime,
-    ) -> Result<()> {
-        sink.begin()?;
-        if sink.entries() >= config.log_rotation_count {
-            sink.rotate()?;
-        }
-
-        if config.log_headers {
-            let walltime = SystemTime::now();
-            sink.write_header("counters", walltime)?;
-        }
-
-        for (&key, entry) in &self.counters {
-            let type_str = key.stat_type.as_str();
-            let detail = key.detail.as_str();
-            let dir = key.dir.as_str();
-            sink.write_counter_entry(time, type_str, detail, dir, entry.into())?;
-        }
-        sink.inc_entries();
-        sink.finalize();
-        Ok(())
-    }
-}
-
-struct CounterEntry(AtomicU64);
-
-impl CounterEntry {
-    fn new() -> Self {
-        Self(AtomicU64::new(0))
-    }
-
-    fn add(&self, value: u64) {
-        self.0.fetch_add(value, std::sync::atomic::Ordering::SeqCst);
-    }
-}
-
-impl From<&CounterEntry> for u64 {
-    fn from(value: &CounterEntry) -> Self {
-        value.0.load(std::sync::atomic::Ordering::SeqCst)
-    }
 }
 
 struct SamplerEntry {
@@ -436,6 +334,7 @@ impl From<MessageType> for DetailType {
 }
 
 struct StatsLoop {
+    counters: Arc<CounterTable>,
     mutables: Arc<RwLock<StatMutables>>,
     condition: Condvar,
     loop_state: Mutex<StatsLoopState>,
@@ -473,7 +372,7 @@ impl StatsLoop {
                 }
             };
 
-            stats.log_counters_impl(writer, &self.config, SystemTime::now())?;
+            self.counters.log(writer, &self.config, SystemTime::now())?;
             lock.log_last_count_writeout = Instant::now();
         }
 
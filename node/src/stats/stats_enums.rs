@@ -50,6 +50,8 @@ pub enum StatType {
     BlockprocessorSource,
     BlockprocessorResult,
     BlockprocessorOverfill,
+    /// Accumulated time in microseconds the block processor spent in each stage
+    BlockprocessorTiming,
     BootstrapAscending,
     BootstrapAscendingAccounts,
     BootstrapAscendingVerify,
@@ -85,7 +87,11 @@ pub enum StatType {
     MessageProcessor,
     MessageProcessorOverfill,
     MessageProcessorType,
+    MessagePublisher,
     ProcessConfirmed,
+    /// Adaptive batch size adjustments, the detail identifies the processing loop
+    BatchGrow,
+    BatchShrink,
 }
 
 impl StatType {
@@ -137,6 +143,12 @@ pub enum DetailType {
     Queue,
     Overfill,
     Batch,
+    /// Queued messages which own a heap buffer. The other messages are stored inline
+    HeapBuffers,
+    /// Reading from a channel was paused, because its queue was full
+    Backpressure,
+    ConfirmingSet,
+    VoteProcessor,
 
     // error specific
     InsufficientWork,
@@ -175,7 +187,12 @@ pub enum DetailType {
     // blockprocessor
     ProcessBlocking,
     ProcessBlockingTimeout,
+    ProcessChain,
     Force,
+    Precheck,
+    PrecheckParallel,
+    WriteLockWait,
+    WriteLockHeld,
 
     // block source
     Live,
@@ -228,6 +245,7 @@ pub enum DetailType {
     // vote processor
     VoteOverflow,
     VoteIgnored,
+    SignaturesUnbatched,
 
     // election specific
     VoteNew,
@@ -343,6 +361,7 @@ pub enum DetailType {
     RequestsUnknown,
     RequestsNonFinal,
     RequestsFinal,
+    RequestsCoalesced,
 
     // request_aggregator
     RequestHashes,
@@ -407,6 +426,14 @@ pub enum DetailType {
     Put,
     Satisfied,
     Trigger,
+    Spilled,
+    SatisfiedFromDisk,
+    OverflowFull,
+
+    // message publisher
+    Flood,
+    BytesCopied,
+    BufferReused,
 
     // election scheduler
     InsertManual,
@@ -498,6 +525,8 @@ pub enum DetailType {
     Cementing,
     CementedHash,
     CementingFailed,
+    Resolved,
+    PlanInvalidated,
 
     // election_state
     Passive,
@@ -1,3 +1,4 @@
+use super::LatencySummary;
 use anyhow::Result;
 use chrono::{DateTime, Local};
 use std::{any::Any, fs::File, io::Write, path::PathBuf, time::SystemTime};
@@ -30,6 +31,15 @@ pub trait StatsLogSink {
         expected_min_max: (i64, i64),
     ) -> Result<()>;
 
+    /// Write the summary of a latency histogram. All latencies are in microseconds.
+    fn write_latency_entry(
+        &mut self,
+        time: SystemTime,
+        stage: &str,
+        source: &str,
+        summary: &LatencySummary,
+    ) -> Result<()>;
+
     /// Rotates the log (e.g. empty file). This is a no-op for sinks where rotation is not supported.
     fn rotate(&mut self) -> Result<()>;
 
@@ -111,6 +121,28 @@ impl StatsLogSink for StatFileWriter {
         Ok(())
     }
 
+    fn write_latency_entry(
+        &mut self,
+        time: SystemTime,
+        stage: &str,
+        source: &str,
+        summary: &LatencySummary,
+    ) -> Result<()> {
+        let now = DateTime::<Local>::from(time).format("%H:%M:%S");
+        writeln!(
+            &mut self.file,
+            "{now},{stage},{source},{},{},{},{},{},{},{}",
+            summary.count,
+            summary.mean,
+            summary.p50,
+            summary.p90,
+            summary.p99,
+            summary.p999,
+            summary.max
+        )?;
+        Ok(())
+    }
+
     fn rotate(&mut self) -> Result<()> {
         self.file = File::create(self.filename.clone())?;
         self.log_entries = 0;
@@ -221,6 +253,41 @@ impl StatsLogSink for StatsJsonWriterV2 {
         Ok(())
     }
 
+    fn write_latency_entry(
+        &mut self,
+        time: SystemTime,
+        stage: &str,
+        source: &str,
+        summary: &LatencySummary,
+    ) -> Result<()> {
+        let mut entry = serde_json::Map::new();
+        entry.insert(
+            "time".to_owned(),
+            serde_json::Value::String(DateTime::<Local>::from(time).format("%H:%M:%S").to_string()),
+        );
+        entry.insert(
+            "stage".to_owned(),
+            serde_json::Value::String(stage.to_owned()),
+        );
+        entry.insert(
+            "source".to_owned(),
+            serde_json::Value::String(source.to_owned()),
+        );
+        for (key, value) in [
+            ("count", summary.count),
+            ("mean", summary.mean),
+            ("p50", summary.p50),
+            ("p90", summary.p90),
+            ("p99", summary.p99),
+            ("p999", summary.p999),
+            ("max", summary.max),
+        ] {
+            entry.insert(key.to_owned(), serde_json::Value::String(value.to_string()));
+        }
+        self.entries.push(serde_json::Value::Object(entry));
+        Ok(())
+    }
+
     fn rotate(&mut self) -> Result<()> {
         Ok(())
     }
@@ -7,7 +7,7 @@ use std::{
 };
 
 /// Queue items of type T from source S
-pub(crate) struct FairQueue<S, T>
+pub struct FairQueue<S, T>
 where
     S: Ord + Copy,
 {
@@ -48,7 +48,6 @@ where
         self.queues.get(source).map(|q| q.len()).unwrap_or_default()
     }
 
-    #[allow(dead_code)]
     pub fn max_len(&self, source: &S) -> usize {
         self.queues
             .get(source)
@@ -64,6 +63,13 @@ where
             .unwrap_or_default()
     }
 
+    /// Whether the next item from this source would be dropped
+    pub fn is_full(&self, source: &S) -> bool {
+        self.queues
+            .get(source)
+            .is_some_and(|q| q.requests.len() >= q.max_size)
+    }
+
     pub fn len(&self) -> usize {
         self.total_len
     }
@@ -320,6 +326,20 @@ mod tests {
         assert!(queue.is_empty());
     }
 
+    #[test]
+    fn is_full() {
+        let mut queue: FairQueue<usize, &'static str> =
+            FairQueue::new(Box::new(|_| 2), Box::new(|_| 1));
+        assert!(!queue.is_full(&7));
+        queue.push(7, "a");
+        assert!(!queue.is_full(&7));
+        queue.push(7, "b");
+        assert!(queue.is_full(&7));
+        assert!(!queue.is_full(&8));
+        queue.next();
+        assert!(!queue.is_full(&7));
+    }
+
     #[test]
     fn fifo() {
         let mut queue: FairQueue<usize, &'static str> =
@@ -4,13 +4,21 @@ use rsban_core::utils::ContainerInfo;
 use rsban_messages::Message;
 use rsban_network::{ChannelId, ChannelInfo, DeadChannelCleanupStep};
 use std::{
-    collections::VecDeque,
-    sync::{Arc, Condvar, Mutex},
+    collections::{HashMap, VecDeque},
+    sync::{
+        atomic::{AtomicUsize, Ordering},
+        Arc, Condvar, Mutex,
+    },
 };
+use tokio::sync::Notify;
 
 pub struct InboundMessageQueue {
     state: Mutex<State>,
     condition: Condvar,
+    /// Notified when the queue of a channel is no longer full
+    room: Notify,
+    /// Number of readers which wait for room in their channel's queue
+    waiting: AtomicUsize,
     stats: Arc<Stats>,
     inbound_callback: Option<MessageCallback>,
     inbound_dropped_callback: Option<MessageCallback>,
@@ -24,6 +32,8 @@ impl InboundMessageQueue {
                 stopped: false,
             }),
             condition: Condvar::new(),
+            room: Notify::new(),
+            waiting: AtomicUsize::new(0),
             stats,
             inbound_callback: None,
             inbound_dropped_callback: None,
@@ -40,30 +50,40 @@ impl InboundMessageQueue {
 
     pub fn put(&self, message: Message, channel: Arc<ChannelInfo>) -> bool {
         let message_type = message.message_type();
+        let channel_id = channel.channel_id();
+        let heap_buffers = message.heap_buffers();
+        // The message is only copied if somebody observes it
+        let observed = (self.inbound_callback.is_some() || self.inbound_dropped_callback.is_some())
+            .then(|| message.clone());
         let added = self
             .state
             .lock()
             .unwrap()
             .queue
-            .push(channel.channel_id(), (message.clone(), channel.clone()));
+            .push(channel_id, (message, channel));
 
         if added {
             self.stats
                 .inc(StatType::MessageProcessor, DetailType::Process);
             self.stats
                 .inc(StatType::MessageProcessorType, message_type.into());
+            self.stats.add(
+                StatType::MessageProcessor,
+                DetailType::HeapBuffers,
+                heap_buffers as u64,
+            );
 
             self.condition.notify_all();
-            if let Some(cb) = &self.inbound_callback {
-                cb(channel.channel_id(), &message);
+            if let (Some(cb), Some(message)) = (&self.inbound_callback, &observed) {
+                cb(channel_id, message);
             }
         } else {
             self.stats
                 .inc(StatType::MessageProcessor, DetailType::Overfill);
             self.stats
                 .inc(StatType::MessageProcessorOverfill, message_type.into());
-            if let Some(cb) = &self.inbound_dropped_callback {
-                cb(channel.channel_id(), &message);
+            if let (Some(cb), Some(message)) = (&self.inbound_dropped_callback, &observed) {
+                cb(channel_id, message);
             }
         }
 
@@ -74,7 +94,39 @@ impl InboundMessageQueue {
         &self,
         max_batch_size: usize,
     ) -> VecDeque<(ChannelId, (Message, Arc<ChannelInfo>))> {
-        self.state.lock().unwrap().queue.next_batch(max_batch_size)
+        let mut state = self.state.lock().unwrap();
+        let batch = state.queue.next_batch(max_batch_size);
+        if self.waiting.load(Ordering::SeqCst) > 0 {
+            let mut taken: HashMap<ChannelId, usize> = HashMap::new();
+            for (channel_id, _) in &batch {
+                *taken.entry(*channel_id).or_default() += 1;
+            }
+            let was_full = taken.iter().any(|(channel_id, count)| {
+                state.queue.queue_len(channel_id) + count >= state.queue.max_len(channel_id)
+            });
+            drop(state);
+            if was_full {
+                self.room.notify_waiters();
+            }
+        }
+        batch
+    }
+
+    /// Waits until the queue of the channel is no longer full or the queue was stopped
+    pub async fn wait_for_room(&self, channel_id: ChannelId) {
+        self.waiting.fetch_add(1, Ordering::SeqCst);
+        let _waiting = WaitingGuard(&self.waiting);
+        loop {
+            // Created before the check, so a notification in between isn't lost
+            let notified = self.room.notified();
+            {
+                let state = self.state.lock().unwrap();
+                if state.stopped || !state.queue.is_full(&channel_id) {
+                    return;
+                }
+            }
+            notified.await;
+        }
     }
 
     pub fn wait_for_messages(&self) {
@@ -88,6 +140,12 @@ impl InboundMessageQueue {
         )
     }
 
+    /// The queue of this channel is full, so the next message would be dropped.
+    /// Readers should stop reading from the channel until there is room again
+    pub fn is_full(&self, channel_id: ChannelId) -> bool {
+        self.state.lock().unwrap().queue.is_full(&channel_id)
+    }
+
     pub fn size(&self) -> usize {
         self.state.lock().unwrap().queue.len()
     }
@@ -99,6 +157,7 @@ impl InboundMessageQueue {
             lock.stopped = true;
         }
         self.condition.notify_all();
+        self.room.notify_waiters();
     }
 
     pub fn container_info(&self) -> ContainerInfo {
@@ -125,10 +184,21 @@ impl InboundMessageQueueCleanup {
 
 impl DeadChannelCleanupStep for InboundMessageQueueCleanup {
     fn clean_up_dead_channels(&self, dead_channel_ids: &[ChannelId]) {
-        let mut guard = self.0.state.lock().unwrap();
-        for channel_id in dead_channel_ids {
-            guard.queue.remove(channel_id);
+        {
+            let mut guard = self.0.state.lock().unwrap();
+            for channel_id in dead_channel_ids {
+                guard.queue.remove(channel_id);
+            }
         }
+        self.0.room.notify_waiters();
+    }
+}
+
+struct WaitingGuard<'a>(&'a AtomicUsize);
+
+impl Drop for WaitingGuard<'_> {
+    fn drop(&mut self) {
+        self.0.fetch_sub(1, Ordering::SeqCst);
     }
 }
 
@@ -140,7 +210,8 @@ struct State {
 #[cfg(test)]
 mod tests {
     use super::*;
-    use rsban_messages::Message;
+    use crate::stats::Direction;
+    use rsban_messages::{ConfirmAck, Message};
 
     #[test]
     fn put_and_get_one_message() {
@@ -154,4 +225,48 @@ mod tests {
         assert_eq!(manager.next_batch(1000).len(), 1);
         assert_eq!(manager.size(), 0);
     }
+
+    #[tokio::test]
+    async fn wake_reader_when_queue_has_room() {
+        let queue = Arc::new(InboundMessageQueue::new(1, Arc::new(Stats::default())));
+        let channel = Arc::new(ChannelInfo::new_test_instance());
+        let channel_id = channel.channel_id();
+        queue.put(Message::BulkPush, channel);
+        assert!(queue.is_full(channel_id));
+
+        let waiter = tokio::spawn({
+            let queue = queue.clone();
+            async move { queue.wait_for_room(channel_id).await }
+        });
+        while queue.waiting.load(Ordering::SeqCst) == 0 {
+            tokio::task::yield_now().await;
+        }
+        assert!(!waiter.is_finished());
+
+        assert_eq!(queue.next_batch(10).len(), 1);
+        tokio::time::timeout(std::time::Duration::from_secs(5), waiter)
+            .await
+            .unwrap()
+            .unwrap();
+    }
+
+    #[test]
+    fn count_heap_buffers() {
+        let stats = Arc::new(Stats::default());
+        let manager = InboundMessageQueue::new(10, stats.clone());
+        let channel = Arc::new(ChannelInfo::new_test_instance());
+        manager.put(Message::BulkPush, channel.clone());
+        manager.put(
+            Message::ConfirmAck(ConfirmAck::new_test_instance()),
+            channel,
+        );
+        assert_eq!(
+            stats.count(
+                StatType::MessageProcessor,
+                DetailType::HeapBuffers,
+                Direction::In
+            ),
+            1
+        );
+    }
 }
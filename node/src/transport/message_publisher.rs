@@ -1,9 +1,9 @@
 use crate::{
     representatives::OnlineReps,
-    stats::{Direction, StatType, Stats},
+    stats::{DetailType, Direction, StatType, Stats},
 };
 use rsban_messages::{Message, MessageSerializer, ProtocolInfo};
-use rsban_network::{ChannelId, ChannelInfo, DropPolicy, Network, TrafficType};
+use rsban_network::{ChannelId, ChannelInfo, DropPolicy, Network, SharedBufferPool, TrafficType};
 use std::sync::{Arc, Mutex};
 use tracing::trace;
 
@@ -16,6 +16,7 @@ pub struct MessagePublisher {
     network: Arc<Network>,
     stats: Arc<Stats>,
     message_serializer: MessageSerializer,
+    buffer_pool: SharedBufferPool,
     published_callback: Option<MessageCallback>,
 }
 
@@ -31,6 +32,7 @@ impl MessagePublisher {
             network,
             stats,
             message_serializer: MessageSerializer::new(protocol_info),
+            buffer_pool: SharedBufferPool::default(),
             published_callback: None,
         }
     }
@@ -47,6 +49,7 @@ impl MessagePublisher {
             network,
             stats,
             message_serializer: MessageSerializer::new_with_buffer_size(protocol_info, buffer_size),
+            buffer_pool: SharedBufferPool::default(),
             published_callback: None,
         }
     }
@@ -110,6 +113,37 @@ impl MessagePublisher {
         Ok(())
     }
 
+    /// Serializes the message once and sends the same buffer to all given channels
+    /// Returns the number of channels the message was sent to
+    pub fn broadcast(
+        &mut self,
+        channel_ids: &[ChannelId],
+        message: &Message,
+        drop_policy: DropPolicy,
+        traffic_type: TrafficType,
+    ) -> usize {
+        let buffer = self.serialize_shared(message);
+        let mut sent = 0;
+        for channel_id in channel_ids {
+            if try_send_shared_message(
+                &self.network,
+                &self.stats,
+                *channel_id,
+                &buffer,
+                message,
+                drop_policy,
+                traffic_type,
+            ) {
+                sent += 1;
+            }
+
+            if let Some(callback) = &self.published_callback {
+                callback(*channel_id, message);
+            }
+        }
+        sent
+    }
+
     pub(crate) fn flood_prs_and_some_non_prs(
         &mut self,
         message: &Message,
@@ -117,10 +151,14 @@ impl MessagePublisher {
         traffic_type: TrafficType,
         scale: f32,
     ) {
-        let peered_prs = self.online_reps.lock().unwrap().peered_principal_reps();
-        for rep in peered_prs {
-            self.try_send(rep.channel_id, &message, drop_policy, traffic_type);
-        }
+        let mut channel_ids: Vec<_> = self
+            .online_reps
+            .lock()
+            .unwrap()
+            .peered_principal_reps()
+            .iter()
+            .map(|rep| rep.channel_id)
+            .collect();
 
         let mut channels;
         let fanout;
@@ -131,9 +169,8 @@ impl MessagePublisher {
         }
 
         self.remove_no_pr(&mut channels, fanout);
-        for peer in channels {
-            self.try_send(peer.channel_id(), &message, drop_policy, traffic_type);
-        }
+        channel_ids.extend(channels.iter().map(|c| c.channel_id()));
+        self.broadcast(&channel_ids, message, drop_policy, traffic_type);
     }
 
     fn remove_no_pr(&self, channels: &mut Vec<Arc<ChannelInfo>>, count: usize) {
@@ -145,7 +182,6 @@ impl MessagePublisher {
     }
 
     pub fn flood(&mut self, message: &Message, drop_policy: DropPolicy, scale: f32) {
-        let buffer = self.message_serializer.serialize(message);
         let channels = self
             .network
             .info
@@ -153,18 +189,38 @@ impl MessagePublisher {
             .unwrap()
             .random_fanout_realtime(scale);
 
+        let buffer = self.serialize_shared(message);
         for channel in channels {
-            try_send_serialized_message(
+            try_send_shared_message(
                 &self.network,
                 &self.stats,
                 channel.channel_id(),
-                buffer,
+                &buffer,
                 message,
                 drop_policy,
                 TrafficType::Generic,
             );
         }
     }
+
+    /// The message gets copied once into a pooled buffer, which is then
+    /// shared by the write queues of all target channels
+    fn serialize_shared(&mut self, message: &Message) -> Arc<Vec<u8>> {
+        let serialized = self.message_serializer.serialize(message);
+        let (buffer, reused) = self.buffer_pool.get(serialized);
+        self.stats
+            .inc(StatType::MessagePublisher, DetailType::Flood);
+        self.stats.add(
+            StatType::MessagePublisher,
+            DetailType::BytesCopied,
+            buffer.len() as u64,
+        );
+        if reused {
+            self.stats
+                .inc(StatType::MessagePublisher, DetailType::BufferReused);
+        }
+        buffer
+    }
 }
 
 fn try_send_serialized_message(
@@ -177,7 +233,25 @@ fn try_send_serialized_message(
     traffic_type: TrafficType,
 ) -> bool {
     let sent = network.try_send_buffer(channel_id, buffer, drop_policy, traffic_type);
+    record_send_result(stats, channel_id, message, sent);
+    sent
+}
+
+fn try_send_shared_message(
+    network: &Network,
+    stats: &Stats,
+    channel_id: ChannelId,
+    buffer: &Arc<Vec<u8>>,
+    message: &Message,
+    drop_policy: DropPolicy,
+    traffic_type: TrafficType,
+) -> bool {
+    let sent = network.try_send_shared(channel_id, buffer, drop_policy, traffic_type);
+    record_send_result(stats, channel_id, message, sent);
+    sent
+}
 
+fn record_send_result(stats: &Stats, channel_id: ChannelId, message: &Message, sent: bool) {
     if sent {
         stats.inc_dir_aggregate(StatType::Message, message.into(), Direction::Out);
         trace!(%channel_id, message = ?message, "Message sent");
@@ -186,6 +260,4 @@ fn try_send_serialized_message(
         stats.inc_dir_aggregate(StatType::Drop, detail_type, Direction::Out);
         trace!(%channel_id, message = ?message, "Message dropped");
     }
-
-    sent
 }
@@ -24,7 +24,7 @@ pub use latest_keepalives::*;
 pub use message_deserializer::MessageDeserializer;
 pub use message_processor::*;
 pub use message_publisher::*;
-pub use network_filter::NetworkFilter;
+pub use network_filter::{DefaultNetworkFilterHasher, NetworkFilter, NetworkFilterHasher};
 pub(crate) use network_threads::*;
 pub use peer_cache_connector::*;
 pub use peer_cache_updater::*;
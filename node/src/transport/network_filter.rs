@@ -11,20 +11,46 @@ struct Entry {
     epoch: u64,
 }
 
+/// A part of the filter with its own lock.
+/// Aligned to a cache line, so that threads working on neighbouring shards don't contend.
+#[repr(align(64))]
+struct Shard {
+    items: Mutex<Vec<Entry>>,
+}
+
 /// A probabilistic duplicate filter based on directed map caches, using SipHash 2/4/128
 /// The probability of false negatives (unique packet marked as duplicate) is the probability of a 128-bit SipHash collision.
 /// The probability of false positives (duplicate packet marked as unique) shrinks with a larger filter.
+/// The slots are spread over independently locked shards. Every digest still maps to exactly one
+/// slot, so sharding doesn't change which messages are detected as duplicates.
 pub struct NetworkFilter<T: NetworkFilterHasher = DefaultNetworkFilterHasher> {
-    items: Mutex<Vec<Entry>>,
+    shards: Vec<Shard>,
+    size: usize,
     hasher: T,
     pub age_cutoff: u64,
     current_epoch: AtomicU64,
 }
 
 impl<T: NetworkFilterHasher> NetworkFilter<T> {
+    pub const DEFAULT_SHARDS: usize = 64;
+
     pub fn with_hasher(hasher: T, size: usize) -> Self {
+        Self::with_shards(hasher, size, Self::DEFAULT_SHARDS)
+    }
+
+    /// Creates a filter with `size` slots spread over `shards` locks.
+    /// A single shard behaves like a filter with one global lock
+    pub fn with_shards(hasher: T, size: usize, shards: usize) -> Self {
+        let size = size.max(1);
+        let shard_count = shards.clamp(1, size);
+        let shard_size = size.div_ceil(shard_count);
         Self {
-            items: Mutex::new(vec![Entry::default(); size]),
+            shards: (0..shard_count)
+                .map(|_| Shard {
+                    items: Mutex::new(vec![Entry::default(); shard_size]),
+                })
+                .collect(),
+            size,
             hasher,
             age_cutoff: 0,
             current_epoch: AtomicU64::new(0),
@@ -52,8 +78,8 @@ impl<T: NetworkFilterHasher> NetworkFilter<T> {
     }
 
     pub fn apply_digest(&self, digest: u128) -> bool {
-        let mut lock = self.items.lock().unwrap();
-        let element = self.get_element(digest, &mut lock);
+        let (mut lock, index) = self.lock_slot(digest);
+        let element = &mut lock[index];
         let existed = self.compare(element, digest);
         if !existed {
             // Replace likely old element with a new one
@@ -72,21 +98,22 @@ impl<T: NetworkFilterHasher> NetworkFilter<T> {
 
     /// Checks if the digest is in the filter.
     pub fn check(&self, digest: u128) -> bool {
-        let mut guard = self.items.lock().unwrap();
-        let element = self.get_element(digest, &mut guard);
-        self.compare(element, digest)
+        let (lock, index) = self.lock_slot(digest);
+        self.compare(&lock[index], digest)
     }
 
     /// Sets the corresponding element in the filter to zero, if it matches `digest` exactly.
     pub fn clear(&self, digest: u128) {
-        let mut lock = self.items.lock().unwrap();
-        self.clear_locked(digest, &mut lock);
+        let (mut lock, index) = self.lock_slot(digest);
+        let element = &mut lock[index];
+        if self.compare(element, digest) {
+            *element = Default::default();
+        }
     }
 
     pub fn clear_many(&self, digests: impl IntoIterator<Item = u128>) {
-        let mut lock = self.items.lock().unwrap();
         for digest in digests.into_iter() {
-            self.clear_locked(digest, &mut lock);
+            self.clear(digest);
         }
     }
 
@@ -95,20 +122,17 @@ impl<T: NetworkFilterHasher> NetworkFilter<T> {
     }
 
     pub fn clear_all(&self) {
-        let mut lock = self.items.lock().unwrap();
-        lock.fill(Default::default());
-    }
-
-    fn clear_locked(&self, digest: u128, lock: &mut MutexGuard<Vec<Entry>>) {
-        let element = self.get_element(digest, lock);
-        if self.compare(&element, digest) {
-            *element = Default::default();
+        for shard in &self.shards {
+            shard.items.lock().unwrap().fill(Default::default());
         }
     }
 
-    fn get_element<'a>(&self, hash: u128, items: &'a mut MutexGuard<Vec<Entry>>) -> &'a mut Entry {
-        let index = (hash % items.len() as u128) as usize;
-        items.get_mut(index).unwrap()
+    /// Locks the shard which contains the slot of `digest`
+    /// and returns the index of the slot within that shard
+    fn lock_slot(&self, digest: u128) -> (MutexGuard<Vec<Entry>>, usize) {
+        let slot = (digest % self.size as u128) as usize;
+        let shard = &self.shards[slot % self.shards.len()];
+        (shard.items.lock().unwrap(), slot / self.shards.len())
     }
 
     pub fn hash(&self, bytes: &[u8]) -> u128 {
@@ -270,6 +294,36 @@ mod tests {
         assert_eq!(existed, true);
     }
 
+    #[test]
+    fn digests_in_different_shards() {
+        let filter = NetworkFilter::with_shards(StubHasher::default(), 8, 4);
+        for digest in 0..8 {
+            assert_eq!(filter.apply_digest(digest), false);
+        }
+        for digest in 0..8 {
+            assert_eq!(filter.check(digest), true);
+        }
+        // Maps to the same slot as digest 1
+        assert_eq!(filter.apply_digest(9), false);
+        assert_eq!(filter.check(1), false);
+        assert_eq!(filter.check(2), true);
+
+        filter.clear_all();
+        for digest in 0..8 {
+            assert_eq!(filter.check(digest), false);
+        }
+    }
+
+    #[test]
+    fn more_shards_than_slots() {
+        let filter = NetworkFilter::with_shards(StubHasher::default(), 2, 64);
+        assert_eq!(filter.apply_digest(1), false);
+        assert_eq!(filter.apply_digest(2), false);
+        assert_eq!(filter.apply_digest(1), true);
+        assert_eq!(filter.apply_digest(3), false);
+        assert_eq!(filter.check(1), false);
+    }
+
     #[test]
     fn expire() {
         let mut filter = NetworkFilter::with_hasher(StubHasher::default(), 4);
@@ -223,7 +223,21 @@ impl ResponseServer {
 
     fn queue_realtime(&self, message: Message) {
         self.inbound_queue.put(message, self.channel.info.clone());
-        // TODO: Throttle if not added
+    }
+
+    /// Stops reading from the channel while its inbound queue is full. TCP flow
+    /// control then slows down the peer, instead of its messages getting dropped
+    async fn wait_for_inbound_queue(&self) {
+        let channel_id = self.channel.channel_id();
+        if !self.inbound_queue.is_full(channel_id) {
+            return;
+        }
+        self.stats
+            .inc(StatType::MessageProcessor, DetailType::Backpressure);
+        tokio::select! {
+            _ = self.inbound_queue.wait_for_room(channel_id) => {}
+            _ = self.channel.closed() => {}
+        }
     }
 
     fn set_last_keepalive(&self, keepalive: Keepalive) {
@@ -341,6 +355,10 @@ impl ResponseServerExt for Arc<ResponseServer> {
                 break;
             }
 
+            if self.is_realtime_connection() {
+                self.wait_for_inbound_queue().await;
+            }
+
             let result = match message_deserializer.read().await {
                 Ok(msg) => {
                     if first_message {
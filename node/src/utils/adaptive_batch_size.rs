@@ -0,0 +1,207 @@
+use crate::stats::{DetailType, StatType, Stats};
+use std::{
+    sync::{
+        atomic::{AtomicUsize, Ordering},
+        Arc,
+    },
+    time::Duration,
+};
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct AdaptiveBatchConfig {
+    pub min_size: usize,
+    pub max_size: usize,
+    /// How long processing one batch should take.
+    /// For the ledger writers this is the time the write lock is held
+    pub target_time: Duration,
+}
+
+impl AdaptiveBatchConfig {
+    pub const fn new(min_size: usize, max_size: usize, target_time: Duration) -> Self {
+        Self {
+            min_size,
+            max_size,
+            target_time,
+        }
+    }
+
+    /// A fixed batch size, which never adapts
+    pub const fn fixed(size: usize) -> Self {
+        Self::new(size, size, Duration::MAX)
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum BatchAdjustment {
+    Grow,
+    Shrink,
+    Keep,
+}
+
+/// Sizes the batches of a processing loop so that a batch takes about the target time.
+/// Batches shrink right away when they take too long, but grow slowly, only after
+/// full batches finished quickly or the queued items had to wait for too long.
+pub struct AdaptiveBatchSize {
+    config: AdaptiveBatchConfig,
+    current: AtomicUsize,
+    stats: Arc<Stats>,
+    /// Identifies the loop in the batch_grow/batch_shrink stats
+    detail: DetailType,
+}
+
+impl AdaptiveBatchSize {
+    pub fn new(config: AdaptiveBatchConfig, stats: Arc<Stats>, detail: DetailType) -> Self {
+        let config = AdaptiveBatchConfig {
+            min_size: config.min_size.clamp(1, config.max_size.max(1)),
+            max_size: config.max_size.max(1),
+            ..config
+        };
+        Self {
+            current: AtomicUsize::new(config.max_size),
+            config,
+            stats,
+            detail,
+        }
+    }
+
+    pub fn current(&self) -> usize {
+        self.current.load(Ordering::Relaxed)
+    }
+
+    pub fn config(&self) -> &AdaptiveBatchConfig {
+        &self.config
+    }
+
+    /// Adjusts the batch size after `len` items were processed in `elapsed`.
+    /// `queue_latency` is how long the oldest item of the batch waited in the queue
+    pub fn update(
+        &self,
+        len: usize,
+        elapsed: Duration,
+        queue_latency: Option<Duration>,
+    ) -> BatchAdjustment {
+        let current = self.current();
+        let target = self.config.target_time;
+
+        let next = if elapsed > target && current > self.config.min_size {
+            // Scale down to the size which would have met the target,
+            // but at most halve it, so that a single outlier can't collapse the size
+            let fitting = (len as u128 * target.as_nanos() / elapsed.as_nanos().max(1)) as usize;
+            fitting.max(current / 2).max(self.config.min_size)
+        } else if len >= current && current < self.config.max_size {
+            let fast = elapsed < target / 2;
+            let backlogged = elapsed < target && queue_latency.is_some_and(|l| l > target);
+            if fast || backlogged {
+                (current + (current / 8).max(1)).min(self.config.max_size)
+            } else {
+                current
+            }
+        } else {
+            current
+        };
+
+        let adjustment = if next > current {
+            self.stats.inc(StatType::BatchGrow, self.detail);
+            BatchAdjustment::Grow
+        } else if next < current {
+            self.stats.inc(StatType::BatchShrink, self.detail);
+            BatchAdjustment::Shrink
+        } else {
+            BatchAdjustment::Keep
+        };
+        self.current.store(next, Ordering::Relaxed);
+        adjustment
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stats::Direction;
+
+    fn create(min_size: usize, max_size: usize) -> AdaptiveBatchSize {
+        AdaptiveBatchSize::new(
+            AdaptiveBatchConfig::new(min_size, max_size, Duration::from_millis(100)),
+            Arc::new(Stats::default()),
+            DetailType::Live,
+        )
+    }
+
+    #[test]
+    fn start_with_max_size() {
+        assert_eq!(create(16, 256).current(), 256);
+    }
+
+    #[test]
+    fn shrink_when_batch_takes_too_long() {
+        let batch_size = create(16, 256);
+        let adjustment = batch_size.update(256, Duration::from_millis(160), None);
+        assert_eq!(adjustment, BatchAdjustment::Shrink);
+        assert_eq!(batch_size.current(), 160);
+        assert_eq!(
+            batch_size
+                .stats
+                .count(StatType::BatchShrink, DetailType::Live, Direction::In),
+            1
+        );
+    }
+
+    #[test]
+    fn shrink_at_most_by_half() {
+        let batch_size = create(16, 256);
+        batch_size.update(256, Duration::from_secs(10), None);
+        assert_eq!(batch_size.current(), 128);
+        for _ in 0..10 {
+            batch_size.update(128, Duration::from_secs(10), None);
+        }
+        assert_eq!(batch_size.current(), 16);
+    }
+
+    #[test]
+    fn grow_after_fast_full_batch() {
+        let batch_size = create(16, 256);
+        batch_size.update(256, Duration::from_secs(1), None);
+        assert_eq!(batch_size.current(), 128);
+
+        let adjustment = batch_size.update(128, Duration::from_millis(10), None);
+        assert_eq!(adjustment, BatchAdjustment::Grow);
+        assert_eq!(batch_size.current(), 144);
+    }
+
+    #[test]
+    fn keep_size_when_batch_is_not_full() {
+        let batch_size = create(16, 256);
+        batch_size.update(256, Duration::from_secs(1), None);
+        let adjustment = batch_size.update(10, Duration::from_millis(1), None);
+        assert_eq!(adjustment, BatchAdjustment::Keep);
+        assert_eq!(batch_size.current(), 128);
+    }
+
+    #[test]
+    fn grow_when_queue_is_backlogged() {
+        let batch_size = create(16, 256);
+        batch_size.update(256, Duration::from_secs(1), None);
+
+        let elapsed = Duration::from_millis(80);
+        assert_eq!(
+            batch_size.update(128, elapsed, Some(Duration::from_millis(10))),
+            BatchAdjustment::Keep
+        );
+        assert_eq!(
+            batch_size.update(128, elapsed, Some(Duration::from_secs(1))),
+            BatchAdjustment::Grow
+        );
+    }
+
+    #[test]
+    fn fixed_size() {
+        let batch_size = AdaptiveBatchSize::new(
+            AdaptiveBatchConfig::fixed(64),
+            Arc::new(Stats::default()),
+            DetailType::Live,
+        );
+        batch_size.update(64, Duration::from_secs(100), None);
+        batch_size.update(64, Duration::ZERO, None);
+        assert_eq!(batch_size.current(), 64);
+    }
+}
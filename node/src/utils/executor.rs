@@ -0,0 +1,839 @@
+use super::{ThreadPool, Timer};
+use crate::stats::{LatencyHistogram, LatencySummary};
+use rsban_core::utils::ContainerInfo;
+use std::{
+    cell::Cell,
+    collections::VecDeque,
+    mem::size_of,
+    panic::{catch_unwind, AssertUnwindSafe},
+    sync::{
+        atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering},
+        Arc, Condvar, Mutex, Weak,
+    },
+    thread::JoinHandle,
+    time::{Duration, Instant},
+};
+use strum::IntoEnumIterator;
+use strum_macros::EnumIter;
+use tracing::error;
+
+/// Workers always look for tasks of a higher priority first
+#[derive(Clone, Copy, PartialEq, Eq, Debug, EnumIter)]
+pub enum TaskPriority {
+    /// Batches which write to the ledger, like the block processor's
+    LedgerWrite,
+    /// Resolves the dependencies of the blocks which get cemented next
+    Cementing,
+    Votes,
+    Bootstrap,
+    Housekeeping,
+}
+
+impl TaskPriority {
+    pub const COUNT: usize = TaskPriority::Housekeeping as usize + 1;
+
+    pub fn as_str(&self) -> &'static str {
+        match self {
+            TaskPriority::LedgerWrite => "ledger_write",
+            TaskPriority::Cementing => "cementing",
+            TaskPriority::Votes => "votes",
+            TaskPriority::Bootstrap => "bootstrap",
+            TaskPriority::Housekeeping => "housekeeping",
+        }
+    }
+}
+
+#[derive(Clone, Debug, PartialEq)]
+pub struct ExecutorConfig {
+    pub threads: usize,
+    /// Maximum number of threads which may run tasks of a priority at the same time.
+    /// This keeps blocking tasks of one priority from occupying all threads.
+    pub max_running: [usize; TaskPriority::COUNT],
+}
+
+impl ExecutorConfig {
+    /// One thread per core
+    pub fn new() -> Self {
+        let threads = std::thread::available_parallelism()
+            .map(|i| i.get())
+            .unwrap_or(4)
+            .max(2);
+        Self {
+            threads,
+            max_running: [threads; TaskPriority::COUNT],
+        }
+    }
+
+    /// Adds threads if needed, so that the priority can run `max` tasks
+    /// and still leave a thread for the other priorities
+    pub fn max_running(mut self, priority: TaskPriority, max: usize) -> Self {
+        self.max_running[priority as usize] = max;
+        self.threads = self.threads.max(max + 1);
+        self
+    }
+}
+
+impl Default for ExecutorConfig {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Per priority metrics
+#[derive(Clone, Debug, PartialEq)]
+pub struct ExecutorMetrics {
+    pub priority: TaskPriority,
+    pub queued: usize,
+    pub executed: u64,
+    /// Total CPU time the threads spent in tasks of this priority.
+    /// Time the tasks were blocked is not included
+    pub task_cpu_time: Duration,
+    /// Time from submitting a task until a thread started it
+    pub queue_delay: LatencySummary,
+}
+
+type Task = Box<dyn FnOnce() + Send>;
+
+thread_local! {
+    /// Waiting for the executor on one of its own threads would dead lock
+    static IS_EXECUTOR_THREAD: Cell<bool> = const { Cell::new(false) };
+}
+
+struct QueuedTask {
+    task: Task,
+    enqueued: Instant,
+}
+
+/// A work stealing thread pool with priority classes. It runs the worker pools of
+/// the node and the batch loops of the block processor and vote processor,
+/// see [`BatchLoop`]. Tasks are submitted to a global queue per priority.
+/// Workers move tasks in batches to their local queues and steal from the
+/// local queues of other workers when they run out of work.
+pub struct Executor {
+    shared: Arc<Shared>,
+    threads: Mutex<Vec<JoinHandle<()>>>,
+}
+
+impl Executor {
+    pub fn new(config: ExecutorConfig) -> Self {
+        let threads = config.threads.max(1);
+        let classes = TaskPriority::iter()
+            .map(|priority| {
+                // Leave a thread for the other priorities, unless there is only one thread
+                let max_running = config.max_running[priority as usize]
+                    .min(threads.saturating_sub(1))
+                    .max(1);
+                PriorityClass {
+                    injector: Mutex::new(VecDeque::new()),
+                    locals: (0..threads).map(|_| Mutex::new(VecDeque::new())).collect(),
+                    max_running,
+                    running: AtomicUsize::new(0),
+                    queued: AtomicUsize::new(0),
+                    executed: AtomicU64::new(0),
+                    cpu_micros: AtomicU64::new(0),
+                    queue_delay: LatencyHistogram::new(),
+                }
+            })
+            .collect();
+
+        let shared = Arc::new(Shared {
+            classes,
+            stopped: AtomicBool::new(false),
+            mutex: Mutex::new(()),
+            condition: Condvar::new(),
+            drained: Condvar::new(),
+        });
+
+        let handles = (0..threads)
+            .map(|index| {
+                let shared = shared.clone();
+                std::thread::Builder::new()
+                    .name("Executor".to_string())
+                    .spawn(move || shared.run(index))
+                    .unwrap()
+            })
+            .collect();
+
+        Self {
+            shared,
+            threads: Mutex::new(handles),
+        }
+    }
+
+    pub fn new_test_instance() -> Self {
+        Self::new(ExecutorConfig {
+            threads: 2,
+            max_running: [2; TaskPriority::COUNT],
+        })
+    }
+
+    pub fn submit(&self, priority: TaskPriority, task: Box<dyn FnOnce() + Send>) {
+        self.submit_batch(priority, vec![task]);
+    }
+
+    /// Submits all tasks at once, which wakes up as many threads as there are tasks
+    pub fn submit_batch(&self, priority: TaskPriority, tasks: Vec<Box<dyn FnOnce() + Send>>) {
+        if self.shared.stopped.load(Ordering::SeqCst) || tasks.is_empty() {
+            return;
+        }
+        let class = self.shared.class(priority);
+        let enqueued = Instant::now();
+        let count = tasks.len();
+        class
+            .injector
+            .lock()
+            .unwrap()
+            .extend(tasks.into_iter().map(|task| QueuedTask { task, enqueued }));
+        class.queued.fetch_add(count, Ordering::SeqCst);
+        self.shared.wake(count);
+    }
+
+    pub fn queued(&self, priority: TaskPriority) -> usize {
+        self.shared.class(priority).queued.load(Ordering::SeqCst)
+    }
+
+    /// Waits until all submitted tasks of the priority are done
+    pub fn drain(&self, priority: TaskPriority) {
+        if IS_EXECUTOR_THREAD.get() {
+            return;
+        }
+        let class = self.shared.class(priority);
+        let guard = self.shared.mutex.lock().unwrap();
+        drop(
+            self.shared
+                .drained
+                .wait_while(guard, |_| {
+                    !self.shared.stopped.load(Ordering::SeqCst) && !class.is_idle()
+                })
+                .unwrap(),
+        );
+    }
+
+    pub fn stop(&self) {
+        self.shared.stopped.store(true, Ordering::SeqCst);
+        {
+            let _guard = self.shared.mutex.lock().unwrap();
+            self.shared.condition.notify_all();
+            self.shared.drained.notify_all();
+        }
+        if IS_EXECUTOR_THREAD.get() {
+            return;
+        }
+        let threads = std::mem::take(&mut *self.threads.lock().unwrap());
+        for thread in threads {
+            thread.join().unwrap();
+        }
+    }
+
+    pub fn metrics(&self) -> Vec<ExecutorMetrics> {
+        TaskPriority::iter()
+            .map(|priority| {
+                let class = self.shared.class(priority);
+                ExecutorMetrics {
+                    priority,
+                    queued: class.queued.load(Ordering::Relaxed),
+                    executed: class.executed.load(Ordering::Relaxed),
+                    task_cpu_time: Duration::from_micros(class.cpu_micros.load(Ordering::Relaxed)),
+                    queue_delay: class.queue_delay.summary(),
+                }
+            })
+            .collect()
+    }
+
+    pub fn container_info(&self) -> ContainerInfo {
+        let mut builder = ContainerInfo::builder();
+        for priority in TaskPriority::iter() {
+            builder = builder.leaf(
+                priority.as_str(),
+                self.queued(priority),
+                size_of::<QueuedTask>(),
+            );
+        }
+        builder.finish()
+    }
+}
+
+impl Drop for Executor {
+    fn drop(&mut self) {
+        self.stop();
+    }
+}
+
+struct PriorityClass {
+    injector: Mutex<VecDeque<QueuedTask>>,
+    /// The local queue of each worker
+    locals: Vec<Mutex<VecDeque<QueuedTask>>>,
+    max_running: usize,
+    running: AtomicUsize,
+    queued: AtomicUsize,
+    executed: AtomicU64,
+    cpu_micros: AtomicU64,
+    queue_delay: LatencyHistogram,
+}
+
+impl PriorityClass {
+    fn try_acquire(&self) -> bool {
+        self.running
+            .fetch_update(Ordering::SeqCst, Ordering::SeqCst, |running| {
+                (running < self.max_running).then_some(running + 1)
+            })
+            .is_ok()
+    }
+
+    fn release(&self) {
+        self.running.fetch_sub(1, Ordering::SeqCst);
+    }
+
+    fn is_idle(&self) -> bool {
+        self.queued.load(Ordering::SeqCst) == 0 && self.running.load(Ordering::SeqCst) == 0
+    }
+
+    fn is_runnable(&self) -> bool {
+        self.queued.load(Ordering::SeqCst) > 0
+            && self.running.load(Ordering::SeqCst) < self.max_running
+    }
+
+    /// Maximum number of tasks which a worker moves from the global to its local queue
+    const MAX_LOCAL_BATCH: usize = 32;
+
+    fn find_task(&self, index: usize) -> Option<QueuedTask> {
+        let mut local = self.locals[index].lock().unwrap();
+        if let Some(task) = local.pop_front() {
+            return Some(task);
+        }
+
+        {
+            // Take a fair share of the global queue, so the other workers find tasks too
+            let mut injector = self.injector.lock().unwrap();
+            if let Some(task) = injector.pop_front() {
+                let batch = (injector.len() / self.locals.len()).min(Self::MAX_LOCAL_BATCH);
+                local.extend(injector.drain(..batch));
+                return Some(task);
+            }
+        }
+        drop(local);
+
+        for i in (1..self.locals.len()).map(|offset| (index + offset) % self.locals.len()) {
+            if let Some(task) = self.locals[i].lock().unwrap().pop_back() {
+                return Some(task);
+            }
+        }
+        None
+    }
+}
+
+struct Shared {
+    classes: Vec<PriorityClass>,
+    stopped: AtomicBool,
+    mutex: Mutex<()>,
+    condition: Condvar,
+    /// Notified when a priority ran out of tasks, for `Executor::drain`
+    drained: Condvar,
+}
+
+impl Shared {
+    /// Sleeping threads wake up regularly, in case a wake up got lost
+    const IDLE_TIMEOUT: Duration = Duration::from_millis(100);
+
+    fn class(&self, priority: TaskPriority) -> &PriorityClass {
+        &self.classes[priority as usize]
+    }
+
+    fn wake(&self, count: usize) {
+        let _guard = self.mutex.lock().unwrap();
+        if count == 1 {
+            self.condition.notify_one();
+        } else {
+            self.condition.notify_all();
+        }
+    }
+
+    fn run(&self, index: usize) {
+        IS_EXECUTOR_THREAD.set(true);
+        while !self.stopped.load(Ordering::SeqCst) {
+            if self.run_next(index) {
+                continue;
+            }
+            let guard = self.mutex.lock().unwrap();
+            if self.stopped.load(Ordering::SeqCst)
+                || self.classes.iter().any(|class| class.is_runnable())
+            {
+                continue;
+            }
+            drop(
+                self.condition
+                    .wait_timeout(guard, Self::IDLE_TIMEOUT)
+                    .unwrap(),
+            );
+        }
+    }
+
+    /// Runs the next task of the highest priority which has work. Returns false if there was no task
+    fn run_next(&self, index: usize) -> bool {
+        for class in &self.classes {
+            if !class.try_acquire() {
+                continue;
+            }
+            let Some(queued) = class.find_task(index) else {
+                class.release();
+                continue;
+            };
+            class.queued.fetch_sub(1, Ordering::SeqCst);
+
+            class
+                .queue_delay
+                .record(Instant::now().saturating_duration_since(queued.enqueued));
+            let cpu_start = thread_cpu_time();
+            if catch_unwind(AssertUnwindSafe(queued.task)).is_err() {
+                error!("Executor task panicked");
+            }
+            class.cpu_micros.fetch_add(
+                thread_cpu_time().saturating_sub(cpu_start).as_micros() as u64,
+                Ordering::Relaxed,
+            );
+            class.executed.fetch_add(1, Ordering::Relaxed);
+            class.release();
+
+            if class.is_idle() {
+                let _guard = self.mutex.lock().unwrap();
+                self.drained.notify_all();
+            }
+
+            // Another thread may have skipped the priority, because it was at its limit
+            if class.is_runnable() {
+                self.wake(1);
+            }
+            return true;
+        }
+        false
+    }
+}
+
+/// CPU time consumed by the current thread
+fn thread_cpu_time() -> Duration {
+    let mut time = libc::timespec {
+        tv_sec: 0,
+        tv_nsec: 0,
+    };
+    // SAFETY: `time` is a valid timespec and the clock id is supported on all unix systems
+    let result = unsafe { libc::clock_gettime(libc::CLOCK_THREAD_CPUTIME_ID, &mut time) };
+    if result != 0 {
+        return Duration::ZERO;
+    }
+    Duration::new(time.tv_sec as u64, time.tv_nsec as u32)
+}
+
+/// Runs a batch loop on the executor instead of a dedicated thread.
+/// `run_batch` processes one batch, if there is one, and returns true if more
+/// work is left. Whenever the component gets new work it calls `notify`, which
+/// submits a task unless `max_running` batches are already running.
+/// Tasks resubmit themselves while there is work, so other tasks of the
+/// same priority get a turn between batches.
+pub struct BatchLoop {
+    executor: Weak<Executor>,
+    priority: TaskPriority,
+    max_running: usize,
+    run_batch: Box<dyn Fn() -> bool + Send + Sync>,
+    running: AtomicUsize,
+    /// Set by `notify`, so that a finishing batch looks for work again
+    pending: AtomicBool,
+    stopped: AtomicBool,
+    idle: Mutex<()>,
+    idle_condition: Condvar,
+}
+
+impl BatchLoop {
+    pub fn new(
+        executor: &Arc<Executor>,
+        priority: TaskPriority,
+        max_running: usize,
+        run_batch: Box<dyn Fn() -> bool + Send + Sync>,
+    ) -> Arc<Self> {
+        Arc::new(Self {
+            executor: Arc::downgrade(executor),
+            priority,
+            max_running: max_running.max(1),
+            run_batch,
+            running: AtomicUsize::new(0),
+            pending: AtomicBool::new(false),
+            stopped: AtomicBool::new(false),
+            idle: Mutex::new(()),
+            idle_condition: Condvar::new(),
+        })
+    }
+
+    /// Called when there is new work
+    pub fn notify(self: &Arc<Self>) {
+        self.pending.store(true, Ordering::SeqCst);
+        self.submit(1);
+    }
+
+    /// Waits for the running batches. No further batches are started
+    pub fn stop(&self) {
+        self.stopped.store(true, Ordering::SeqCst);
+        let mut guard = self.idle.lock().unwrap();
+        // Batches which are still queued when the executor stops never run
+        while self.running.load(Ordering::SeqCst) > 0 && !self.executor_stopped() {
+            guard = self
+                .idle_condition
+                .wait_timeout(guard, Shared::IDLE_TIMEOUT)
+                .unwrap()
+                .0;
+        }
+    }
+
+    fn executor_stopped(&self) -> bool {
+        self.executor.upgrade().map_or(true, |executor| {
+            executor.shared.stopped.load(Ordering::SeqCst)
+        })
+    }
+
+    /// Submits up to `count` batches, as far as the limit allows
+    fn submit(self: &Arc<Self>, count: usize) {
+        if self.stopped.load(Ordering::SeqCst) {
+            return;
+        }
+        let Some(executor) = self.executor.upgrade() else {
+            return;
+        };
+        let mut tasks: Vec<Box<dyn FnOnce() + Send>> = Vec::new();
+        while tasks.len() < count && self.try_acquire() {
+            let batch_loop = Arc::clone(self);
+            tasks.push(Box::new(move || batch_loop.run()));
+        }
+        if !tasks.is_empty() {
+            self.pending.store(false, Ordering::SeqCst);
+            executor.submit_batch(self.priority, tasks);
+        }
+    }
+
+    fn try_acquire(&self) -> bool {
+        self.running
+            .fetch_update(Ordering::SeqCst, Ordering::SeqCst, |running| {
+                (running < self.max_running).then_some(running + 1)
+            })
+            .is_ok()
+    }
+
+    fn release(&self) {
+        if self.running.fetch_sub(1, Ordering::SeqCst) == 1 {
+            let _guard = self.idle.lock().unwrap();
+            self.idle_condition.notify_all();
+        }
+    }
+
+    fn run(self: Arc<Self>) {
+        let more = !self.stopped.load(Ordering::SeqCst) && (self.run_batch)();
+        self.release();
+        if more {
+            // Use all free slots while a backlog is left
+            self.submit(self.max_running);
+        } else if self.pending.load(Ordering::SeqCst) {
+            self.submit(1);
+        }
+    }
+}
+
+/// Runs the tasks of one priority on the shared executor.
+/// The lane counts its own tasks, so that stopping it doesn't wait for
+/// other components which run on the same priority
+pub struct ExecutorLane {
+    executor: Arc<Executor>,
+    priority: TaskPriority,
+    timer: Mutex<Timer>,
+    stopped: Arc<AtomicBool>,
+    tasks: Arc<LaneTasks>,
+}
+
+impl ExecutorLane {
+    pub fn new(executor: Arc<Executor>, priority: TaskPriority) -> Self {
+        Self {
+            executor,
+            priority,
+            timer: Mutex::new(Timer::new()),
+            stopped: Arc::new(AtomicBool::new(false)),
+            tasks: Arc::new(LaneTasks::default()),
+        }
+    }
+}
+
+impl ThreadPool for ExecutorLane {
+    fn push_task(&self, callback: Box<dyn FnOnce() + Send>) {
+        if !self.stopped.load(Ordering::SeqCst) {
+            self.executor
+                .submit(self.priority, self.tasks.track(callback));
+        }
+    }
+
+    fn add_delayed_task(&self, delay: Duration, callback: Box<dyn FnOnce() + Send>) {
+        if self.stopped.load(Ordering::SeqCst) {
+            return;
+        }
+        let executor = Arc::downgrade(&self.executor);
+        let priority = self.priority;
+        let stopped = self.stopped.clone();
+        let tasks = self.tasks.clone();
+        let mut callback = Some(callback);
+        self.timer.lock().unwrap().schedule_with_delay(
+            chrono::Duration::from_std(delay).unwrap(),
+            move || {
+                if stopped.load(Ordering::SeqCst) {
+                    return;
+                }
+                if let (Some(executor), Some(cb)) = (executor.upgrade(), callback.take()) {
+                    executor.submit(priority, tasks.track(cb));
+                }
+            },
+        );
+    }
+
+    /// Waits for the submitted tasks of this lane like `ThreadPoolImpl::stop`
+    fn stop(&self) {
+        if !self.stopped.swap(true, Ordering::SeqCst) {
+            self.tasks.wait_idle(&self.executor);
+        }
+    }
+
+    fn num_queued_tasks(&self) -> usize {
+        self.executor.queued(self.priority)
+    }
+}
+
+/// The tasks of a lane which were submitted to the executor and didn't finish yet
+#[derive(Default)]
+struct LaneTasks {
+    in_flight: Mutex<usize>,
+    idle: Condvar,
+}
+
+impl LaneTasks {
+    fn track(self: &Arc<Self>, callback: Box<dyn FnOnce() + Send>) -> Box<dyn FnOnce() + Send> {
+        *self.in_flight.lock().unwrap() += 1;
+        // Also counts the task as done if it panics or is dropped without running
+        let done = LaneTaskDone(Arc::clone(self));
+        Box::new(move || {
+            let _done = done;
+            callback();
+        })
+    }
+
+    fn wait_idle(&self, executor: &Executor) {
+        if IS_EXECUTOR_THREAD.get() {
+            return;
+        }
+        let mut in_flight = self.in_flight.lock().unwrap();
+        // Tasks which are still queued when the executor stops never run
+        while *in_flight > 0 && !executor.shared.stopped.load(Ordering::SeqCst) {
+            in_flight = self
+                .idle
+                .wait_timeout(in_flight, Shared::IDLE_TIMEOUT)
+                .unwrap()
+                .0;
+        }
+    }
+}
+
+struct LaneTaskDone(Arc<LaneTasks>);
+
+impl Drop for LaneTaskDone {
+    fn drop(&mut self) {
+        let mut in_flight = self.0.in_flight.lock().unwrap();
+        *in_flight -= 1;
+        if *in_flight == 0 {
+            self.0.idle.notify_all();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::mpsc::channel;
+
+    #[test]
+    fn run_task() {
+        let executor = Executor::new_test_instance();
+        let (tx, rx) = channel();
+        executor.submit(
+            TaskPriority::Housekeeping,
+            Box::new(move || tx.send(42).unwrap()),
+        );
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)), Ok(42));
+    }
+
+    #[test]
+    fn run_batch() {
+        let executor = Executor::new_test_instance();
+        let (tx, rx) = channel();
+        let tasks: Vec<Box<dyn FnOnce() + Send>> = (0..100)
+            .map(|i| {
+                let tx = tx.clone();
+                Box::new(move || tx.send(i).unwrap()) as Box<dyn FnOnce() + Send>
+            })
+            .collect();
+        executor.submit_batch(TaskPriority::Votes, tasks);
+
+        let mut results: Vec<i32> = (0..100)
+            .map(|_| rx.recv_timeout(Duration::from_secs(5)).unwrap())
+            .collect();
+        results.sort();
+        assert_eq!(results, (0..100).collect::<Vec<_>>());
+
+        executor.drain(TaskPriority::Votes);
+        let metrics = &executor.metrics()[TaskPriority::Votes as usize];
+        assert_eq!(metrics.priority, TaskPriority::Votes);
+        assert_eq!(metrics.executed, 100);
+        assert_eq!(metrics.queued, 0);
+        assert_eq!(metrics.queue_delay.count, 100);
+    }
+
+    #[test]
+    fn limit_running_tasks_per_priority() {
+        let executor = Executor::new(ExecutorConfig {
+            threads: 3,
+            max_running: [1; TaskPriority::COUNT],
+        });
+        let running = Arc::new(AtomicUsize::new(0));
+        let max_seen = Arc::new(AtomicUsize::new(0));
+        let tasks: Vec<Box<dyn FnOnce() + Send>> = (0..10)
+            .map(|_| {
+                let running = running.clone();
+                let max_seen = max_seen.clone();
+                Box::new(move || {
+                    let now = running.fetch_add(1, Ordering::SeqCst) + 1;
+                    max_seen.fetch_max(now, Ordering::SeqCst);
+                    std::thread::sleep(Duration::from_millis(1));
+                    running.fetch_sub(1, Ordering::SeqCst);
+                }) as Box<dyn FnOnce() + Send>
+            })
+            .collect();
+        executor.submit_batch(TaskPriority::Bootstrap, tasks);
+        executor.drain(TaskPriority::Bootstrap);
+        assert_eq!(max_seen.load(Ordering::SeqCst), 1);
+    }
+
+    #[test]
+    fn add_threads_for_max_running() {
+        let config = ExecutorConfig {
+            threads: 2,
+            max_running: [1; TaskPriority::COUNT],
+        }
+        .max_running(TaskPriority::Housekeeping, 4)
+        .max_running(TaskPriority::Votes, 1);
+        assert_eq!(config.threads, 5);
+    }
+
+    #[test]
+    fn survive_panicking_task() {
+        let executor = Executor::new(ExecutorConfig {
+            threads: 1,
+            max_running: [1; TaskPriority::COUNT],
+        });
+        executor.submit(TaskPriority::Housekeeping, Box::new(|| panic!("test")));
+        let (tx, rx) = channel();
+        executor.submit(
+            TaskPriority::Housekeeping,
+            Box::new(move || tx.send(1).unwrap()),
+        );
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)), Ok(1));
+    }
+
+    #[test]
+    fn batch_loop_runs_until_work_is_done() {
+        let executor = Arc::new(Executor::new_test_instance());
+        let remaining = Arc::new(AtomicUsize::new(5));
+        let (tx, rx) = channel();
+        let batch_loop = BatchLoop::new(&executor, TaskPriority::LedgerWrite, 1, {
+            let remaining = remaining.clone();
+            Box::new(move || {
+                let left = remaining.fetch_sub(1, Ordering::SeqCst) - 1;
+                if left == 0 {
+                    tx.send(()).unwrap();
+                }
+                left > 0
+            })
+        });
+
+        batch_loop.notify();
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)), Ok(()));
+        executor.drain(TaskPriority::LedgerWrite);
+        batch_loop.stop();
+        assert_eq!(remaining.load(Ordering::SeqCst), 0);
+        assert_eq!(
+            executor.metrics()[TaskPriority::LedgerWrite as usize].executed,
+            5
+        );
+    }
+
+    #[test]
+    fn batch_loop_limits_running_batches() {
+        let executor = Arc::new(Executor::new(ExecutorConfig {
+            threads: 4,
+            max_running: [4; TaskPriority::COUNT],
+        }));
+        let running = Arc::new(AtomicUsize::new(0));
+        let max_seen = Arc::new(AtomicUsize::new(0));
+        let batches = Arc::new(AtomicUsize::new(20));
+        let batch_loop = BatchLoop::new(&executor, TaskPriority::Votes, 2, {
+            let running = running.clone();
+            let max_seen = max_seen.clone();
+            let batches = batches.clone();
+            Box::new(move || {
+                let now = running.fetch_add(1, Ordering::SeqCst) + 1;
+                max_seen.fetch_max(now, Ordering::SeqCst);
+                std::thread::sleep(Duration::from_millis(1));
+                running.fetch_sub(1, Ordering::SeqCst);
+                batches
+                    .fetch_update(Ordering::SeqCst, Ordering::SeqCst, |i| i.checked_sub(1))
+                    .is_ok_and(|i| i > 1)
+            })
+        });
+
+        for _ in 0..10 {
+            batch_loop.notify();
+        }
+        executor.drain(TaskPriority::Votes);
+        batch_loop.stop();
+        assert_eq!(batches.load(Ordering::SeqCst), 0);
+        assert!(max_seen.load(Ordering::SeqCst) <= 2);
+    }
+
+    #[test]
+    fn lane_stop_waits_for_tasks() {
+        let executor = Arc::new(Executor::new_test_instance());
+        let lane = ExecutorLane::new(executor.clone(), TaskPriority::Housekeeping);
+        let done = Arc::new(AtomicBool::new(false));
+        let done2 = done.clone();
+        lane.push_task(Box::new(move || {
+            std::thread::sleep(Duration::from_millis(10));
+            done2.store(true, Ordering::SeqCst);
+        }));
+        lane.stop();
+        assert!(done.load(Ordering::SeqCst));
+
+        // Tasks are ignored after stop
+        lane.push_task(Box::new(|| panic!("must not run")));
+        assert_eq!(lane.num_queued_tasks(), 0);
+    }
+
+    #[test]
+    fn lane_stop_ignores_other_tasks_of_the_priority() {
+        let executor = Arc::new(Executor::new_test_instance());
+        let lane = ExecutorLane::new(executor.clone(), TaskPriority::Housekeeping);
+        let (release_tx, release_rx) = channel::<()>();
+        executor.submit(
+            TaskPriority::Housekeeping,
+            Box::new(move || {
+                let _ = release_rx.recv_timeout(Duration::from_secs(5));
+            }),
+        );
+        let (tx, rx) = channel();
+        lane.push_task(Box::new(move || tx.send(1).unwrap()));
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)), Ok(1));
+
+        let start = Instant::now();
+        lane.stop();
+        assert!(start.elapsed() < Duration::from_secs(1));
+        release_tx.send(()).unwrap();
+    }
+}
@@ -0,0 +1,195 @@
+use std::{
+    collections::hash_map::RandomState,
+    hash::{BuildHasher, Hash},
+};
+
+const EMPTY: u32 = u32::MAX;
+
+/// An open addressing hash table with linear probing, which maps keys to slot
+/// numbers of a fixed size slab. The keys are stored inline in the buckets, so
+/// a lookup touches a single contiguous memory region and never allocates.
+/// The table is sized for a load factor of at most 50%.
+pub(crate) struct FixedHashIndex<K> {
+    buckets: Box<[Bucket<K>]>,
+    mask: usize,
+    len: usize,
+    /// Randomly seeded, so that peers cannot craft colliding keys
+    hasher: RandomState,
+}
+
+#[derive(Clone)]
+struct Bucket<K> {
+    key: K,
+    slot: u32,
+}
+
+impl<K> FixedHashIndex<K>
+where
+    K: Clone + Default + Eq + Hash,
+{
+    pub fn new(max_len: usize) -> Self {
+        assert!(max_len < EMPTY as usize);
+        let capacity = (max_len.max(1) * 2).next_power_of_two();
+        Self {
+            buckets: vec![
+                Bucket {
+                    key: K::default(),
+                    slot: EMPTY
+                };
+                capacity
+            ]
+            .into_boxed_slice(),
+            mask: capacity - 1,
+            len: 0,
+            hasher: RandomState::new(),
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn get(&self, key: &K) -> Option<u32> {
+        self.find(key).map(|i| self.buckets[i].slot)
+    }
+
+    /// Inserts or overwrites the slot of the key
+    pub fn insert(&mut self, key: K, slot: u32) {
+        debug_assert!(slot != EMPTY);
+        let mut i = self.home(&key);
+        loop {
+            let bucket = &mut self.buckets[i];
+            if bucket.slot == EMPTY {
+                debug_assert!(self.len < self.mask, "index is full");
+                *bucket = Bucket { key, slot };
+                self.len += 1;
+                return;
+            }
+            if bucket.key == key {
+                bucket.slot = slot;
+                return;
+            }
+            i = (i + 1) & self.mask;
+        }
+    }
+
+    pub fn remove(&mut self, key: &K) -> Option<u32> {
+        let mut hole = self.find(key)?;
+        let removed = self.buckets[hole].slot;
+        self.len -= 1;
+
+        // Backward shift deletion: move following entries of the same probe
+        // sequence into the hole, so that no tombstones are needed
+        let mut i = hole;
+        loop {
+            i = (i + 1) & self.mask;
+            if self.buckets[i].slot == EMPTY {
+                break;
+            }
+            let home = self.home(&self.buckets[i].key);
+            let distance_to_home = i.wrapping_sub(home) & self.mask;
+            let distance_to_hole = i.wrapping_sub(hole) & self.mask;
+            if distance_to_home >= distance_to_hole {
+                self.buckets.swap(hole, i);
+                hole = i;
+            }
+        }
+        self.buckets[hole] = Bucket {
+            key: K::default(),
+            slot: EMPTY,
+        };
+        Some(removed)
+    }
+
+    pub fn clear(&mut self) {
+        for bucket in self.buckets.iter_mut() {
+            bucket.slot = EMPTY;
+            bucket.key = K::default();
+        }
+        self.len = 0;
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.buckets.len()
+    }
+
+    pub const fn bucket_size() -> usize {
+        std::mem::size_of::<Bucket<K>>()
+    }
+
+    fn find(&self, key: &K) -> Option<usize> {
+        let mut i = self.home(key);
+        loop {
+            let bucket = &self.buckets[i];
+            if bucket.slot == EMPTY {
+                return None;
+            }
+            if bucket.key == *key {
+                return Some(i);
+            }
+            i = (i + 1) & self.mask;
+        }
+    }
+
+    fn home(&self, key: &K) -> usize {
+        self.hasher.hash_one(key) as usize & self.mask
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use rsban_core::BlockHash;
+
+    #[test]
+    fn empty() {
+        let index = FixedHashIndex::<BlockHash>::new(4);
+        assert_eq!(index.len(), 0);
+        assert_eq!(index.capacity(), 8);
+        assert_eq!(index.get(&BlockHash::from(1)), None);
+    }
+
+    #[test]
+    fn insert_get_and_remove() {
+        let mut index = FixedHashIndex::new(4);
+        index.insert(BlockHash::from(1), 10);
+        index.insert(BlockHash::from(2), 20);
+        assert_eq!(index.len(), 2);
+        assert_eq!(index.get(&BlockHash::from(1)), Some(10));
+        assert_eq!(index.get(&BlockHash::from(2)), Some(20));
+
+        index.insert(BlockHash::from(1), 11);
+        assert_eq!(index.len(), 2);
+        assert_eq!(index.get(&BlockHash::from(1)), Some(11));
+
+        assert_eq!(index.remove(&BlockHash::from(1)), Some(11));
+        assert_eq!(index.remove(&BlockHash::from(1)), None);
+        assert_eq!(index.get(&BlockHash::from(2)), Some(20));
+        assert_eq!(index.len(), 1);
+    }
+
+    #[test]
+    fn remove_keeps_probe_sequences_intact() {
+        let mut index = FixedHashIndex::new(64);
+        for i in 0..64 {
+            index.insert(BlockHash::from(i), i as u32);
+        }
+        for i in (0..64).step_by(2) {
+            assert_eq!(index.remove(&BlockHash::from(i)), Some(i as u32));
+        }
+        for i in 0..64 {
+            let expected = if i % 2 == 0 { None } else { Some(i as u32) };
+            assert_eq!(index.get(&BlockHash::from(i)), expected);
+        }
+        assert_eq!(index.len(), 32);
+    }
+
+    #[test]
+    fn clear() {
+        let mut index = FixedHashIndex::new(4);
+        index.insert(BlockHash::from(1), 1);
+        index.clear();
+        assert_eq!(index.len(), 0);
+        assert_eq!(index.get(&BlockHash::from(1)), None);
+    }
+}
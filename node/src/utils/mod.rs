@@ -1,5 +1,8 @@
+mod adaptive_batch_size;
 mod async_runtime;
 mod blake2b;
+mod executor;
+mod fixed_hash_index;
 mod hardened_constants;
 mod long_running_transaction_logger;
 mod processing_queue;
@@ -8,12 +11,15 @@ mod timer;
 mod timer_thread;
 
 pub use crate::utils::timer::{NullTimer, Timer, TimerStrategy, TimerWrapper};
+pub use adaptive_batch_size::*;
 pub use async_runtime::AsyncRuntime;
 use blake2::{
     digest::{Update, VariableOutput},
     Blake2bVar,
 };
 pub use blake2b::*;
+pub use executor::*;
+pub(crate) use fixed_hash_index::FixedHashIndex;
 pub use hardened_constants::HardenedConstants;
 pub use long_running_transaction_logger::{LongRunningTransactionLogger, TxnTrackingConfig};
 pub use processing_queue::*;
@@ -1276,7 +1276,7 @@ mod bootstrap_processor {
 
 mod bulk_pull {
     use super::*;
-    use rsban_core::{StateBlockArgs, UnsavedBlockLatticeBuilder};
+    use rsban_core::{utils::BufferReader, BlockType, StateBlockArgs, UnsavedBlockLatticeBuilder};
 
     // If the account doesn't exist, current == end so there's no iteration
     #[test]
@@ -1537,6 +1537,75 @@ mod bulk_pull {
         assert!(block.is_none());
     }
 
+    #[test]
+    fn chunked_response_ends_with_terminator() {
+        let mut system = System::new();
+        let node = system.make_node();
+        let sends = process_sends(&node, 100);
+
+        let bulk_pull = BulkPull {
+            start: (*DEV_GENESIS_ACCOUNT).into(),
+            end: BlockHash::zero(),
+            count: 0,
+            ascending: false,
+        };
+        let pull_server = create_bulk_pull_server(&node, bulk_pull);
+
+        let chunks = collect_chunks(|| pull_server.next_chunk());
+        assert!(chunks.len() > 1);
+        let (hashes, rest) = read_blocks(&chunks.concat());
+        assert_eq!(hashes.len(), sends.len() + 1);
+        assert_eq!(hashes[0], sends.last().unwrap().hash());
+        assert_eq!(*hashes.last().unwrap(), *DEV_GENESIS_HASH);
+        // The terminator is the last byte of the last chunk
+        assert!(rest.is_empty());
+    }
+
+    #[test]
+    fn count_limit_across_chunks() {
+        let mut system = System::new();
+        let node = system.make_node();
+        let sends = process_sends(&node, 100);
+
+        let bulk_pull = BulkPull {
+            start: (*DEV_GENESIS_ACCOUNT).into(),
+            end: BlockHash::zero(),
+            count: 90,
+            ascending: false,
+        };
+        let pull_server = create_bulk_pull_server(&node, bulk_pull);
+
+        let chunks = collect_chunks(|| pull_server.next_chunk());
+        assert!(chunks.len() > 1);
+        let (hashes, rest) = read_blocks(&chunks.concat());
+        assert_eq!(hashes.len(), 90);
+        assert_eq!(hashes[89], sends[10].hash());
+        assert!(rest.is_empty());
+    }
+
+    fn process_sends(node: &Node, count: usize) -> Vec<Block> {
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let sends: Vec<_> = (0..count)
+            .map(|_| lattice.genesis().send(Account::from(42), 1))
+            .collect();
+        node.process_multi(&sends);
+        sends
+    }
+
+    /// Returns the hashes of the blocks before the not-a-block terminator
+    /// and the bytes after it
+    fn read_blocks(bytes: &[u8]) -> (Vec<BlockHash>, &[u8]) {
+        let mut reader = BufferReader::new(bytes);
+        let mut hashes = Vec::new();
+        loop {
+            let offset = bytes.len() - reader.remaining().len();
+            if bytes[offset] == BlockType::NotABlock as u8 {
+                return (hashes, &bytes[offset + 1..]);
+            }
+            hashes.push(Block::deserialize(&mut reader).unwrap().hash());
+        }
+    }
+
     fn create_bulk_pull_server(node: &Node, request: BulkPull) -> BulkPullServer {
         let response_server = create_response_server(&node);
         BulkPullServer::new(
@@ -1553,7 +1622,7 @@ mod frontier_req {
     use super::*;
     use rsban_core::UnsavedBlockLatticeBuilder;
     use rsban_messages::FrontierReq;
-    use rsban_node::bootstrap::FrontierReqServer;
+    use rsban_node::bootstrap::{bootstrap_limits::STREAM_CHUNK_SIZE, FrontierReqServer};
     use std::thread::sleep;
 
     #[test]
@@ -1770,6 +1839,41 @@ mod frontier_req {
         assert_eq!(receive2.hash(), frontier_req_server7.frontier());
     }
 
+    #[test]
+    fn count_across_chunks() {
+        let mut system = System::new();
+        let node = system.make_node();
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let mut blocks = Vec::new();
+        for i in 0..260 {
+            let key = PrivateKey::from(i + 1);
+            let send = lattice.genesis().send(&key, 1);
+            let open = lattice.account(&key).receive(&send);
+            blocks.push(send);
+            blocks.push(open);
+        }
+        node.process_multi(&blocks);
+
+        let request = FrontierReq {
+            start: Account::zero(),
+            age: u32::MAX,
+            count: 258,
+            only_confirmed: false,
+        };
+        let frontier_req_server = create_frontier_req_server(&node, request);
+
+        // A frontier pair is an account and a block hash
+        let pair_size = 64;
+        let (first, finished) = frontier_req_server.next_chunk();
+        assert!(!finished);
+        assert_eq!(first.len(), STREAM_CHUNK_SIZE);
+        let (second, finished) = frontier_req_server.next_chunk();
+        assert!(finished);
+        assert_eq!(second.len(), 3 * pair_size);
+        assert!(second[..pair_size].iter().any(|b| *b != 0));
+        assert!(second[2 * pair_size..].iter().all(|b| *b == 0));
+    }
+
     fn create_frontier_req_server(node: &Node, request: FrontierReq) -> FrontierReqServer {
         let response_server = create_response_server(&node);
         FrontierReqServer::new(
@@ -1891,6 +1995,41 @@ mod bulk_pull_account {
             assert!(pull_server.get_next().is_none());
         }
     }
+
+    #[test]
+    fn first_chunk_starts_with_frontier() {
+        let mut system = System::new();
+        let node = system.make_node();
+        let key1 = PrivateKey::from(1);
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let send1 = lattice.genesis().send(&key1, 10);
+        let open = lattice.account(&key1).receive(&send1);
+        let send2 = lattice.genesis().send(&key1, 20);
+        node.process_multi(&[send1, open.clone(), send2.clone()]);
+
+        let payload = BulkPullAccount {
+            account: key1.account(),
+            minimum_amount: Amount::zero(),
+            flags: BulkPullAccountFlags::PendingHashAndAmount,
+        };
+        let pull_server = BulkPullAccountServer::new(
+            create_response_server(&node),
+            payload,
+            node.workers.clone(),
+            node.ledger.clone(),
+            node.runtime.clone(),
+        );
+
+        // Frontier and balance, one receivable entry and the final sequence
+        let (chunk, finished) = pull_server.next_chunk(true);
+        assert!(finished);
+        assert_eq!(chunk.len(), 3 * 48);
+        assert_eq!(&chunk[..32], open.hash().as_bytes());
+        assert_eq!(&chunk[32..48], &Amount::raw(10).to_be_bytes());
+        assert_eq!(&chunk[48..80], send2.hash().as_bytes());
+        assert_eq!(&chunk[80..96], &Amount::raw(20).to_be_bytes());
+        assert!(chunk[96..].iter().all(|b| *b == 0));
+    }
 }
 
 #[test]
@@ -2296,6 +2435,19 @@ fn lazy_max_pull_count() {
     });
 }
 
+/// Collects the chunks of a streamed response up to the one which completes it
+fn collect_chunks(mut next_chunk: impl FnMut() -> (Vec<u8>, bool)) -> Vec<Vec<u8>> {
+    let mut chunks = Vec::new();
+    loop {
+        let (chunk, finished) = next_chunk();
+        chunks.push(chunk);
+        if finished {
+            return chunks;
+        }
+        assert!(chunks.len() < 1000, "response doesn't finish");
+    }
+}
+
 fn create_response_server(node: &Node) -> Arc<ResponseServer> {
     let channel = Channel::create(
         Arc::new(ChannelInfo::new_test_instance()),
@@ -3,8 +3,15 @@ use rsban_core::{
     UnsavedBlockLatticeBuilder, DEV_GENESIS_KEY,
 };
 use rsban_ledger::{DEV_GENESIS_ACCOUNT, DEV_GENESIS_PUB_KEY};
-use rsban_node::{block_processing::UncheckedMap, stats::Stats};
-use std::{sync::Arc, time::Duration};
+use rsban_node::{
+    block_processing::{UncheckedMap, UncheckedOverflow},
+    stats::Stats,
+};
+use rsban_store_lmdb::{LmdbUncheckedStore, TestLmdbEnv};
+use std::{
+    sync::{Arc, Mutex},
+    time::Duration,
+};
 use test_helpers::{assert_timely, assert_timely_eq};
 
 #[test]
@@ -206,3 +213,40 @@ fn multiple_get() {
     let unchecked5 = unchecked.get(&block2.hash().into());
     assert_eq!(unchecked5.len(), 0);
 }
+
+// Entries which don't fit into memory are spilled to disk and are still found and triggered
+#[test]
+fn overflow_to_disk() {
+    let env = TestLmdbEnv::new();
+    let overflow = Arc::new(UncheckedOverflow::new(
+        LmdbUncheckedStore::new(env.env()).unwrap(),
+        10,
+    ));
+    let unchecked =
+        UncheckedMap::with_overflow(1, Arc::new(Stats::default()), false, Some(overflow));
+    let mut lattice = UnsavedBlockLatticeBuilder::new();
+    let block1 = lattice.genesis().send(&*DEV_GENESIS_KEY, 1);
+    let block2 = lattice.genesis().send(&*DEV_GENESIS_KEY, 1);
+
+    unchecked.put(block1.hash().into(), UncheckedInfo::new(block1.clone()));
+    // Evicts block1 from memory
+    unchecked.put(block2.hash().into(), UncheckedInfo::new(block2.clone()));
+
+    assert_eq!(unchecked.len(), 2);
+    assert!(unchecked.exists(&UncheckedKey::new(block1.hash(), block1.hash())));
+    let blocks = unchecked.get(&block1.hash().into());
+    assert_eq!(blocks.len(), 1);
+    assert_eq!(blocks[0].block.hash(), block1.hash());
+
+    let satisfied = Arc::new(Mutex::new(Vec::new()));
+    let satisfied_l = satisfied.clone();
+    unchecked.set_satisfied_observer(Box::new(move |info| {
+        satisfied_l.lock().unwrap().push(info.block.hash());
+    }));
+    unchecked.start();
+    unchecked.trigger(&block1.hash().into());
+
+    assert_timely_eq(Duration::from_secs(5), || unchecked.len(), 1);
+    assert_eq!(*satisfied.lock().unwrap(), vec![block1.hash()]);
+    unchecked.stop();
+}
@@ -52,7 +52,7 @@ fn codes() {
     );
 
     // Clear vote cache before starting election
-    node.vote_cache.lock().unwrap().clear();
+    node.vote_cache.clear();
 
     // First vote from an account for an ongoing election
     start_election(&node, &blocks[0].hash());
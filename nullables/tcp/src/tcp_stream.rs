@@ -1,5 +1,6 @@
 use std::{
     cmp::min,
+    io::IoSlice,
     net::{Ipv6Addr, SocketAddr, SocketAddrV6},
     sync::atomic::{AtomicUsize, Ordering},
 };
@@ -66,6 +67,11 @@ impl TcpStream {
     pub fn try_write(&self, buf: &[u8]) -> tokio::io::Result<usize> {
         self.stream.try_write(buf)
     }
+
+    /// Writes many buffers with a single syscall
+    pub fn try_write_vectored(&self, bufs: &[IoSlice<'_>]) -> tokio::io::Result<usize> {
+        self.stream.try_write_vectored(bufs)
+    }
 }
 
 #[async_trait]
@@ -76,6 +82,7 @@ trait InternalTcpStream: Send + Sync {
     fn peer_addr(&self) -> std::io::Result<SocketAddr>;
     async fn writable(&self) -> tokio::io::Result<()>;
     fn try_write(&self, buf: &[u8]) -> tokio::io::Result<usize>;
+    fn try_write_vectored(&self, bufs: &[IoSlice<'_>]) -> tokio::io::Result<usize>;
     async fn shutdown(&mut self) -> tokio::io::Result<()>;
 }
 
@@ -107,6 +114,10 @@ impl InternalTcpStream for TokioTcpStreamWrapper {
         self.0.try_write(buf)
     }
 
+    fn try_write_vectored(&self, bufs: &[IoSlice<'_>]) -> tokio::io::Result<usize> {
+        self.0.try_write_vectored(bufs)
+    }
+
     async fn shutdown(&mut self) -> tokio::io::Result<()> {
         self.0.shutdown().await
     }
@@ -175,6 +186,10 @@ impl InternalTcpStream for TcpStreamStub {
         Ok(buf.len())
     }
 
+    fn try_write_vectored(&self, bufs: &[IoSlice<'_>]) -> tokio::io::Result<usize> {
+        Ok(bufs.iter().map(|b| b.len()).sum())
+    }
+
     async fn shutdown(&mut self) -> tokio::io::Result<()> {
         Ok(())
     }
@@ -289,6 +304,15 @@ mod tests {
             .expect_err("try_read should fail on second call");
     }
 
+    #[test]
+    fn nulled_stream_writes_all_vectored_buffers() {
+        let stream = TcpStream::new_null();
+        let written = stream
+            .try_write_vectored(&[IoSlice::new(&[1, 2]), IoSlice::new(&[3])])
+            .unwrap();
+        assert_eq!(written, 3);
+    }
+
     async fn start_test_tcp_server(endpoint: SocketAddr) {
         let listener = TcpListener::bind(endpoint).await.unwrap();
 
@@ -520,7 +520,7 @@ impl NanoRpcClient {
         self.request(&RpcCommand::UncheckedClear).await
     }
 
-    pub async fn unopened(&self, args: impl Into<UnopenedArgs>) -> Result<AccountsWithAmountsDto> {
+    pub async fn unopened(&self, args: impl Into<UnopenedArgs>) -> Result<UnopenedResponse> {
         self.request(&RpcCommand::Unopened(args.into())).await
     }
 
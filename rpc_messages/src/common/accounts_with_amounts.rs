@@ -28,10 +28,17 @@ impl RepresentativesResponse {
 #[derive(PartialEq, Eq, Debug, Serialize, Deserialize)]
 pub struct DelegatorsResponse {
     pub delegators: HashMap<Account, Amount>,
+    /// The last returned delegator, if the count was reached.
+    /// Pass it as `start` to get the next page
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub next: Option<Account>,
 }
 
 impl DelegatorsResponse {
     pub fn new(delegators: HashMap<Account, Amount>) -> Self {
-        Self { delegators }
+        Self {
+            delegators,
+            next: None,
+        }
     }
 }
@@ -8,6 +8,10 @@ pub struct FrontiersResponse {
     pub frontiers: Option<HashMap<Account, BlockHash>>,
     #[serde(skip_serializing_if = "Option::is_none")]
     pub errors: Option<HashMap<Account, String>>,
+    /// The first account which was not returned because the count was reached.
+    /// Pass it as `account` to get the next page
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub next: Option<Account>,
 }
 
 impl FrontiersResponse {
@@ -15,6 +19,7 @@ impl FrontiersResponse {
         Self {
             frontiers: Some(frontiers),
             errors: None,
+            next: None,
         }
     }
 }
@@ -121,6 +126,7 @@ mod tests {
         let expected_frontiers_dto = FrontiersResponse {
             frontiers: Some(frontiers),
             errors: Some(errors),
+            next: None,
         };
         assert_eq!(deserialized, expected_frontiers_dto);
     }
@@ -2,7 +2,7 @@ use crate::RpcU64;
 use rsban_core::{Account, Amount};
 use serde::{Deserialize, Serialize};
 
-#[derive(PartialEq, Eq, Debug, Serialize, Deserialize)]
+#[derive(PartialEq, Eq, Debug, Serialize, Deserialize, Clone)]
 pub struct DelegatorsArgs {
     pub account: Account,
     #[serde(skip_serializing_if = "Option::is_none")]
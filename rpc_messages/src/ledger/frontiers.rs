@@ -8,7 +8,7 @@ impl RpcCommand {
     }
 }
 
-#[derive(PartialEq, Eq, Debug, Serialize, Deserialize)]
+#[derive(PartialEq, Eq, Debug, Serialize, Deserialize, Clone)]
 pub struct FrontiersArgs {
     pub account: Account,
     pub count: RpcU64,
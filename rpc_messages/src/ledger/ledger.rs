@@ -9,7 +9,7 @@ impl RpcCommand {
     }
 }
 
-#[derive(PartialEq, Eq, Debug, Serialize, Deserialize, Default)]
+#[derive(PartialEq, Eq, Debug, Serialize, Deserialize, Default, Clone)]
 pub struct LedgerArgs {
     #[serde(skip_serializing_if = "Option::is_none")]
     pub account: Option<Account>,
@@ -90,6 +90,19 @@ impl LedgerArgsBuilder {
 #[derive(PartialEq, Eq, Debug, Serialize, Deserialize)]
 pub struct LedgerResponse {
     pub accounts: HashMap<Account, LedgerAccountInfo>,
+    /// The first account which was not returned because the count was reached.
+    /// Pass it as `account` to get the next page
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub next: Option<Account>,
+}
+
+impl LedgerResponse {
+    pub fn new(accounts: HashMap<Account, LedgerAccountInfo>) -> Self {
+        Self {
+            accounts,
+            next: None,
+        }
+    }
 }
 
 #[derive(PartialEq, Eq, Debug, Serialize, Deserialize)]
@@ -232,7 +245,7 @@ mod tests {
             },
         );
 
-        let ledger_dto = LedgerResponse { accounts };
+        let ledger_dto = LedgerResponse::new(accounts);
 
         let serialized = serde_json::to_value(&ledger_dto).unwrap();
 
@@ -3,7 +3,7 @@ use rsban_core::{Account, Amount};
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
 
-#[derive(PartialEq, Eq, Debug, Serialize, Deserialize, Default)]
+#[derive(PartialEq, Eq, Debug, Serialize, Deserialize, Default, Clone)]
 pub struct UnopenedArgs {
     #[serde(skip_serializing_if = "Option::is_none")]
     pub account: Option<Account>,
@@ -16,11 +16,18 @@ pub struct UnopenedArgs {
 #[derive(PartialEq, Eq, Debug, Serialize, Deserialize)]
 pub struct UnopenedResponse {
     pub accounts: HashMap<Account, Amount>,
+    /// The first account which was not returned because the count was reached.
+    /// Pass it as `account` to get the next page
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub next: Option<Account>,
 }
 
 impl UnopenedResponse {
     pub fn new(accounts: HashMap<Account, Amount>) -> Self {
-        Self { accounts }
+        Self {
+            accounts,
+            next: None,
+        }
     }
 }
 
@@ -13,4 +13,6 @@ pub enum StatsType {
     Objects,
     Samples,
     Database,
+    /// Latency histograms of the block lifecycle
+    Latencies,
 }
@@ -1,6 +1,6 @@
 use crate::command_handler::RpcCommandHandler;
 use anyhow::anyhow;
-use rsban_core::{Account, Block, BlockBase, BlockHash, SavedBlock};
+use rsban_core::{Account, Block, BlockBase, BlockHash, SavedBlock, SavedBlockView};
 use rsban_ledger::Ledger;
 use rsban_rpc_messages::{
     unwrap_bool_or_false, unwrap_u64_or_zero, AccountHistoryArgs, AccountHistoryResponse,
@@ -86,7 +86,11 @@ impl<'a> AccountHistoryHelper<'a> {
         let tx = self.ledger.read_txn();
         self.initialize(&tx)?;
         let mut history = Vec::new();
-        let mut next_block = self.ledger.any().get_block(&tx, &self.current_block_hash);
+        // Walk the chain through borrowed views, so that skipped blocks are never decoded
+        let mut next_block = self
+            .ledger
+            .any()
+            .get_block_view(&tx, &self.current_block_hash);
         while let Some(block) = next_block {
             if self.count == 0 {
                 break;
@@ -95,7 +99,7 @@ impl<'a> AccountHistoryHelper<'a> {
             if self.offset > 0 {
                 self.offset -= 1;
             } else {
-                if let Some(entry) = self.entry_for(&block, &tx) {
+                if let Some(entry) = self.entry_for(&block.to_saved_block(), &tx) {
                     history.push(entry);
                     self.count -= 1;
                 }
@@ -107,16 +111,19 @@ impl<'a> AccountHistoryHelper<'a> {
         Ok(self.create_response(history))
     }
 
-    fn go_to_next_block(&mut self, tx: &LmdbReadTransaction, block: &Block) -> Option<SavedBlock> {
+    fn go_to_next_block<'txn>(
+        &mut self,
+        tx: &'txn LmdbReadTransaction,
+        block: &SavedBlockView,
+    ) -> Option<SavedBlockView<'txn>> {
         self.current_block_hash = if self.reverse {
-            self.ledger
-                .any()
-                .block_successor(tx, &self.current_block_hash)
-                .unwrap_or_default()
+            block.successor().unwrap_or_default()
         } else {
             block.previous()
         };
-        self.ledger.any().get_block(tx, &self.current_block_hash)
+        self.ledger
+            .any()
+            .get_block_view(tx, &self.current_block_hash)
     }
 
     fn should_ignore_account(&self, account: &Account) -> bool {
@@ -0,0 +1,130 @@
+use crate::command_handler::RpcCommandHandler;
+use rsban_core::{Account, AccountInfo, PublicKey};
+use rsban_store_lmdb::{LmdbReadTransaction, Transaction};
+
+/// Number of table entries which are read before checking if the read transaction
+/// is old enough to be refreshed. Short walks keep reusing the same transaction
+pub(crate) const ENTRIES_PER_TXN: usize = 4096;
+
+impl RpcCommandHandler {
+    /// Visits the accounts in ascending order, starting at `start`.
+    /// The read transaction is reused across slices of accounts and only refreshed
+    /// once it gets old, so that a walk over the whole ledger doesn't pin an old LMDB snapshot.
+    /// `visit` returns false if it doesn't accept any more accounts. The first
+    /// account which wasn't accepted is returned, so the walk can be resumed there.
+    pub(crate) fn walk_accounts(
+        &self,
+        start: Account,
+        mut visit: impl FnMut(&LmdbReadTransaction, &Account, &AccountInfo) -> bool,
+    ) -> Option<Account> {
+        let mut tx = self.node.ledger.read_txn();
+        let mut cursor = start;
+        loop {
+            let mut resume_at = None;
+            for (i, (account, info)) in self
+                .node
+                .store
+                .account
+                .iter_range(&tx, cursor..)
+                .enumerate()
+            {
+                if i == ENTRIES_PER_TXN {
+                    resume_at = Some(account);
+                    break;
+                }
+                if !visit(&tx, &account, &info) {
+                    return Some(account);
+                }
+            }
+
+            match resume_at {
+                Some(account) => {
+                    cursor = account;
+                    tx.refresh_if_needed();
+                }
+                None => return None,
+            }
+        }
+    }
+
+    /// Visits the delegators of the representative in ascending order, starting at `start`.
+    /// The delegators are read from the delegator index in slices, and the
+    /// account infos of a slice are loaded with a single cursor.
+    /// Returns the first delegator which wasn't accepted by `visit`.
+    pub(crate) fn walk_delegators(
+        &self,
+        representative: &PublicKey,
+        start: Account,
+        mut visit: impl FnMut(&Account, &AccountInfo) -> bool,
+    ) -> Option<Account> {
+        let mut tx = self.node.ledger.read_txn();
+        let mut cursor = start;
+        loop {
+            let mut delegators: Vec<Account> = self
+                .node
+                .store
+                .delegator
+                .iter(&tx, representative, &cursor)
+                .take(ENTRIES_PER_TXN + 1)
+                .collect();
+            let resume_at = if delegators.len() > ENTRIES_PER_TXN {
+                delegators.pop()
+            } else {
+                None
+            };
+
+            let infos = self.node.store.account.get_sorted(&tx, &delegators);
+            for (account, info) in delegators.iter().zip(infos) {
+                if let Some(info) = info {
+                    if !visit(account, &info) {
+                        return Some(*account);
+                    }
+                }
+            }
+
+            match resume_at {
+                Some(account) => {
+                    cursor = account;
+                    tx.refresh_if_needed();
+                }
+                None => return None,
+            }
+        }
+    }
+
+    /// Loads the infos of the given accounts, which have to be sorted.
+    /// The lookups follow the order of the table and the transaction is
+    /// refreshed between slices of accounts once it gets old.
+    pub(crate) fn sorted_account_infos(&self, accounts: &[Account]) -> Vec<Option<AccountInfo>> {
+        let mut tx = self.node.ledger.read_txn();
+        let mut result = Vec::with_capacity(accounts.len());
+        for (i, slice) in accounts.chunks(ENTRIES_PER_TXN).enumerate() {
+            if i > 0 {
+                tx.refresh_if_needed();
+            }
+            result.extend(self.node.store.account.get_sorted(&tx, slice));
+        }
+        result
+    }
+}
+
+/// Sorts the accounts and removes duplicates, so that they can be read in table order
+pub(crate) fn sorted_accounts(mut accounts: Vec<Account>) -> Vec<Account> {
+    accounts.sort_unstable();
+    accounts.dedup();
+    accounts
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn sort_and_dedup_accounts() {
+        let accounts = vec![Account::from(3), Account::from(1), Account::from(3)];
+        assert_eq!(
+            sorted_accounts(accounts),
+            vec![Account::from(1), Account::from(3)]
+        );
+    }
+}
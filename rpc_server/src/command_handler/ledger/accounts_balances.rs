@@ -1,17 +1,23 @@
+use super::account_walk::{sorted_accounts, ENTRIES_PER_TXN};
 use crate::command_handler::RpcCommandHandler;
 use rsban_core::Amount;
 use rsban_rpc_messages::{
     unwrap_bool_or_true, AccountBalanceResponse, AccountsBalancesArgs, AccountsBalancesResponse,
 };
+use rsban_store_lmdb::Transaction;
 use std::collections::HashMap;
 
 impl RpcCommandHandler {
     pub(crate) fn accounts_balances(&self, args: AccountsBalancesArgs) -> AccountsBalancesResponse {
-        let tx = self.node.ledger.read_txn();
+        let mut tx = self.node.ledger.read_txn();
         let mut balances = HashMap::new();
         let only_confirmed = unwrap_bool_or_true(args.include_only_confirmed);
 
-        for account in args.accounts {
+        // Accounts and receivables are keyed by account, so both tables are read in order
+        for (i, account) in sorted_accounts(args.accounts).into_iter().enumerate() {
+            if i > 0 && i % ENTRIES_PER_TXN == 0 {
+                tx.refresh_if_needed();
+            }
             let balance = if only_confirmed {
                 self.node
                     .ledger
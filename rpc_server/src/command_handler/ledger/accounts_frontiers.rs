@@ -1,16 +1,18 @@
+use super::account_walk::sorted_accounts;
 use crate::command_handler::RpcCommandHandler;
 use rsban_rpc_messages::{AccountsRpcMessage, FrontiersResponse};
 use std::collections::HashMap;
 
 impl RpcCommandHandler {
     pub(crate) fn accounts_frontiers(&self, args: AccountsRpcMessage) -> FrontiersResponse {
-        let tx = self.node.ledger.read_txn();
+        let accounts = sorted_accounts(args.accounts);
+        let infos = self.sorted_account_infos(&accounts);
         let mut frontiers = HashMap::new();
         let mut errors = HashMap::new();
 
-        for account in args.accounts {
-            if let Some(block_hash) = self.node.ledger.any().account_head(&tx, &account) {
-                frontiers.insert(account, block_hash);
+        for (account, info) in accounts.into_iter().zip(infos) {
+            if let Some(info) = info {
+                frontiers.insert(account, info.head);
             } else {
                 errors.insert(account, "Account not found".to_string());
             }
@@ -1,3 +1,4 @@
+use super::account_walk::sorted_accounts;
 use crate::command_handler::RpcCommandHandler;
 use rsban_core::Account;
 use rsban_rpc_messages::{AccountsRepresentativesResponse, AccountsRpcMessage};
@@ -8,12 +9,13 @@ impl RpcCommandHandler {
         &self,
         args: AccountsRpcMessage,
     ) -> AccountsRepresentativesResponse {
-        let tx = self.node.ledger.read_txn();
+        let accounts = sorted_accounts(args.accounts);
+        let infos = self.sorted_account_infos(&accounts);
         let mut representatives: HashMap<Account, Account> = HashMap::new();
         let mut errors: HashMap<Account, String> = HashMap::new();
 
-        for account in args.accounts {
-            match self.node.ledger.store.account.get(&tx, &account) {
+        for (account, info) in accounts.into_iter().zip(infos) {
+            match info {
                 Some(account_info) => {
                     representatives.insert(account, account_info.representative.as_account());
                 }
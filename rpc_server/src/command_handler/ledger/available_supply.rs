@@ -5,13 +5,18 @@ use rsban_rpc_messages::AvailableSupplyReponse;
 impl RpcCommandHandler {
     pub(crate) fn available_supply(&self) -> AvailableSupplyReponse {
         let tx = self.node.store.env.tx_begin_read();
+        let balance = |account: &Account| {
+            self.node
+                .ledger
+                .any()
+                .account_balance(&tx, account)
+                .unwrap_or_default()
+        };
         // Cold storage genesis
-        let genesis_balance = self
-            .node
-            .balance(&self.node.network_params.ledger.genesis_account);
+        let genesis_balance = balance(&self.node.network_params.ledger.genesis_account);
 
         // Active unavailable account
-        let landing_balance = self.node.balance(
+        let landing_balance = balance(
             &Account::decode_hex(
                 "059F68AAB29DE0D3A27443625C7EA9CDDB6517A8B76FE37727EF6A4D76832AD5",
             )
@@ -19,7 +24,7 @@ impl RpcCommandHandler {
         );
 
         // Faucet account
-        let faucet_balance = self.node.balance(
+        let faucet_balance = balance(
             &Account::decode_hex(
                 "8E319CE6F3025E5B2DF66DA7AB1467FE48F1679C13DD43BFDB29FA2E9FC40D3B",
             )
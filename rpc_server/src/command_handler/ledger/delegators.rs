@@ -11,24 +11,26 @@ impl RpcCommandHandler {
         let start_account = args.start.unwrap_or(Account::zero());
 
         let mut delegators: HashMap<Account, Amount> = HashMap::new();
-        let tx = self.node.ledger.read_txn();
-        let mut iter = self
-            .node
-            .store
-            .account
-            .begin_account(&tx, &start_account.inc().unwrap_or_default());
+        let mut last_delegator = None;
+        let next = self.walk_delegators(
+            &representative,
+            start_account.inc().unwrap_or_default(),
+            |account, info| {
+                if delegators.len() >= count as usize {
+                    return false;
+                }
 
-        while let Some((account, info)) = iter.current() {
-            if delegators.len() >= count as usize {
-                break;
-            }
+                if info.balance >= threshold {
+                    delegators.insert(*account, info.balance);
+                    last_delegator = Some(*account);
+                }
+                true
+            },
+        );
 
-            if info.representative == representative && info.balance >= threshold {
-                delegators.insert(*account, info.balance);
-            }
-
-            iter.next();
-        }
-        DelegatorsResponse::new(delegators)
+        let mut response = DelegatorsResponse::new(delegators);
+        // The start account is exclusive, so the next page starts after the last delegator
+        response.next = next.and(last_delegator);
+        response
     }
 }
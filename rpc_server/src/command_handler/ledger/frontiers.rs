@@ -5,21 +5,19 @@ use std::collections::HashMap;
 
 impl RpcCommandHandler {
     pub(crate) fn frontiers(&self, args: FrontiersArgs) -> FrontiersResponse {
-        let tx = self.node.ledger.read_txn();
+        let count: u64 = args.count.into();
         let mut frontiers: HashMap<Account, BlockHash> = HashMap::new();
-        let mut iterator = self.node.store.account.begin_account(&tx, &args.account);
-        let mut collected = 0_u64;
 
-        while collected < args.count.into() {
-            if let Some((account, account_info)) = iterator.current() {
-                frontiers.insert(*account, account_info.head);
-                collected += 1;
-                iterator.next();
-            } else {
-                break;
+        let next = self.walk_accounts(args.account, |_, account, account_info| {
+            if frontiers.len() as u64 >= count {
+                return false;
             }
-        }
+            frontiers.insert(*account, account_info.head);
+            true
+        });
 
-        FrontiersResponse::new(frontiers)
+        let mut response = FrontiersResponse::new(frontiers);
+        response.next = next;
+        response
     }
 }
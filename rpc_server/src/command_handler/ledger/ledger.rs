@@ -1,9 +1,11 @@
+use super::account_walk::ENTRIES_PER_TXN;
 use crate::command_handler::RpcCommandHandler;
 use rsban_core::{Account, Amount};
 use rsban_rpc_messages::{
     unwrap_bool_or_false, unwrap_u64_or_max, unwrap_u64_or_zero, LedgerAccountInfo, LedgerArgs,
     LedgerResponse,
 };
+use rsban_store_lmdb::Transaction;
 use std::collections::HashMap;
 
 impl RpcCommandHandler {
@@ -18,17 +20,20 @@ impl RpcCommandHandler {
         let receivable = unwrap_bool_or_false(args.receivable);
 
         let mut accounts: HashMap<Account, LedgerAccountInfo> = HashMap::new();
-        let tx = self.node.store.tx_begin_read();
+        let mut next = None;
 
         if !sorting {
             // Simple
-            for (account, info) in self.node.store.account.iter_range(&tx, start..) {
+            next = self.walk_accounts(start, |tx, account, info| {
+                if accounts.len() >= count as usize {
+                    return false;
+                }
                 if info.modified >= modified_since && (receivable || info.balance >= threshold) {
                     let receivable = if receivable {
                         let account_receivable =
-                            self.node.ledger.account_receivable(&tx, &account, false);
+                            self.node.ledger.account_receivable(tx, account, false);
                         if info.balance + account_receivable < threshold {
-                            continue;
+                            return true;
                         }
                         Some(account_receivable)
                     } else {
@@ -41,33 +46,37 @@ impl RpcCommandHandler {
                         representative_block: self
                             .node
                             .ledger
-                            .representative_block_hash(&tx, &info.head),
+                            .representative_block_hash(tx, &info.head),
                         balance: info.balance,
                         modified_timestamp: info.modified.into(),
                         block_count: info.block_count.into(),
                         representative: representative.then(|| info.representative.into()),
-                        weight: weight.then(|| self.node.ledger.weight_exact(&tx, account.into())),
+                        weight: weight
+                            .then(|| self.node.ledger.weight_exact(tx, (*account).into())),
                         pending: receivable,
                         receivable,
                     };
-                    accounts.insert(account, entry);
-                    if accounts.len() >= count as usize {
-                        break;
-                    }
+                    accounts.insert(*account, entry);
                 }
-            }
+                true
+            });
         } else {
             // Sorting
             let mut ledger: Vec<(Amount, Account)> = Vec::new();
-            for (account, info) in self.node.store.account.iter_range(&tx, start..) {
+            self.walk_accounts(start, |_, account, info| {
                 if info.modified >= modified_since {
-                    ledger.push((info.balance, account));
+                    ledger.push((info.balance, *account));
                 }
-            }
+                true
+            });
 
             ledger.sort_by(|a, b| b.cmp(&a));
 
-            for (_, account) in ledger {
+            let mut tx = self.node.store.tx_begin_read();
+            for (i, (_, account)) in ledger.into_iter().enumerate() {
+                if i > 0 && i % ENTRIES_PER_TXN == 0 {
+                    tx.refresh_if_needed();
+                }
                 if let Some(info) = self.node.store.account.get(&tx, &account) {
                     if receivable || info.balance >= threshold {
                         let pending = if receivable {
@@ -106,6 +115,8 @@ impl RpcCommandHandler {
             }
         }
 
-        LedgerResponse { accounts }
+        let mut response = LedgerResponse::new(accounts);
+        response.next = next;
+        response
     }
 }
@@ -2,6 +2,7 @@ mod account_balance;
 mod account_history;
 mod account_info;
 mod account_representative;
+mod account_walk;
 mod account_weight;
 mod accounts_balances;
 mod accounts_frontiers;
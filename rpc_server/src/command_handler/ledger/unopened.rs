@@ -1,6 +1,8 @@
+use super::account_walk::ENTRIES_PER_TXN;
 use crate::command_handler::RpcCommandHandler;
 use rsban_core::{Account, Amount, BlockHash, PendingKey};
 use rsban_rpc_messages::{unwrap_u64_or_max, UnopenedArgs, UnopenedResponse};
+use rsban_store_lmdb::Transaction;
 use std::collections::HashMap;
 
 impl RpcCommandHandler {
@@ -10,45 +12,64 @@ impl RpcCommandHandler {
         let start = args.account.unwrap_or(Account::from(1)); // exclude burn account by default
         let mut accounts: HashMap<Account, Amount> = HashMap::new();
 
-        let tx = self.node.store.tx_begin_read();
-
-        let mut iterator = self
-            .node
-            .store
-            .pending
-            .begin_at_key(&tx, &PendingKey::new(start, BlockHash::zero()));
+        let mut tx = self.node.store.tx_begin_read();
+        let mut cursor = PendingKey::new(start, BlockHash::zero());
 
         let mut current_account = start;
         let mut current_account_sum = Amount::zero();
 
-        while !iterator.is_end() && accounts.len() < count {
-            let (key, info) = iterator.current().unwrap();
-            let account = key.receiving_account;
+        loop {
+            let mut iterator = self.node.store.pending.begin_at_key(&tx, &cursor);
+            let mut visited = 0;
+            let mut resume_at = None;
 
-            if self.node.store.account.get(&tx, &account).is_some() {
-                if account == Account::MAX {
+            while !iterator.is_end() && accounts.len() < count {
+                let (key, info) = iterator.current().unwrap();
+                if visited == ENTRIES_PER_TXN {
+                    resume_at = Some(key.clone());
                     break;
                 }
-                // Skip existing accounts
-                iterator = self.node.store.pending.begin_at_key(
-                    &tx,
-                    &PendingKey::new(account.inc().unwrap(), BlockHash::zero()),
-                );
-            } else {
-                if account != current_account {
-                    if !current_account_sum.is_zero() {
-                        if current_account_sum >= threshold {
-                            accounts.insert(current_account, current_account_sum);
+                visited += 1;
+                let account = key.receiving_account;
+
+                if self.node.store.account.get(&tx, &account).is_some() {
+                    if account == Account::MAX {
+                        break;
+                    }
+                    // Skip existing accounts
+                    iterator = self.node.store.pending.begin_at_key(
+                        &tx,
+                        &PendingKey::new(account.inc().unwrap(), BlockHash::zero()),
+                    );
+                } else {
+                    if account != current_account {
+                        if !current_account_sum.is_zero() {
+                            if current_account_sum >= threshold {
+                                accounts.insert(current_account, current_account_sum);
+                            }
+                            current_account_sum = Amount::zero();
                         }
-                        current_account_sum = Amount::zero();
+                        current_account = account;
                     }
-                    current_account = account;
+                    current_account_sum += info.amount;
+                    iterator.next();
                 }
-                current_account_sum += info.amount;
-                iterator.next();
+            }
+
+            // Don't hold on to the snapshot during long walks
+            drop(iterator);
+            match resume_at {
+                Some(key) => {
+                    cursor = key;
+                    tx.refresh_if_needed();
+                }
+                None => break,
             }
         }
 
+        // The account which is summed up when the count is reached wasn't returned
+        let next = (accounts.len() >= count).then_some(current_account);
+
         // last one after iterator reaches end
         if accounts.len() < count
             && !current_account_sum.is_zero()
@@ -57,6 +78,8 @@ impl RpcCommandHandler {
             accounts.insert(current_account, current_account_sum);
         }
 
-        UnopenedResponse::new(accounts)
+        let mut response = UnopenedResponse::new(accounts);
+        response.next = next;
+        response
     }
 }
@@ -1,4 +1,5 @@
 mod ledger;
+mod ndjson;
 mod node;
 mod utils;
 mod wallets;
@@ -14,6 +15,8 @@ use tokio::sync::oneshot;
 use tracing::debug;
 use utils::*;
 
+pub(crate) use ndjson::can_stream;
+
 #[derive(Clone)]
 pub(crate) struct RpcCommandHandler {
     node: Arc<Node>,
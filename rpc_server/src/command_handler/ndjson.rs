@@ -0,0 +1,199 @@
+use super::RpcCommandHandler;
+use rsban_core::Account;
+use rsban_rpc_messages::{
+    unwrap_u64_or, unwrap_u64_or_max, DelegatorsArgs, FrontiersArgs, LedgerArgs, RpcCommand,
+    RpcError, UnopenedArgs,
+};
+use serde::Serialize;
+use serde_json::{to_value, Map, Value};
+
+/// Maximum number of accounts which are held in memory while a command is streamed
+const PAGE_SIZE: u64 = 1000;
+
+/// Commands which walk a range of accounts can be streamed as newline delimited JSON.
+/// A sorted ledger has to be collected completely before it can be returned
+pub(crate) fn can_stream(command: &RpcCommand) -> bool {
+    match command {
+        RpcCommand::Ledger(args) => !args.sorting.map(|i| i.inner()).unwrap_or(false),
+        RpcCommand::Frontiers(_) | RpcCommand::Delegators(_) | RpcCommand::Unopened(_) => true,
+        _ => false,
+    }
+}
+
+impl RpcCommandHandler {
+    /// Handles the command page by page and writes one JSON object per account and line,
+    /// in ascending order of the accounts. Every page is sent before the next one is read.
+    /// `page_permit` is held while a page is read, but not while it is sent, so a slow
+    /// client doesn't keep the slot of its command.
+    pub(crate) fn handle_ndjson<P>(
+        &self,
+        command: RpcCommand,
+        page_permit: impl Fn() -> P,
+        send: &mut dyn FnMut(String) -> bool,
+    ) {
+        if let Err(e) = self.check_control_enabled(&command) {
+            send(error_line(e.to_string()));
+            return;
+        }
+
+        let mut pages = match command {
+            RpcCommand::Ledger(args) => AccountPages::Ledger(args),
+            RpcCommand::Frontiers(args) => AccountPages::Frontiers(args),
+            RpcCommand::Delegators(args) => AccountPages::Delegators(args),
+            RpcCommand::Unopened(args) => AccountPages::Unopened(args),
+            _ => {
+                send(error_line("Command can't be streamed".to_owned()));
+                return;
+            }
+        };
+
+        let mut remaining = pages.count();
+        while remaining > 0 {
+            let permit = page_permit();
+            let (mut entries, next) = pages.next_page(self, remaining.min(PAGE_SIZE));
+            drop(permit);
+            remaining = remaining.saturating_sub(entries.len() as u64);
+            entries.sort_by(|a, b| a.0.cmp(&b.0));
+
+            let mut chunk = String::new();
+            for (account, fields) in entries {
+                let mut line = Map::new();
+                line.insert("account".to_owned(), to_value(account).unwrap());
+                line.extend(fields);
+                chunk.push_str(&Value::Object(line).to_string());
+                chunk.push('\n');
+            }
+            if !chunk.is_empty() && !send(chunk) {
+                return;
+            }
+
+            match next {
+                Some(next) => pages.set_start(next),
+                None => return,
+            }
+        }
+    }
+}
+
+enum AccountPages {
+    Ledger(LedgerArgs),
+    Frontiers(FrontiersArgs),
+    Delegators(DelegatorsArgs),
+    Unopened(UnopenedArgs),
+}
+
+type Page = (Vec<(Account, Map<String, Value>)>, Option<Account>);
+
+impl AccountPages {
+    /// The total number of accounts that were requested
+    fn count(&self) -> u64 {
+        match self {
+            Self::Ledger(args) => unwrap_u64_or_max(args.count),
+            Self::Frontiers(args) => args.count.into(),
+            Self::Delegators(args) => unwrap_u64_or(args.count, 1024),
+            Self::Unopened(args) => unwrap_u64_or_max(args.count),
+        }
+    }
+
+    /// Returns the entries of the page and the start of the next page
+    fn next_page(&mut self, handler: &RpcCommandHandler, count: u64) -> Page {
+        match self {
+            Self::Ledger(args) => {
+                args.count = Some(count.into());
+                let response = handler.ledger(args.clone());
+                let entries = response
+                    .accounts
+                    .into_iter()
+                    .map(|(account, info)| (account, fields(info)))
+                    .collect();
+                (entries, response.next)
+            }
+            Self::Frontiers(args) => {
+                args.count = count.into();
+                let response = handler.frontiers(args.clone());
+                let entries = response
+                    .frontiers
+                    .unwrap_or_default()
+                    .into_iter()
+                    .map(|(account, frontier)| (account, field("frontier", frontier)))
+                    .collect();
+                (entries, response.next)
+            }
+            Self::Delegators(args) => {
+                args.count = Some(count.into());
+                let response = handler.delegators(args.clone());
+                let entries = response
+                    .delegators
+                    .into_iter()
+                    .map(|(account, balance)| (account, field("balance", balance)))
+                    .collect();
+                (entries, response.next)
+            }
+            Self::Unopened(args) => {
+                args.count = Some(count.into());
+                let response = handler.unopened(args.clone());
+                let entries = response
+                    .accounts
+                    .into_iter()
+                    .map(|(account, amount)| (account, field("amount", amount)))
+                    .collect();
+                (entries, response.next)
+            }
+        }
+    }
+
+    fn set_start(&mut self, next: Account) {
+        match self {
+            Self::Ledger(args) => args.account = Some(next),
+            Self::Frontiers(args) => args.account = next,
+            Self::Delegators(args) => args.start = Some(next),
+            Self::Unopened(args) => args.account = Some(next),
+        }
+    }
+}
+
+fn fields(value: impl Serialize) -> Map<String, Value> {
+    match to_value(value) {
+        Ok(Value::Object(fields)) => fields,
+        _ => Map::new(),
+    }
+}
+
+fn field(name: &str, value: impl Serialize) -> Map<String, Value> {
+    let mut fields = Map::new();
+    fields.insert(name.to_owned(), to_value(value).unwrap_or(Value::Null));
+    fields
+}
+
+fn error_line(error: String) -> String {
+    let mut line = to_value(RpcError::new(error)).unwrap().to_string();
+    line.push('\n');
+    line
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn stream_account_walks() {
+        assert!(can_stream(&RpcCommand::frontiers(Account::zero(), 1)));
+        assert!(can_stream(&RpcCommand::Delegators(DelegatorsArgs::new(
+            Account::zero()
+        ))));
+        assert!(can_stream(&RpcCommand::ledger(LedgerArgs::default())));
+    }
+
+    #[test]
+    fn dont_stream_sorted_ledger() {
+        assert!(!can_stream(&RpcCommand::ledger(
+            LedgerArgs::builder().sorted().build()
+        )));
+        assert!(!can_stream(&RpcCommand::block_count()));
+    }
+
+    #[test]
+    fn error_line_is_terminated() {
+        assert_eq!(error_line("test".to_owned()), "{\"error\":\"test\"}\n");
+    }
+}
@@ -23,6 +23,14 @@ impl RpcCommandHandler {
                 );
                 Ok(sink.finish())
             }
+            StatsType::Latencies => {
+                self.node.stats.log_latencies(&mut sink).unwrap();
+                sink.add(
+                    "stat_duration_seconds",
+                    self.node.stats.last_reset().as_secs(),
+                );
+                Ok(sink.finish())
+            }
             StatsType::Database => Ok(serde_json::to_value(self.node.store.memory_stats()?)?),
             StatsType::Objects => Ok(ContainerInfo::builder()
                 .node("node", self.node.container_info())
@@ -13,6 +13,8 @@ pub struct RpcServerConfig {
     pub address: String,
     pub port: u16,
     pub enable_control: bool,
+    /// Serves the node metrics in the Prometheus text format on GET /metrics
+    pub enable_metrics: bool,
     pub max_json_depth: u8,
     pub max_request_size: u64,
     pub rpc_logging: RpcServerLoggingConfig,
@@ -39,6 +41,7 @@ impl RpcServerConfig {
             address: Ipv6Addr::LOCALHOST.to_string(),
             port,
             enable_control,
+            enable_metrics: false,
             max_json_depth: 20,
             max_request_size: 32 * 1024 * 1024,
             rpc_logging: RpcServerLoggingConfig::default(),
@@ -0,0 +1,168 @@
+use rsban_rpc_messages::RpcCommand;
+use std::sync::Arc;
+use tokio::{
+    runtime::Handle,
+    sync::{OwnedSemaphorePermit, Semaphore},
+    task::spawn_blocking,
+};
+
+/// Commands are executed in lanes with separate concurrency limits,
+/// so that cheap lookups don't queue up behind commands which scan the ledger
+/// and scans don't queue up behind commands which wait for work
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+pub(crate) enum RpcLane {
+    Cheap,
+    /// Commands which scan tables or read many keys
+    Heavy,
+    /// Commands which generate work. They mostly wait for the work pool
+    Work,
+}
+
+impl RpcLane {
+    pub fn for_command(command: &RpcCommand) -> Self {
+        match command {
+            RpcCommand::AccountHistory(_)
+            | RpcCommand::AccountsBalances(_)
+            | RpcCommand::AccountsCreate(_)
+            | RpcCommand::AccountsFrontiers(_)
+            | RpcCommand::AccountsReceivable(_)
+            | RpcCommand::AccountsRepresentatives(_)
+            | RpcCommand::Blocks(_)
+            | RpcCommand::BlocksInfo(_)
+            | RpcCommand::Chain(_)
+            | RpcCommand::Delegators(_)
+            | RpcCommand::DelegatorsCount(_)
+            | RpcCommand::Frontiers(_)
+            | RpcCommand::Ledger(_)
+            | RpcCommand::PopulateBacklog
+            | RpcCommand::Receivable(_)
+            | RpcCommand::Representatives(_)
+            | RpcCommand::Republish(_)
+            | RpcCommand::SearchReceivable(_)
+            | RpcCommand::SearchReceivableAll
+            | RpcCommand::Successors(_)
+            | RpcCommand::Unchecked(_)
+            | RpcCommand::UncheckedKeys(_)
+            | RpcCommand::Unopened(_)
+            | RpcCommand::WalletBalances(_)
+            | RpcCommand::WalletFrontiers(_)
+            | RpcCommand::WalletHistory(_)
+            | RpcCommand::WalletInfo(_)
+            | RpcCommand::WalletLedger(_)
+            | RpcCommand::WalletReceivable(_)
+            | RpcCommand::WalletRepublish(_) => RpcLane::Heavy,
+            RpcCommand::BlockCreate(_)
+            | RpcCommand::Receive(_)
+            | RpcCommand::Send(_)
+            | RpcCommand::WorkGenerate(_) => RpcLane::Work,
+            _ => RpcLane::Cheap,
+        }
+    }
+}
+
+/// Runs the blocking command handlers. Each lane has a bounded number of
+/// handlers which may run at the same time, further requests wait for a free slot.
+pub(crate) struct RpcExecutor {
+    cheap: Arc<Semaphore>,
+    heavy: Arc<Semaphore>,
+    work: Arc<Semaphore>,
+}
+
+impl RpcExecutor {
+    pub fn new(cheap_limit: usize, heavy_limit: usize, work_limit: usize) -> Self {
+        Self {
+            cheap: Arc::new(Semaphore::new(cheap_limit.max(1))),
+            heavy: Arc::new(Semaphore::new(heavy_limit.max(1))),
+            work: Arc::new(Semaphore::new(work_limit.max(1))),
+        }
+    }
+
+    /// Cheap commands are short, so they get more slots than there are cores.
+    /// Heavy commands get at most half of the cores, so they can't starve the node.
+    /// Work is generated by the work pool, so the work lane only limits the waiting handlers
+    pub fn for_parallelism(parallelism: usize) -> Self {
+        Self::new(parallelism * 4, parallelism / 2, parallelism)
+    }
+
+    pub async fn execute<T, F>(&self, lane: RpcLane, f: F) -> T
+    where
+        T: Send + 'static,
+        F: FnOnce() -> T + Send + 'static,
+    {
+        let permit = self.permit(lane).await;
+        spawn_blocking(move || {
+            let _permit = permit;
+            f()
+        })
+        .await
+        .unwrap()
+    }
+
+    /// Waits for a free slot in the lane. The slot is taken until the permit is dropped
+    pub async fn permit(&self, lane: RpcLane) -> OwnedSemaphorePermit {
+        let semaphore = match lane {
+            RpcLane::Cheap => &self.cheap,
+            RpcLane::Heavy => &self.heavy,
+            RpcLane::Work => &self.work,
+        };
+        Arc::clone(semaphore).acquire_owned().await.unwrap()
+    }
+
+    /// Like `permit`, but for code on a blocking thread of the runtime
+    pub fn blocking_permit(&self, lane: RpcLane) -> OwnedSemaphorePermit {
+        Handle::current().block_on(self.permit(lane))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use rsban_core::{Account, BlockHash};
+    use rsban_rpc_messages::AccountArg;
+
+    #[test]
+    fn classify_commands() {
+        assert_eq!(
+            RpcLane::for_command(&RpcCommand::block_count()),
+            RpcLane::Cheap
+        );
+        assert_eq!(
+            RpcLane::for_command(&RpcCommand::DelegatorsCount(AccountArg::new(
+                Account::zero()
+            ))),
+            RpcLane::Heavy
+        );
+        assert_eq!(
+            RpcLane::for_command(&RpcCommand::work_generate(BlockHash::zero().into())),
+            RpcLane::Work
+        );
+    }
+
+    #[test]
+    fn cheap_lane_is_not_blocked_by_heavy_lane() {
+        let runtime = tokio::runtime::Builder::new_current_thread()
+            .build()
+            .unwrap();
+        let executor = Arc::new(RpcExecutor::new(1, 1, 1));
+        let (tx_release, rx_release) = std::sync::mpsc::channel::<()>();
+
+        runtime.block_on(async {
+            let heavy_permit = executor.permit(RpcLane::Heavy).await;
+            let heavy = tokio::spawn({
+                let executor = executor.clone();
+                async move {
+                    executor
+                        .execute(RpcLane::Heavy, move || rx_release.recv().unwrap())
+                        .await
+                }
+            });
+
+            // The heavy lane is full, but cheap commands still run
+            assert_eq!(executor.execute(RpcLane::Cheap, || 42).await, 42);
+
+            drop(heavy_permit);
+            tx_release.send(()).unwrap();
+            heavy.await.unwrap();
+        });
+    }
+}
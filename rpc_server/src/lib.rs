@@ -1,6 +1,9 @@
 pub(crate) mod command_handler;
 mod config;
+mod executor;
+mod metrics;
 mod server;
+mod streaming;
 mod toml;
 
 pub use config::*;
@@ -0,0 +1,578 @@
+use crate::streaming::blocking_body;
+use axum::body::Body;
+use rsban_core::utils::ContainerInfo;
+use rsban_ledger::CommitLatencyPercentiles;
+use rsban_node::{
+    stats::{LatencySummary, StatsLogSink},
+    utils::ExecutorMetrics,
+    Node,
+};
+use rsban_store_lmdb::MemoryStats;
+use std::{
+    any::Any,
+    fmt::{Display, Write},
+    sync::Arc,
+    time::SystemTime,
+};
+
+pub(crate) const METRICS_CONTENT_TYPE: &str = "text/plain; version=0.0.4; charset=utf-8";
+
+/// Streams the node metrics in the Prometheus text exposition format.
+/// The metrics are generated section by section and every section is sent
+/// as soon as it is ready.
+pub(crate) fn metrics_body(node: Arc<Node>) -> Body {
+    blocking_body(move |send| write_metrics(&node, send))
+}
+
+/// Writes all sections and passes each one to `send`. Stops early if `send` returns false
+fn write_metrics(node: &Node, send: &mut dyn FnMut(String) -> bool) {
+    let mut writer = MetricsWriter::new();
+
+    // Both only read atomics and don't block the threads which update them
+    let _ = node.stats.log_counters(&mut writer);
+    if !send(writer.take()) {
+        return;
+    }
+    let _ = node.stats.log_latencies(&mut writer);
+    if !send(writer.take()) {
+        return;
+    }
+
+    // Every component holds its own lock only while its sizes are read
+    writer.write_container_infos(&[
+        ("block_processor", node.block_processor.container_info()),
+        ("vote_processor", node.vote_processor_queue.container_info()),
+        (
+            "message_processor",
+            node.inbound_message_queue.container_info(),
+        ),
+        ("vote_cache", node.vote_cache.container_info()),
+        ("unchecked", node.unchecked.container_info()),
+        ("confirming_set", node.confirming_set.container_info()),
+        ("active", node.active.container_info()),
+    ]);
+    if !send(writer.take()) {
+        return;
+    }
+
+    writer.write_executor_metrics(&node.executor.metrics());
+    if !send(writer.take()) {
+        return;
+    }
+
+    let write_queue = &node.ledger.write_queue;
+    writer.write_commit_metrics(
+        &write_queue.commit_latency(),
+        write_queue.sync_count(),
+        write_queue.sync_failures(),
+    );
+    if !send(writer.take()) {
+        return;
+    }
+
+    if let Ok(stats) = node.store.memory_stats() {
+        writer.write_lmdb_stats(&stats);
+    }
+    send(writer.take());
+}
+
+/// Formats metrics in the Prometheus text exposition format.
+/// All samples of a metric family must be written at once, because the
+/// format requires them to form a single group.
+pub(crate) struct MetricsWriter {
+    output: String,
+    families: Vec<&'static str>,
+}
+
+impl MetricsWriter {
+    pub fn new() -> Self {
+        Self {
+            output: String::new(),
+            families: Vec::new(),
+        }
+    }
+
+    /// Returns the output written since the last call
+    pub fn take(&mut self) -> String {
+        std::mem::take(&mut self.output)
+    }
+
+    pub fn write_container_infos(&mut self, components: &[(&str, ContainerInfo)]) {
+        self.family(
+            "rsban_container_count",
+            "gauge",
+            "Number of elements in a container",
+        );
+        for (component, info) in components {
+            info.visit_leaves(&mut |path, leaf| {
+                let container = container_path(path, &leaf.name);
+                self.sample(
+                    "rsban_container_count",
+                    &[("component", *component), ("container", &container)],
+                    leaf.info.count,
+                );
+            });
+        }
+
+        self.family(
+            "rsban_container_size_bytes",
+            "gauge",
+            "Approximate memory used by the elements of a container",
+        );
+        for (component, info) in components {
+            info.visit_leaves(&mut |path, leaf| {
+                let container = container_path(path, &leaf.name);
+                self.sample(
+                    "rsban_container_size_bytes",
+                    &[("component", *component), ("container", &container)],
+                    leaf.info.count * leaf.info.element_size,
+                );
+            });
+        }
+    }
+
+    pub fn write_executor_metrics(&mut self, metrics: &[ExecutorMetrics]) {
+        self.family(
+            "rsban_executor_queued_tasks",
+            "gauge",
+            "Number of tasks waiting for an executor thread",
+        );
+        for m in metrics {
+            self.sample(
+                "rsban_executor_queued_tasks",
+                &[("priority", m.priority.as_str())],
+                m.queued,
+            );
+        }
+
+        self.family(
+            "rsban_executor_tasks_total",
+            "counter",
+            "Number of tasks run by the executor",
+        );
+        for m in metrics {
+            self.sample(
+                "rsban_executor_tasks_total",
+                &[("priority", m.priority.as_str())],
+                m.executed,
+            );
+        }
+
+        self.family(
+            "rsban_executor_task_cpu_seconds_total",
+            "counter",
+            "CPU time the executor threads spent in tasks",
+        );
+        for m in metrics {
+            self.sample(
+                "rsban_executor_task_cpu_seconds_total",
+                &[("priority", m.priority.as_str())],
+                m.task_cpu_time.as_secs_f64(),
+            );
+        }
+
+        const DELAY: &str = "rsban_executor_queue_delay_microseconds";
+        self.family(
+            DELAY,
+            "summary",
+            "Time from submitting a task until an executor thread started it",
+        );
+        for m in metrics {
+            let priority = m.priority.as_str();
+            for (quantile, value) in [
+                ("0.5", m.queue_delay.p50),
+                ("0.9", m.queue_delay.p90),
+                ("0.99", m.queue_delay.p99),
+            ] {
+                self.sample(
+                    DELAY,
+                    &[("priority", priority), ("quantile", quantile)],
+                    value,
+                );
+            }
+            self.sample(
+                "rsban_executor_queue_delay_microseconds_sum",
+                &[("priority", priority)],
+                m.queue_delay.sum,
+            );
+            self.sample(
+                "rsban_executor_queue_delay_microseconds_count",
+                &[("priority", priority)],
+                m.queue_delay.count,
+            );
+        }
+    }
+
+    /// The syncs are only counted if the commits of the writers are flushed together
+    pub fn write_commit_metrics(
+        &mut self,
+        latency: &CommitLatencyPercentiles,
+        sync_count: u64,
+        sync_failures: u64,
+    ) {
+        const LATENCY: &str = "rsban_ledger_commit_latency_microseconds";
+        self.family(
+            LATENCY,
+            "summary",
+            "Time from committing a write transaction until it is durable, of the most recent commits",
+        );
+        for (quantile, value) in [
+            ("0.5", latency.p50),
+            ("0.9", latency.p90),
+            ("0.99", latency.p99),
+            ("1", latency.max),
+        ] {
+            self.sample(LATENCY, &[("quantile", quantile)], value.as_micros());
+        }
+        self.sample(
+            "rsban_ledger_commit_latency_microseconds_count",
+            &[],
+            latency.count,
+        );
+
+        self.family(
+            "rsban_ledger_syncs_total",
+            "counter",
+            "Number of flushes of the ledger to disk",
+        );
+        self.sample("rsban_ledger_syncs_total", &[], sync_count);
+        self.family(
+            "rsban_ledger_sync_failures_total",
+            "counter",
+            "Number of failed flushes of the ledger to disk, which were retried",
+        );
+        self.sample("rsban_ledger_sync_failures_total", &[], sync_failures);
+    }
+
+    pub fn write_lmdb_stats(&mut self, stats: &MemoryStats) {
+        let gauges = [
+            ("rsban_lmdb_entries", "Number of entries", stats.entries),
+            (
+                "rsban_lmdb_depth",
+                "Depth of the B-tree",
+                stats.depth as usize,
+            ),
+            (
+                "rsban_lmdb_branch_pages",
+                "Number of internal pages",
+                stats.branch_pages,
+            ),
+            (
+                "rsban_lmdb_leaf_pages",
+                "Number of leaf pages",
+                stats.leaf_pages,
+            ),
+            (
+                "rsban_lmdb_overflow_pages",
+                "Number of overflow pages",
+                stats.overflow_pages,
+            ),
+            (
+                "rsban_lmdb_page_size_bytes",
+                "Size of a database page",
+                stats.page_size as usize,
+            ),
+        ];
+        for (name, help, value) in gauges {
+            self.family(name, "gauge", help);
+            self.sample(name, &[], value);
+        }
+    }
+
+    /// Writes the HELP and TYPE lines, unless they were already written for the family
+    fn family(&mut self, name: &'static str, kind: &str, help: &str) {
+        if self.families.contains(&name) {
+            return;
+        }
+        self.families.push(name);
+        let _ = writeln!(self.output, "# HELP {name} {help}");
+        let _ = writeln!(self.output, "# TYPE {name} {kind}");
+    }
+
+    fn sample(&mut self, name: &str, labels: &[(&str, &str)], value: impl Display) {
+        self.output.push_str(name);
+        if !labels.is_empty() {
+            self.output.push('{');
+            for (i, (key, value)) in labels.iter().enumerate() {
+                if i > 0 {
+                    self.output.push(',');
+                }
+                self.output.push_str(key);
+                self.output.push_str("=\"");
+                escape_label_value(&mut self.output, value);
+                self.output.push('"');
+            }
+            self.output.push('}');
+        }
+        let _ = writeln!(self.output, " {value}");
+    }
+}
+
+impl StatsLogSink for MetricsWriter {
+    fn begin(&mut self) -> anyhow::Result<()> {
+        Ok(())
+    }
+
+    fn finalize(&mut self) {}
+
+    fn write_header(&mut self, _header: &str, _walltime: SystemTime) -> anyhow::Result<()> {
+        Ok(())
+    }
+
+    fn write_counter_entry(
+        &mut self,
+        _time: SystemTime,
+        entry_type: &str,
+        detail: &str,
+        dir: &str,
+        value: u64,
+    ) -> anyhow::Result<()> {
+        self.family("rsban_stats_total", "counter", "Node statistics counters");
+        self.sample(
+            "rsban_stats_total",
+            &[("type", entry_type), ("detail", detail), ("dir", dir)],
+            value,
+        );
+        Ok(())
+    }
+
+    /// Samples are not exported
+    fn write_sampler_entry(
+        &mut self,
+        _time: SystemTime,
+        _sample: &str,
+        _values: Vec<i64>,
+        _expected_min_max: (i64, i64),
+    ) -> anyhow::Result<()> {
+        Ok(())
+    }
+
+    fn write_latency_entry(
+        &mut self,
+        _time: SystemTime,
+        stage: &str,
+        source: &str,
+        summary: &LatencySummary,
+    ) -> anyhow::Result<()> {
+        const NAME: &str = "rsban_block_latency_microseconds";
+        self.family(
+            NAME,
+            "summary",
+            "Time from the arrival of a block until it reached the stage",
+        );
+        for (quantile, value) in [
+            ("0.5", summary.p50),
+            ("0.9", summary.p90),
+            ("0.99", summary.p99),
+            ("0.999", summary.p999),
+        ] {
+            self.sample(
+                NAME,
+                &[("stage", stage), ("source", source), ("quantile", quantile)],
+                value,
+            );
+        }
+        let labels = [("stage", stage), ("source", source)];
+        self.sample("rsban_block_latency_microseconds_sum", &labels, summary.sum);
+        self.sample(
+            "rsban_block_latency_microseconds_count",
+            &labels,
+            summary.count,
+        );
+        Ok(())
+    }
+
+    fn rotate(&mut self) -> anyhow::Result<()> {
+        Ok(())
+    }
+
+    fn entries(&self) -> usize {
+        0
+    }
+
+    fn inc_entries(&mut self) {}
+
+    fn to_string(&self) -> String {
+        self.output.clone()
+    }
+
+    fn to_object(&self) -> Option<&dyn Any> {
+        None
+    }
+}
+
+fn container_path(path: &[&str], leaf: &str) -> String {
+    let mut result = String::new();
+    for node in path {
+        result.push_str(node);
+        result.push('/');
+    }
+    result.push_str(leaf);
+    result
+}
+
+fn escape_label_value(output: &mut String, value: &str) {
+    for c in value.chars() {
+        match c {
+            '\\' => output.push_str("\\\\"),
+            '"' => output.push_str("\\\""),
+            '\n' => output.push_str("\\n"),
+            c => output.push(c),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use rsban_node::{
+        stats::{DetailType, Direction, StatType, Stats},
+        utils::TaskPriority,
+    };
+    use std::time::Duration;
+
+    #[test]
+    fn counters() {
+        let stats = Stats::default();
+        stats.inc(StatType::Ledger, DetailType::Send);
+        stats.inc_dir(StatType::Vote, DetailType::All, Direction::Out);
+        let mut writer = MetricsWriter::new();
+        stats.log_counters(&mut writer).unwrap();
+
+        assert_eq!(
+            writer.take(),
+            "# HELP rsban_stats_total Node statistics counters\n\
+             # TYPE rsban_stats_total counter\n\
+             rsban_stats_total{type=\"ledger\",detail=\"all\",dir=\"in\"} 0\n\
+             rsban_stats_total{type=\"ledger\",detail=\"send\",dir=\"in\"} 1\n\
+             rsban_stats_total{type=\"vote\",detail=\"all\",dir=\"out\"} 1\n"
+        );
+    }
+
+    #[test]
+    fn latencies() {
+        let mut writer = MetricsWriter::new();
+        let summary = LatencySummary {
+            count: 2,
+            sum: 21,
+            mean: 10,
+            p50: 8,
+            p90: 12,
+            p99: 12,
+            p999: 12,
+            max: 12,
+        };
+        writer
+            .write_latency_entry(SystemTime::now(), "processed", "live", &summary)
+            .unwrap();
+
+        let output = writer.take();
+        assert!(output.contains("# TYPE rsban_block_latency_microseconds summary\n"));
+        assert!(output.contains(
+            "rsban_block_latency_microseconds{stage=\"processed\",source=\"live\",quantile=\"0.5\"} 8\n"
+        ));
+        assert!(output.contains(
+            "rsban_block_latency_microseconds_sum{stage=\"processed\",source=\"live\"} 21\n"
+        ));
+        assert!(output.contains(
+            "rsban_block_latency_microseconds_count{stage=\"processed\",source=\"live\"} 2\n"
+        ));
+    }
+
+    #[test]
+    fn container_infos() {
+        let mut writer = MetricsWriter::new();
+        writer.write_container_infos(&[
+            ("unchecked", [("entries", 3, 100)].into()),
+            (
+                "active",
+                ContainerInfo::builder()
+                    .leaf("roots", 2, 10)
+                    .node("recently_confirmed", [("confirmed", 5, 20)].into())
+                    .finish(),
+            ),
+        ]);
+
+        assert_eq!(
+            writer.take(),
+            "# HELP rsban_container_count Number of elements in a container\n\
+             # TYPE rsban_container_count gauge\n\
+             rsban_container_count{component=\"unchecked\",container=\"entries\"} 3\n\
+             rsban_container_count{component=\"active\",container=\"roots\"} 2\n\
+             rsban_container_count{component=\"active\",container=\"recently_confirmed/confirmed\"} 5\n\
+             # HELP rsban_container_size_bytes Approximate memory used by the elements of a container\n\
+             # TYPE rsban_container_size_bytes gauge\n\
+             rsban_container_size_bytes{component=\"unchecked\",container=\"entries\"} 300\n\
+             rsban_container_size_bytes{component=\"active\",container=\"roots\"} 20\n\
+             rsban_container_size_bytes{component=\"active\",container=\"recently_confirmed/confirmed\"} 100\n"
+        );
+    }
+
+    #[test]
+    fn executor_metrics() {
+        let mut writer = MetricsWriter::new();
+        writer.write_executor_metrics(&[ExecutorMetrics {
+            priority: TaskPriority::Votes,
+            queued: 3,
+            executed: 7,
+            task_cpu_time: Duration::from_millis(1500),
+            queue_delay: LatencySummary {
+                count: 7,
+                sum: 75,
+                mean: 10,
+                ..Default::default()
+            },
+        }]);
+
+        let output = writer.take();
+        assert!(output.contains("rsban_executor_queued_tasks{priority=\"votes\"} 3\n"));
+        assert!(output.contains("rsban_executor_tasks_total{priority=\"votes\"} 7\n"));
+        assert!(output.contains("rsban_executor_task_cpu_seconds_total{priority=\"votes\"} 1.5\n"));
+        assert!(
+            output.contains("rsban_executor_queue_delay_microseconds_sum{priority=\"votes\"} 75\n")
+        );
+    }
+
+    #[test]
+    fn commit_metrics() {
+        let mut writer = MetricsWriter::new();
+        let latency = CommitLatencyPercentiles {
+            count: 4,
+            p50: Duration::from_micros(150),
+            p90: Duration::from_micros(300),
+            p99: Duration::from_micros(300),
+            max: Duration::from_micros(400),
+        };
+        writer.write_commit_metrics(&latency, 3, 1);
+
+        let output = writer.take();
+        assert!(output.contains("# TYPE rsban_ledger_commit_latency_microseconds summary\n"));
+        assert!(output.contains("rsban_ledger_commit_latency_microseconds{quantile=\"0.5\"} 150\n"));
+        assert!(output.contains("rsban_ledger_commit_latency_microseconds_count 4\n"));
+        assert!(output.contains("rsban_ledger_syncs_total 3\n"));
+        assert!(output.contains("rsban_ledger_sync_failures_total 1\n"));
+    }
+
+    #[test]
+    fn write_family_header_once() {
+        let mut writer = MetricsWriter::new();
+        writer
+            .write_counter_entry(SystemTime::now(), "a", "b", "in", 1)
+            .unwrap();
+        writer.take();
+        writer
+            .write_counter_entry(SystemTime::now(), "a", "c", "in", 1)
+            .unwrap();
+        assert_eq!(
+            writer.take(),
+            "rsban_stats_total{type=\"a\",detail=\"c\",dir=\"in\"} 1\n"
+        );
+    }
+
+    #[test]
+    fn escape_label_values() {
+        let mut output = String::new();
+        escape_label_value(&mut output, "a\"b\\c\nd");
+        assert_eq!(output, "a\\\"b\\\\c\\nd");
+    }
+}
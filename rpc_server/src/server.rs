@@ -1,28 +1,55 @@
-use crate::command_handler::RpcCommandHandler;
+use crate::{
+    command_handler::{can_stream, RpcCommandHandler},
+    executor::{RpcExecutor, RpcLane},
+    metrics::{metrics_body, METRICS_CONTENT_TYPE},
+    streaming::blocking_body,
+};
 use anyhow::{Context, Result};
-use axum::{extract::State, http::Request, middleware::map_request, routing::post, Json, Router};
+use axum::{
+    extract::State,
+    http::{header, HeaderMap, Request},
+    middleware::map_request,
+    response::{IntoResponse, Response},
+    routing::{get, post},
+    Json, Router,
+};
 use rsban_node::Node;
 use rsban_rpc_messages::RpcCommand;
 use std::{future::Future, sync::Arc};
-use tokio::{net::TcpListener, task::spawn_blocking};
+use tokio::net::TcpListener;
 use tracing::info;
 
 pub async fn run_rpc_server<F>(
     node: Arc<Node>,
     listener: TcpListener,
     enable_control: bool,
+    enable_metrics: bool,
     tx_stop: tokio::sync::oneshot::Sender<()>,
     shutdown: F,
 ) -> Result<()>
 where
     F: Future<Output = ()> + Send + 'static,
 {
-    let command_handler = RpcCommandHandler::new(node, enable_control, tx_stop);
+    let parallelism = std::thread::available_parallelism()
+        .map(|i| i.get())
+        .unwrap_or(1);
+    let state = RpcState {
+        command_handler: RpcCommandHandler::new(node.clone(), enable_control, tx_stop),
+        executor: Arc::new(RpcExecutor::for_parallelism(parallelism)),
+    };
 
-    let app = Router::new()
+    let mut app = Router::new()
         .route("/", post(handle_rpc))
         .layer(map_request(set_json_content))
-        .with_state(command_handler);
+        .with_state(state);
+
+    if enable_metrics {
+        app = app.merge(
+            Router::new()
+                .route("/metrics", get(handle_metrics))
+                .with_state(node),
+        );
+    }
 
     info!("RPC listening address: {}", listener.local_addr()?);
 
@@ -32,14 +59,53 @@ where
         .context("Failed to run the server")
 }
 
+#[derive(Clone)]
+struct RpcState {
+    command_handler: RpcCommandHandler,
+    executor: Arc<RpcExecutor>,
+}
+
+const NDJSON_CONTENT_TYPE: &str = "application/x-ndjson";
+
 async fn handle_rpc(
-    State(command_handler): State<RpcCommandHandler>,
+    State(state): State<RpcState>,
+    headers: HeaderMap,
     Json(command): Json<RpcCommand>,
-) -> Json<serde_json::Value> {
-    let response = spawn_blocking(move || command_handler.handle(command))
-        .await
-        .unwrap();
-    Json(response)
+) -> Response {
+    let lane = RpcLane::for_command(&command);
+    let command_handler = state.command_handler;
+
+    if accepts_ndjson(&headers) && can_stream(&command) {
+        // A slot is taken for every page, so the stream doesn't hold it while the client reads
+        let executor = state.executor;
+        let body = blocking_body(move |send| {
+            command_handler.handle_ndjson(command, || executor.blocking_permit(lane), send)
+        });
+        return ([(header::CONTENT_TYPE, NDJSON_CONTENT_TYPE)], body).into_response();
+    }
+
+    let response = state
+        .executor
+        .execute(lane, move || command_handler.handle(command))
+        .await;
+    Json(response).into_response()
+}
+
+/// Commands which walk over accounts are streamed as newline delimited JSON,
+/// if the client accepts it
+fn accepts_ndjson(headers: &HeaderMap) -> bool {
+    headers
+        .get_all(header::ACCEPT)
+        .iter()
+        .filter_map(|value| value.to_str().ok())
+        .any(|value| value.contains(NDJSON_CONTENT_TYPE))
+}
+
+async fn handle_metrics(State(node): State<Arc<Node>>) -> impl IntoResponse {
+    (
+        [(header::CONTENT_TYPE, METRICS_CONTENT_TYPE)],
+        metrics_body(node),
+    )
 }
 
 /// JSON is the default and the only accepted content type!
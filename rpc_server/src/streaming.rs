@@ -0,0 +1,22 @@
+use axum::body::Body;
+use std::convert::Infallible;
+use tokio::{sync::mpsc, task::spawn_blocking};
+
+/// Runs `write` on a blocking thread and streams every chunk which it passes
+/// to its callback. Only a few chunks are buffered, so a slow client slows down
+/// the writer instead of growing the buffer. The callback returns false once
+/// the client disconnected, in which case `write` should stop.
+pub(crate) fn blocking_body<F>(write: F) -> Body
+where
+    F: FnOnce(&mut dyn FnMut(String) -> bool) + Send + 'static,
+{
+    let (tx, rx) = mpsc::channel::<String>(4);
+    spawn_blocking(move || write(&mut |chunk| tx.blocking_send(chunk).is_ok()));
+
+    let chunks = futures_util::stream::unfold(rx, |mut rx| async move {
+        rx.recv()
+            .await
+            .map(|chunk| (Ok::<_, Infallible>(chunk), rx))
+    });
+    Body::from_stream(chunks)
+}
@@ -5,6 +5,7 @@ use serde::{Deserialize, Serialize};
 pub struct RpcServerToml {
     pub address: Option<String>,
     pub enable_control: Option<bool>,
+    pub enable_metrics: Option<bool>,
     pub max_json_depth: Option<u8>,
     pub max_request_size: Option<u64>,
     pub port: Option<u16>,
@@ -18,6 +19,7 @@ impl From<&RpcServerConfig> for RpcServerToml {
             address: Some(config.address.clone()),
             port: Some(config.port),
             enable_control: Some(config.enable_control),
+            enable_metrics: Some(config.enable_metrics),
             max_json_depth: Some(config.max_json_depth),
             max_request_size: Some(config.max_request_size),
             logging: Some((&config.rpc_logging).into()),
@@ -37,6 +39,9 @@ impl RpcServerConfig {
         if let Some(enable_control) = toml.enable_control {
             self.enable_control = enable_control;
         }
+        if let Some(enable_metrics) = toml.enable_metrics {
+            self.enable_metrics = enable_metrics;
+        }
         if let Some(max_json_depth) = toml.max_json_depth {
             self.max_json_depth = max_json_depth;
         }
@@ -128,6 +133,7 @@ mod tests {
     static DEFAULT_TOML_STR: &str = r#"
         address = "::1"
         enable_control = false
+        enable_metrics = false
     	max_json_depth = 20
     	max_request_size = 33554432
         port = 55000
@@ -144,6 +150,7 @@ mod tests {
     static MODIFIED_TOML_STR: &str = r#"
         address = "0:0:0:0:0:ffff:7f01:101"
     	enable_control = true
+    	enable_metrics = true
     	max_json_depth = 9
     	max_request_size = 999
     	port = 999
@@ -183,6 +190,10 @@ mod tests {
             deserialized_rpc_config.enable_control,
             default_rpc_config.enable_control
         );
+        assert_ne!(
+            deserialized_rpc_config.enable_metrics,
+            default_rpc_config.enable_metrics
+        );
         assert_ne!(
             deserialized_rpc_config.max_json_depth,
             default_rpc_config.max_json_depth
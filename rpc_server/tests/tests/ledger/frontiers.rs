@@ -1,3 +1,4 @@
+use rsban_core::Account;
 use rsban_ledger::{DEV_GENESIS_ACCOUNT, DEV_GENESIS_HASH};
 use test_helpers::{setup_rpc_client_and_server, System};
 
@@ -25,3 +26,18 @@ fn frontiers() {
         &*DEV_GENESIS_HASH
     );
 }
+
+#[test]
+fn frontiers_returns_next_page() {
+    let mut system = System::new();
+    let node = system.make_node();
+
+    let server = setup_rpc_client_and_server(node.clone(), true);
+
+    let result = node
+        .runtime
+        .block_on(async { server.client.frontiers(Account::zero(), 0).await.unwrap() });
+
+    assert_eq!(result.frontiers.unwrap().len(), 0);
+    assert_eq!(result.next, Some(*DEV_GENESIS_ACCOUNT));
+}
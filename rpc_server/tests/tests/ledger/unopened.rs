@@ -86,3 +86,31 @@ fn unopened_fails_without_enable_control() {
         Some("node returned error: \"RPC control is disabled\"".to_string())
     );
 }
+
+#[test]
+fn unopened_returns_next_page() {
+    let mut system = System::new();
+    let node = system.make_node();
+
+    let mut lattice = UnsavedBlockLatticeBuilder::new();
+    let send1 = lattice.genesis().send(Account::from(1), 1);
+    let send2 = lattice.genesis().send(Account::from(2), 1);
+    node.process(send1).unwrap();
+    node.process(send2).unwrap();
+
+    let server = setup_rpc_client_and_server(node.clone(), true);
+
+    let args = UnopenedArgs {
+        account: Some(Account::from(1)),
+        count: Some(1.into()),
+        ..Default::default()
+    };
+
+    let result = node
+        .runtime
+        .block_on(async { server.client.unopened(args).await.unwrap() });
+
+    assert_eq!(result.accounts.len(), 1);
+    assert!(result.accounts.contains_key(&Account::from(1)));
+    assert_eq!(result.next, Some(Account::from(2)));
+}
@@ -4,6 +4,7 @@ use crate::{
     LmdbReadTransaction, LmdbWriteTransaction, Transaction, ACCOUNT_TEST_DATABASE,
 };
 use lmdb::{DatabaseFlags, WriteFlags};
+use lmdb_sys::MDB_SET_RANGE;
 use rsban_core::{
     utils::{BufferReader, Deserialize},
     Account, AccountInfo,
@@ -76,6 +77,33 @@ impl LmdbAccountStore {
         }
     }
 
+    /// Looks up all accounts with a single cursor. If the accounts are sorted,
+    /// the cursor moves forward through the table and most lookups stay on the
+    /// page of the previous one, instead of descending the B-tree for each key.
+    pub fn get_sorted(
+        &self,
+        tx: &dyn Transaction,
+        accounts: &[Account],
+    ) -> Vec<Option<AccountInfo>> {
+        let cursor = tx
+            .open_ro_cursor(self.database)
+            .expect("could not read from account store");
+
+        accounts
+            .iter()
+            .map(
+                |account| match cursor.get(Some(account.as_bytes()), None, MDB_SET_RANGE) {
+                    Ok((Some(key), value)) if key == account.as_bytes() => {
+                        let mut stream = BufferReader::new(value);
+                        AccountInfo::deserialize(&mut stream).ok()
+                    }
+                    Ok(_) | Err(lmdb::Error::NotFound) => None,
+                    Err(e) => panic!("Could not load account info {:?}", e),
+                },
+            )
+            .collect()
+    }
+
     pub fn del(&self, transaction: &mut LmdbWriteTransaction, account: &Account) {
         transaction
             .delete(self.database, account.as_bytes(), None)
@@ -250,6 +278,32 @@ mod tests {
         assert_eq!(result, Some(info));
     }
 
+    #[test]
+    fn get_sorted() {
+        let info1 = AccountInfo::new_test_instance();
+        let info3 = AccountInfo {
+            head: BlockHash::from(3),
+            ..AccountInfo::new_test_instance()
+        };
+        let fixture = Fixture::with_stored_accounts(vec![
+            (Account::from(1), info1.clone()),
+            (Account::from(3), info3.clone()),
+        ]);
+        let txn = fixture.env.tx_begin_read();
+
+        let result = fixture.store.get_sorted(
+            &txn,
+            &[
+                Account::from(1),
+                Account::from(2),
+                Account::from(3),
+                Account::from(4),
+            ],
+        );
+
+        assert_eq!(result, vec![Some(info1), None, Some(info3), None]);
+    }
+
     #[test]
     fn count() {
         let fixture = Fixture::with_stored_accounts(vec![
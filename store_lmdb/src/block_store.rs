@@ -6,7 +6,7 @@ use lmdb::{DatabaseFlags, WriteFlags};
 use num_traits::FromPrimitive;
 use rsban_core::{
     utils::{BufferReader, Deserialize, FixedSizeSerialize},
-    Block, BlockHash, BlockSideband, BlockType, SavedBlock,
+    Block, BlockHash, BlockSideband, BlockType, SavedBlock, SavedBlockView,
 };
 use rsban_nullable_lmdb::ConfiguredDatabase;
 #[cfg(feature = "output_tracking")]
@@ -121,6 +121,19 @@ impl LmdbBlockStore {
         })
     }
 
+    /// Returns a view into the database which decodes the fields lazily.
+    /// Use this when only a few fields of the block are needed
+    pub fn get_view<'a>(
+        &self,
+        txn: &'a dyn Transaction,
+        hash: &BlockHash,
+    ) -> Option<SavedBlockView<'a>> {
+        self.block_raw_get(txn, hash).map(|bytes| {
+            SavedBlockView::new(bytes)
+                .unwrap_or_else(|| panic!("Could not deserialize block {}!", hash))
+        })
+    }
+
     pub fn get_no_sideband(&self, txn: &dyn Transaction, hash: &BlockHash) -> Option<Block> {
         match self.block_raw_get(txn, hash) {
             None => None,
@@ -242,6 +255,27 @@ mod tests {
         assert_eq!(store.count(&txn), 0);
     }
 
+    #[test]
+    fn get_view() {
+        let block = SavedBlock::new_test_instance();
+        let fixture = Fixture::with_env(
+            LmdbEnv::new_null_with()
+                .database("blocks", LmdbDatabase::new_null(100))
+                .entry(block.hash().as_bytes(), &block.serialize_with_sideband())
+                .build()
+                .build(),
+        );
+        let txn = fixture.env.tx_begin_read();
+
+        let view = fixture.store.get_view(&txn, &block.hash()).unwrap();
+
+        assert_eq!(view.account(), block.account());
+        assert_eq!(view.height(), block.height());
+        assert_eq!(view.successor(), block.successor());
+        assert_eq!(view.to_saved_block(), block);
+        assert!(fixture.store.get_view(&txn, &BlockHash::from(1)).is_none());
+    }
+
     #[test]
     fn load_block_by_hash() {
         let block = SavedBlock::new_test_instance();
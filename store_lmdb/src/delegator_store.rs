@@ -0,0 +1,302 @@
+use crate::{
+    LmdbAccountStore, LmdbDatabase, LmdbEnv, LmdbWriteTransaction, Transaction,
+    DELEGATOR_TEST_DATABASE,
+};
+use lmdb::{DatabaseFlags, WriteFlags};
+use lmdb_sys::{MDB_NEXT, MDB_SET_RANGE};
+use rsban_core::{Account, PublicKey};
+use rsban_nullable_lmdb::ConfiguredDatabase;
+#[cfg(feature = "output_tracking")]
+use rsban_output_tracker::{OutputListenerMt, OutputTrackerMt};
+use std::sync::Arc;
+
+/// Secondary index of the account table, which maps every representative
+/// to the accounts that delegate to it. The accounts of a representative are
+/// stored next to each other, so they can be looked up without a full scan.
+pub struct LmdbDelegatorStore {
+    /// Representative (32 bytes) ++ Account (32 bytes) -> empty
+    database: LmdbDatabase,
+    #[cfg(feature = "output_tracking")]
+    put_listener: OutputListenerMt<(PublicKey, Account)>,
+    #[cfg(feature = "output_tracking")]
+    delete_listener: OutputListenerMt<(PublicKey, Account)>,
+}
+
+impl LmdbDelegatorStore {
+    pub fn new(env: Arc<LmdbEnv>) -> anyhow::Result<Self> {
+        let database = env
+            .environment
+            .create_db(Some("delegators"), DatabaseFlags::empty())?;
+        Ok(Self {
+            database,
+            #[cfg(feature = "output_tracking")]
+            put_listener: OutputListenerMt::new(),
+            #[cfg(feature = "output_tracking")]
+            delete_listener: OutputListenerMt::new(),
+        })
+    }
+
+    #[cfg(feature = "output_tracking")]
+    pub fn track_puts(&self) -> Arc<OutputTrackerMt<(PublicKey, Account)>> {
+        self.put_listener.track()
+    }
+
+    #[cfg(feature = "output_tracking")]
+    pub fn track_deletions(&self) -> Arc<OutputTrackerMt<(PublicKey, Account)>> {
+        self.delete_listener.track()
+    }
+
+    pub fn database(&self) -> LmdbDatabase {
+        self.database
+    }
+
+    pub fn put(
+        &self,
+        txn: &mut LmdbWriteTransaction,
+        representative: &PublicKey,
+        account: &Account,
+    ) {
+        #[cfg(feature = "output_tracking")]
+        self.put_listener.emit((*representative, *account));
+        txn.put(
+            self.database,
+            &delegator_key(representative, account),
+            &[0; 0],
+            WriteFlags::empty(),
+        )
+        .unwrap();
+    }
+
+    pub fn del(
+        &self,
+        txn: &mut LmdbWriteTransaction,
+        representative: &PublicKey,
+        account: &Account,
+    ) {
+        #[cfg(feature = "output_tracking")]
+        self.delete_listener.emit((*representative, *account));
+        match txn.delete(self.database, &delegator_key(representative, account), None) {
+            // The index is derived from the account table, so a missing entry is harmless
+            Ok(()) | Err(lmdb::Error::NotFound) => {}
+            Err(e) => panic!("Could not delete delegator {:?}", e),
+        }
+    }
+
+    pub fn exists(
+        &self,
+        txn: &dyn Transaction,
+        representative: &PublicKey,
+        account: &Account,
+    ) -> bool {
+        txn.exists(self.database, &delegator_key(representative, account))
+    }
+
+    /// Iterates the delegators of the representative in ascending order,
+    /// beginning with `start`
+    pub fn iter<'txn>(
+        &self,
+        txn: &'txn dyn Transaction,
+        representative: &PublicKey,
+        start: &Account,
+    ) -> impl Iterator<Item = Account> + 'txn {
+        let cursor = txn
+            .open_ro_cursor(self.database)
+            .expect("could not read from delegator store");
+        let representative = *representative;
+        let start_key = delegator_key(&representative, start);
+        let mut initialized = false;
+
+        std::iter::from_fn(move || {
+            let result = if initialized {
+                cursor.get(None, None, MDB_NEXT)
+            } else {
+                initialized = true;
+                cursor.get(Some(&start_key), None, MDB_SET_RANGE)
+            };
+            match result {
+                Ok((Some(key), _)) if key[..32] == *representative.as_bytes() => {
+                    Some(Account::from_bytes(key[32..].try_into().unwrap()))
+                }
+                Ok(_) | Err(lmdb::Error::NotFound) => None,
+                Err(e) => panic!("Could not read delegators {:?}", e),
+            }
+        })
+        .fuse()
+    }
+
+    pub fn count(&self, txn: &dyn Transaction, representative: &PublicKey) -> u64 {
+        self.iter(txn, representative, &Account::zero()).count() as u64
+    }
+
+    /// Number of entries for all representatives
+    pub fn count_all(&self, txn: &dyn Transaction) -> u64 {
+        txn.count(self.database)
+    }
+
+    pub fn clear(&self, txn: &mut LmdbWriteTransaction) {
+        txn.clear_db(self.database).unwrap();
+    }
+
+    /// Fills the index from the account table
+    pub fn backfill(
+        &self,
+        env: &LmdbEnv,
+        txn: &mut LmdbWriteTransaction,
+        accounts: &LmdbAccountStore,
+    ) {
+        let ro_txn = env.tx_begin_read();
+        for (account, info) in accounts.iter(&ro_txn) {
+            self.put(txn, &info.representative, &account);
+        }
+    }
+}
+
+fn delegator_key(representative: &PublicKey, account: &Account) -> [u8; 64] {
+    let mut key = [0; 64];
+    key[..32].copy_from_slice(representative.as_bytes());
+    key[32..].copy_from_slice(account.as_bytes());
+    key
+}
+
+pub struct ConfiguredDelegatorDatabaseBuilder {
+    database: ConfiguredDatabase,
+}
+
+impl ConfiguredDelegatorDatabaseBuilder {
+    pub fn new() -> Self {
+        Self {
+            database: ConfiguredDatabase::new(DELEGATOR_TEST_DATABASE, "delegators"),
+        }
+    }
+
+    pub fn delegator(mut self, representative: &PublicKey, account: &Account) -> Self {
+        self.database
+            .entries
+            .insert(delegator_key(representative, account).to_vec(), Vec::new());
+        self
+    }
+
+    pub fn build(self) -> ConfiguredDatabase {
+        self.database
+    }
+
+    pub fn create(delegators: Vec<(PublicKey, Account)>) -> ConfiguredDatabase {
+        let mut builder = Self::new();
+        for (representative, account) in delegators {
+            builder = builder.delegator(&representative, &account);
+        }
+        builder.build()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{DeleteEvent, PutEvent};
+
+    struct Fixture {
+        env: Arc<LmdbEnv>,
+        store: LmdbDelegatorStore,
+    }
+
+    impl Fixture {
+        fn new() -> Self {
+            Self::with_stored_data(Vec::new())
+        }
+
+        fn with_stored_data(entries: Vec<(PublicKey, Account)>) -> Self {
+            let env = LmdbEnv::new_null_with()
+                .configured_database(ConfiguredDelegatorDatabaseBuilder::create(entries))
+                .build();
+            let env = Arc::new(env);
+            Self {
+                env: env.clone(),
+                store: LmdbDelegatorStore::new(env).unwrap(),
+            }
+        }
+    }
+
+    #[test]
+    fn empty_store() {
+        let fixture = Fixture::new();
+        let txn = fixture.env.tx_begin_read();
+        let representative = PublicKey::from(1);
+
+        assert_eq!(fixture.store.count(&txn, &representative), 0);
+        assert_eq!(fixture.store.count_all(&txn), 0);
+        assert_eq!(
+            fixture
+                .store
+                .iter(&txn, &representative, &Account::zero())
+                .next(),
+            None
+        );
+    }
+
+    #[test]
+    fn add_delegator() {
+        let fixture = Fixture::new();
+        let mut txn = fixture.env.tx_begin_write();
+        let put_tracker = txn.track_puts();
+        let representative = PublicKey::from(1);
+        let account = Account::from(2);
+
+        fixture.store.put(&mut txn, &representative, &account);
+
+        assert_eq!(
+            put_tracker.output(),
+            vec![PutEvent {
+                database: DELEGATOR_TEST_DATABASE.into(),
+                key: delegator_key(&representative, &account).to_vec(),
+                value: Vec::new(),
+                flags: WriteFlags::empty()
+            }]
+        );
+    }
+
+    #[test]
+    fn delete_delegator() {
+        let fixture = Fixture::new();
+        let mut txn = fixture.env.tx_begin_write();
+        let delete_tracker = txn.track_deletions();
+        let representative = PublicKey::from(1);
+        let account = Account::from(2);
+
+        fixture.store.del(&mut txn, &representative, &account);
+
+        assert_eq!(
+            delete_tracker.output(),
+            vec![DeleteEvent {
+                database: DELEGATOR_TEST_DATABASE.into(),
+                key: delegator_key(&representative, &account).to_vec(),
+            }]
+        );
+    }
+
+    #[test]
+    fn iterate_delegators_of_one_representative() {
+        let rep1 = PublicKey::from(1);
+        let rep2 = PublicKey::from(2);
+        let fixture = Fixture::with_stored_data(vec![
+            (rep1, Account::from(10)),
+            (rep2, Account::from(5)),
+            (rep2, Account::from(7)),
+            (rep2, Account::from(9)),
+            (PublicKey::from(3), Account::from(1)),
+        ]);
+        let txn = fixture.env.tx_begin_read();
+
+        let delegators: Vec<_> = fixture.store.iter(&txn, &rep2, &Account::zero()).collect();
+        assert_eq!(
+            delegators,
+            vec![Account::from(5), Account::from(7), Account::from(9)]
+        );
+
+        let delegators: Vec<_> = fixture.store.iter(&txn, &rep2, &Account::from(6)).collect();
+        assert_eq!(delegators, vec![Account::from(7), Account::from(9)]);
+
+        assert_eq!(fixture.store.count(&txn, &rep1), 1);
+        assert_eq!(fixture.store.count(&txn, &rep2), 3);
+        assert_eq!(fixture.store.count_all(&txn), 5);
+    }
+}
@@ -7,6 +7,7 @@ extern crate anyhow;
 mod account_store;
 mod block_store;
 mod confirmation_height_store;
+mod delegator_store;
 mod fan;
 mod final_vote_store;
 mod iterator;
@@ -17,13 +18,16 @@ mod peer_store;
 mod pending_store;
 mod pruned_store;
 mod rep_weight_store;
+mod snapshot;
 mod store;
+mod unchecked_store;
 mod version_store;
 mod wallet_store;
 
 pub use account_store::{ConfiguredAccountDatabaseBuilder, LmdbAccountStore};
 pub use block_store::{ConfiguredBlockDatabaseBuilder, LmdbBlockStore};
 pub use confirmation_height_store::*;
+pub use delegator_store::{ConfiguredDelegatorDatabaseBuilder, LmdbDelegatorStore};
 pub use fan::Fan;
 pub use final_vote_store::LmdbFinalVoteStore;
 pub use iterator::{BinaryDbIterator, LmdbIterator, LmdbIteratorImpl};
@@ -37,8 +41,10 @@ pub use rep_weight_store::*;
 use rsban_nullable_lmdb::{
     InactiveTransaction, LmdbDatabase, LmdbEnvironment, RoCursor, RoTransaction, RwTransaction,
 };
-pub use store::{create_backup_file, LedgerCache, LmdbStore};
-pub use version_store::LmdbVersionStore;
+pub use snapshot::{export_snapshot, import_snapshot, SNAPSHOT_VERSION};
+pub use store::{create_backup_file, LedgerCache, LmdbStore, MemoryStats};
+pub use unchecked_store::{ConfiguredUncheckedDatabaseBuilder, LmdbUncheckedStore};
+pub use version_store::{LedgerCounts, LmdbVersionStore};
 pub use wallet_store::{Fans, KeyType, LmdbWalletStore, WalletValue};
 
 use primitive_types::U256;
@@ -224,6 +230,19 @@ pub struct DeleteEvent {
     key: Vec<u8>,
 }
 
+/// What a write transaction does after committing changes, so that they are durable
+/// even though the environment was opened with NO_SYNC
+#[derive(Clone, Default)]
+pub enum CommitDurability {
+    /// The environment syncs on commit by itself
+    #[default]
+    Env,
+    /// Flush the environment after every commit that changed something
+    Sync,
+    /// Hand the flush to the owner of the environment, e.g. for group commit
+    Hook(Arc<dyn Fn() + Send + Sync>),
+}
+
 pub struct LmdbWriteTransaction {
     env: &'static LmdbEnvironment,
     txn_id: u64,
@@ -236,6 +255,8 @@ pub struct LmdbWriteTransaction {
     #[cfg(feature = "output_tracking")]
     clear_listener: OutputListener<LmdbDatabase>,
     start: Instant,
+    durability: CommitDurability,
+    dirty: bool,
 }
 
 impl LmdbWriteTransaction {
@@ -243,6 +264,7 @@ impl LmdbWriteTransaction {
         txn_id: u64,
         env: &'a LmdbEnvironment,
         callbacks: Arc<dyn TransactionTracker>,
+        durability: CommitDurability,
     ) -> lmdb::Result<Self> {
         let env =
             unsafe { std::mem::transmute::<&'a LmdbEnvironment, &'static LmdbEnvironment>(env) };
@@ -258,6 +280,8 @@ impl LmdbWriteTransaction {
             #[cfg(feature = "output_tracking")]
             clear_listener: OutputListener::new(),
             start: Instant::now(),
+            durability,
+            dirty: false,
         };
         tx.renew();
         Ok(tx)
@@ -271,6 +295,7 @@ impl LmdbWriteTransaction {
     }
 
     pub fn rw_txn_mut(&mut self) -> &mut RwTransaction {
+        self.dirty = true;
         match &mut self.txn {
             RwTxnState::Active(t) => t,
             _ => panic!("txn not active"),
@@ -292,7 +317,18 @@ impl LmdbWriteTransaction {
         self.start = Instant::now();
     }
 
+    /// Commits and returns once the changes are durable
     pub fn commit(&mut self) {
+        self.commit_impl(true);
+    }
+
+    /// Commits without running the commit hook. The caller is responsible for
+    /// waiting until the changes are durable, e.g. after releasing the write queue.
+    pub fn commit_deferred(&mut self) {
+        self.commit_impl(false);
+    }
+
+    fn commit_impl(&mut self, run_hook: bool) {
         let t = mem::replace(&mut self.txn, RwTxnState::Transitioning);
         match t {
             RwTxnState::Inactive => {}
@@ -303,6 +339,17 @@ impl LmdbWriteTransaction {
             RwTxnState::Transitioning => unreachable!(),
         };
         self.txn = RwTxnState::Inactive;
+        if mem::take(&mut self.dirty) {
+            match &self.durability {
+                CommitDurability::Env => {}
+                CommitDurability::Sync => self.env.sync(true).unwrap(),
+                CommitDurability::Hook(hook) => {
+                    if run_hook {
+                        hook()
+                    }
+                }
+            }
+        }
     }
 
     #[cfg(feature = "output_tracking")]
@@ -325,6 +372,7 @@ impl LmdbWriteTransaction {
         name: Option<&str>,
         flags: lmdb::DatabaseFlags,
     ) -> lmdb::Result<LmdbDatabase> {
+        self.dirty = true;
         self.rw_txn().create_db(name, flags)
     }
 
@@ -433,7 +481,7 @@ pub fn parallel_traversal(action: &(impl Fn(U256, U256, bool) + Send + Sync)) {
 }
 
 pub const STORE_VERSION_MINIMUM: i32 = 24;
-pub const STORE_VERSION_CURRENT: i32 = 24;
+pub const STORE_VERSION_CURRENT: i32 = 25;
 
 pub const BLOCK_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(1);
 pub const FRONTIER_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(2);
@@ -443,6 +491,8 @@ pub const PRUNED_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(5);
 pub const REP_WEIGHT_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(6);
 pub const CONFIRMATION_HEIGHT_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(7);
 pub const PEERS_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(8);
+pub const UNCHECKED_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(9);
+pub const DELEGATOR_TEST_DATABASE: LmdbDatabase = LmdbDatabase::new_null(10);
 
 #[cfg(test)]
 mod test {
@@ -17,6 +17,11 @@ pub enum SyncStrategy {
      * @warning Do not use this option if external processes uses the database concurrently.
      */
     NosyncUnsafeLargeMemory,
+    /**
+     * Do not flush to disk on commit. Writers flush together via the ledger write queue, so that
+     * concurrent commits share a single fsync. A commit is only acknowledged once it was flushed.
+     */
+    GroupCommit,
 }
 
 #[derive(Clone, Debug, PartialEq)]
@@ -1,6 +1,6 @@
 use crate::{
-    LmdbConfig, LmdbReadTransaction, LmdbWriteTransaction, NullTransactionTracker, SyncStrategy,
-    TransactionTracker,
+    CommitDurability, LmdbConfig, LmdbReadTransaction, LmdbWriteTransaction,
+    NullTransactionTracker, SyncStrategy, TransactionTracker,
 };
 use anyhow::bail;
 use lmdb::EnvironmentFlags;
@@ -18,7 +18,7 @@ use std::{
     path::{Path, PathBuf},
     sync::{
         atomic::{AtomicU64, AtomicUsize, Ordering},
-        Arc,
+        Arc, Mutex,
     },
 };
 use tracing::debug;
@@ -73,6 +73,7 @@ pub struct LmdbEnv {
     next_txn_id: AtomicU64,
     txn_tracker: Arc<dyn TransactionTracker>,
     env_id: usize,
+    durability: Mutex<CommitDurability>,
 }
 
 static ENV_COUNT: AtomicUsize = AtomicUsize::new(0);
@@ -95,7 +96,9 @@ impl LmdbEnv {
 
     pub fn new_with_options(path: impl AsRef<Path>, options: &EnvOptions) -> anyhow::Result<Self> {
         let environment = Self::init(path.as_ref(), options)?;
-        Ok(Self::new_with_env(environment))
+        let env = Self::new_with_env(environment);
+        env.set_durability(Self::durability_for(options));
+        Ok(env)
     }
 
     pub fn new_with_env(env: LmdbEnvironment) -> Self {
@@ -107,6 +110,7 @@ impl LmdbEnv {
             next_txn_id: AtomicU64::new(0),
             txn_tracker: Arc::new(NullTransactionTracker::new()),
             env_id,
+            durability: Mutex::new(CommitDurability::Env),
         }
     }
 
@@ -120,12 +124,28 @@ impl LmdbEnv {
             next_txn_id: AtomicU64::new(0),
             txn_tracker,
             env_id: NEXT_ENV_ID.fetch_add(1, Ordering::SeqCst),
+            durability: Mutex::new(Self::durability_for(options)),
         };
         let alive = ENV_COUNT.fetch_add(1, Ordering::SeqCst) + 1;
         debug!(env_id = env.env_id, alive, ?path, "LMDB env created",);
         Ok(env)
     }
 
+    /// Group commit opens the env with NO_SYNC, so every write transaction has to
+    /// flush by itself until the owner installs a cheaper hook with [`Self::set_durability`]
+    fn durability_for(options: &EnvOptions) -> CommitDurability {
+        if options.config.sync == SyncStrategy::GroupCommit {
+            CommitDurability::Sync
+        } else {
+            CommitDurability::Env
+        }
+    }
+
+    /// Sets what write transactions do after a commit. Only affects transactions begun afterwards.
+    pub fn set_durability(&self, durability: CommitDurability) {
+        *self.durability.lock().unwrap() = durability;
+    }
+
     pub fn init(path: impl AsRef<Path>, options: &EnvOptions) -> anyhow::Result<LmdbEnvironment> {
         let path = path.as_ref();
         debug_assert!(
@@ -149,7 +169,9 @@ impl LmdbEnv {
             | EnvironmentFlags::NO_READAHEAD;
         if options.config.sync == SyncStrategy::NosyncSafe {
             environment_flags |= EnvironmentFlags::NO_META_SYNC;
-        } else if options.config.sync == SyncStrategy::NosyncUnsafe {
+        } else if options.config.sync == SyncStrategy::NosyncUnsafe
+            || options.config.sync == SyncStrategy::GroupCommit
+        {
             environment_flags |= EnvironmentFlags::NO_SYNC;
         } else if options.config.sync == SyncStrategy::NosyncUnsafeLargeMemory {
             environment_flags |= EnvironmentFlags::NO_SYNC
@@ -181,8 +203,14 @@ impl LmdbEnv {
         // For IO threads, we do not want them to block on creating write transactions.
         debug_assert!(std::thread::current().name() != Some("I/O"));
         let txn_id = self.next_txn_id.fetch_add(1, Ordering::Relaxed);
-        LmdbWriteTransaction::new(txn_id, &self.environment, self.create_txn_callbacks())
-            .expect("Could not create LMDB read-write transaction")
+        let durability = self.durability.lock().unwrap().clone();
+        LmdbWriteTransaction::new(
+            txn_id,
+            &self.environment,
+            self.create_txn_callbacks(),
+            durability,
+        )
+        .expect("Could not create LMDB read-write transaction")
     }
 
     pub fn file_path(&self) -> anyhow::Result<PathBuf> {
@@ -195,6 +223,12 @@ impl LmdbEnv {
         Ok(source_path)
     }
 
+    /// Flushes all committed transactions to disk
+    pub fn sync(&self) -> anyhow::Result<()> {
+        self.environment.sync(true)?;
+        Ok(())
+    }
+
     fn create_txn_callbacks(&self) -> Arc<dyn TransactionTracker> {
         Arc::clone(&self.txn_tracker)
     }
@@ -0,0 +1,685 @@
+use crate::{LedgerCounts, LmdbDatabase, LmdbStore, Transaction, STORE_VERSION_CURRENT};
+use blake2::{
+    digest::{Update, VariableOutput},
+    Blake2bVar,
+};
+use lmdb::WriteFlags;
+use lmdb_sys::{MDB_FIRST, MDB_NEXT};
+use num_traits::FromPrimitive;
+use rsban_core::{
+    serialized_block_size,
+    utils::{BufferReader, Deserialize, FixedSizeSerialize},
+    Account, AccountInfo, Amount, BlockHash, BlockSideband, BlockType, ConfirmationHeightInfo,
+    PendingInfo, PendingKey, SavedBlockView,
+};
+use std::io::{self, Read, Write};
+
+const MAGIC: &[u8; 8] = b"RSBNSNAP";
+pub const SNAPSHOT_VERSION: u32 = 1;
+const CHECKSUM_SIZE: usize = 32;
+/// The import commits after this many records, so that the write transaction stays small
+const RECORDS_PER_TXN: u64 = 64 * 1024;
+
+/// A snapshot is a header followed by records. Every table is written as a
+/// contiguous run of records, and the tables are written in the order of this enum.
+/// All tables except the pruned table are in key order, so that they can be
+/// imported with `MDB_APPEND`. The pruned hashes are written as they are found.
+#[derive(Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Debug, FromPrimitive)]
+#[repr(u8)]
+enum RecordType {
+    Accounts = 1,
+    Blocks = 2,
+    ConfirmationHeight = 3,
+    Pending = 4,
+    RepWeights = 5,
+    Pruned = 6,
+    Delegators = 7,
+    Counts = 0xFE,
+    /// Contains the checksum of all bytes before this record
+    End = 0xFF,
+}
+
+impl RecordType {
+    /// The largest key which the table of this record type can contain
+    fn max_key_len(&self) -> usize {
+        match self {
+            Self::Accounts
+            | Self::Blocks
+            | Self::ConfirmationHeight
+            | Self::RepWeights
+            | Self::Pruned => 32,
+            Self::Pending => PendingKey::serialized_size(),
+            // representative + delegator
+            Self::Delegators => 64,
+            Self::Counts | Self::End => 0,
+        }
+    }
+
+    /// The largest value which the table of this record type can contain
+    fn max_value_len(&self) -> usize {
+        match self {
+            Self::Accounts => AccountInfo::serialized_size(),
+            Self::Blocks => max_block_len(),
+            Self::ConfirmationHeight => ConfirmationHeightInfo::serialized_size(),
+            Self::Pending => PendingInfo::serialized_size(),
+            Self::RepWeights => Amount::serialized_size(),
+            Self::Pruned | Self::Delegators => 0,
+            Self::Counts => LedgerCounts::SERIALIZED_SIZE,
+            Self::End => CHECKSUM_SIZE,
+        }
+    }
+}
+
+/// The block type, the block and its sideband of the largest block type
+fn max_block_len() -> usize {
+    [
+        BlockType::LegacySend,
+        BlockType::LegacyReceive,
+        BlockType::LegacyOpen,
+        BlockType::LegacyChange,
+        BlockType::State,
+    ]
+    .into_iter()
+    .map(|block_type| {
+        1 + serialized_block_size(block_type) + BlockSideband::serialized_size(block_type)
+    })
+    .max()
+    .unwrap()
+}
+
+/// Writes a snapshot of the ledger as seen by `txn`.
+///
+/// The snapshot contains the account infos, confirmation heights, pending
+/// entries, rep weights and the delegator index. Of the blocks only the
+/// confirmed frontier and the unconfirmed blocks above it are included.
+/// The blocks below the confirmed frontiers which are still referenced are
+/// recorded as pruned, so an imported ledger is a pruned ledger.
+///
+/// Every table is streamed with a cursor, so the export needs no memory
+/// proportional to the size of the ledger.
+pub fn export_snapshot(
+    store: &LmdbStore,
+    txn: &dyn Transaction,
+    output: impl Write,
+) -> anyhow::Result<LedgerCounts> {
+    let mut writer = SnapshotWriter::new(output)?;
+    let mut counts = LedgerCounts::default();
+
+    for_each_entry(txn, store.account.database(), |key, value| {
+        writer.record(RecordType::Accounts, key, value)?;
+        let account = Account::from_bytes(key.try_into()?);
+        let info = AccountInfo::deserialize(&mut BufferReader::new(value))?;
+        counts.account_count += 1;
+        counts.block_count += info.block_count;
+        counts.cemented_count += confirmed_height(store, txn, &account);
+        Ok(())
+    })?;
+
+    // The block table is in key order already, so the exported blocks are
+    // picked while scanning it instead of collecting and sorting their hashes
+    for_each_entry(txn, store.block.database(), |key, value| {
+        let block = SavedBlockView::new(value)
+            .ok_or_else(|| anyhow!("could not deserialize block {:?}", key))?;
+        if block.height() >= lowest_exported_height(store, txn, &block.account()) {
+            writer.record(RecordType::Blocks, key, value)?;
+        }
+        Ok(())
+    })?;
+
+    writer.table(
+        RecordType::ConfirmationHeight,
+        txn,
+        store.confirmation_height.database(),
+    )?;
+    writer.table(RecordType::Pending, txn, store.pending.database())?;
+    writer.table(RecordType::RepWeights, txn, store.rep_weight.database())?;
+
+    for_each_entry(txn, store.account.database(), |key, value| {
+        let account = Account::from_bytes(key.try_into()?);
+        let info = AccountInfo::deserialize(&mut BufferReader::new(value))?;
+        counts.pruned_count += write_pruned_dependencies(store, txn, &account, &info, &mut writer)?;
+        Ok(())
+    })?;
+
+    for_each_entry(txn, store.pending.database(), |key, _| {
+        // The key is the receiving account followed by the hash of the send block
+        let send = BlockHash::from_bytes(key[32..64].try_into()?);
+        if needs_pruned_record(store, txn, &send) {
+            writer.record(RecordType::Pruned, send.as_bytes(), &[])?;
+            counts.pruned_count += 1;
+        }
+        Ok(())
+    })?;
+
+    writer.table(RecordType::Delegators, txn, store.delegator.database())?;
+    writer.record(RecordType::Counts, &[], &counts.to_bytes())?;
+    writer.finish()?;
+    Ok(counts)
+}
+
+/// Walks back from the head block to the confirmed frontier and records the blocks
+/// which the exported part of the chain depends on, but which are not exported:
+/// The previous block of the lowest exported block, and the sources of the
+/// unconfirmed receives which lie below the confirmed frontier of their sender.
+/// Without them the receives could not be cemented after the import.
+fn write_pruned_dependencies<W: Write>(
+    store: &LmdbStore,
+    txn: &dyn Transaction,
+    account: &Account,
+    info: &AccountInfo,
+    writer: &mut SnapshotWriter<W>,
+) -> anyhow::Result<u64> {
+    let confirmed = confirmed_height(store, txn, account);
+    let lowest_height = confirmed.max(1);
+    let mut written = 0;
+    let mut hash = info.head;
+    loop {
+        let block = store
+            .block
+            .get_view(txn, &hash)
+            .ok_or_else(|| anyhow!("block {} not found", hash))?;
+        if block.height() > confirmed {
+            if let Some(source) = block.source() {
+                if needs_pruned_record(store, txn, &source) {
+                    writer.record(RecordType::Pruned, source.as_bytes(), &[])?;
+                    written += 1;
+                }
+            }
+        }
+        let previous = block.previous();
+        if block.height() <= lowest_height || previous.is_zero() {
+            if !previous.is_zero() {
+                writer.record(RecordType::Pruned, previous.as_bytes(), &[])?;
+                written += 1;
+            }
+            return Ok(written);
+        }
+        hash = previous;
+    }
+}
+
+/// Returns false for blocks which are exported, and for blocks which are recorded
+/// as the previous block of the lowest exported block of their account
+fn needs_pruned_record(store: &LmdbStore, txn: &dyn Transaction, hash: &BlockHash) -> bool {
+    match store.block.get_view(txn, hash) {
+        Some(block) => block.height() + 1 < lowest_exported_height(store, txn, &block.account()),
+        None => true,
+    }
+}
+
+fn confirmed_height(store: &LmdbStore, txn: &dyn Transaction, account: &Account) -> u64 {
+    store
+        .confirmation_height
+        .get(txn, account)
+        .unwrap_or_default()
+        .height
+}
+
+/// The confirmed frontier is exported even if the account has no confirmed block yet
+fn lowest_exported_height(store: &LmdbStore, txn: &dyn Transaction, account: &Account) -> u64 {
+    confirmed_height(store, txn, account).max(1)
+}
+
+/// Reads a snapshot into an empty store. The records are inserted with
+/// `MDB_APPEND`, which is only possible because the tables are listed in key order.
+/// Only the pruned hashes are inserted one by one.
+/// The write transaction is committed in between, so the store should be a new
+/// file which is discarded if the import fails.
+pub fn import_snapshot(store: &LmdbStore, input: impl Read) -> anyhow::Result<LedgerCounts> {
+    let mut txn = store.tx_begin_write();
+    if store.account.count(&txn) != 0 {
+        bail!("the ledger must be empty to import a snapshot");
+    }
+
+    let mut reader = SnapshotReader::new(input)?;
+    let mut counts = None;
+    let mut previous_type = None;
+    let mut records = 0;
+
+    loop {
+        let record_type = reader.next()?;
+        if previous_type.is_some_and(|previous| record_type < previous) {
+            bail!("snapshot tables are out of order");
+        }
+        previous_type = Some(record_type);
+
+        let database = match record_type {
+            RecordType::Accounts => store.account.database(),
+            RecordType::Blocks => store.block.database(),
+            RecordType::ConfirmationHeight => store.confirmation_height.database(),
+            RecordType::Pending => store.pending.database(),
+            RecordType::RepWeights => store.rep_weight.database(),
+            RecordType::Pruned => store.pruned.database(),
+            RecordType::Delegators => store.delegator.database(),
+            RecordType::Counts => {
+                counts = Some(
+                    LedgerCounts::from_bytes(&reader.value)
+                        .ok_or_else(|| anyhow!("invalid counts record"))?,
+                );
+                continue;
+            }
+            RecordType::End => break,
+        };
+
+        let flags = if record_type == RecordType::Pruned {
+            WriteFlags::empty()
+        } else {
+            WriteFlags::APPEND
+        };
+        txn.put(database, &reader.key, &reader.value, flags)
+            .map_err(|e| anyhow!("could not import {:?} record: {:?}", record_type, e))?;
+        records += 1;
+        if records % RECORDS_PER_TXN == 0 {
+            txn.refresh();
+        }
+    }
+
+    let mut counts = counts.ok_or_else(|| anyhow!("the snapshot contains no counts"))?;
+    // An already pruned ledger can reference a missing block twice, which is only stored once
+    counts.pruned_count = store.pruned.count(&txn);
+    // The node can start without scanning the imported tables
+    store.version.put_counts(&mut txn, &counts);
+    Ok(counts)
+}
+
+fn for_each_entry(
+    txn: &dyn Transaction,
+    database: LmdbDatabase,
+    mut action: impl FnMut(&[u8], &[u8]) -> anyhow::Result<()>,
+) -> anyhow::Result<()> {
+    let cursor = txn.open_ro_cursor(database)?;
+    let mut operation = MDB_FIRST;
+    loop {
+        match cursor.get(None, None, operation) {
+            Ok((Some(key), value)) => action(key, value)?,
+            Ok((None, _)) | Err(lmdb::Error::NotFound) => return Ok(()),
+            Err(e) => return Err(e.into()),
+        }
+        operation = MDB_NEXT;
+    }
+}
+
+struct SnapshotWriter<W: Write> {
+    output: W,
+    hasher: Blake2bVar,
+}
+
+impl<W: Write> SnapshotWriter<W> {
+    fn new(output: W) -> anyhow::Result<Self> {
+        let mut writer = Self {
+            output,
+            hasher: Blake2bVar::new(CHECKSUM_SIZE).unwrap(),
+        };
+        writer.write(MAGIC)?;
+        writer.write(&SNAPSHOT_VERSION.to_be_bytes())?;
+        writer.write(&STORE_VERSION_CURRENT.to_be_bytes())?;
+        Ok(writer)
+    }
+
+    fn table(
+        &mut self,
+        record_type: RecordType,
+        txn: &dyn Transaction,
+        database: LmdbDatabase,
+    ) -> anyhow::Result<()> {
+        for_each_entry(txn, database, |key, value| {
+            self.record(record_type, key, value)
+        })
+    }
+
+    fn record(&mut self, record_type: RecordType, key: &[u8], value: &[u8]) -> anyhow::Result<()> {
+        self.write(&[record_type as u8])?;
+        self.write(&u16::try_from(key.len())?.to_be_bytes())?;
+        self.write(&u32::try_from(value.len())?.to_be_bytes())?;
+        self.write(key)?;
+        self.write(value)
+    }
+
+    fn write(&mut self, bytes: &[u8]) -> anyhow::Result<()> {
+        self.hasher.update(bytes);
+        self.output.write_all(bytes)?;
+        Ok(())
+    }
+
+    fn finish(mut self) -> anyhow::Result<()> {
+        let mut checksum = [0; CHECKSUM_SIZE];
+        self.hasher
+            .clone()
+            .finalize_variable(&mut checksum)
+            .unwrap();
+        self.record(RecordType::End, &[], &checksum)?;
+        self.output.flush()?;
+        Ok(())
+    }
+}
+
+struct SnapshotReader<R: Read> {
+    input: R,
+    hasher: Blake2bVar,
+    key: Vec<u8>,
+    value: Vec<u8>,
+}
+
+impl<R: Read> SnapshotReader<R> {
+    fn new(input: R) -> anyhow::Result<Self> {
+        let mut reader = Self {
+            input,
+            hasher: Blake2bVar::new(CHECKSUM_SIZE).unwrap(),
+            key: Vec::new(),
+            value: Vec::new(),
+        };
+
+        let mut header = [0; 16];
+        reader.read(&mut header)?;
+        if &header[..8] != MAGIC {
+            bail!("not a ledger snapshot");
+        }
+        let version = u32::from_be_bytes(header[8..12].try_into().unwrap());
+        if version != SNAPSHOT_VERSION {
+            bail!("unsupported snapshot version {}", version);
+        }
+        let store_version = i32::from_be_bytes(header[12..].try_into().unwrap());
+        if store_version != STORE_VERSION_CURRENT {
+            bail!(
+                "the snapshot was created with store version {}, but this node uses version {}",
+                store_version,
+                STORE_VERSION_CURRENT
+            );
+        }
+        Ok(reader)
+    }
+
+    /// Reads the next record into `key` and `value`.
+    /// The checksum is verified when the end record is reached.
+    fn next(&mut self) -> anyhow::Result<RecordType> {
+        let mut header = [0; 7];
+        self.input.read_exact(&mut header)?;
+        let record_type = RecordType::from_u8(header[0])
+            .ok_or_else(|| anyhow!("invalid snapshot record type {}", header[0]))?;
+        let expected_checksum = (record_type == RecordType::End).then(|| self.checksum());
+        self.hasher.update(&header);
+
+        let key_len = u16::from_be_bytes(header[1..3].try_into().unwrap()) as usize;
+        let value_len = u32::from_be_bytes(header[3..].try_into().unwrap()) as usize;
+        // The lengths aren't covered by the checksum yet, so they mustn't size the buffers
+        if key_len > record_type.max_key_len() || value_len > record_type.max_value_len() {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidData,
+                format!(
+                    "invalid {:?} record length: key {} value {}",
+                    record_type, key_len, value_len
+                ),
+            )
+            .into());
+        }
+        let mut key = std::mem::take(&mut self.key);
+        let mut value = std::mem::take(&mut self.value);
+        key.resize(key_len, 0);
+        value.resize(value_len, 0);
+        self.read(&mut key)?;
+        self.read(&mut value)?;
+        self.key = key;
+        self.value = value;
+
+        if let Some(checksum) = expected_checksum {
+            if self.value != checksum {
+                bail!("snapshot checksum mismatch");
+            }
+        }
+        Ok(record_type)
+    }
+
+    fn read(&mut self, buffer: &mut [u8]) -> anyhow::Result<()> {
+        self.input.read_exact(buffer)?;
+        self.hasher.update(buffer);
+        Ok(())
+    }
+
+    fn checksum(&self) -> [u8; CHECKSUM_SIZE] {
+        let mut checksum = [0; CHECKSUM_SIZE];
+        self.hasher
+            .clone()
+            .finalize_variable(&mut checksum)
+            .unwrap();
+        checksum
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::TestDbFile;
+    use rsban_core::{
+        Amount, Block, BlockDetails, BlockSideband, ConfirmationHeightInfo, Epoch, PendingInfo,
+        PendingKey, PrivateKey, PublicKey, SavedBlock, UnsavedBlockLatticeBuilder, DEV_GENESIS_KEY,
+    };
+
+    #[test]
+    fn round_trip() -> anyhow::Result<()> {
+        let source_file = TestDbFile::random();
+        let source = LmdbStore::open(&source_file.path).build()?;
+        let block = SavedBlock::new_test_instance();
+        let account = block.account();
+        let info = AccountInfo {
+            head: block.hash(),
+            balance: block.balance(),
+            block_count: block.height(),
+            ..AccountInfo::new_test_instance()
+        };
+        let pending_key = PendingKey::new(account, BlockHash::from(100));
+        {
+            let mut txn = source.tx_begin_write();
+            source.block.put(&mut txn, &block);
+            source.account.put(&mut txn, &account, &info);
+            source.confirmation_height.put(
+                &mut txn,
+                &account,
+                &ConfirmationHeightInfo::new(block.height(), block.hash()),
+            );
+            source
+                .pending
+                .put(&mut txn, &pending_key, &PendingInfo::new_test_instance());
+            source
+                .rep_weight
+                .put(&mut txn, info.representative, info.balance);
+            source
+                .delegator
+                .put(&mut txn, &info.representative, &account);
+        }
+
+        let mut snapshot = Vec::new();
+        let exported = export_snapshot(&source, &source.tx_begin_read(), &mut snapshot)?;
+        assert_eq!(
+            exported,
+            LedgerCounts {
+                block_count: block.height(),
+                cemented_count: block.height(),
+                account_count: 1,
+                pruned_count: 2,
+            }
+        );
+
+        let target_file = TestDbFile::random();
+        let target = LmdbStore::open(&target_file.path).build()?;
+        let imported = import_snapshot(&target, snapshot.as_slice())?;
+        assert_eq!(imported, exported);
+
+        let txn = target.tx_begin_read();
+        assert_eq!(target.version.get_counts(&txn), Some(exported));
+        assert_eq!(target.account.get(&txn, &account), Some(info.clone()));
+        assert_eq!(target.block.get(&txn, &block.hash()), Some(block.clone()));
+        assert!(target.pruned.exists(&txn, &block.previous()));
+        assert!(target.pruned.exists(&txn, &pending_key.send_block_hash));
+        assert!(target.pending.exists(&txn, &pending_key));
+        assert_eq!(
+            target.rep_weight.get(&txn, &info.representative),
+            Some(info.balance)
+        );
+        assert!(target
+            .delegator
+            .exists(&txn, &info.representative, &account));
+        assert_eq!(
+            target
+                .confirmation_height
+                .get(&txn, &account)
+                .unwrap()
+                .height,
+            block.height()
+        );
+        Ok(())
+    }
+
+    #[test]
+    fn prune_source_of_unconfirmed_receive() -> anyhow::Result<()> {
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let receiver = PrivateKey::from(1);
+        let send1 = lattice.genesis().send(&receiver, 1);
+        let send2 = lattice.genesis().send(Account::from(43), 1);
+        let send3 = lattice.genesis().send(Account::from(43), 1);
+        let open = lattice.account(&receiver).receive(&send1);
+
+        let sender = DEV_GENESIS_KEY.account();
+        let send1 = saved(
+            send1,
+            sender,
+            2,
+            BlockDetails::new(Epoch::Epoch0, true, false, false),
+        );
+        let send2 = saved(
+            send2,
+            sender,
+            3,
+            BlockDetails::new(Epoch::Epoch0, true, false, false),
+        );
+        let send3 = saved(
+            send3,
+            sender,
+            4,
+            BlockDetails::new(Epoch::Epoch0, true, false, false),
+        );
+        let open = saved(
+            open,
+            receiver.account(),
+            1,
+            BlockDetails::new(Epoch::Epoch0, false, true, false),
+        );
+
+        let source_file = TestDbFile::random();
+        let source = LmdbStore::open(&source_file.path).build()?;
+        {
+            let mut txn = source.tx_begin_write();
+            for block in [&send1, &send2, &send3, &open] {
+                source.block.put(&mut txn, block);
+            }
+            let sender_info = AccountInfo {
+                head: send3.hash(),
+                block_count: 4,
+                ..AccountInfo::new_test_instance()
+            };
+            source.account.put(&mut txn, &sender, &sender_info);
+            let receiver_info = AccountInfo {
+                head: open.hash(),
+                block_count: 1,
+                ..AccountInfo::new_test_instance()
+            };
+            source
+                .account
+                .put(&mut txn, &receiver.account(), &receiver_info);
+            // The send to the receiver is confirmed and below the confirmed
+            // frontier of the sender, the receive isn't confirmed yet
+            source.confirmation_height.put(
+                &mut txn,
+                &sender,
+                &ConfirmationHeightInfo::new(4, send3.hash()),
+            );
+            for send in [&send2, &send3] {
+                source.pending.put(
+                    &mut txn,
+                    &PendingKey::new(Account::from(43), send.hash()),
+                    &PendingInfo::new_test_instance(),
+                );
+            }
+        }
+
+        let mut snapshot = Vec::new();
+        let exported = export_snapshot(&source, &source.tx_begin_read(), &mut snapshot)?;
+        assert_eq!(exported.pruned_count, 2);
+
+        let target_file = TestDbFile::random();
+        let target = LmdbStore::open(&target_file.path).build()?;
+        let imported = import_snapshot(&target, snapshot.as_slice())?;
+        assert_eq!(imported, exported);
+
+        let txn = target.tx_begin_read();
+        assert!(target.block.exists(&txn, &send3.hash()));
+        assert!(target.block.exists(&txn, &open.hash()));
+        assert!(!target.block.exists(&txn, &send1.hash()));
+        assert!(!target.block.exists(&txn, &send2.hash()));
+        assert!(target.pruned.exists(&txn, &send2.hash()));
+        assert!(target.pruned.exists(&txn, &send1.hash()));
+        Ok(())
+    }
+
+    fn saved(block: Block, account: Account, height: u64, details: BlockDetails) -> SavedBlock {
+        let balance = block.balance_field().unwrap_or_default();
+        let sideband = BlockSideband::new(
+            account,
+            BlockHash::zero(),
+            balance,
+            height,
+            0,
+            details,
+            Epoch::Epoch0,
+        );
+        SavedBlock::new(block, sideband)
+    }
+
+    #[test]
+    fn reject_corrupted_snapshot() -> anyhow::Result<()> {
+        let source_file = TestDbFile::random();
+        let source = LmdbStore::open(&source_file.path).build()?;
+        {
+            let mut txn = source.tx_begin_write();
+            source
+                .rep_weight
+                .put(&mut txn, PublicKey::from(1), Amount::raw(1000));
+        }
+        let mut snapshot = Vec::new();
+        export_snapshot(&source, &source.tx_begin_read(), &mut snapshot)?;
+        // Flip a bit of the rep weight, which is followed by the counts and the end record
+        let index = snapshot.len() - 80;
+        snapshot[index] ^= 1;
+
+        let target_file = TestDbFile::random();
+        let target = LmdbStore::open(&target_file.path).build()?;
+        let error = import_snapshot(&target, snapshot.as_slice()).unwrap_err();
+        assert_eq!(error.to_string(), "snapshot checksum mismatch");
+        Ok(())
+    }
+
+    #[test]
+    fn reject_oversized_record() -> anyhow::Result<()> {
+        let source_file = TestDbFile::random();
+        let source = LmdbStore::open(&source_file.path).build()?;
+        let mut snapshot = Vec::new();
+        export_snapshot(&source, &source.tx_begin_read(), &mut snapshot)?;
+        // The header is followed by the counts record. Claim a 4 GB value
+        assert_eq!(snapshot[16], RecordType::Counts as u8);
+        snapshot[16 + 3..16 + 7].copy_from_slice(&u32::MAX.to_be_bytes());
+
+        let target_file = TestDbFile::random();
+        let target = LmdbStore::open(&target_file.path).build()?;
+        let error = import_snapshot(&target, snapshot.as_slice()).unwrap_err();
+        let error = error.downcast::<io::Error>()?;
+        assert_eq!(error.kind(), io::ErrorKind::InvalidData);
+        Ok(())
+    }
+
+    #[test]
+    fn reject_unknown_format() {
+        let target_file = TestDbFile::random();
+        let target = LmdbStore::open(&target_file.path).build().unwrap();
+        let error = import_snapshot(&target, [0u8; 32].as_slice()).unwrap_err();
+        assert_eq!(error.to_string(), "not a ledger snapshot");
+    }
+}
@@ -1,9 +1,9 @@
 use crate::{
-    EnvOptions, LmdbAccountStore, LmdbBlockStore, LmdbConfirmationHeightStore, LmdbDatabase,
-    LmdbEnv, LmdbFinalVoteStore, LmdbOnlineWeightStore, LmdbPeerStore, LmdbPendingStore,
-    LmdbPrunedStore, LmdbReadTransaction, LmdbRepWeightStore, LmdbVersionStore,
-    LmdbWriteTransaction, NullTransactionTracker, TransactionTracker, STORE_VERSION_CURRENT,
-    STORE_VERSION_MINIMUM,
+    EnvOptions, LedgerCounts, LmdbAccountStore, LmdbBlockStore, LmdbConfirmationHeightStore,
+    LmdbDatabase, LmdbDelegatorStore, LmdbEnv, LmdbFinalVoteStore, LmdbOnlineWeightStore,
+    LmdbPeerStore, LmdbPendingStore, LmdbPrunedStore, LmdbReadTransaction, LmdbRepWeightStore,
+    LmdbVersionStore, LmdbWriteTransaction, NullTransactionTracker, TransactionTracker,
+    STORE_VERSION_CURRENT, STORE_VERSION_MINIMUM,
 };
 use lmdb::{DatabaseFlags, WriteFlags};
 use lmdb_sys::{MDB_CP_COMPACT, MDB_SUCCESS};
@@ -42,6 +42,48 @@ impl LedgerCache {
         }
     }
 
+    pub fn counts(&self) -> LedgerCounts {
+        LedgerCounts {
+            block_count: self.block_count.load(Ordering::SeqCst),
+            cemented_count: self.cemented_count.load(Ordering::SeqCst),
+            account_count: self.account_count.load(Ordering::SeqCst),
+            pruned_count: self.pruned_count.load(Ordering::SeqCst),
+        }
+    }
+
+    pub fn set_counts(&self, counts: &LedgerCounts) {
+        self.block_count.store(counts.block_count, Ordering::SeqCst);
+        self.cemented_count
+            .store(counts.cemented_count, Ordering::SeqCst);
+        self.account_count
+            .store(counts.account_count, Ordering::SeqCst);
+        self.pruned_count
+            .store(counts.pruned_count, Ordering::SeqCst);
+    }
+
+    /// Corrects the counters by the difference between the actual and the expected counts
+    pub fn correct_counts(&self, expected: &LedgerCounts, actual: &LedgerCounts) {
+        let correct = |counter: &AtomicU64, expected: u64, actual: u64| {
+            counter.fetch_add(actual.wrapping_sub(expected), Ordering::SeqCst);
+        };
+        correct(&self.block_count, expected.block_count, actual.block_count);
+        correct(
+            &self.cemented_count,
+            expected.cemented_count,
+            actual.cemented_count,
+        );
+        correct(
+            &self.account_count,
+            expected.account_count,
+            actual.account_count,
+        );
+        correct(
+            &self.pruned_count,
+            expected.pruned_count,
+            actual.pruned_count,
+        );
+    }
+
     pub fn reset(&self) {
         self.cemented_count.store(0, Ordering::SeqCst);
         self.block_count.store(0, Ordering::SeqCst);
@@ -62,6 +104,7 @@ pub struct LmdbStore {
     pub peer: Arc<LmdbPeerStore>,
     pub confirmation_height: Arc<LmdbConfirmationHeightStore>,
     pub final_vote: Arc<LmdbFinalVoteStore>,
+    pub delegator: Arc<LmdbDelegatorStore>,
     pub version: Arc<LmdbVersionStore>,
 }
 
@@ -144,6 +187,7 @@ impl LmdbStore {
             peer: Arc::new(LmdbPeerStore::new(env.clone())?),
             confirmation_height: Arc::new(LmdbConfirmationHeightStore::new(env.clone())?),
             final_vote: Arc::new(LmdbFinalVoteStore::new(env.clone())?),
+            delegator: Arc::new(LmdbDelegatorStore::new(env.clone())?),
             version: Arc::new(LmdbVersionStore::new(env.clone())?),
             env,
         })
@@ -160,6 +204,7 @@ impl LmdbStore {
             self.pruned.database(),
             self.confirmation_height.database(),
             self.pending.database(),
+            self.delegator.database(),
         ];
         for table in tables {
             rebuild_table(&self.env, txn, table)?;
@@ -185,6 +230,12 @@ impl LmdbStore {
         format!("lmdb-rkv {}.{}.{}", 0, 14, 0)
     }
 
+    /// Writes the current ledger cache counters. Has to be called in every write
+    /// transaction which changes them, so that the persisted counts stay consistent
+    pub fn persist_counts(&self, txn: &mut LmdbWriteTransaction) {
+        self.version.put_counts(txn, &self.cache.counts());
+    }
+
     pub fn tx_begin_read(&self) -> LmdbReadTransaction {
         self.env.tx_begin_read()
     }
@@ -286,10 +337,30 @@ fn do_upgrades(env: Arc<LmdbEnv>) -> anyhow::Result<Vacuuming> {
         bail!("version too high");
     }
 
+    if version == 24 {
+        upgrade_v24_to_v25(&env, &mut txn, &version_store)?;
+    }
+
     // most recent version
     Ok(Vacuuming::NotNeeded)
 }
 
+/// Adds the delegator index and fills it from the account table
+fn upgrade_v24_to_v25(
+    env: &Arc<LmdbEnv>,
+    txn: &mut LmdbWriteTransaction,
+    version_store: &LmdbVersionStore,
+) -> anyhow::Result<()> {
+    info!("Preparing v24 to v25 database upgrade...");
+    let accounts = LmdbAccountStore::new(env.clone())?;
+    let delegators = LmdbDelegatorStore::new(env.clone())?;
+    delegators.clear(txn);
+    delegators.backfill(env, txn, &accounts);
+    version_store.put(txn, 25);
+    info!("Finished creating the delegator index");
+    Ok(())
+}
+
 fn vacuum_after_upgrade(env: Arc<LmdbEnv>, path: &Path) -> anyhow::Result<()> {
     // Vacuum the database. This is not a required step and may actually fail if there isn't enough storage space.
     let mut vacuum_path = path.to_owned();
@@ -396,6 +467,7 @@ fn backup_file_path(source_path: &Path) -> anyhow::Result<PathBuf> {
 mod tests {
     use super::*;
     use crate::TestDbFile;
+    use rsban_core::{Account, AccountInfo};
 
     #[test]
     fn create_store() -> anyhow::Result<()> {
@@ -425,7 +497,29 @@ mod tests {
         let file = TestDbFile::random();
         let store = LmdbStore::open(&file.path).build().unwrap();
         let txn = store.tx_begin_read();
-        assert_eq!(store.version.get(&txn), Some(STORE_VERSION_MINIMUM));
+        assert_eq!(store.version.get(&txn), Some(STORE_VERSION_CURRENT));
+    }
+
+    #[test]
+    fn upgrade_v24_creates_delegator_index() -> anyhow::Result<()> {
+        let file = TestDbFile::random();
+        let account = Account::from(1);
+        let info = AccountInfo::new_test_instance();
+        {
+            let env = Arc::new(LmdbEnv::new(&file.path)?);
+            let accounts = LmdbAccountStore::new(env.clone())?;
+            let mut txn = env.tx_begin_write();
+            accounts.put(&mut txn, &account, &info);
+        }
+        set_store_version(&file, 24)?;
+
+        let store = LmdbStore::open(&file.path).build()?;
+
+        let txn = store.tx_begin_read();
+        assert_eq!(store.version.get(&txn), Some(25));
+        assert!(store.delegator.exists(&txn, &info.representative, &account));
+        assert_eq!(store.delegator.count_all(&txn), 1);
+        Ok(())
     }
 
     fn assert_upgrade_fails(path: &Path, error_msg: &str) {
@@ -0,0 +1,227 @@
+use crate::{
+    BinaryDbIterator, LmdbDatabase, LmdbEnv, LmdbIteratorImpl, LmdbWriteTransaction, Transaction,
+    UNCHECKED_TEST_DATABASE,
+};
+use lmdb::{DatabaseFlags, WriteFlags};
+use rsban_core::{BlockHash, HashOrAccount, UncheckedInfo, UncheckedKey};
+use rsban_nullable_lmdb::ConfiguredDatabase;
+use std::sync::Arc;
+
+pub type UncheckedIterator<'txn> = BinaryDbIterator<'txn, UncheckedKey, UncheckedInfo>;
+
+/// Blocks with a missing dependency which didn't fit into the in-memory unchecked map.
+/// The table lives in its own environment, so that it never competes with the ledger for its write lock.
+/// UncheckedKey (dependency, hash) -> UncheckedInfo
+pub struct LmdbUncheckedStore {
+    env: Arc<LmdbEnv>,
+    database: LmdbDatabase,
+}
+
+impl LmdbUncheckedStore {
+    pub fn new(env: Arc<LmdbEnv>) -> anyhow::Result<Self> {
+        let database = env
+            .environment
+            .create_db(Some("unchecked"), DatabaseFlags::empty())?;
+        Ok(Self { env, database })
+    }
+
+    pub fn database(&self) -> LmdbDatabase {
+        self.database
+    }
+
+    pub fn env(&self) -> &Arc<LmdbEnv> {
+        &self.env
+    }
+
+    pub fn put(&self, txn: &mut LmdbWriteTransaction, key: &UncheckedKey, info: &UncheckedInfo) {
+        txn.put(
+            self.database,
+            &key.to_bytes(),
+            &info.to_bytes(),
+            WriteFlags::empty(),
+        )
+        .unwrap();
+    }
+
+    pub fn exists(&self, txn: &dyn Transaction, key: &UncheckedKey) -> bool {
+        txn.exists(self.database, &key.to_bytes())
+    }
+
+    pub fn del(&self, txn: &mut LmdbWriteTransaction, key: &UncheckedKey) {
+        txn.delete(self.database, &key.to_bytes(), None).unwrap();
+    }
+
+    pub fn begin<'txn>(&self, txn: &'txn dyn Transaction) -> UncheckedIterator<'txn> {
+        LmdbIteratorImpl::new_iterator(txn, self.database, None, true)
+    }
+
+    pub fn begin_at_key<'txn>(
+        &self,
+        txn: &'txn dyn Transaction,
+        key: &UncheckedKey,
+    ) -> UncheckedIterator<'txn> {
+        LmdbIteratorImpl::new_iterator(txn, self.database, Some(&key.to_bytes()), true)
+    }
+
+    /// All entries which wait for `dependency`
+    pub fn get_dependents(
+        &self,
+        txn: &dyn Transaction,
+        dependency: &HashOrAccount,
+    ) -> Vec<(UncheckedKey, UncheckedInfo)> {
+        let dependency: BlockHash = dependency.into();
+        let mut result = Vec::new();
+        let mut it = self.begin_at_key(txn, &UncheckedKey::new(dependency, BlockHash::zero()));
+        while let Some((key, info)) = it.current() {
+            if key.previous != dependency {
+                break;
+            }
+            result.push((key.clone(), info.clone()));
+            it.next();
+        }
+        result
+    }
+
+    pub fn count(&self, txn: &dyn Transaction) -> u64 {
+        txn.count(self.database)
+    }
+
+    pub fn clear(&self, txn: &mut LmdbWriteTransaction) {
+        txn.clear_db(self.database).unwrap();
+    }
+}
+
+pub struct ConfiguredUncheckedDatabaseBuilder {
+    database: ConfiguredDatabase,
+}
+
+impl ConfiguredUncheckedDatabaseBuilder {
+    pub fn new() -> Self {
+        Self {
+            database: ConfiguredDatabase::new(UNCHECKED_TEST_DATABASE, "unchecked"),
+        }
+    }
+
+    pub fn unchecked(mut self, key: &UncheckedKey, info: &UncheckedInfo) -> Self {
+        self.database
+            .entries
+            .insert(key.to_bytes().to_vec(), info.to_bytes());
+        self
+    }
+
+    pub fn build(self) -> ConfiguredDatabase {
+        self.database
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{DeleteEvent, PutEvent};
+    use rsban_core::Block;
+
+    struct Fixture {
+        env: Arc<LmdbEnv>,
+        store: LmdbUncheckedStore,
+    }
+
+    impl Fixture {
+        fn new() -> Self {
+            Self::with_stored_data(Vec::new())
+        }
+
+        fn with_stored_data(entries: Vec<(UncheckedKey, UncheckedInfo)>) -> Self {
+            let mut builder = ConfiguredUncheckedDatabaseBuilder::new();
+            for (key, info) in &entries {
+                builder = builder.unchecked(key, info);
+            }
+            let env = Arc::new(
+                LmdbEnv::new_null_with()
+                    .configured_database(builder.build())
+                    .build(),
+            );
+            Self {
+                env: env.clone(),
+                store: LmdbUncheckedStore::new(env).unwrap(),
+            }
+        }
+    }
+
+    #[test]
+    fn empty_store() {
+        let fixture = Fixture::new();
+        let txn = fixture.env.tx_begin_read();
+        assert_eq!(fixture.store.count(&txn), 0);
+        assert!(fixture.store.begin(&txn).is_end());
+        assert!(fixture
+            .store
+            .get_dependents(&txn, &HashOrAccount::from(1))
+            .is_empty());
+    }
+
+    #[test]
+    fn put() {
+        let fixture = Fixture::new();
+        let mut txn = fixture.env.tx_begin_write();
+        let put_tracker = txn.track_puts();
+        let (key, info) = test_entry(1, 2);
+
+        fixture.store.put(&mut txn, &key, &info);
+
+        assert_eq!(
+            put_tracker.output(),
+            vec![PutEvent {
+                database: UNCHECKED_TEST_DATABASE.into(),
+                key: key.to_bytes().to_vec(),
+                value: info.to_bytes(),
+                flags: WriteFlags::empty()
+            }]
+        );
+    }
+
+    #[test]
+    fn get_dependents() {
+        let fixture = Fixture::with_stored_data(vec![
+            test_entry(1, 10),
+            test_entry(2, 20),
+            test_entry(2, 21),
+            test_entry(3, 30),
+        ]);
+        let txn = fixture.env.tx_begin_read();
+
+        let dependents = fixture.store.get_dependents(&txn, &HashOrAccount::from(2));
+
+        let keys: Vec<_> = dependents.into_iter().map(|(k, _)| k).collect();
+        assert_eq!(keys, vec![test_entry(2, 20).0, test_entry(2, 21).0]);
+        assert!(fixture.store.exists(&txn, &test_entry(3, 30).0));
+        assert!(!fixture.store.exists(&txn, &test_entry(3, 31).0));
+    }
+
+    #[test]
+    fn delete() {
+        let fixture = Fixture::new();
+        let mut txn = fixture.env.tx_begin_write();
+        let delete_tracker = txn.track_deletions();
+        let (key, _) = test_entry(1, 2);
+
+        fixture.store.del(&mut txn, &key);
+
+        assert_eq!(
+            delete_tracker.output(),
+            vec![DeleteEvent {
+                database: UNCHECKED_TEST_DATABASE.into(),
+                key: key.to_bytes().to_vec()
+            }]
+        )
+    }
+
+    fn test_entry(dependency: u64, hash: u64) -> (UncheckedKey, UncheckedInfo) {
+        (
+            UncheckedKey::new(BlockHash::from(dependency), BlockHash::from(hash)),
+            UncheckedInfo {
+                block: Block::new_test_instance(),
+                modified: 42,
+            },
+        )
+    }
+}
@@ -10,6 +10,42 @@ pub struct LmdbVersionStore {
     db_handle: LmdbDatabase,
 }
 
+/// The ledger cache counters. They are written in the same transaction as the
+/// changes they count, so that they don't have to be recalculated at startup.
+#[derive(Clone, Copy, Default, PartialEq, Eq, Debug)]
+pub struct LedgerCounts {
+    pub block_count: u64,
+    pub cemented_count: u64,
+    pub account_count: u64,
+    pub pruned_count: u64,
+}
+
+impl LedgerCounts {
+    pub const SERIALIZED_SIZE: usize = 32;
+
+    pub fn to_bytes(&self) -> [u8; Self::SERIALIZED_SIZE] {
+        let mut bytes = [0; Self::SERIALIZED_SIZE];
+        bytes[..8].copy_from_slice(&self.block_count.to_be_bytes());
+        bytes[8..16].copy_from_slice(&self.cemented_count.to_be_bytes());
+        bytes[16..24].copy_from_slice(&self.account_count.to_be_bytes());
+        bytes[24..].copy_from_slice(&self.pruned_count.to_be_bytes());
+        bytes
+    }
+
+    pub fn from_bytes(bytes: &[u8]) -> Option<Self> {
+        if bytes.len() != Self::SERIALIZED_SIZE {
+            return None;
+        }
+        let read = |i: usize| u64::from_be_bytes(bytes[i * 8..(i + 1) * 8].try_into().unwrap());
+        Some(Self {
+            block_count: read(0),
+            cemented_count: read(1),
+            account_count: read(2),
+            pruned_count: read(3),
+        })
+    }
+}
+
 pub struct UpgradeInfo {
     pub is_fresh_db: bool,
     pub is_fully_upgraded: bool,
@@ -69,6 +105,33 @@ impl LmdbVersionStore {
         let db = self.db_handle();
         load_version(txn, db)
     }
+
+    pub fn put_counts(&self, txn: &mut LmdbWriteTransaction, counts: &LedgerCounts) {
+        txn.put(
+            self.db_handle,
+            &counts_key(),
+            &counts.to_bytes(),
+            WriteFlags::empty(),
+        )
+        .unwrap();
+    }
+
+    /// Forces a table scan on the next startup
+    pub fn clear_counts(&self, txn: &mut LmdbWriteTransaction) {
+        match txn.delete(self.db_handle, &counts_key(), None) {
+            Ok(()) | Err(lmdb::Error::NotFound) => {}
+            Err(e) => panic!("Could not delete ledger counts {:?}", e),
+        }
+    }
+
+    /// Returns None if the counts were never persisted
+    pub fn get_counts(&self, txn: &dyn Transaction) -> Option<LedgerCounts> {
+        match txn.get(self.db_handle, &counts_key()) {
+            Ok(value) => LedgerCounts::from_bytes(value),
+            Err(lmdb::Error::NotFound) => None,
+            Err(_) => panic!("Error while loading ledger counts"),
+        }
+    }
 }
 
 fn load_version(txn: &dyn Transaction, db: LmdbDatabase) -> Option<i32> {
@@ -89,3 +152,43 @@ fn value_bytes(version: i32) -> [u8; 32] {
 fn version_key() -> [u8; 32] {
     value_bytes(1)
 }
+
+fn counts_key() -> [u8; 32] {
+    value_bytes(2)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::TestDbFile;
+
+    #[test]
+    fn counts_are_not_persisted_by_default() {
+        let store = LmdbVersionStore::new(Arc::new(LmdbEnv::new_null())).unwrap();
+        let txn = store._env.tx_begin_read();
+        assert_eq!(store.get_counts(&txn), None);
+    }
+
+    #[test]
+    fn persist_counts() -> anyhow::Result<()> {
+        let file = TestDbFile::random();
+        let env = Arc::new(LmdbEnv::new(&file.path)?);
+        let store = LmdbVersionStore::new(env.clone())?;
+        let counts = LedgerCounts {
+            block_count: 1,
+            cemented_count: 2,
+            account_count: 3,
+            pruned_count: 4,
+        };
+        {
+            let mut txn = env.tx_begin_write();
+            store.put_counts(&mut txn, &counts);
+            store.put(&mut txn, 42);
+        }
+
+        let txn = env.tx_begin_read();
+        assert_eq!(store.get_counts(&txn), Some(counts));
+        assert_eq!(store.get(&txn), Some(42));
+        Ok(())
+    }
+}
@@ -0,0 +1,311 @@
+use crate::{
+    load_replay::{isolate_replay_node, replay_flags, LoadReplay, ReplayOptions},
+    message_capture::{CaptureReader, CaptureWriter},
+};
+use anyhow::{anyhow, bail};
+use rsban_core::{utils::get_cpu_count, Networks};
+use rsban_daemon::DaemonBuilder;
+use rsban_messages::{Message, ProtocolInfo};
+use rsban_network::ChannelId;
+use rsban_node::{config::DaemonConfig, NodeBuilder, NodeCallbacks, NodeExt};
+use rsban_nullable_clock::{SteadyClock, Timestamp};
+use std::{
+    fs::File,
+    io::{BufReader, BufWriter},
+    path::PathBuf,
+    sync::{Arc, Mutex},
+    time::Duration,
+};
+use tokio::runtime::Runtime;
+
+pub(crate) const USAGE: &str = "\
+usage:
+  rsban-insight
+      starts the user interface
+  rsban-insight record --output <file> [--network <name>] [--data-path <dir>] [--duration <secs>]
+      runs a node and captures its inbound messages until ctrl+c or the duration elapsed
+  rsban-insight replay --input <file> --data-path <dir> [--network <name>] [--speed <factor>] [--drain <secs>]
+      replays a capture into a node and reports the load it handled.
+      speed 1 keeps the recorded timing, 0 replays as fast as possible.
+      the blocks of the capture are written into the ledger at --data-path,
+      so replay a copy of the ledger if you need it unchanged";
+
+/// Lower speeds would stretch the recorded offsets beyond what a Duration can hold
+const MIN_REPLAY_SPEED: f64 = 0.001;
+
+#[derive(Clone, Debug, PartialEq)]
+pub(crate) enum HeadlessCommand {
+    Record {
+        network: Networks,
+        data_path: Option<PathBuf>,
+        output: PathBuf,
+        duration: Option<Duration>,
+    },
+    Replay {
+        network: Networks,
+        data_path: PathBuf,
+        input: PathBuf,
+        options: ReplayOptions,
+    },
+}
+
+/// Returns None if insight should start the user interface
+pub(crate) fn parse_args(
+    args: impl IntoIterator<Item = String>,
+) -> anyhow::Result<Option<HeadlessCommand>> {
+    let mut args = args.into_iter();
+    let Some(command) = args.next() else {
+        return Ok(None);
+    };
+
+    let mut network = Networks::BananoLiveNetwork;
+    let mut data_path = None;
+    let mut file = None;
+    let mut duration = None;
+    let mut options = ReplayOptions::default();
+    while let Some(arg) = args.next() {
+        let value = args
+            .next()
+            .ok_or_else(|| anyhow!("missing value for {}", arg))?;
+        match arg.as_str() {
+            "--network" => network = value.parse().map_err(|e| anyhow!("{}", e))?,
+            "--data-path" => data_path = Some(PathBuf::from(value)),
+            "--output" if command == "record" => file = Some(PathBuf::from(value)),
+            "--input" if command == "replay" => file = Some(PathBuf::from(value)),
+            "--duration" if command == "record" => {
+                duration = Some(Duration::from_secs(value.parse()?))
+            }
+            "--speed" if command == "replay" => options.speed = parse_speed(&value)?,
+            "--drain" if command == "replay" => {
+                options.drain_timeout = Duration::from_secs(value.parse()?)
+            }
+            _ => bail!("unknown argument {}", arg),
+        }
+    }
+
+    let command = match command.as_str() {
+        "record" => HeadlessCommand::Record {
+            network,
+            data_path,
+            output: file.ok_or_else(|| anyhow!("record needs --output"))?,
+            duration,
+        },
+        "replay" => HeadlessCommand::Replay {
+            network,
+            data_path: data_path.ok_or_else(|| anyhow!("replay needs --data-path"))?,
+            input: file.ok_or_else(|| anyhow!("replay needs --input"))?,
+            options,
+        },
+        _ => bail!("unknown command {}", command),
+    };
+    Ok(Some(command))
+}
+
+/// The speed is either 0 (as fast as possible) or a finite factor of at least `MIN_REPLAY_SPEED`
+fn parse_speed(value: &str) -> anyhow::Result<f64> {
+    let speed: f64 = value.parse()?;
+    if speed == 0.0 || (speed.is_finite() && speed >= MIN_REPLAY_SPEED) {
+        Ok(speed)
+    } else {
+        bail!(
+            "invalid speed {}, use 0 or a factor of at least {}",
+            value,
+            MIN_REPLAY_SPEED
+        )
+    }
+}
+
+pub(crate) fn run(command: HeadlessCommand) -> anyhow::Result<()> {
+    match command {
+        HeadlessCommand::Record {
+            network,
+            data_path,
+            output,
+            duration,
+        } => record(network, data_path, output, duration),
+        HeadlessCommand::Replay {
+            network,
+            data_path,
+            input,
+            options,
+        } => replay(network, data_path, input, options),
+    }
+}
+
+type SharedCapture = Arc<Mutex<Option<CaptureWriter<BufWriter<File>>>>>;
+
+fn record(
+    network: Networks,
+    data_path: Option<PathBuf>,
+    output: PathBuf,
+    duration: Option<Duration>,
+) -> anyhow::Result<()> {
+    let runtime = Runtime::new()?;
+    let writer = CaptureWriter::new(
+        BufWriter::new(File::create(&output)?),
+        ProtocolInfo::default_for(network),
+    )?;
+    let capture: SharedCapture = Arc::new(Mutex::new(Some(writer)));
+
+    let clock = Arc::new(SteadyClock::default());
+    let started = clock.now();
+
+    // Dropped messages are captured too, they are part of the load the node had to handle
+    let callbacks = NodeCallbacks::builder()
+        .on_inbound(capture_callback(capture.clone(), clock.clone(), started))
+        .on_inbound_dropped(capture_callback(capture.clone(), clock, started))
+        .finish();
+
+    let mut daemon = DaemonBuilder::new(network).callbacks(callbacks);
+    if let Some(data_path) = data_path {
+        daemon = daemon.data_path(data_path);
+    }
+
+    let shutdown = async move {
+        match duration {
+            Some(duration) => tokio::time::sleep(duration).await,
+            None => {
+                let _ = tokio::signal::ctrl_c().await;
+            }
+        }
+    };
+    runtime.block_on(daemon.run(shutdown))?;
+
+    let writer = capture.lock().unwrap().take();
+    let written = match writer {
+        Some(writer) => writer.finish()?,
+        None => bail!("capture to {:?} failed", output),
+    };
+    println!("captured {} messages to {:?}", written, output);
+    Ok(())
+}
+
+fn capture_callback(
+    capture: SharedCapture,
+    clock: Arc<SteadyClock>,
+    started: Timestamp,
+) -> impl Fn(ChannelId, &Message) + Send + Sync {
+    move |channel_id, message| {
+        let mut guard = capture.lock().unwrap();
+        if let Some(writer) = guard.as_mut() {
+            if let Err(e) = writer.write(clock.now() - started, channel_id, message) {
+                eprintln!(
+                    "stopped capturing after {} messages: {}",
+                    writer.written(),
+                    e
+                );
+                *guard = None;
+            }
+        }
+    }
+}
+
+fn replay(
+    network: Networks,
+    data_path: PathBuf,
+    input: PathBuf,
+    options: ReplayOptions,
+) -> anyhow::Result<()> {
+    let runtime = Runtime::new()?;
+    let mut config = DaemonConfig::load_from_data_path(network, get_cpu_count(), &data_path)?.node;
+    isolate_replay_node(&mut config);
+    let node = NodeBuilder::new(network)
+        .runtime(runtime.handle().clone())
+        .data_path(data_path)
+        .config(config)
+        .flags(replay_flags())
+        .finish()?;
+    let node = Arc::new(node);
+    node.start();
+
+    let reader = CaptureReader::new(BufReader::new(File::open(&input)?))?;
+    let report = LoadReplay::new(node.clone(), options).run(reader);
+    node.stop();
+    print!("{}", report?);
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn parse(args: &[&str]) -> anyhow::Result<Option<HeadlessCommand>> {
+        parse_args(args.iter().map(|a| a.to_string()))
+    }
+
+    #[test]
+    fn no_command_starts_ui() {
+        assert_eq!(parse(&[]).unwrap(), None);
+    }
+
+    #[test]
+    fn parse_record() {
+        let command = parse(&["record", "--output", "/tmp/capture", "--duration", "60"]).unwrap();
+        assert_eq!(
+            command,
+            Some(HeadlessCommand::Record {
+                network: Networks::BananoLiveNetwork,
+                data_path: None,
+                output: "/tmp/capture".into(),
+                duration: Some(Duration::from_secs(60)),
+            })
+        );
+    }
+
+    #[test]
+    fn parse_replay() {
+        let command = parse(&[
+            "replay",
+            "--input",
+            "/tmp/capture",
+            "--data-path",
+            "/tmp/ledger",
+            "--network",
+            "beta",
+            "--speed",
+            "4",
+        ])
+        .unwrap();
+        assert_eq!(
+            command,
+            Some(HeadlessCommand::Replay {
+                network: Networks::BananoBetaNetwork,
+                data_path: "/tmp/ledger".into(),
+                input: "/tmp/capture".into(),
+                options: ReplayOptions {
+                    speed: 4.0,
+                    ..Default::default()
+                },
+            })
+        );
+    }
+
+    #[test]
+    fn reject_invalid_args() {
+        assert!(parse(&["replay", "--input", "/tmp/capture"]).is_err());
+        assert!(parse(&["record", "--speed", "2"]).is_err());
+        assert!(parse(&["record", "--output"]).is_err());
+        assert!(parse(&["dance"]).is_err());
+    }
+
+    #[test]
+    fn reject_invalid_speed() {
+        let replay = |speed: &str| {
+            parse(&[
+                "replay",
+                "--input",
+                "/tmp/capture",
+                "--data-path",
+                "/tmp/ledger",
+                "--speed",
+                speed,
+            ])
+        };
+        assert!(replay("0").is_ok());
+        assert!(replay("0.5").is_ok());
+        assert!(replay("NaN").is_err());
+        assert!(replay("inf").is_err());
+        assert!(replay("-1").is_err());
+        assert!(replay("1e-300").is_err());
+    }
+}
@@ -0,0 +1,440 @@
+use crate::message_capture::CapturedMessage;
+use rsban_messages::{MessageType, ProtocolInfo};
+use rsban_network::{ChannelDirection, ChannelId, ChannelInfo};
+use rsban_node::{
+    block_processing::BlockSource,
+    config::{NodeConfig, NodeFlags},
+    stats::{DetailType, Direction, LatencyStage, LatencySummary, StatType},
+    Node,
+};
+use std::{
+    collections::HashMap,
+    fmt::Display,
+    io,
+    net::{Ipv6Addr, SocketAddrV6},
+    sync::Arc,
+    thread::sleep,
+    time::{Duration, Instant},
+};
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub(crate) struct ReplayOptions {
+    /// 1.0 replays with the recorded timing, 2.0 twice as fast.
+    /// 0.0 replays as fast as the node accepts the messages: instead of dropping
+    /// messages the replay waits while the inbound queue of their channel is full
+    pub speed: f64,
+    /// How long to wait for the node to work off its queues after the last message,
+    /// and at speed 0.0 how long to wait for room in a full inbound queue
+    pub drain_timeout: Duration,
+}
+
+impl Default for ReplayOptions {
+    fn default() -> Self {
+        Self {
+            speed: 1.0,
+            drain_timeout: Duration::from_secs(30),
+        }
+    }
+}
+
+/// Feeds a message capture into the inbound message queue of a node, as if the
+/// messages just arrived from the network.
+///
+/// Only the message types which put load on the ledger and on consensus are
+/// replayed. Keepalives, handshakes and legacy bootstrap requests are skipped,
+/// so that the node never tries to reach the peers of the capture.
+/// Blocks only apply if the ledger is in the state it was in when the capture
+/// started, for example a snapshot which was taken at that time.
+pub(crate) struct LoadReplay {
+    node: Arc<Node>,
+    options: ReplayOptions,
+    channels: HashMap<ChannelId, Arc<ChannelInfo>>,
+    counts: ReplayCounts,
+}
+
+impl LoadReplay {
+    pub fn new(node: Arc<Node>, options: ReplayOptions) -> Self {
+        Self {
+            node,
+            options,
+            channels: HashMap::new(),
+            counts: Default::default(),
+        }
+    }
+
+    pub fn run(
+        mut self,
+        messages: impl Iterator<Item = io::Result<CapturedMessage>>,
+    ) -> io::Result<ReplayReport> {
+        // Only measure the latencies of blocks which are part of the replay
+        self.node.stats.block_latency().clear();
+        let before = LoadSnapshot::take(&self.node);
+        let started = Instant::now();
+
+        for message in messages {
+            let message = message?;
+            let due = scaled_offset(message.offset, self.options.speed);
+            if let Some(wait) = due.checked_sub(started.elapsed()) {
+                sleep(wait);
+            }
+            self.inject(&message);
+        }
+
+        self.drain();
+        let elapsed = started.elapsed();
+        let after = LoadSnapshot::take(&self.node);
+
+        Ok(ReplayReport {
+            elapsed,
+            counts: self.counts,
+            load: after.since(&before),
+            confirmation_latencies: self.confirmation_latencies(),
+        })
+    }
+
+    fn inject(&mut self, message: &CapturedMessage) {
+        let message_type = message.message_type();
+        if !is_replayable(message_type) {
+            self.counts.skipped += 1;
+            return;
+        }
+
+        // Duplicates are filtered like in the message deserializer of a real channel
+        let digest = if matches!(message_type, MessageType::Publish | MessageType::ConfirmAck) {
+            let (digest, existed) = self.node.network_filter.apply(message.payload());
+            if existed {
+                self.counts.duplicates += 1;
+                return;
+            }
+            digest
+        } else {
+            0
+        };
+
+        let Some(decoded) = message.decode(digest) else {
+            self.counts.invalid += 1;
+            return;
+        };
+
+        let channel = self.channel(message.channel_id);
+        if self.options.speed <= 0.0 {
+            self.wait_for_room(message.channel_id);
+        }
+        if self.node.inbound_message_queue.put(decoded, channel) {
+            self.counts.replayed += 1;
+        } else {
+            self.counts.dropped += 1;
+        }
+    }
+
+    fn channel(&mut self, channel_id: ChannelId) -> Arc<ChannelInfo> {
+        let now = self.node.steady_clock.now();
+        self.channels
+            .entry(channel_id)
+            .or_insert_with(|| {
+                let addr = SocketAddrV6::new(Ipv6Addr::LOCALHOST, 0, 0, 0);
+                Arc::new(ChannelInfo::new(
+                    channel_id,
+                    addr,
+                    addr,
+                    ChannelDirection::Inbound,
+                    ProtocolInfo::default().version_using,
+                    now,
+                ))
+            })
+            .clone()
+    }
+
+    /// Returns once the queue made room or the drain timeout elapsed
+    fn wait_for_room(&self, channel_id: ChannelId) {
+        let queue = &self.node.inbound_message_queue;
+        if !queue.is_full(channel_id) {
+            return;
+        }
+        let _ = self.node.runtime.block_on(tokio::time::timeout(
+            self.options.drain_timeout,
+            queue.wait_for_room(channel_id),
+        ));
+    }
+
+    fn drain(&self) {
+        let deadline = Instant::now() + self.options.drain_timeout;
+        while Instant::now() < deadline {
+            if self.node.inbound_message_queue.size() == 0
+                && self.node.block_processor.total_queue_len() == 0
+                && self.node.vote_processor_queue.len() == 0
+            {
+                break;
+            }
+            sleep(Duration::from_millis(10));
+        }
+    }
+
+    fn confirmation_latencies(&self) -> Vec<(BlockSource, LatencySummary)> {
+        self.node
+            .stats
+            .block_latency()
+            .summaries()
+            .into_iter()
+            .filter(|(stage, _, summary)| *stage == LatencyStage::Confirmed && summary.count > 0)
+            .map(|(_, source, summary)| (source, summary))
+            .collect()
+    }
+}
+
+/// The replay node processes inbound messages like a live node, but it must only
+/// see the replayed traffic. So it neither accepts nor opens any connection
+pub(crate) fn isolate_replay_node(config: &mut NodeConfig) {
+    config.preconfigured_peers.clear();
+    config.tcp.max_inbound_connections = 0;
+    config.tcp.max_outbound_connections = 0;
+    config.tcp.max_attempts = 0;
+}
+
+/// Realtime networking stays enabled, because its message processing threads
+/// are the only consumers of the inbound message queue
+pub(crate) fn replay_flags() -> NodeFlags {
+    let mut flags = NodeFlags::new();
+    flags.disable_bootstrap_listener = true;
+    flags.disable_ongoing_bootstrap = true;
+    flags.disable_ascending_bootstrap = true;
+    flags.disable_lazy_bootstrap = true;
+    flags.disable_legacy_bootstrap = true;
+    flags.disable_wallet_bootstrap = true;
+    flags.disable_rep_crawler = true;
+    flags
+}
+
+fn is_replayable(message_type: MessageType) -> bool {
+    matches!(
+        message_type,
+        MessageType::Publish
+            | MessageType::ConfirmReq
+            | MessageType::ConfirmAck
+            | MessageType::AscPullReq
+    )
+}
+
+fn scaled_offset(offset: Duration, speed: f64) -> Duration {
+    if speed > 0.0 {
+        offset.div_f64(speed)
+    } else {
+        Duration::ZERO
+    }
+}
+
+#[derive(Clone, Copy, Default, Debug, PartialEq, Eq)]
+pub(crate) struct ReplayCounts {
+    pub replayed: u64,
+    pub skipped: u64,
+    pub duplicates: u64,
+    pub invalid: u64,
+    /// Rejected because the inbound queue of the channel was full. At speed 0.0
+    /// this only happens if the node didn't make room within the drain timeout
+    pub dropped: u64,
+}
+
+/// Counters of the node which describe the load it handled
+#[derive(Clone, Copy, Default, Debug, PartialEq, Eq)]
+pub(crate) struct LoadSnapshot {
+    pub blocks: u64,
+    pub cemented: u64,
+    pub votes: u64,
+    pub write_lock_held_us: u64,
+    pub write_lock_wait_us: u64,
+}
+
+impl LoadSnapshot {
+    fn take(node: &Node) -> Self {
+        let timing = |detail| {
+            node.stats
+                .count(StatType::BlockprocessorTiming, detail, Direction::In)
+        };
+        Self {
+            blocks: node.ledger.block_count(),
+            cemented: node.ledger.cemented_count(),
+            votes: node
+                .stats
+                .count(StatType::Vote, DetailType::VoteProcessed, Direction::In),
+            write_lock_held_us: timing(DetailType::WriteLockHeld),
+            write_lock_wait_us: timing(DetailType::WriteLockWait),
+        }
+    }
+
+    fn since(&self, before: &Self) -> Self {
+        Self {
+            blocks: self.blocks.saturating_sub(before.blocks),
+            cemented: self.cemented.saturating_sub(before.cemented),
+            votes: self.votes.saturating_sub(before.votes),
+            write_lock_held_us: self
+                .write_lock_held_us
+                .saturating_sub(before.write_lock_held_us),
+            write_lock_wait_us: self
+                .write_lock_wait_us
+                .saturating_sub(before.write_lock_wait_us),
+        }
+    }
+}
+
+pub(crate) struct ReplayReport {
+    pub elapsed: Duration,
+    pub counts: ReplayCounts,
+    pub load: LoadSnapshot,
+    pub confirmation_latencies: Vec<(BlockSource, LatencySummary)>,
+}
+
+impl ReplayReport {
+    fn per_second(&self, count: u64) -> f64 {
+        count as f64 / self.elapsed.as_secs_f64().max(f64::MIN_POSITIVE)
+    }
+}
+
+impl Display for ReplayReport {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        let counts = &self.counts;
+        let load = &self.load;
+        writeln!(
+            f,
+            "replayed {} messages in {:.1}s (skipped {}, duplicates {}, invalid {}, dropped {})",
+            counts.replayed,
+            self.elapsed.as_secs_f64(),
+            counts.skipped,
+            counts.duplicates,
+            counts.invalid,
+            counts.dropped
+        )?;
+        writeln!(
+            f,
+            "blocks:    {} ({:.1}/s), cemented {} ({:.1}/s)",
+            load.blocks,
+            self.per_second(load.blocks),
+            load.cemented,
+            self.per_second(load.cemented)
+        )?;
+        writeln!(
+            f,
+            "votes:     {} ({:.1}/s)",
+            load.votes,
+            self.per_second(load.votes)
+        )?;
+        let held = Duration::from_micros(load.write_lock_held_us);
+        writeln!(
+            f,
+            "write lock held by block processor: {:.3}s ({:.1}% of the replay), waited {:.3}s",
+            held.as_secs_f64(),
+            100.0 * held.as_secs_f64() / self.elapsed.as_secs_f64().max(f64::MIN_POSITIVE),
+            Duration::from_micros(load.write_lock_wait_us).as_secs_f64()
+        )?;
+        for (source, latency) in &self.confirmation_latencies {
+            writeln!(
+                f,
+                "confirmation latency ({}): count {} mean {}us p50 {}us p90 {}us p99 {}us max {}us",
+                source.as_str(),
+                latency.count,
+                latency.mean,
+                latency.p50,
+                latency.p90,
+                latency.p99,
+                latency.max
+            )?;
+        }
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::message_capture::{CaptureReader, CaptureWriter};
+    use rsban_core::{Account, Networks, UnsavedBlockLatticeBuilder};
+    use rsban_messages::{Keepalive, Message, Publish};
+    use test_helpers::{assert_timely, System};
+
+    #[test]
+    fn replayed_publish_reaches_block_processor() {
+        let mut system = System::new();
+        let mut config = System::default_config();
+        isolate_replay_node(&mut config);
+        let node = system
+            .build_node()
+            .config(config)
+            .flags(replay_flags())
+            .finish();
+
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let send = lattice.genesis().send(Account::from(42), 1);
+
+        let mut capture = Vec::new();
+        let mut writer = CaptureWriter::new(
+            &mut capture,
+            ProtocolInfo::default_for(Networks::BananoDevNetwork),
+        )
+        .unwrap();
+        let channel_id = ChannelId::from(1);
+        writer
+            .write(
+                Duration::ZERO,
+                channel_id,
+                &Message::Keepalive(Keepalive::default()),
+            )
+            .unwrap();
+        writer
+            .write(
+                Duration::from_millis(1),
+                channel_id,
+                &Message::Publish(Publish::new_forward(send.clone())),
+            )
+            .unwrap();
+        writer.finish().unwrap();
+
+        let options = ReplayOptions {
+            speed: 0.0,
+            drain_timeout: Duration::from_secs(5),
+        };
+        let report = LoadReplay::new(node.clone(), options)
+            .run(CaptureReader::new(capture.as_slice()).unwrap())
+            .unwrap();
+
+        assert_eq!(report.counts.replayed, 1);
+        assert_eq!(report.counts.skipped, 1);
+        assert_eq!(report.counts.dropped, 0);
+        assert_timely(Duration::from_secs(5), || node.block_exists(&send.hash()));
+        assert_eq!(
+            node.stats
+                .count(StatType::Message, DetailType::Publish, Direction::In),
+            1
+        );
+    }
+
+    #[test]
+    fn scale_offsets_by_speed() {
+        let offset = Duration::from_secs(10);
+        assert_eq!(scaled_offset(offset, 1.0), offset);
+        assert_eq!(scaled_offset(offset, 4.0), Duration::from_millis(2500));
+        assert_eq!(scaled_offset(offset, 0.0), Duration::ZERO);
+    }
+
+    #[test]
+    fn load_since() {
+        let before = LoadSnapshot {
+            blocks: 10,
+            votes: 5,
+            ..Default::default()
+        };
+        let after = LoadSnapshot {
+            blocks: 15,
+            votes: 25,
+            write_lock_held_us: 100,
+            ..Default::default()
+        };
+        assert_eq!(
+            after.since(&before),
+            LoadSnapshot {
+                blocks: 5,
+                votes: 20,
+                write_lock_held_us: 100,
+                ..Default::default()
+            }
+        );
+    }
+}
@@ -1,5 +1,8 @@
 mod channels;
+mod headless;
 mod ledger_stats;
+mod load_replay;
+mod message_capture;
 mod message_collection;
 mod message_rate_calculator;
 mod message_recorder;
@@ -14,6 +17,21 @@ use tokio::runtime::Runtime;
 use views::AppView;
 
 fn main() -> eframe::Result {
+    match headless::parse_args(std::env::args().skip(1)) {
+        Ok(None) => {}
+        Ok(Some(command)) => {
+            if let Err(e) = headless::run(command) {
+                eprintln!("{:#}", e);
+                std::process::exit(1);
+            }
+            return Ok(());
+        }
+        Err(e) => {
+            eprintln!("{}\n\n{}", e, headless::USAGE);
+            std::process::exit(2);
+        }
+    }
+
     let runtime = Runtime::new().unwrap();
     let runtime_handle = runtime.handle().clone();
 
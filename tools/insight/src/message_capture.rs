@@ -0,0 +1,199 @@
+use rsban_messages::{Message, MessageHeader, MessageSerializer, MessageType, ProtocolInfo};
+use rsban_network::ChannelId;
+use std::{
+    io::{self, ErrorKind, Read, Write},
+    time::Duration,
+};
+
+const MAGIC: &[u8; 6] = b"RSBCAP";
+const VERSION: u16 = 1;
+
+/// Writes inbound messages to a compact binary capture file.
+///
+/// The file starts with a magic and a version, followed by one record per message:
+/// offset since the start of the capture in microseconds (u64), channel id (u64),
+/// length (u32) and the message as it was sent over the wire (header and payload).
+/// All integers are little endian.
+pub(crate) struct CaptureWriter<W: Write> {
+    writer: W,
+    serializer: MessageSerializer,
+    written: u64,
+}
+
+impl<W: Write> CaptureWriter<W> {
+    pub fn new(mut writer: W, protocol: ProtocolInfo) -> io::Result<Self> {
+        writer.write_all(MAGIC)?;
+        writer.write_all(&VERSION.to_le_bytes())?;
+        Ok(Self {
+            writer,
+            serializer: MessageSerializer::new(protocol),
+            written: 0,
+        })
+    }
+
+    pub fn write(
+        &mut self,
+        offset: Duration,
+        channel_id: ChannelId,
+        message: &Message,
+    ) -> io::Result<()> {
+        let bytes = self.serializer.serialize(message);
+        self.writer
+            .write_all(&(offset.as_micros() as u64).to_le_bytes())?;
+        self.writer
+            .write_all(&(channel_id.as_usize() as u64).to_le_bytes())?;
+        self.writer.write_all(&(bytes.len() as u32).to_le_bytes())?;
+        self.writer.write_all(bytes)?;
+        self.written += 1;
+        Ok(())
+    }
+
+    pub fn written(&self) -> u64 {
+        self.written
+    }
+
+    /// Flushes the capture and returns the number of written messages
+    pub fn finish(mut self) -> io::Result<u64> {
+        self.writer.flush()?;
+        Ok(self.written)
+    }
+}
+
+/// A message of a capture file, still in its wire format
+#[derive(Clone, PartialEq, Eq, Debug)]
+pub(crate) struct CapturedMessage {
+    pub offset: Duration,
+    pub channel_id: ChannelId,
+    pub bytes: Vec<u8>,
+}
+
+impl CapturedMessage {
+    pub fn header(&self) -> Option<MessageHeader> {
+        MessageHeader::deserialize_slice(&self.bytes).ok()
+    }
+
+    pub fn message_type(&self) -> MessageType {
+        self.header()
+            .map(|h| h.message_type)
+            .unwrap_or(MessageType::Invalid)
+    }
+
+    pub fn payload(&self) -> &[u8] {
+        &self.bytes[MessageHeader::SERIALIZED_SIZE.min(self.bytes.len())..]
+    }
+
+    /// `digest` is the network filter digest of the payload, see `NetworkFilter::apply`
+    pub fn decode(&self, digest: u128) -> Option<Message> {
+        Message::deserialize(self.payload(), &self.header()?, digest)
+    }
+}
+
+/// Reads the messages of a capture file in the order they were recorded
+pub(crate) struct CaptureReader<R: Read> {
+    reader: R,
+}
+
+impl<R: Read> CaptureReader<R> {
+    pub fn new(mut reader: R) -> io::Result<Self> {
+        let mut magic = [0; MAGIC.len()];
+        reader.read_exact(&mut magic)?;
+        let mut version = [0; 2];
+        reader.read_exact(&mut version)?;
+        if magic != *MAGIC || u16::from_le_bytes(version) != VERSION {
+            return Err(io::Error::new(
+                ErrorKind::InvalidData,
+                "not a message capture file",
+            ));
+        }
+        Ok(Self { reader })
+    }
+
+    fn read_next(&mut self) -> io::Result<Option<CapturedMessage>> {
+        let mut offset = [0; 8];
+        match self.reader.read_exact(&mut offset) {
+            Ok(()) => {}
+            // A capture which was cut off at a record boundary is still valid
+            Err(e) if e.kind() == ErrorKind::UnexpectedEof => return Ok(None),
+            Err(e) => return Err(e),
+        }
+        let mut channel_id = [0; 8];
+        self.reader.read_exact(&mut channel_id)?;
+        let mut len = [0; 4];
+        self.reader.read_exact(&mut len)?;
+        let len = u32::from_le_bytes(len) as usize;
+        if len > MessageHeader::SERIALIZED_SIZE + Message::MAX_MESSAGE_SIZE {
+            return Err(io::Error::new(
+                ErrorKind::InvalidData,
+                "captured message too big",
+            ));
+        }
+        let mut bytes = vec![0; len];
+        self.reader.read_exact(&mut bytes)?;
+        Ok(Some(CapturedMessage {
+            offset: Duration::from_micros(u64::from_le_bytes(offset)),
+            channel_id: ChannelId::from(u64::from_le_bytes(channel_id) as usize),
+            bytes,
+        }))
+    }
+}
+
+impl<R: Read> Iterator for CaptureReader<R> {
+    type Item = io::Result<CapturedMessage>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.read_next().transpose()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use rsban_messages::{ConfirmAck, Publish};
+
+    #[test]
+    fn write_and_read_messages() {
+        let publish = Message::Publish(Publish::new_test_instance());
+        let confirm_ack = Message::ConfirmAck(ConfirmAck::new_test_instance());
+
+        let mut writer = CaptureWriter::new(Vec::new(), ProtocolInfo::default()).unwrap();
+        writer
+            .write(Duration::from_millis(1), ChannelId::from(1), &publish)
+            .unwrap();
+        writer
+            .write(Duration::from_millis(250), ChannelId::from(2), &confirm_ack)
+            .unwrap();
+        assert_eq!(writer.written(), 2);
+        let file = writer.writer;
+
+        let messages: Vec<_> = CaptureReader::new(file.as_slice())
+            .unwrap()
+            .collect::<io::Result<_>>()
+            .unwrap();
+        assert_eq!(messages.len(), 2);
+        assert_eq!(messages[0].offset, Duration::from_millis(1));
+        assert_eq!(messages[0].channel_id, ChannelId::from(1));
+        assert_eq!(messages[0].message_type(), MessageType::Publish);
+        assert_eq!(messages[0].decode(0), Some(publish));
+        assert_eq!(messages[1].offset, Duration::from_millis(250));
+        assert_eq!(messages[1].decode(0), Some(confirm_ack));
+    }
+
+    #[test]
+    fn reject_other_files() {
+        assert!(CaptureReader::new(b"not a capture".as_slice()).is_err());
+    }
+
+    #[test]
+    fn stop_at_truncated_record() {
+        let mut writer = CaptureWriter::new(Vec::new(), ProtocolInfo::default()).unwrap();
+        writer
+            .write(Duration::ZERO, ChannelId::from(1), &Message::TelemetryReq)
+            .unwrap();
+        let mut file = writer.writer;
+        file.extend_from_slice(&[1, 2, 3]);
+
+        let mut reader = CaptureReader::new(file.as_slice()).unwrap();
+        assert!(reader.next().unwrap().is_ok());
+        assert!(reader.next().is_none());
+    }
+}
@@ -547,6 +547,7 @@ pub fn setup_rpc_client_and_server(node: Arc<Node>, enable_control: bool) -> Rpc
         node.clone(),
         listener,
         enable_control,
+        false,
         tx_stop,
         async move {
             tokio::select! {
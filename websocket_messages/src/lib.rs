@@ -30,6 +30,8 @@ pub enum Topic {
     Telemetry,
     /// New block arrival message
     NewUnconfirmedBlock,
+    /// Latencies of a block from arrival until cementation
+    BlockLatency,
     /// Auxiliary length, not a valid topic, must be the last enum
     Length,
 }
@@ -179,6 +181,7 @@ pub fn to_topic(topic: impl AsRef<str>) -> Topic {
         "bootstrap" => Topic::Bootstrap,
         "telemetry" => Topic::Telemetry,
         "new_unconfirmed_block" => Topic::NewUnconfirmedBlock,
+        "block_latency" => Topic::BlockLatency,
         _ => Topic::Invalid,
     }
 }
@@ -9,6 +9,7 @@ use rsban_node::{
     consensus::{
         ActiveElections, ElectionStatus, ElectionStatusType, ProcessLiveDispatcher, VoteProcessor,
     },
+    stats::{BlockTrace, LatencyStage, Stats},
     wallets::Wallets,
     Telemetry,
 };
@@ -30,6 +31,7 @@ pub fn create_websocket_server(
     vote_processor: &VoteProcessor,
     process_live_dispatcher: &ProcessLiveDispatcher,
     bootstrap_initiator: &BootstrapInitiator,
+    stats: &Stats,
 ) -> Option<Arc<WebsocketListener>> {
     if !config.enabled {
         return None;
@@ -143,9 +145,57 @@ pub fn create_websocket_server(
         }
     }));
 
+    let server_w: std::sync::Weak<WebsocketListener> = Arc::downgrade(&server);
+    stats
+        .block_latency()
+        .on_block_traced(Box::new(move |trace| {
+            if let Some(server) = server_w.upgrade() {
+                if server.any_subscriber(Topic::BlockLatency) {
+                    server.broadcast(&block_latency(trace));
+                }
+            }
+        }));
+
     Some(server)
 }
 
+fn block_latency(trace: &BlockTrace) -> OutgoingMessageEnvelope {
+    let micros = |stage| {
+        trace
+            .latency(stage)
+            .map(|latency| latency.as_micros().to_string())
+    };
+    let mut envelope = OutgoingMessageEnvelope::new(
+        Topic::BlockLatency,
+        BlockLatency {
+            source: trace.source.as_str().to_owned(),
+            queued: micros(LatencyStage::Queued),
+            processed: micros(LatencyStage::Processed),
+            election_started: micros(LatencyStage::ElectionStarted),
+            confirmed: micros(LatencyStage::Confirmed),
+            cemented: micros(LatencyStage::Cemented),
+        },
+    );
+    envelope.hash = Some(trace.hash);
+    envelope
+}
+
+/// Latencies in microseconds since the block arrived
+#[derive(Serialize, Deserialize)]
+pub struct BlockLatency {
+    pub source: String,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub queued: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub processed: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub election_started: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub confirmed: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    pub cemented: Option<String>,
+}
+
 fn telemetry_received(data: &TelemetryData, endpoint: SocketAddrV6) -> OutgoingMessageEnvelope {
     OutgoingMessageEnvelope::new(
         Topic::Telemetry,
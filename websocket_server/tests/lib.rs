@@ -13,8 +13,8 @@ use rsban_node::{
 };
 use rsban_websocket_messages::{OutgoingMessageEnvelope, Topic};
 use rsban_websocket_server::{
-    create_websocket_server, vote_received, BlockConfirmed, TelemetryReceived, VoteReceived,
-    WebsocketListener, WebsocketListenerExt,
+    create_websocket_server, vote_received, BlockConfirmed, BlockLatency, TelemetryReceived,
+    VoteReceived, WebsocketListener, WebsocketListenerExt,
 };
 use std::{sync::Arc, time::Duration};
 use test_helpers::{assert_timely, get_available_port, make_fake_channel, System};
@@ -708,6 +708,46 @@ fn new_unconfirmed_block() {
     });
 }
 
+#[test]
+// Confirms a block and awaits the latencies of all its stages
+fn block_latency() {
+    let mut system = System::new();
+    let (node1, _websocket) = create_node_with_websocket(&mut system);
+    node1.runtime.block_on(async {
+        let mut ws_stream = connect_websocket(&node1).await;
+        ws_stream
+            .send(tungstenite::Message::Text(
+                r#"{"action": "subscribe", "topic": "block_latency", "ack": true}"#.to_string(),
+            ))
+            .await
+            .unwrap();
+        //await ack
+        ws_stream.next().await.unwrap().unwrap();
+
+        node1.insert_into_wallet(&DEV_GENESIS_KEY);
+        let mut lattice = UnsavedBlockLatticeBuilder::new();
+        let send_amount = node1.online_reps.lock().unwrap().quorum_delta() + Amount::raw(1);
+        let send = lattice.genesis().send(&PrivateKey::new(), send_amount);
+        node1.process_active(send.clone());
+
+        let tungstenite::Message::Text(response) = ws_stream.next().await.unwrap().unwrap() else {
+            panic!("not a text message");
+        };
+
+        let response_json: OutgoingMessageEnvelope = serde_json::from_str(&response).unwrap();
+        assert_eq!(response_json.topic, Some(Topic::BlockLatency));
+        assert_eq!(response_json.hash, Some(send.hash()));
+
+        let latency: BlockLatency = serde_json::from_value(response_json.message.unwrap()).unwrap();
+        assert_eq!(latency.source, "live");
+        assert!(latency.queued.is_some());
+        assert!(latency.processed.is_some());
+        assert!(latency.election_started.is_some());
+        assert!(latency.confirmed.is_some());
+        assert!(latency.cemented.is_some());
+    });
+}
+
 fn create_node_with_websocket(system: &mut System) -> (Arc<Node>, Arc<WebsocketListener>) {
     let websocket_port = get_available_port();
     let config = NodeConfig {
@@ -732,6 +772,7 @@ fn create_node_with_websocket(system: &mut System) -> (Arc<Node>, Arc<WebsocketL
         &node.vote_processor,
         &node.process_live_dispatcher,
         &node.bootstrap_initiator,
+        &node.stats,
     )
     .unwrap();
 